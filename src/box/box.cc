@@ -47,6 +47,7 @@
 #include "engine.h"
 #include "memtx_engine.h"
 #include "memtx_index.h"
+#include "memtx_read_view.h"
 #include "sysview_engine.h"
 #include "vinyl_engine.h"
 #include "space.h"
@@ -112,6 +113,20 @@ process_rw(struct request *request, struct tuple **result)
 	assert(iproto_type_is_dml(request->type));
 	rmean_collect(rmean_box, request->type, 1);
 	try {
+		/*
+		 * Alter may delete indexes and formats which
+		 * memtx read views use, see memtx_read_view_lock().
+		 * DDL is autocommit only, so it's fine to yield.
+		 */
+		bool is_ddl = (request->space_id == BOX_SPACE_ID ||
+			       request->space_id == BOX_INDEX_ID) &&
+			      in_txn() == NULL;
+		if (is_ddl)
+			memtx_read_view_lock();
+		auto read_view_guard = make_scoped_guard([=] {
+			if (is_ddl)
+				memtx_read_view_unlock();
+		});
 		struct space *space = space_cache_find(request->space_id);
 		struct txn *txn = txn_begin_stmt(space);
 		access_check_space(space, PRIV_W);
@@ -341,6 +356,106 @@ box_check_rows_per_wal(int64_t rows_per_wal)
 	return rows_per_wal;
 }
 
+static double
+box_check_wal_group_commit_delay(double delay)
+{
+	if (delay < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_delay",
+			  "the value must not be negative");
+	}
+	return delay;
+}
+
+static int64_t
+box_check_wal_group_commit_rows(int64_t rows)
+{
+	if (rows <= 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_rows",
+			  "the value must be greater than zero");
+	}
+	return rows;
+}
+
+static int
+box_check_wal_stream_dirs(void)
+{
+	int count = cfg_getarr_size("wal_stream_dirs");
+	if (count >= WAL_STREAMS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "wal_stream_dirs",
+			  "too many directories");
+	}
+	if (count > 0 && cfg_getarr_size("replication_source") > 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_stream_dirs",
+			  "can not be used with replication_source");
+	}
+	return count;
+}
+
+static int
+box_check_iproto_threads(int iproto_threads)
+{
+	if (iproto_threads <= 0 || iproto_threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_threads",
+			  "specified value is out of bounds");
+	}
+	return iproto_threads;
+}
+
+static double
+box_check_read_view_period(double period)
+{
+	if (period < 0) {
+		tnt_raise(ClientError, ER_CFG, "read_view_period",
+			  "the value must not be negative");
+	}
+	return period;
+}
+
+static int
+box_check_memtx_build_threads(int build_threads)
+{
+	if (build_threads <= 0) {
+		tnt_raise(ClientError, ER_CFG, "memtx_build_threads",
+			  "the value must be greater than zero");
+	}
+	return build_threads;
+}
+
+static int
+box_check_snap_threads(int snap_threads)
+{
+	if (snap_threads <= 0) {
+		tnt_raise(ClientError, ER_CFG, "snap_threads",
+			  "the value must be greater than zero");
+	}
+	if (snap_threads > SNAP_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "snap_threads",
+			  "specified value is out of bounds");
+	}
+	return snap_threads;
+}
+
+static int
+box_check_vinyl_read_threads(int read_threads)
+{
+	if (read_threads <= 0) {
+		tnt_raise(ClientError, ER_CFG, "vinyl.read_threads",
+			  "the value must be greater than zero");
+	}
+	return read_threads;
+}
+
+static enum xlog_compression
+box_check_snap_compression(const char *name)
+{
+	assert(name != NULL); /* checked in Lua */
+	int compression = strindex(xlog_compression_STRS, name,
+				   XLOG_COMPRESSION_MAX);
+	if (compression == XLOG_COMPRESSION_MAX)
+		tnt_raise(ClientError, ER_CFG, "snap_compression", name);
+	return (enum xlog_compression) compression;
+}
+
 void
 box_check_config()
 {
@@ -348,9 +463,18 @@ box_check_config()
 	box_check_uri(cfg_gets("listen"), "listen");
 	box_check_replication_source();
 	box_check_readahead(cfg_geti("readahead"));
+	box_check_iproto_threads(cfg_geti("iproto_threads"));
+	box_check_read_view_period(cfg_getd("read_view_period"));
 	box_check_rows_per_wal(cfg_geti64("rows_per_wal"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_wal_group_commit_delay(cfg_getd("wal_group_commit_delay"));
+	box_check_wal_group_commit_rows(cfg_geti64("wal_group_commit_rows"));
+	box_check_wal_stream_dirs();
 	box_check_slab_alloc_minimal(cfg_geti64("slab_alloc_minimal"));
+	box_check_memtx_build_threads(cfg_geti("memtx_build_threads"));
+	box_check_snap_threads(cfg_geti("snap_threads"));
+	box_check_snap_compression(cfg_gets("snap_compression"));
+	box_check_vinyl_read_threads(cfg_geti("vinyl.read_threads"));
 }
 
 /*
@@ -368,6 +492,10 @@ cfg_get_replication_source(int *p_count)
 		tnt_raise(ClientError, ER_CFG, "replication_source",
 				"too many replicas");
 	}
+	if (count > 0 && cfg_getarr_size("wal_stream_dirs") > 0) {
+		tnt_raise(ClientError, ER_CFG, "replication_source",
+			  "can not be used with wal_stream_dirs");
+	}
 
 	for (int i = 0; i < count; i++) {
 		const char *source = cfg_getarr_elem("replication_source", i);
@@ -459,6 +587,25 @@ box_set_snap_io_rate_limit(void)
 		memtx->setSnapIoRateLimit(cfg_getd("snap_io_rate_limit"));
 }
 
+extern "C" void
+box_set_snap_threads(void)
+{
+	int snap_threads = box_check_snap_threads(cfg_geti("snap_threads"));
+	MemtxEngine *memtx = (MemtxEngine *) engine_find("memtx");
+	if (memtx)
+		memtx->setSnapThreads(snap_threads);
+}
+
+extern "C" void
+box_set_snap_compression(void)
+{
+	enum xlog_compression compression =
+		box_check_snap_compression(cfg_gets("snap_compression"));
+	MemtxEngine *memtx = (MemtxEngine *) engine_find("memtx");
+	if (memtx)
+		memtx->setSnapCompression(compression);
+}
+
 extern "C" void
 box_set_too_long_threshold(void)
 {
@@ -620,6 +767,20 @@ box_select(struct port *port, uint32_t space_id, uint32_t index_id,
 	}
 }
 
+int
+box_check_stale_select(uint32_t space_id)
+{
+	rmean_collect(rmean_box, IPROTO_SELECT, 1);
+
+	try {
+		struct space *space = space_cache_find(space_id);
+		access_check_space(space, PRIV_R);
+		return 0;
+	} catch (Exception *e) {
+		return -1;
+	}
+}
+
 int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -1034,6 +1195,12 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	if (!box_init_done)
 		tnt_raise(ClientError, ER_LOADING);
 
+	/* Relays read wal_dir only. */
+	if (recovery->stream_dir_count > 0) {
+		tnt_raise(ClientError, ER_UNSUPPORTED, "Replication",
+			  "WAL streams");
+	}
+
 	/* Forbid connection to itself */
 	if (tt_uuid_is_equal(&server_uuid, &SERVER_UUID))
 		tnt_raise(ClientError, ER_CONNECTION_TO_SELF);
@@ -1102,6 +1269,12 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	if (!box_init_done)
 		tnt_raise(ClientError, ER_LOADING);
 
+	/* Relays read wal_dir only. */
+	if (recovery->stream_dir_count > 0) {
+		tnt_raise(ClientError, ER_UNSUPPORTED, "Replication",
+			  "WAL streams");
+	}
+
 	struct tt_uuid cluster_uuid = uuid_nil, replica_uuid = uuid_nil;
 	struct vclock replica_clock;
 	vclock_create(&replica_clock);
@@ -1214,9 +1387,12 @@ engine_init()
 	 * in snapshotting (in enigne_foreach order),
 	 * so it must be registered first.
 	 */
+	int build_threads =
+		box_check_memtx_build_threads(cfg_geti("memtx_build_threads"));
 	MemtxEngine *memtx = new MemtxEngine(cfg_gets("snap_dir"),
 					     cfg_geti("panic_on_snap_error"),
-					     cfg_geti("panic_on_wal_error"));
+					     cfg_geti("panic_on_wal_error"),
+					     build_threads);
 	engine_register(memtx);
 
 	SysviewEngine *sysview = new SysviewEngine();
@@ -1326,6 +1502,17 @@ bootstrap(void)
 		panic_syserror("failed to save a snapshot");
 }
 
+/** Pass the directories of wal_stream_dirs to recovery. */
+static void
+box_add_wal_stream_dirs(struct recovery *r)
+{
+	int count = box_check_wal_stream_dirs();
+	for (int i = 0; i < count; i++) {
+		const char *dir = cfg_getarr_elem("wal_stream_dirs", i);
+		recovery_add_stream_dir(r, dir);
+	}
+}
+
 static inline void
 box_init(void)
 {
@@ -1335,7 +1522,8 @@ box_init(void)
 	tuple_init(cfg_getd("slab_alloc_arena"),
 		   cfg_geti("slab_alloc_minimal"),
 		   cfg_geti("slab_alloc_maximal"),
-		   cfg_getd("slab_alloc_factor"));
+		   cfg_getd("slab_alloc_factor"),
+		   cfg_geti("tuple_cord_arenas"));
 
 	rmean_box = rmean_new(iproto_type_strs, IPROTO_TYPE_STAT_MAX);
 	rmean_error = rmean_new(rmean_error_strings, RMEAN_ERROR_LAST);
@@ -1362,12 +1550,16 @@ box_init(void)
 	xstream_create(&final_join_stream, apply_row);
 	xstream_create(&subscribe_stream, apply_subscribe_row);
 
+	double read_view_period =
+		box_check_read_view_period(cfg_getd("read_view_period"));
+
 	struct vclock checkpoint_vclock;
 	int64_t lsn = recovery_last_checkpoint(&checkpoint_vclock);
 	if (lsn != -1) {
 		recovery = recovery_new(cfg_gets("wal_dir"),
 					cfg_geti("panic_on_wal_error"),
 					&checkpoint_vclock);
+		box_add_wal_stream_dirs(recovery);
 		engine_begin_initial_recovery();
 
 		/* Replace server vclock using the data from snapshot */
@@ -1381,24 +1573,39 @@ box_init(void)
 		/* Start network */
 		assert(!tt_uuid_is_nil(&SERVER_UUID));
 		port_init();
-		iproto_init();
+		iproto_init(cfg_geti("iproto_threads"),
+			    cfg_geti("iproto_io_uring"),
+			    read_view_period > 0);
 		box_set_listen();
 		recovery_finalize(recovery, &wal_stream.base);
 
 		box_sync_replication_source();
 
 		engine_end_recovery();
+		if (recovery->stream_gap) {
+			/*
+			 * Recovery skipped the rows of WAL streams
+			 * after a gap in LSN. Save a snapshot, so
+			 * that they are not read again.
+			 */
+			if (engine_begin_checkpoint() ||
+			    engine_commit_checkpoint(&recovery->vclock))
+				panic_syserror("failed to save a snapshot");
+		}
 	} else {
 		/* TODO: don't create recovery for this case */
 		vclock_create(&checkpoint_vclock);
 		recovery = recovery_new(cfg_gets("wal_dir"),
 					cfg_geti("panic_on_wal_error"),
 					&checkpoint_vclock);
+		box_add_wal_stream_dirs(recovery);
 
 		/* Start network */
 		tt_uuid_create(&SERVER_UUID);
 		port_init();
-		iproto_init();
+		iproto_init(cfg_geti("iproto_threads"),
+			    cfg_geti("iproto_io_uring"),
+			    read_view_period > 0);
 		box_set_listen();
 		box_sync_replication_source();
 
@@ -1410,12 +1617,25 @@ box_init(void)
 	int64_t rows_per_wal = box_check_rows_per_wal(cfg_geti64("rows_per_wal"));
 	enum wal_mode wal_mode = box_check_wal_mode(cfg_gets("wal_mode"));
 	if (wal_mode != WAL_NONE) {
-		wal_writer_start(wal_mode, cfg_gets("wal_dir"), &SERVER_UUID,
-				 &recovery->vclock, rows_per_wal);
+		double group_commit_delay = box_check_wal_group_commit_delay(
+			cfg_getd("wal_group_commit_delay"));
+		int64_t group_commit_rows = box_check_wal_group_commit_rows(
+			cfg_geti64("wal_group_commit_rows"));
+		const char *stream_dirs[WAL_STREAMS_MAX];
+		int stream_dir_count = recovery->stream_dir_count;
+		for (int i = 0; i < stream_dir_count; i++)
+			stream_dirs[i] = recovery->stream_dirs[i].dirname;
+		wal_writer_start(wal_mode, cfg_gets("wal_dir"), stream_dirs,
+				 stream_dir_count, &SERVER_UUID,
+				 &recovery->vclock, rows_per_wal,
+				 group_commit_delay, group_commit_rows);
 	}
 
 	rmean_cleanup(rmean_box);
 
+	if (read_view_period > 0)
+		memtx_read_view_init(read_view_period);
+
 	/* Follow replica */
 	server_foreach(server) {
 		if (server->applier != NULL)
@@ -109,6 +109,8 @@ void box_set_replication_source(void);
 void box_set_log_level(void);
 void box_set_io_collect_interval(void);
 void box_set_snap_io_rate_limit(void);
+void box_set_snap_threads(void);
+void box_set_snap_compression(void);
 void box_set_too_long_threshold(void);
 void box_set_readahead(void);
 void box_set_panic_on_wal_error(void);
@@ -130,6 +132,15 @@ box_select(struct port *port, uint32_t space_id, uint32_t index_id,
 	   int iterator, uint32_t offset, uint32_t limit,
 	   const char *key, const char *key_end);
 
+/**
+ * Account a SELECT served from a memtx read view and check
+ * that the current user may read the space, see IPROTO_STALE_OK.
+ * @retval 0 success
+ * @retval -1 error, diag is set
+ */
+int
+box_check_stale_select(uint32_t space_id);
+
 /** \cond public */
 
 /*
@@ -92,6 +92,14 @@ public:
 	 * a snapshot.
 	 */
 	virtual bool needToBuildSecondaryKey(struct space *space);
+	/**
+	 * Fill a new secondary key of a space with the tuples
+	 * of the old space's primary key. Checks the tuples
+	 * against the new space format and the key constraints.
+	 */
+	virtual void buildSecondaryKey(struct space *old_space,
+				       struct space *new_space,
+				       Index *new_index);
 
 	virtual void join(struct xstream *);
 	/**
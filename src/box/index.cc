@@ -38,6 +38,7 @@
 #include "request.h"
 #include "txn.h"
 #include "rmean.h"
+#include "scoped_guard.h"
 
 const char *iterator_type_strs[] = {
 	/* [ITER_EQ]  = */ "EQ",
@@ -231,6 +232,29 @@ Index::findByKey(const char *key, uint32_t part_count) const
 	return NULL;
 }
 
+void
+Index::findByKeys(const char *keys, uint32_t count,
+		  struct tuple **result) const
+{
+	uint32_t found = 0;
+	auto guard = make_scoped_guard([&]{
+		for (uint32_t i = 0; i < found; i++) {
+			if (result[i] != NULL)
+				tuple_unref(result[i]);
+		}
+	});
+	for (; found < count; found++) {
+		const char *key = keys;
+		uint32_t part_count = mp_decode_array(&key);
+		mp_next(&keys);
+		struct tuple *tuple = findByKey(key, part_count);
+		if (tuple != NULL)
+			tuple_ref(tuple);
+		result[found] = tuple;
+	}
+	guard.is_active = false;
+}
+
 struct tuple *
 Index::findByTuple(struct tuple *tuple) const
 {
@@ -374,6 +398,43 @@ box_index_get(uint32_t space_id, uint32_t index_id, const char *key,
 	}
 }
 
+int
+box_index_get_many(uint32_t space_id, uint32_t index_id, const char *keys,
+		   const char *keys_end, box_tuple_t **result)
+{
+	mp_tuple_assert(keys, keys_end);
+	assert(result != NULL);
+	try {
+		struct space *space;
+		Index *index = check_index(space_id, index_id, &space);
+		if (!index->key_def->opts.is_unique)
+			tnt_raise(ClientError, ER_MORE_THAN_ONE_TUPLE);
+		const char *key = keys;
+		uint32_t count = mp_decode_array(&key);
+		const char *first = key;
+		for (uint32_t i = 0; i < count; i++) {
+			if (mp_typeof(*key) != MP_ARRAY) {
+				tnt_raise(ClientError, ER_ILLEGAL_PARAMS,
+					  "a key must be an array");
+			}
+			uint32_t part_count = mp_decode_array(&key);
+			primary_key_validate(index->key_def, key, part_count);
+			for (uint32_t j = 0; j < part_count; j++)
+				mp_next(&key);
+		}
+		/* Start transaction in the engine. */
+		struct txn *txn = txn_begin_ro_stmt(space);
+		index->findByKeys(first, count, result);
+		/* Count statistics */
+		rmean_collect(rmean_box, IPROTO_SELECT, 1);
+		txn_commit_ro_stmt(txn);
+		return 0;
+	}  catch (Exception *) {
+		txn_rollback_stmt();
+		return -1;
+	}
+}
+
 int
 box_index_min(uint32_t space_id, uint32_t index_id, const char *key,
 	      const char *key_end, box_tuple_t **result)
@@ -237,6 +237,20 @@ box_index_count(uint32_t space_id, uint32_t index_id, int type,
 
 /** \endcond public */
 
+/**
+ * Same as box_index_get() for each key of @a keys, which is
+ * a MsgPack array of keys, in one statement. result[i] is the
+ * tuple of the i-th key or NULL. The found tuples are
+ * referenced, the caller must unreference them.
+ *
+ * \param[out] result must have room for a tuple per key
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ */
+int
+box_index_get_many(uint32_t space_id, uint32_t index_id, const char *keys,
+		   const char *keys_end, box_tuple_t **result);
+
 extern const char *iterator_type_strs[];
 
 #if defined(__cplusplus)
@@ -331,6 +345,13 @@ public:
 	virtual size_t count(enum iterator_type type, const char *key,
 			     uint32_t part_count) const;
 	virtual struct tuple *findByKey(const char *key, uint32_t part_count) const;
+	/**
+	 * Find a tuple by each of @a count full keys following
+	 * one another at @a keys. result[i] is the referenced
+	 * tuple of the i-th key or NULL.
+	 */
+	virtual void findByKeys(const char *keys, uint32_t count,
+				struct tuple **result) const;
 	virtual struct tuple *findByTuple(struct tuple *tuple) const;
 	virtual struct tuple *replace(struct tuple *old_tuple,
 				      struct tuple *new_tuple,
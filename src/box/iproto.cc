@@ -30,9 +30,13 @@
  */
 #include "iproto.h"
 #include <string.h>
+#include <stdlib.h>
+#include <errno.h>
 #include <stdint.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <netdb.h>
+#include <sys/socket.h>
 
 #include <msgpuck.h>
 #include "third_party/base64.h"
@@ -56,12 +60,42 @@
 #include "session.h"
 #include "xrow.h"
 #include "schema.h" /* sc_version */
+#include "space.h"
+#include "txn.h"
 #include "cluster.h" /* server_uuid */
 #include "iproto_constants.h"
 #include "rmean.h"
+#include "uring.h"
+#include "memtx_read_view.h"
+#include "histogram.h"
+#include "clock.h"
 
 /* The number of iproto messages in flight */
 enum { IPROTO_MSG_MAX = 768 };
+/* The max number of DML requests in a batch, see iproto_enqueue_batch() */
+enum { IPROTO_BATCH_MAX = 64 };
+/* The max number of open cursors of a connection, see IPROTO_OPEN */
+enum { IPROTO_CURSORS_MAX = 64 };
+/* The number of rows returned by OPEN or FETCH without a chunk size */
+enum { IPROTO_CHUNK_SIZE_DEFAULT = 1000 };
+/*
+ * Tuples of this size and bigger are written to the client
+ * right from the tuple, see tx_dump_port(). It's cheaper to
+ * copy smaller ones to the output buffer.
+ */
+enum { IPROTO_REF_MIN = 1024 };
+/* The max number of tuples written in one writev() */
+enum { IPROTO_FLUSH_REFS_MAX = 64 };
+/* The max size of an iovec array of one writev() */
+enum { IPROTO_FLUSH_IOV_MAX = SMALL_OBUF_IOV_MAX + 1 +
+	2 * IPROTO_FLUSH_REFS_MAX };
+/* The max number of connections flushed at once, see iproto_uring_flush() */
+enum { IPROTO_URING_BATCH_MAX = 64 };
+/*
+ * Buffers of a connection which has received no input for this
+ * many seconds are released, see iproto_release_idle().
+ */
+enum { IPROTO_IDLE_TIMEOUT = 1 };
 
 /* {{{ iproto_msg - declaration */
 
@@ -99,9 +133,43 @@ struct iproto_msg: public cmsg
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/**
+	 * Used in DML batches, see iproto_enqueue_batch().
+	 * The first request of a batch is sent to tx on behalf
+	 * of the whole batch and keeps the list of its requests,
+	 * itself included.
+	 */
+	struct stailq batch;
+	/** Link in the list of requests of a batch. */
+	struct stailq_entry in_batch;
+	/** Result of a request of a batch: a tuple or an error. */
+	struct tuple *tuple;
+	struct error *error;
+	/**
+	 * Tuples referenced by the reply, see tx_dump_port(),
+	 * or written tuples to release, see iproto_flush_advance().
+	 */
+	struct stailq refs;
+	/**
+	 * Used in SELECTs with IPROTO_STALE_OK, see
+	 * reader_process_select(): the result in a memtx read
+	 * view and the schema version of the view.
+	 */
+	struct memtx_read_view_result stale_result;
+	uint32_t stale_sc_version;
+	bool has_stale_result;
+	/**
+	 * Monotonic time in nanoseconds of the read of the
+	 * request, of the end of its parsing and of the start
+	 * of its execution in tx, see net_account_msg().
+	 */
+	uint64_t read_time;
+	uint64_t parse_time;
+	uint64_t tx_time;
 };
 
-static struct mempool iproto_msg_pool;
+/* Each network thread has its own pools. */
+static __thread struct mempool iproto_msg_pool;
 
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con)
@@ -109,6 +177,7 @@ iproto_msg_new(struct iproto_connection *con)
 	struct iproto_msg *msg =
 		(struct iproto_msg *) mempool_alloc_xc(&iproto_msg_pool);
 	msg->connection = con;
+	stailq_create(&msg->refs);
 	return msg;
 }
 
@@ -132,24 +201,136 @@ struct IprotoMsgGuard {
 /* {{{ iproto connection and requests */
 
 /**
- * A single global queue for all requests in all connections. All
- * requests from all connections are processed concurrently.
- * Is also used as a queue for just established connections and to
- * execute disconnect triggers. A few notes about these triggers:
- * - they need to be run in a fiber
- * - unlike an ordinary request failure, on_connect trigger
- *   failure must lead to connection close.
- * - on_connect trigger must be processed before any other
- *   request on this connection.
+ * A network thread. Connections are spread among the threads
+ * by the kernel, see iproto_set_listen(), and a connection
+ * stays in the thread which accepted it.
+ */
+struct iproto_thread
+{
+	struct cord cord;
+	/**
+	 * A single queue for all requests in all connections of
+	 * the thread. All requests from all connections are
+	 * processed concurrently.
+	 * Is also used as a queue for just established connections and to
+	 * execute disconnect triggers. A few notes about these triggers:
+	 * - they need to be run in a fiber
+	 * - unlike an ordinary request failure, on_connect trigger
+	 *   failure must lead to connection close.
+	 * - on_connect trigger must be processed before any other
+	 *   request on this connection.
+	 */
+	struct cpipe tx_pipe;
+	struct cpipe net_pipe;
+	struct cbus net_tx_bus;
+	/** The iproto binary listener of the thread. */
+	struct evio_service binary;
+	struct rmean *rmean_net;
+	/*
+	 * Message routes lead to net_pipe of the thread,
+	 * see iproto_thread_init_routes().
+	 */
+	struct cmsg_hop disconnect_route[2];
+	struct cmsg_hop misc_route[2];
+	struct cmsg_hop select_route[2];
+	struct cmsg_hop process1_route[2];
+	struct cmsg_hop batch_route[2];
+	struct cmsg_hop sync_route[2];
+	struct cmsg_hop connect_route[2];
+	struct cmsg_hop release_route[2];
+	struct cmsg_hop idle_route[2];
+	struct cmsg_hop cursor_route[2];
+	struct cmsg_hop get_many_route[2];
+	struct cmsg_hop stale_select_route[4];
+	const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX];
+	/**
+	 * The reader thread serves SELECTs with IPROTO_STALE_OK
+	 * from memtx read views, see reader_process_select().
+	 * Started only if box.cfg.read_view_period is set.
+	 */
+	bool use_readers;
+	struct cord reader_cord;
+	/** Consumed by the reader thread. */
+	struct cpipe reader_pipe;
+	/** Consumed by the network thread, replies of the reader. */
+	struct cpipe net_reader_pipe;
+	struct cbus net_reader_bus;
+	/** Written tuples to release in tx, see iproto_flush_advance(). */
+	struct iproto_msg *release;
+	/**
+	 * Open connections of the thread, the least recently
+	 * active first, and connections with released buffers,
+	 * see iproto_release_idle().
+	 */
+	struct rlist connections;
+	struct rlist idle_connections;
+	ev_timer idle_timer;
+	/** Use io_uring to write to the sockets, see iproto_init(). */
+	bool use_uring;
+	/** NULL if io_uring is off or is not supported. */
+	struct iproto_uring *uring;
+	/**
+	 * Latency of the stages of requests and of whole
+	 * requests by type in microseconds. Updated only by the
+	 * thread, see net_account_msg().
+	 */
+	struct histogram stage_hist[IPROTO_STAGE_MAX];
+	struct histogram request_hist[IPROTO_TYPE_STAT_MAX];
+};
+
+/**
+ * Output of the connections of a network thread which is written
+ * with io_uring: instead of a writev() per connection, the output
+ * of all connections ready for write in an event loop iteration
+ * is written in a single system call at the end of the iteration,
+ * see iproto_uring_flush().
  */
-static struct cpipe tx_pipe;
-static struct cpipe net_pipe;
-static struct cbus net_tx_bus;
+struct iproto_uring
+{
+	struct uring ring;
+	/** Flushes the output before the event loop blocks. */
+	struct ev_prepare flush;
+	/** Connections with output to flush. */
+	struct rlist queue;
+	/* The current batch. */
+	struct iproto_connection *con[IPROTO_URING_BATCH_MAX];
+	struct iobuf *iobuf[IPROTO_URING_BATCH_MAX];
+	struct uring_write writes[IPROTO_URING_BATCH_MAX];
+	struct iovec iov[IPROTO_URING_BATCH_MAX][IPROTO_FLUSH_IOV_MAX];
+};
+
+static struct iproto_thread iproto_threads[IPROTO_THREADS_MAX];
+static int iproto_thread_count;
+/** The network thread of the current cord, NULL in tx. */
+static __thread struct iproto_thread *net_thread;
+
 /* A pointer to the transaction processor cord. */
 struct cord *tx_cord;
 
-struct rmean *rmean_net;
-struct rmean *rmean_net_tx_bus;
+/**
+ * A tuple written to the client in place, see tx_dump_port().
+ * Allocated and freed in tx.
+ */
+struct iproto_tuple_ref
+{
+	struct iobuf_ref base;
+	struct tuple *tuple;
+};
+
+static struct mempool iproto_tuple_ref_pool;
+
+/** Unreference tuples written to the client. */
+static void
+tx_release_refs(struct stailq *refs)
+{
+	struct iobuf_ref *base, *next;
+	stailq_foreach_entry_safe(base, next, refs, in_iobuf) {
+		struct iproto_tuple_ref *ref = (struct iproto_tuple_ref *) base;
+		tuple_unref(ref->tuple);
+		mempool_free(&iproto_tuple_ref_pool, ref);
+	}
+	stailq_create(refs);
+}
 
 enum rmean_net_name {
 	IPROTO_SENT,
@@ -159,6 +340,10 @@ enum rmean_net_name {
 
 const char *rmean_net_strings[IPROTO_LAST] = { "SENT", "RECEIVED" };
 
+const char *iproto_stage_strs[IPROTO_STAGE_MAX] = {
+	"PARSE", "TX_QUEUE", "TX", "FLUSH"
+};
+
 /** Context of a single client connection. */
 struct iproto_connection
 {
@@ -189,9 +374,38 @@ struct iproto_connection
 	ev_loop *loop;
 	/* Pre-allocated disconnect msg. */
 	struct iproto_msg *disconnect;
+	/** Link in the queue of output to flush with io_uring. */
+	struct rlist in_flush;
+	/** Link in iproto_thread::connections or idle_connections. */
+	struct rlist in_thread;
+	/** The time of the last input. */
+	ev_tstamp last_input;
+	/** Monotonic time of the last read, in nanoseconds. */
+	uint64_t read_time;
+	/**
+	 * The time the oldest reply not written yet was passed
+	 * to the thread, 0 if all replies are written, see
+	 * iproto_connection_on_flush().
+	 */
+	uint64_t reply_time;
+	/**
+	 * The input buffer size, grows with the traffic and
+	 * shrinks when the connection is idle.
+	 */
+	size_t readahead;
+	/** The output buffers are being released in tx. */
+	bool is_releasing;
+	/**
+	 * Open cursors, see tx_process_cursor(). Accessed
+	 * only in tx.
+	 */
+	struct rlist cursors;
+	int cursor_count;
+	/** The id of the last opened cursor. */
+	uint32_t last_cursor_id;
 };
 
-static struct mempool iproto_connection_pool;
+static __thread struct mempool iproto_connection_pool;
 
 /**
  * A connection is idle when the client is gone
@@ -248,12 +462,28 @@ tx_process1(struct cmsg *msg);
 static void
 tx_process_select(struct cmsg *msg);
 static void
+reader_process_select(struct cmsg *msg);
+static void
+net_forward_to_tx(struct cmsg *msg);
+static void
+tx_process_stale_select(struct cmsg *msg);
+static void
 net_send_msg(struct cmsg *msg);
+static void
+tx_process_batch(struct cmsg *msg);
+static void
+net_send_batch(struct cmsg *msg);
 
 static void
 tx_process_join_subscribe(struct cmsg *msg);
 static void
 net_end_join_subscribe(struct cmsg *msg);
+static void
+tx_process_idle(struct cmsg *msg);
+static void
+net_end_idle(struct cmsg *msg);
+static void
+tx_close_cursors(struct iproto_connection *con);
 
 /**
  * Fire on_disconnect triggers in the tx
@@ -271,12 +501,16 @@ tx_process_disconnect(struct cmsg *m)
 		session_destroy(con->session);
 		con->session = NULL; /* safety */
 	}
+	tx_close_cursors(con);
 	/*
 	 * Got to be done in iproto thread since
 	 * that's where the memory is allocated.
 	 */
 	obuf_destroy(&con->iobuf[0]->out);
 	obuf_destroy(&con->iobuf[1]->out);
+	/* The tuples the client has not read. */
+	tx_release_refs(&con->iobuf[0]->refs);
+	tx_release_refs(&con->iobuf[1]->refs);
 }
 
 /**
@@ -292,44 +526,6 @@ net_finish_disconnect(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop disconnect_route[] = {
-	{ tx_process_disconnect, &net_pipe },
-	{ net_finish_disconnect, NULL },
-};
-
-static const struct cmsg_hop misc_route[] = {
-	{ tx_process_misc, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop select_route[] = {
-	{ tx_process_select, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop process1_route[] = {
-	{ tx_process1, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
-	NULL,                                   /* IPROTO_OK */
-	select_route,                           /* IPROTO_SELECT */
-	process1_route,                         /* IPROTO_INSERT */
-	process1_route,                         /* IPROTO_REPLACE */
-	process1_route,                         /* IPROTO_UPDATE */
-	process1_route,                         /* IPROTO_DELETE */
-	misc_route,                             /* IPROTO_CALL */
-	misc_route,                             /* IPROTO_AUTH */
-	misc_route,                             /* IPROTO_EVAL */
-	process1_route                          /* IPROTO_UPSERT */
-};
-
-static const struct cmsg_hop sync_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_join_subscribe, NULL },
-};
-
 static struct iproto_connection *
 iproto_connection_new(const char *name, int fd)
 {
@@ -346,7 +542,19 @@ iproto_connection_new(const char *name, int fd)
 	con->session = NULL;
 	/* It may be very awkward to allocate at close. */
 	con->disconnect = iproto_msg_new(con);
-	cmsg_init(con->disconnect, disconnect_route);
+	cmsg_init(con->disconnect, net_thread->disconnect_route);
+	rlist_create(&con->in_flush);
+	con->readahead = iobuf_readahead_min();
+	iobuf_set_readahead_mt(con->iobuf[0], con->readahead);
+	iobuf_set_readahead_mt(con->iobuf[1], con->readahead);
+	con->last_input = ev_now(con->loop);
+	con->read_time = 0;
+	con->reply_time = 0;
+	con->is_releasing = false;
+	rlist_create(&con->cursors);
+	con->cursor_count = 0;
+	con->last_cursor_id = 0;
+	rlist_add_tail_entry(&net_thread->connections, con, in_thread);
 	return con;
 }
 
@@ -367,6 +575,8 @@ iproto_connection_close(struct iproto_connection *con)
 		/* Make evio_has_fd() happy */
 		con->input.fd = con->output.fd = -1;
 		close(fd);
+		rlist_del_entry(con, in_flush);
+		rlist_del_entry(con, in_thread);
 		/*
 		 * Discard unparsed data, to recycle the
 		 * connection in net_send_msg() as soon as all
@@ -391,7 +601,90 @@ iproto_connection_close(struct iproto_connection *con)
 		assert(con->disconnect != NULL);
 		struct iproto_msg *msg = con->disconnect;
 		con->disconnect = NULL;
-		cpipe_push(&tx_pipe, msg);
+		cpipe_push(&net_thread->tx_pipe, msg);
+	}
+}
+
+/** Release the output buffers of an idle connection. */
+static void
+tx_process_idle(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_connection *con = msg->connection;
+	/*
+	 * The connection has sent no requests since the message
+	 * was sent, or they're queued after it, so the output
+	 * buffers are not used.
+	 */
+	iobuf_release_out(con->iobuf[0]);
+	iobuf_release_out(con->iobuf[1]);
+}
+
+static void
+net_end_idle(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	msg->connection->is_releasing = false;
+	iproto_msg_delete(msg);
+}
+
+/**
+ * Give the buffers of a connection which has been idle for
+ * IPROTO_IDLE_TIMEOUT back to the slab caches and halve its
+ * readahead. The input buffers are released at once, the output
+ * buffers are owned by tx and are released there.
+ * Returns false if the connection isn't idle.
+ */
+static bool
+iproto_connection_release(struct iproto_connection *con)
+{
+	if (!iobuf_is_idle(con->iobuf[0]) || !iobuf_is_idle(con->iobuf[1]) ||
+	    con->is_releasing)
+		return false;
+	con->readahead = MAX(con->readahead / 2, iobuf_readahead_min());
+	for (int i = 0; i < 2; i++) {
+		iobuf_set_readahead_mt(con->iobuf[i], con->readahead);
+		iobuf_release_in(con->iobuf[i]);
+	}
+	if (obuf_capacity(&con->iobuf[0]->out) == 0 &&
+	    obuf_capacity(&con->iobuf[1]->out) == 0)
+		return true;
+	try {
+		struct iproto_msg *msg = iproto_msg_new(con);
+		cmsg_init(msg, net_thread->idle_route);
+		msg->iobuf = NULL;
+		msg->len = 0;
+		con->is_releasing = true;
+		cpipe_push(&net_thread->tx_pipe, msg);
+	} catch (Exception *e) {
+		/* Try again on the next timeout. */
+		e->log();
+	}
+	return true;
+}
+
+/**
+ * Release the buffers of connections which have received
+ * no input for IPROTO_IDLE_TIMEOUT. A connection which is
+ * still busy is checked again after the next timeout.
+ */
+static void
+iproto_release_idle(ev_loop *loop, ev_timer *watcher, int /* revents */)
+{
+	struct iproto_thread *thread = (struct iproto_thread *) watcher->data;
+	ev_tstamp now = ev_now(loop);
+	struct iproto_connection *con, *tmp;
+	rlist_foreach_entry_safe(con, &thread->connections, in_thread, tmp) {
+		if (con->last_input > now - IPROTO_IDLE_TIMEOUT)
+			break;
+		if (iproto_connection_release(con)) {
+			rlist_move_tail_entry(&thread->idle_connections,
+					      con, in_thread);
+		} else {
+			con->last_input = now;
+			rlist_move_tail_entry(&thread->connections,
+					      con, in_thread);
+		}
 	}
 }
 
@@ -488,11 +781,41 @@ iproto_connection_input_iobuf(struct iproto_connection *con)
 	return newbuf;
 }
 
-/** Enqueue all requests which were read up. */
+/**
+ * Send a batch of DML requests to tx. A batch of a single
+ * request is processed as usual.
+ */
+static inline void
+iproto_push_batch(struct iproto_msg **batch, int batch_size)
+{
+	if (*batch == NULL)
+		return;
+	if (batch_size == 1)
+		cmsg_init(*batch, net_thread->process1_route);
+	cpipe_push_input(&net_thread->tx_pipe, *batch);
+	*batch = NULL;
+}
+
+/**
+ * Enqueue all requests which were read up.
+ *
+ * Consecutive INSERT, REPLACE, UPDATE, DELETE and UPSERT
+ * requests of the connection are sent to tx in one message,
+ * up to IPROTO_BATCH_MAX requests at a time, see
+ * tx_process_batch(). The batch is pushed only when it
+ * is complete, since tx may start processing a message as
+ * soon as it is pushed.
+ */
 static inline void
 iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 {
 	bool stop_input = false;
+	struct iproto_msg *batch = NULL;
+	int batch_size = 0;
+	/* Don't lose the requests already parsed on error. */
+	auto batch_guard = make_scoped_guard([&] {
+		iproto_push_batch(&batch, batch_size);
+	});
 	while (con->parse_size && stop_input == false) {
 		const char *reqstart = in->wpos - con->parse_size;
 		const char *pos = reqstart;
@@ -542,15 +865,42 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 			request_decode(&msg->request,
 				       (const char *) msg->header.body[0].iov_base,
 				       msg->header.body[0].iov_len);
-			assert(msg->header.type < sizeof(dml_route)/sizeof(*dml_route));
-			cmsg_init(msg, dml_route[msg->header.type]);
+			assert(msg->header.type < IPROTO_TYPE_STAT_MAX);
+			if (msg->header.type == IPROTO_SELECT &&
+			    msg->request.stale_ok && net_thread->use_readers) {
+				cmsg_init(msg, net_thread->stale_select_route);
+				break;
+			}
+			cmsg_init(msg, net_thread->dml_route[msg->header.type]);
+			break;
+		case IPROTO_OPEN:
+		case IPROTO_FETCH:
+		case IPROTO_CLOSE:
+			if (msg->header.bodycnt == 0) {
+				tnt_raise(ClientError, ER_INVALID_MSGPACK,
+					  "missing request body");
+			}
+			request_decode(&msg->request,
+				       (const char *) msg->header.body[0].iov_base,
+				       msg->header.body[0].iov_len);
+			cmsg_init(msg, net_thread->cursor_route);
+			break;
+		case IPROTO_GET_MANY:
+			if (msg->header.bodycnt == 0) {
+				tnt_raise(ClientError, ER_INVALID_MSGPACK,
+					  "missing request body");
+			}
+			request_decode(&msg->request,
+				       (const char *) msg->header.body[0].iov_base,
+				       msg->header.body[0].iov_len);
+			cmsg_init(msg, net_thread->get_many_route);
 			break;
 		case IPROTO_PING:
-			cmsg_init(msg, misc_route);
+			cmsg_init(msg, net_thread->misc_route);
 			break;
 		case IPROTO_JOIN:
 		case IPROTO_SUBSCRIBE:
-			cmsg_init(msg, sync_route);
+			cmsg_init(msg, net_thread->sync_route);
 			stop_input = true;
 			break;
 		default:
@@ -558,7 +908,28 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 				  (uint32_t) msg->header.type);
 			break;
 		}
-		cpipe_push_input(&tx_pipe, guard.release());
+		msg->read_time = con->read_time;
+		msg->parse_time = clock_monotonic64();
+		if (msg->route == net_thread->process1_route) {
+			if (batch == NULL) {
+				batch = msg;
+				batch_size = 0;
+				stailq_create(&batch->batch);
+				cmsg_init(batch, net_thread->batch_route);
+			}
+			assert(batch->iobuf == msg->iobuf);
+			stailq_add_tail_entry(&batch->batch, guard.release(),
+					      in_batch);
+			if (++batch_size == IPROTO_BATCH_MAX)
+				iproto_push_batch(&batch, batch_size);
+		} else if (msg->route == net_thread->stale_select_route) {
+			cpipe_push_input(&net_thread->reader_pipe,
+					 guard.release());
+		} else {
+			iproto_push_batch(&batch, batch_size);
+			cpipe_push_input(&net_thread->tx_pipe,
+					 guard.release());
+		}
 		/* Request is parsed */
 		assert(reqend > reqstart);
 		assert(con->parse_size >= (size_t) (reqend - reqstart));
@@ -587,7 +958,28 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		 */
 		ev_feed_event(con->loop, &con->input, EV_READ);
 	}
-	cpipe_flush_input(&tx_pipe);
+	iproto_push_batch(&batch, batch_size);
+	cpipe_flush_input(&net_thread->tx_pipe);
+	if (net_thread->use_readers)
+		cpipe_flush_input(&net_thread->reader_pipe);
+}
+
+/**
+ * Account input of a connection: the readahead is doubled when
+ * a read fills up a buffer of at least half the readahead size.
+ */
+static inline void
+iproto_connection_on_read(struct iproto_connection *con, size_t unused,
+			  size_t nrd)
+{
+	con->last_input = ev_now(con->loop);
+	rlist_move_tail_entry(&net_thread->connections, con, in_thread);
+	if (nrd < unused || unused < con->readahead / 2 ||
+	    con->readahead >= iobuf_readahead_max())
+		return;
+	con->readahead = MIN(con->readahead * 2, iobuf_readahead_max());
+	iobuf_set_readahead_mt(con->iobuf[0], con->readahead);
+	iobuf_set_readahead_mt(con->iobuf[1], con->readahead);
 }
 
 static void
@@ -614,7 +1006,8 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 
 		struct ibuf *in = &iobuf->in;
 		/* Read input. */
-		int nrd = sio_read(fd, in->wpos, ibuf_unused(in));
+		size_t unused = ibuf_unused(in);
+		int nrd = sio_read(fd, in->wpos, unused);
 		if (nrd < 0) {                  /* Socket is not ready. */
 			ev_io_start(loop, &con->input);
 			return;
@@ -624,7 +1017,9 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		rmean_collect(net_thread->rmean_net, IPROTO_RECEIVED, nrd);
+		iproto_connection_on_read(con, unused, nrd);
+		con->read_time = clock_monotonic64();
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -657,53 +1052,171 @@ iproto_connection_output_iobuf(struct iproto_connection *con)
 	return NULL;
 }
 
-/** writev() to the socket and handle the result. */
+/** Fill @a iov with the output buffer data between two savepoints. */
+static inline int
+iproto_obuf_to_iov(struct obuf *out, const struct obuf_svp *begin,
+		   const struct obuf_svp *end, struct iovec *iov)
+{
+	if (begin->used == end->used)
+		return 0;
+	int iovcnt = end->pos - begin->pos + 1;
+	memcpy(iov, out->iov + begin->pos, iovcnt * sizeof(struct iovec));
+	sio_add_to_iov(iov, -begin->iov_len);
+	iov[iovcnt-1].iov_len = end->iov_len - begin->iov_len * (iovcnt == 1);
+	return iovcnt;
+}
 
-static int
-iproto_flush(struct iobuf *iobuf, struct iproto_connection *con)
+/** Advance a savepoint by @a size bytes, less than up to @a end. */
+static inline void
+iproto_obuf_advance(struct obuf *out, struct obuf_svp *svp,
+		    const struct obuf_svp *end, size_t size)
 {
-	int fd = con->output.fd;
-	struct obuf_svp *begin = &iobuf->out.wpos;
-	struct obuf_svp *end = &iobuf->out.wend;
-	assert(begin->used < end->used);
 	struct iovec iov[SMALL_OBUF_IOV_MAX+1];
-	struct iovec *src = iobuf->out.iov;
-	int iovcnt = end->pos - begin->pos + 1;
+	iproto_obuf_to_iov(out, svp, end, iov);
+	size_t offset = 0;
+	int advance = sio_move_iov(iov, size, &offset);
+	svp->used += size;
+	svp->iov_len = advance == 0 ? svp->iov_len + offset: offset;
+	svp->pos += advance;
+	assert(svp->pos <= end->pos);
+}
+
+/**
+ * Gather the output of @a iobuf to write into @a iov. If the
+ * output refers to tuples, see tx_dump_port(), the output buffer
+ * data and the tuple data are gathered in the order of replies.
+ */
+static int
+iproto_flush_iov(struct iobuf *iobuf, struct iovec *iov)
+{
+	struct obuf *out = &iobuf->out;
+	struct obuf_svp *begin = &out->wpos;
+	struct obuf_svp *end = &out->wend;
+	assert(begin->used < end->used || ! stailq_empty(&iobuf->refs));
 	/*
 	 * iov[i].iov_len may be concurrently modified in tx thread,
-	 * but only for the last position.
+	 * but only for the last position, so iproto_obuf_to_iov()
+	 * *overwrites* iov_len of the last pos as it may be garbage.
 	 */
-	memcpy(iov, src + begin->pos, iovcnt * sizeof(struct iovec));
-	sio_add_to_iov(iov, -begin->iov_len);
-	/* *Overwrite* iov_len of the last pos as it may be garbage. */
-	iov[iovcnt-1].iov_len = end->iov_len - begin->iov_len * (iovcnt == 1);
-
-	ssize_t nwr = sio_writev(fd, iov, iovcnt);
+	if (stailq_empty(&iobuf->refs))
+		return iproto_obuf_to_iov(out, begin, end, iov);
+	/* Don't fail to release tuples once they are written. */
+	if (net_thread->release == NULL) {
+		net_thread->release = iproto_msg_new(NULL);
+		cmsg_init(net_thread->release, net_thread->release_route);
+	}
+	int iovcnt = 0;
+	int n_refs = 0;
+	struct obuf_svp pos = *begin;
+	size_t ref_written = iobuf->ref_written;
+	struct iobuf_ref *ref;
+	stailq_foreach_entry(ref, &iobuf->refs, in_iobuf) {
+		if (n_refs++ == IPROTO_FLUSH_REFS_MAX)
+			break;
+		iovcnt += iproto_obuf_to_iov(out, &pos, &ref->svp, iov + iovcnt);
+		iov[iovcnt].iov_base = (char *) ref->data + ref_written;
+		iov[iovcnt].iov_len = ref->size - ref_written;
+		iovcnt++;
+		ref_written = 0;
+		pos = ref->svp;
+	}
+	if (n_refs <= IPROTO_FLUSH_REFS_MAX)
+		iovcnt += iproto_obuf_to_iov(out, &pos, end, iov + iovcnt);
+	return iovcnt;
+}
 
-	/* Count statistics */
-	rmean_collect(rmean_net, IPROTO_SENT, nwr);
-	if (nwr > 0) {
-		if (begin->used + nwr == end->used) {
-			if (ibuf_used(&iobuf->in) == 0) {
-				/* Quickly recycle the buffer if it's idle. */
-				assert(end->used == obuf_size(&iobuf->out));
-				/* resets wpos and wpend to zero pos */
-				iobuf_reset_mt(iobuf);
-			} else { /* Avoid assignment reordering. */
-				/* Advance write position. */
-				*begin = *end;
-			}
-			return 0;
+/**
+ * Advance the output of @a iobuf by @a nwr written bytes.
+ * Written tuples are sent back to tx to be released at the
+ * end of the event, see iproto_push_release().
+ *
+ * @retval  0 all output of the buffer is written
+ * @retval -1 a partial write
+ */
+static int
+iproto_flush_advance(struct iobuf *iobuf, size_t nwr)
+{
+	struct obuf *out = &iobuf->out;
+	struct obuf_svp *begin = &out->wpos;
+	struct obuf_svp *end = &out->wend;
+	size_t left = nwr;
+	while (! stailq_empty(&iobuf->refs)) {
+		struct iobuf_ref *ref =
+			stailq_first_entry(&iobuf->refs, struct iobuf_ref,
+					   in_iobuf);
+		size_t len = ref->svp.used - begin->used;
+		if (left < len) {
+			iproto_obuf_advance(out, begin, &ref->svp, left);
+			return -1;
+		}
+		left -= len;
+		*begin = ref->svp;
+		len = ref->size - iobuf->ref_written;
+		if (left < len) {
+			iobuf->ref_written += left;
+			return -1;
 		}
-		size_t offset = 0;
-		int advance = 0;
-		advance = sio_move_iov(iov, nwr, &offset);
-		begin->used += nwr;             /* advance write position */
-		begin->iov_len = advance == 0 ? begin->iov_len + offset: offset;
-		begin->pos += advance;
-		assert(begin->pos <= end->pos);
+		left -= len;
+		iobuf->ref_written = 0;
+		stailq_shift(&iobuf->refs);
+		stailq_add_tail_entry(&net_thread->release->refs, ref,
+				      in_iobuf);
+	}
+	if (left < end->used - begin->used) {
+		iproto_obuf_advance(out, begin, end, left);
+		return -1;
 	}
-	return -1;
+	if (ibuf_used(&iobuf->in) == 0) {
+		/* Quickly recycle the buffer if it's idle. */
+		assert(end->used == obuf_size(out));
+		/* resets wpos and wpend to zero pos */
+		iobuf_reset_mt(iobuf);
+	} else { /* Avoid assignment reordering. */
+		/* Advance write position. */
+		*begin = *end;
+	}
+	return 0;
+}
+
+/** writev() to the socket and handle the result. */
+static int
+iproto_flush(struct iobuf *iobuf, struct iproto_connection *con)
+{
+	struct iovec iov[IPROTO_FLUSH_IOV_MAX];
+	int iovcnt = iproto_flush_iov(iobuf, iov);
+
+	ssize_t nwr = sio_writev(con->output.fd, iov, iovcnt);
+
+	/* Count statistics */
+	rmean_collect(net_thread->rmean_net, IPROTO_SENT, nwr);
+	if (nwr <= 0)
+		return -1;
+	return iproto_flush_advance(iobuf, nwr);
+}
+
+/** Send the written tuples to tx to be released. */
+static inline void
+iproto_push_release()
+{
+	struct iproto_msg *msg = net_thread->release;
+	if (msg == NULL || stailq_empty(&msg->refs))
+		return;
+	net_thread->release = NULL;
+	cpipe_push(&net_thread->tx_pipe, msg);
+}
+
+/**
+ * Account the time the replies of a connection waited to be
+ * written, once all of its output is written.
+ */
+static inline void
+iproto_connection_on_flush(struct iproto_connection *con)
+{
+	if (con->reply_time == 0)
+		return;
+	histogram_collect(&net_thread->stage_hist[IPROTO_STAGE_FLUSH],
+			  (clock_monotonic64() - con->reply_time) / 1000);
+	con->reply_time = 0;
 }
 
 static void
@@ -711,29 +1224,191 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 			    int /* revents */)
 {
 	struct iproto_connection *con = (struct iproto_connection *) watcher->data;
+	struct iproto_uring *uring = net_thread->uring;
+	if (uring != NULL) {
+		/* Flushed by iproto_uring_flush(). */
+		if (rlist_empty(&con->in_flush))
+			rlist_add_tail_entry(&uring->queue, con, in_flush);
+		return;
+	}
 
 	try {
 		struct iobuf *iobuf;
 		while ((iobuf = iproto_connection_output_iobuf(con))) {
 			if (iproto_flush(iobuf, con) < 0) {
 				ev_io_start(loop, &con->output);
+				iproto_push_release();
 				return;
 			}
 			if (! ev_is_active(&con->input))
 				ev_feed_event(loop, &con->input, EV_READ);
 		}
+		iproto_connection_on_flush(con);
 		if (ev_is_active(&con->output))
 			ev_io_stop(con->loop, &con->output);
 	} catch (Exception *e) {
 		e->log();
 		iproto_connection_close(con);
 	}
+	iproto_push_release();
+}
+
+static void
+iproto_uring_flush(ev_loop *loop, struct ev_prepare *watcher,
+		   int /* revents */);
+
+/**
+ * Set up io_uring output of the current network thread.
+ * Returns NULL if io_uring is not supported.
+ */
+static struct iproto_uring *
+iproto_uring_new()
+{
+	struct iproto_uring *uring =
+		(struct iproto_uring *) malloc(sizeof(*uring));
+	if (uring == NULL) {
+		say_error("failed to allocate io_uring output buffers");
+		return NULL;
+	}
+	if (uring_create(&uring->ring, IPROTO_URING_BATCH_MAX) != 0) {
+		say_syserror("io_uring is not available, using writev");
+		free(uring);
+		return NULL;
+	}
+	rlist_create(&uring->queue);
+	ev_prepare_init(&uring->flush, iproto_uring_flush);
+	uring->flush.data = uring;
+	ev_prepare_start(loop(), &uring->flush);
+	/* Don't keep the event loop alive. */
+	ev_unref(loop());
+	return uring;
+}
+
+/**
+ * Switch the current network thread back to writev(), the
+ * queued connections are flushed on the next iteration.
+ */
+static void
+iproto_uring_delete(struct iproto_uring *uring)
+{
+	assert(net_thread->uring == uring);
+	net_thread->uring = NULL;
+	ev_ref(loop());
+	ev_prepare_stop(loop(), &uring->flush);
+	struct iproto_connection *con, *tmp;
+	rlist_foreach_entry_safe(con, &uring->queue, in_flush, tmp) {
+		rlist_create(&con->in_flush);
+		ev_feed_event(con->loop, &con->output, EV_WRITE);
+	}
+	uring_destroy(&uring->ring);
+	free(uring);
+}
+
+/** Handle the result of an io_uring write of a connection. */
+static void
+iproto_uring_complete(ev_loop *loop, struct iproto_uring *uring,
+		      struct iproto_connection *con, struct iobuf *iobuf,
+		      struct uring_write *w)
+{
+	try {
+		if (w->res < 0 && w->res != -EAGAIN && w->res != -EINTR) {
+			errno = -w->res;
+			tnt_raise(SocketError, w->fd, "sendmsg(%d)", w->iovcnt);
+		}
+		if (w->res > 0)
+			rmean_collect(net_thread->rmean_net, IPROTO_SENT,
+				      w->res);
+		if (w->res <= 0 || iproto_flush_advance(iobuf, w->res) < 0) {
+			ev_io_start(loop, &con->output);
+			return;
+		}
+		if (! ev_is_active(&con->input))
+			ev_feed_event(loop, &con->input, EV_READ);
+		if (iproto_connection_output_iobuf(con) != NULL) {
+			/* Write the other buffer in the next batch. */
+			rlist_add_tail_entry(&uring->queue, con, in_flush);
+			return;
+		}
+		iproto_connection_on_flush(con);
+		if (ev_is_active(&con->output))
+			ev_io_stop(loop, &con->output);
+	} catch (Exception *e) {
+		e->log();
+		iproto_connection_close(con);
+	}
+}
+
+/**
+ * Write the output of the connections queued by
+ * iproto_connection_on_output(), up to IPROTO_URING_BATCH_MAX
+ * connections in one system call. If io_uring fails, the thread
+ * falls back to writev().
+ */
+static void
+iproto_uring_flush(ev_loop *loop, struct ev_prepare *watcher,
+		   int /* revents */)
+{
+	struct iproto_uring *uring = (struct iproto_uring *) watcher->data;
+	while (! rlist_empty(&uring->queue)) {
+		int count = 0;
+		while (count < IPROTO_URING_BATCH_MAX &&
+		       ! rlist_empty(&uring->queue)) {
+			struct iproto_connection *con =
+				rlist_shift_entry(&uring->queue,
+						  struct iproto_connection,
+						  in_flush);
+			rlist_create(&con->in_flush);
+			struct iobuf *iobuf = iproto_connection_output_iobuf(con);
+			if (iobuf == NULL) {
+				if (ev_is_active(&con->output))
+					ev_io_stop(loop, &con->output);
+				continue;
+			}
+			struct uring_write *w = &uring->writes[count];
+			try {
+				w->iovcnt = iproto_flush_iov(iobuf,
+							     uring->iov[count]);
+			} catch (Exception *e) {
+				e->log();
+				iproto_connection_close(con);
+				continue;
+			}
+			w->fd = con->output.fd;
+			w->iov = uring->iov[count];
+			uring->con[count] = con;
+			uring->iobuf[count] = iobuf;
+			count++;
+		}
+		if (count == 0)
+			break;
+		bool failed = uring_writev_batch(&uring->ring, uring->writes,
+						 count) != 0;
+		if (failed)
+			say_syserror("io_uring failed, falling back to writev");
+		for (int i = 0; i < count; i++) {
+			iproto_uring_complete(loop, uring, uring->con[i],
+					      uring->iobuf[i],
+					      &uring->writes[i]);
+		}
+		if (failed) {
+			iproto_uring_delete(uring);
+			break;
+		}
+	}
+	iproto_push_release();
 }
 
+/**
+ * Prepare the fiber to execute @a msg in the session of its
+ * connection. Marks the start of the execution, see
+ * net_account_msg().
+ */
 static void
-tx_fiber_init(struct session *session, uint64_t sync)
+tx_fiber_init(struct iproto_msg *msg)
 {
-	session->sync = sync;
+	struct session *session = msg->connection->session;
+	msg->tx_time = clock_monotonic64();
+	session->sync = msg->header.sync;
 	fiber_set_session(fiber(), session);
 	fiber_set_user(fiber(), &session->credentials);
 }
@@ -755,7 +1430,7 @@ tx_process1(struct cmsg *m)
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct obuf *out = &msg->iobuf->out;
 
-	tx_fiber_init(msg->connection->session, msg->header.sync);
+	tx_fiber_init(msg);
 	if (tx_check_schema(msg->header.schema_id))
 		goto error;
 
@@ -776,17 +1451,167 @@ error:
 	msg->write_end = obuf_create_svp(out);
 }
 
-static void
-tx_process_select(struct cmsg *m)
+/**
+ * Only requests to memtx spaces without triggers are executed
+ * in the transaction of a batch: memtx statements never yield,
+ * while a trigger may yield and abort the transaction, and
+ * DDL can't be a part of a multi-statement transaction.
+ */
+static bool
+tx_request_is_batchable(struct request *request)
 {
-	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct space *space = space_by_id(request->space_id);
+	return space != NULL && space_is_memtx(space) &&
+	       ! space_is_system(space) && rlist_empty(&space->on_replace);
+}
+
+/**
+ * Commit the transaction of @a txn_size requests of a batch
+ * starting at @a txn_first. If the commit fails, its error
+ * becomes the result of every request of the transaction.
+ */
+static void
+tx_commit_batch(struct iproto_msg *txn_first, int txn_size)
+{
+	if (box_txn_commit() == 0)
+		return;
+	struct error *e = diag_last_error(&fiber()->diag);
+	struct iproto_msg *msg = txn_first;
+	for (int i = 0; i < txn_size; i++) {
+		if (msg->error == NULL) {
+			if (msg->tuple != NULL) {
+				box_tuple_unref(msg->tuple);
+				msg->tuple = NULL;
+			}
+			error_ref(e);
+			msg->error = e;
+		}
+		if (i + 1 < txn_size)
+			msg = stailq_next_entry(msg, in_batch);
+	}
+}
+
+/**
+ * Execute a batch of DML requests, see iproto_enqueue_batch().
+ * Consecutive requests to memtx spaces are executed in one
+ * transaction, so that their rows are written to WAL in one
+ * go, the rest are executed as usual. Each request still gets
+ * its own reply: a failed statement doesn't affect the other
+ * requests of the transaction.
+ */
+static void
+tx_process_batch(struct cmsg *m)
+{
+	struct iproto_msg *batch = (struct iproto_msg *) m;
+	struct obuf *out = &batch->iobuf->out;
+	struct session *session = batch->connection->session;
+	struct iproto_msg *msg;
+
+	tx_fiber_init(batch);
+
+	struct iproto_msg *txn_first = NULL;
+	int txn_size = 0;
+	stailq_foreach_entry(msg, &batch->batch, in_batch) {
+		session->sync = msg->header.sync;
+		msg->tuple = NULL;
+		msg->error = NULL;
+		bool is_batchable = tx_request_is_batchable(&msg->request);
+		if (! is_batchable && txn_size > 0) {
+			tx_commit_batch(txn_first, txn_size);
+			txn_size = 0;
+		}
+		if (is_batchable && txn_size++ == 0) {
+			int rc = box_txn_begin();
+			assert(rc == 0);
+			(void) rc;
+			txn_first = msg;
+		}
+		struct tuple *tuple;
+		if (tx_check_schema(msg->header.schema_id) ||
+		    box_process1(&msg->request, &tuple) ||
+		    (tuple && box_tuple_ref(tuple))) {
+			msg->error = diag_last_error(&fiber()->diag);
+			error_ref(msg->error);
+		} else {
+			msg->tuple = tuple;
+		}
+	}
+	if (txn_size > 0)
+		tx_commit_batch(txn_first, txn_size);
+
+	stailq_foreach_entry(msg, &batch->batch, in_batch) {
+		struct obuf_svp svp;
+		if (msg->error != NULL) {
+			iproto_reply_error(out, msg->error, msg->header.sync);
+			error_unref(msg->error);
+			continue;
+		}
+		if (iproto_prepare_select(out, &svp) ||
+		    (msg->tuple && tuple_to_obuf(msg->tuple, out))) {
+			iproto_reply_error(out,
+					   diag_last_error(&fiber()->diag),
+					   msg->header.sync);
+		} else {
+			iproto_reply_select(out, &svp, msg->header.sync,
+					    msg->tuple != NULL);
+		}
+		if (msg->tuple != NULL)
+			box_tuple_unref(msg->tuple);
+	}
+	batch->write_end = obuf_create_svp(out);
+}
+
+/**
+ * Write the tuples of a SELECT reply. Big tuples aren't copied
+ * to the output buffer: the reply refers to them, and the
+ * network thread writes them to the client in place, see
+ * iproto_flush_advance(). The last tuple is always copied, so
+ * that a reply ends in the output buffer.
+ * @param[out] ref_size the size of the referenced tuples
+ */
+static int
+tx_dump_port(struct iproto_msg *msg, struct port *port, struct obuf *out,
+	     size_t *ref_size)
+{
+	*ref_size = 0;
+	for (struct port_entry *e = port->first; e != NULL; e = e->next) {
+		struct tuple *tuple = e->tuple;
+		if (tuple->bsize < IPROTO_REF_MIN || e->next == NULL ||
+		    tuple->refs >= TUPLE_REF_MAX) {
+			if (tuple_to_obuf(tuple, out) != 0)
+				return -1;
+			continue;
+		}
+		struct iproto_tuple_ref *ref = (struct iproto_tuple_ref *)
+			mempool_alloc(&iproto_tuple_ref_pool);
+		if (ref == NULL) {
+			diag_set(OutOfMemory, sizeof(*ref), "mempool",
+				 "struct iproto_tuple_ref");
+			return -1;
+		}
+		tuple_ref(tuple);
+		ref->tuple = tuple;
+		ref->base.svp = obuf_create_svp(out);
+		ref->base.data = tuple->data;
+		ref->base.size = tuple->bsize;
+		stailq_add_tail_entry(&msg->refs, &ref->base, in_iobuf);
+		*ref_size += tuple->bsize;
+	}
+	return 0;
+}
+
+static void
+tx_process_select(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct obuf *out = &msg->iobuf->out;
 	struct obuf_svp svp;
 	struct port port;
+	size_t ref_size;
 	int rc;
 	struct request *req = &msg->request;
 
-	tx_fiber_init(msg->connection->session, msg->header.sync);
+	tx_fiber_init(msg);
 
 	if (tx_check_schema(msg->header.schema_id))
 		goto error;
@@ -800,8 +1625,173 @@ tx_process_select(struct cmsg *m)
 		port_destroy(&port);
 		goto error;
 	}
-	port_dump(&port, out);
-	iproto_reply_select(out, &svp, msg->header.sync, port.size);
+	if (tx_dump_port(msg, &port, out, &ref_size) != 0) {
+		tx_release_refs(&msg->refs);
+		obuf_rollback_to_svp(out, &svp);
+		port_destroy(&port);
+		goto error;
+	}
+	iproto_reply_select_ref(out, &svp, msg->header.sync, port.size,
+				ref_size);
+	port_destroy(&port);
+	msg->write_end = obuf_create_svp(out);
+	return;
+error:
+	iproto_reply_error(out, diag_last_error(&fiber()->diag),
+			   msg->header.sync);
+	msg->write_end = obuf_create_svp(out);
+}
+
+/**
+ * Execute a SELECT with IPROTO_STALE_OK in the latest memtx
+ * read view. Runs in the reader thread. If there is no view yet,
+ * the index has no view or the request fails, the request is
+ * left to tx, see tx_process_stale_select().
+ */
+static void
+reader_process_select(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct request *req = &msg->request;
+	msg->has_stale_result = false;
+	struct memtx_read_view *view = memtx_read_view_acquire();
+	if (view == NULL)
+		return;
+	try {
+		msg->has_stale_result =
+			memtx_read_view_select(view, req->space_id,
+					       req->index_id, req->iterator,
+					       req->offset, req->limit,
+					       req->key, &msg->stale_result);
+		msg->stale_sc_version = memtx_read_view_schema_version(view);
+	} catch (Exception *e) {
+		/* tx reports the error, if it persists. */
+		diag_clear(&fiber()->diag);
+	}
+	memtx_read_view_release(view);
+}
+
+/**
+ * Pass a SELECT served by the reader thread on to tx: only the
+ * network thread may push to tx_pipe.
+ */
+static void
+net_forward_to_tx(struct cmsg *m)
+{
+	(void) m;
+}
+
+/**
+ * Write the result of a SELECT found by the reader thread, or
+ * execute the SELECT in tx if there is no result or the schema
+ * has changed since the read view was created.
+ */
+static void
+tx_process_stale_select(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct memtx_read_view_result *result = &msg->stale_result;
+	struct obuf *out = &msg->iobuf->out;
+	struct obuf_svp svp;
+
+	if (! msg->has_stale_result || msg->stale_sc_version != sc_version) {
+		if (msg->has_stale_result)
+			free(result->data);
+		return tx_process_select(m);
+	}
+
+	tx_fiber_init(msg);
+
+	if (tx_check_schema(msg->header.schema_id) ||
+	    box_check_stale_select(msg->request.space_id) != 0 ||
+	    iproto_prepare_select(out, &svp) != 0)
+		goto error;
+	if (obuf_dup(out, result->data, result->size) != result->size) {
+		obuf_rollback_to_svp(out, &svp);
+		diag_set(OutOfMemory, result->size, "obuf", "dup");
+		goto error;
+	}
+	iproto_reply_select(out, &svp, msg->header.sync, result->count);
+	free(result->data);
+	msg->write_end = obuf_create_svp(out);
+	return;
+error:
+	free(result->data);
+	iproto_reply_error(out, diag_last_error(&fiber()->diag),
+			   msg->header.sync);
+	msg->write_end = obuf_create_svp(out);
+}
+
+/**
+ * Write the found tuples of IPROTO_GET_MANY, nil for a key
+ * which is not found.
+ */
+static int
+tx_dump_get_many(struct obuf *out, struct tuple **tuples, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		if (tuples[i] != NULL) {
+			if (tuple_to_obuf(tuples[i], out) != 0)
+				return -1;
+			continue;
+		}
+		char nil = 0xc0;
+		if (obuf_dup(out, &nil, sizeof(nil)) != sizeof(nil)) {
+			diag_set(OutOfMemory, sizeof(nil), "obuf", "dup");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Process IPROTO_GET_MANY: look up all keys in one statement
+ * and reply with a tuple or nil per key, in the order of the
+ * keys, in one packet.
+ */
+static void
+tx_process_get_many(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct request *req = &msg->request;
+	struct obuf *out = &msg->iobuf->out;
+	struct obuf_svp svp;
+	struct tuple **tuples;
+	const char *keys = req->key;
+	uint32_t count = mp_decode_array(&keys);
+	int rc;
+
+	tx_fiber_init(msg);
+
+	if (tx_check_schema(msg->header.schema_id))
+		goto error;
+
+	tuples = (struct tuple **) malloc((count + 1) * sizeof(*tuples));
+	if (tuples == NULL) {
+		diag_set(OutOfMemory, (count + 1) * sizeof(*tuples),
+			 "malloc", "tuples");
+		goto error;
+	}
+	if (box_index_get_many(req->space_id, req->index_id, req->key,
+			       req->key_end, tuples) != 0) {
+		free(tuples);
+		goto error;
+	}
+	rc = iproto_prepare_select(out, &svp);
+	if (rc == 0) {
+		rc = tx_dump_get_many(out, tuples, count);
+		if (rc == 0)
+			iproto_reply_select(out, &svp, msg->header.sync, count);
+		else
+			obuf_rollback_to_svp(out, &svp);
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		if (tuples[i] != NULL)
+			tuple_unref(tuples[i]);
+	}
+	free(tuples);
+	if (rc != 0)
+		goto error;
 	msg->write_end = obuf_create_svp(out);
 	return;
 error:
@@ -810,13 +1800,227 @@ error:
 	msg->write_end = obuf_create_svp(out);
 }
 
+/* {{{ server-side cursors */
+
+/**
+ * A cursor opened with IPROTO_OPEN on an index iterator.
+ * The rows are returned in chunks, each chunk is requested by
+ * the client with IPROTO_FETCH, so a client reading a big
+ * result set never has more than a chunk in flight and the
+ * server never materializes the result set.
+ *
+ * Like the iterators of index:pairs(), the cursor is "dirty":
+ * it sees the changes made while it's open and stops at the
+ * first schema change of the index.
+ */
+struct iproto_cursor
+{
+	/** Link in iproto_connection::cursors. */
+	struct rlist in_connection;
+	uint32_t id;
+	box_iterator_t *it;
+	/** The number of rows left to skip. */
+	uint32_t offset;
+	/** The number of rows left to return. */
+	uint32_t limit;
+	/** A FETCH is in progress, it may yield in vinyl. */
+	bool is_busy;
+	/** The search key, the iterator refers to it. */
+	char key[0];
+};
+
+static struct iproto_cursor *
+tx_cursor_open(struct iproto_connection *con, struct request *req)
+{
+	if (con->cursor_count >= IPROTO_CURSORS_MAX) {
+		diag_set(ClientError, ER_ILLEGAL_PARAMS,
+			 "too many open cursors");
+		return NULL;
+	}
+	size_t key_size = req->key_end - req->key;
+	struct iproto_cursor *cursor = (struct iproto_cursor *)
+		malloc(sizeof(*cursor) + key_size);
+	if (cursor == NULL) {
+		diag_set(OutOfMemory, sizeof(*cursor) + key_size,
+			 "malloc", "struct iproto_cursor");
+		return NULL;
+	}
+	/* The request is discarded as soon as it's answered. */
+	memcpy(cursor->key, req->key, key_size);
+	cursor->it = box_index_iterator(req->space_id, req->index_id,
+					req->iterator, cursor->key,
+					cursor->key + key_size);
+	if (cursor->it == NULL) {
+		free(cursor);
+		return NULL;
+	}
+	if (++con->last_cursor_id == 0)
+		++con->last_cursor_id;
+	cursor->id = con->last_cursor_id;
+	cursor->offset = req->offset;
+	cursor->limit = req->limit;
+	cursor->is_busy = false;
+	rlist_add_tail_entry(&con->cursors, cursor, in_connection);
+	con->cursor_count++;
+	return cursor;
+}
+
+static void
+tx_cursor_close(struct iproto_connection *con, struct iproto_cursor *cursor)
+{
+	assert(!cursor->is_busy);
+	rlist_del_entry(cursor, in_connection);
+	con->cursor_count--;
+	box_iterator_free(cursor->it);
+	free(cursor);
+}
+
+static void
+tx_close_cursors(struct iproto_connection *con)
+{
+	struct iproto_cursor *cursor, *tmp;
+	rlist_foreach_entry_safe(cursor, &con->cursors, in_connection, tmp)
+		tx_cursor_close(con, cursor);
+}
+
+static struct iproto_cursor *
+tx_cursor_find(struct iproto_connection *con, uint32_t id)
+{
+	struct iproto_cursor *cursor;
+	rlist_foreach_entry(cursor, &con->cursors, in_connection) {
+		if (cursor->id != id)
+			continue;
+		if (cursor->is_busy) {
+			diag_set(ClientError, ER_ILLEGAL_PARAMS,
+				 "cursor is busy");
+			return NULL;
+		}
+		return cursor;
+	}
+	diag_set(ClientError, ER_ILLEGAL_PARAMS, "no such cursor");
+	return NULL;
+}
+
+/**
+ * Add up to @a chunk_size next rows of the cursor to @a port.
+ * @param[out] is_eof set if the cursor has no more rows
+ */
+static int
+tx_cursor_fetch(struct iproto_cursor *cursor, uint32_t chunk_size,
+		struct port *port, bool *is_eof)
+{
+	int rc = 0;
+	cursor->is_busy = true;
+	while (cursor->limit > 0 && port->size < chunk_size) {
+		struct tuple *tuple;
+		if (box_iterator_next(cursor->it, &tuple) != 0) {
+			rc = -1;
+			break;
+		}
+		if (tuple == NULL)
+			break;
+		if (cursor->offset > 0) {
+			cursor->offset--;
+			continue;
+		}
+		try {
+			port_add_tuple(port, tuple);
+		} catch (Exception *e) {
+			rc = -1;
+			break;
+		}
+		cursor->limit--;
+	}
+	cursor->is_busy = false;
+	/* Save the client a FETCH returning nothing. */
+	*is_eof = cursor->limit == 0 || port->size < chunk_size;
+	return rc;
+}
+
+/**
+ * Process IPROTO_OPEN, IPROTO_FETCH and IPROTO_CLOSE. OPEN and
+ * FETCH reply with a chunk of rows and the id of the cursor,
+ * or 0 if the cursor is exhausted and closed.
+ */
+static void
+tx_process_cursor(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_connection *con = msg->connection;
+	struct request *req = &msg->request;
+	struct obuf *out = &msg->iobuf->out;
+	struct iproto_cursor *cursor;
+	struct obuf_svp svp;
+	struct port port;
+	size_t ref_size;
+	bool is_eof;
+	uint32_t chunk_size = req->chunk_size != 0 ?
+			      req->chunk_size : IPROTO_CHUNK_SIZE_DEFAULT;
+
+	tx_fiber_init(msg);
+
+	if (tx_check_schema(msg->header.schema_id))
+		goto error;
+
+	switch (msg->header.type) {
+	case IPROTO_OPEN:
+		rmean_collect(rmean_box, IPROTO_SELECT, 1);
+		cursor = tx_cursor_open(con, req);
+		break;
+	case IPROTO_FETCH:
+		cursor = tx_cursor_find(con, req->cursor_id);
+		break;
+	case IPROTO_CLOSE:
+		cursor = tx_cursor_find(con, req->cursor_id);
+		if (cursor == NULL)
+			goto error;
+		tx_cursor_close(con, cursor);
+		iproto_reply_ok(out, msg->header.sync);
+		msg->write_end = obuf_create_svp(out);
+		return;
+	default:
+		unreachable();
+	}
+	if (cursor == NULL)
+		goto error;
+
+	port_create(&port);
+	if (tx_cursor_fetch(cursor, chunk_size, &port, &is_eof) != 0 ||
+	    iproto_prepare_cursor(out, &svp) != 0) {
+		port_destroy(&port);
+		/* The position of the cursor is lost. */
+		tx_cursor_close(con, cursor);
+		goto error;
+	}
+	if (tx_dump_port(msg, &port, out, &ref_size) != 0) {
+		tx_release_refs(&msg->refs);
+		obuf_rollback_to_svp(out, &svp);
+		port_destroy(&port);
+		tx_cursor_close(con, cursor);
+		goto error;
+	}
+	iproto_reply_cursor(out, &svp, msg->header.sync,
+			    is_eof ? 0 : cursor->id, port.size, ref_size);
+	port_destroy(&port);
+	if (is_eof)
+		tx_cursor_close(con, cursor);
+	msg->write_end = obuf_create_svp(out);
+	return;
+error:
+	iproto_reply_error(out, diag_last_error(&fiber()->diag),
+			   msg->header.sync);
+	msg->write_end = obuf_create_svp(out);
+}
+
+/* }}} */
+
 static void
 tx_process_misc(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct obuf *out = &msg->iobuf->out;
 
-	tx_fiber_init(msg->connection->session, msg->header.sync);
+	tx_fiber_init(msg);
 
 	try {
 		switch (msg->header.type) {
@@ -854,7 +2058,7 @@ tx_process_join_subscribe(struct cmsg *m)
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
 
-	tx_fiber_init(con->session, msg->header.sync);
+	tx_fiber_init(msg);
 
 	try {
 		switch (msg->header.type) {
@@ -885,14 +2089,40 @@ tx_process_join_subscribe(struct cmsg *m)
 	}
 }
 
+/**
+ * Account the latency of the stages of a request, which is
+ * executed in tx since @a tx_time and is back in the network
+ * thread at @a now. The reply is accounted when it is written,
+ * see iproto_connection_on_flush().
+ */
+static inline void
+net_account_msg(struct iproto_msg *msg, uint64_t tx_time, uint64_t now)
+{
+	struct histogram *stage_hist = net_thread->stage_hist;
+	histogram_collect(&stage_hist[IPROTO_STAGE_PARSE],
+			  (msg->parse_time - msg->read_time) / 1000);
+	histogram_collect(&stage_hist[IPROTO_STAGE_TX_QUEUE],
+			  (int64_t) (tx_time - msg->parse_time) / 1000);
+	histogram_collect(&stage_hist[IPROTO_STAGE_TX],
+			  (now - tx_time) / 1000);
+	if (msg->header.type < IPROTO_TYPE_STAT_MAX) {
+		histogram_collect(&net_thread->request_hist[msg->header.type],
+				  (now - msg->read_time) / 1000);
+	}
+	if (msg->connection->reply_time == 0)
+		msg->connection->reply_time = now;
+}
+
 static void
 net_send_msg(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
 	struct iobuf *iobuf = msg->iobuf;
+	net_account_msg(msg, msg->tx_time, clock_monotonic64());
 	/* Discard request (see iproto_enqueue_batch()) */
 	iobuf->in.rpos += msg->len;
+	stailq_concat(&iobuf->refs, &msg->refs);
 	iobuf->out.wend = msg->write_end;
 
 	if (evio_has_fd(&con->output)) {
@@ -904,6 +2134,28 @@ net_send_msg(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
+/**
+ * Free the requests of a batch and send the replies on behalf
+ * of the first one, which owns the batch.
+ */
+static void
+net_send_batch(struct cmsg *m)
+{
+	struct iproto_msg *batch = (struct iproto_msg *) m;
+	struct iproto_msg *msg, *next;
+	size_t len = 0;
+	uint64_t now = clock_monotonic64();
+	stailq_foreach_entry_safe(msg, next, &batch->batch, in_batch) {
+		len += msg->len;
+		if (msg != batch) {
+			net_account_msg(msg, batch->tx_time, now);
+			iproto_msg_delete(msg);
+		}
+	}
+	batch->len = len;
+	net_send_msg(batch);
+}
+
 static void
 net_end_join_subscribe(struct cmsg *m)
 {
@@ -917,8 +2169,10 @@ net_end_join_subscribe(struct cmsg *m)
 	assert(! ev_is_active(&con->input));
 	/*
 	 * Enqueue any messages if they are in the readahead
-	 * queue. Will simply start input otherwise.
+	 * queue. Will simply start input otherwise. The input
+	 * was on hold, don't count the wait as parsing.
 	 */
+	con->read_time = clock_monotonic64();
 	iproto_enqueue_batch(con, &iobuf->in);
 }
 
@@ -966,7 +2220,7 @@ net_send_greeting(struct cmsg *m)
 						 obuf_iovcnt(out));
 
 			/* Count statistics */
-			rmean_collect(rmean_net, IPROTO_SENT, nwr);
+			rmean_collect(net_thread->rmean_net, IPROTO_SENT, nwr);
 		} catch (Exception *e) {
 			e->log();
 		}
@@ -987,10 +2241,60 @@ net_send_greeting(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop connect_route[] = {
-	{ tx_process_connect, &net_pipe },
-	{ net_send_greeting, NULL },
-};
+/** Release the tuples written by a network thread. */
+static void
+tx_process_release(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	tx_release_refs(&msg->refs);
+}
+
+/** Set the routes of messages of a network thread. */
+static void
+iproto_thread_init_routes(struct iproto_thread *thread)
+{
+	struct cpipe *net_pipe = &thread->net_pipe;
+	thread->disconnect_route[0] = { tx_process_disconnect, net_pipe };
+	thread->disconnect_route[1] = { net_finish_disconnect, NULL };
+	thread->misc_route[0] = { tx_process_misc, net_pipe };
+	thread->misc_route[1] = { net_send_msg, NULL };
+	thread->select_route[0] = { tx_process_select, net_pipe };
+	thread->select_route[1] = { net_send_msg, NULL };
+	thread->process1_route[0] = { tx_process1, net_pipe };
+	thread->process1_route[1] = { net_send_msg, NULL };
+	thread->batch_route[0] = { tx_process_batch, net_pipe };
+	thread->batch_route[1] = { net_send_batch, NULL };
+	thread->sync_route[0] = { tx_process_join_subscribe, net_pipe };
+	thread->sync_route[1] = { net_end_join_subscribe, NULL };
+	thread->connect_route[0] = { tx_process_connect, net_pipe };
+	thread->connect_route[1] = { net_send_greeting, NULL };
+	thread->release_route[0] = { tx_process_release, net_pipe };
+	thread->release_route[1] = { iproto_msg_delete, NULL };
+	thread->idle_route[0] = { tx_process_idle, net_pipe };
+	thread->idle_route[1] = { net_end_idle, NULL };
+	thread->cursor_route[0] = { tx_process_cursor, net_pipe };
+	thread->cursor_route[1] = { net_send_msg, NULL };
+	thread->get_many_route[0] = { tx_process_get_many, net_pipe };
+	thread->get_many_route[1] = { net_send_msg, NULL };
+	thread->stale_select_route[0] = { reader_process_select,
+					  &thread->net_reader_pipe };
+	thread->stale_select_route[1] = { net_forward_to_tx,
+					  &thread->tx_pipe };
+	thread->stale_select_route[2] = { tx_process_stale_select, net_pipe };
+	thread->stale_select_route[3] = { net_send_msg, NULL };
+
+	const struct cmsg_hop **dml_route = thread->dml_route;
+	dml_route[IPROTO_OK] = NULL;
+	dml_route[IPROTO_SELECT] = thread->select_route;
+	dml_route[IPROTO_INSERT] = thread->process1_route;
+	dml_route[IPROTO_REPLACE] = thread->process1_route;
+	dml_route[IPROTO_UPDATE] = thread->process1_route;
+	dml_route[IPROTO_DELETE] = thread->process1_route;
+	dml_route[IPROTO_CALL] = thread->misc_route;
+	dml_route[IPROTO_AUTH] = thread->misc_route;
+	dml_route[IPROTO_EVAL] = thread->misc_route;
+	dml_route[IPROTO_UPSERT] = thread->process1_route;
+}
 
 /** }}} */
 
@@ -1014,21 +2318,20 @@ iproto_on_accept(struct evio_service * /* service */, int fd,
 	 * use, all stored in just a few blocks of the memory pool.
 	 */
 	struct iproto_msg *msg = iproto_msg_new(con);
-	cmsg_init(msg, connect_route);
+	cmsg_init(msg, net_thread->connect_route);
 	msg->iobuf = con->iobuf[0];
 	msg->close_connection = false;
-	cpipe_push(&tx_pipe, msg);
+	cpipe_push(&net_thread->tx_pipe, msg);
 }
 
-static struct evio_service binary; /* iproto binary listener */
-
 /**
  * The network io thread main function:
  * begin serving the message bus.
  */
 static int
-net_cord_f(va_list /* ap */)
+net_cord_f(va_list ap)
 {
+	net_thread = va_arg(ap, struct iproto_thread *);
 	/* Got to be called in every thread using iobuf */
 	iobuf_init();
 	mempool_create(&iproto_msg_pool, &cord()->slabc,
@@ -1036,50 +2339,265 @@ net_cord_f(va_list /* ap */)
 	mempool_create(&iproto_connection_pool, &cord()->slabc,
 		       sizeof(struct iproto_connection));
 
-	evio_service_init(loop(), &binary, "binary",
+	evio_service_init(loop(), &net_thread->binary, "binary",
 			  iproto_on_accept, NULL);
+	if (net_thread->use_uring)
+		net_thread->uring = iproto_uring_new();
+	rlist_create(&net_thread->connections);
+	rlist_create(&net_thread->idle_connections);
+	ev_timer_init(&net_thread->idle_timer, iproto_release_idle,
+		      IPROTO_IDLE_TIMEOUT, IPROTO_IDLE_TIMEOUT);
+	net_thread->idle_timer.data = net_thread;
+	ev_timer_start(loop(), &net_thread->idle_timer);
+	/* Don't keep the event loop alive. */
+	ev_unref(loop());
 
 
 	/* Init statistics counter */
-	rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
+	net_thread->rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
 
-	if (rmean_net == NULL) {
+	if (net_thread->rmean_net == NULL) {
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
 
-	cbus_join(&net_tx_bus, &net_pipe);
+	cbus_join(&net_thread->net_tx_bus, &net_thread->net_pipe);
+	if (net_thread->use_readers) {
+		cbus_join(&net_thread->net_reader_bus,
+			  &net_thread->net_reader_pipe);
+	}
 	/*
 	 * Nothing to do in the fiber so far, the service
 	 * will take care of creating events for incoming
 	 * connections.
 	 */
 	fiber_yield();
-	if (evio_service_is_active(&binary))
-		evio_service_stop(&binary);
+	if (evio_service_is_active(&net_thread->binary))
+		evio_service_stop(&net_thread->binary);
+	if (net_thread->uring != NULL)
+		iproto_uring_delete(net_thread->uring);
+	ev_ref(loop());
+	ev_timer_stop(loop(), &net_thread->idle_timer);
+
+	rmean_delete(net_thread->rmean_net);
+	return 0;
+}
 
-	rmean_delete(rmean_net);
+/**
+ * The reader thread function: serve SELECTs with IPROTO_STALE_OK
+ * of a network thread.
+ */
+static int
+reader_cord_f(va_list ap)
+{
+	struct iproto_thread *thread = va_arg(ap, struct iproto_thread *);
+	cbus_join(&thread->net_reader_bus, &thread->reader_pipe);
+	/* The fiber pool of the cord does all the work. */
+	fiber_yield();
 	return 0;
 }
 
-/** Initialize the iproto subsystem and start network io thread */
+/**
+ * Initialize the iproto subsystem and start @a thread_count
+ * network io threads. With @a use_uring the threads write to
+ * the sockets with io_uring if the kernel supports it. With
+ * @a use_readers each network thread gets a reader thread,
+ * which serves SELECTs from memtx read views.
+ */
 void
-iproto_init()
+iproto_init(int thread_count, bool use_uring, bool use_readers)
 {
+	assert(thread_count > 0 && thread_count <= IPROTO_THREADS_MAX);
 	tx_cord = cord();
+	mempool_create(&iproto_tuple_ref_pool, &cord()->slabc,
+		       sizeof(struct iproto_tuple_ref));
+
+	for (int i = 0; i < thread_count; i++) {
+		struct iproto_thread *thread = &iproto_threads[i];
+		iproto_thread_init_routes(thread);
+		thread->use_uring = use_uring;
+		thread->use_readers = use_readers;
+		for (int j = 0; j < IPROTO_STAGE_MAX; j++)
+			histogram_create(&thread->stage_hist[j]);
+		for (int j = 0; j < IPROTO_TYPE_STAT_MAX; j++)
+			histogram_create(&thread->request_hist[j]);
+		cbus_create(&thread->net_tx_bus);
+		cpipe_create(&thread->tx_pipe);
+		cpipe_set_max_input(&thread->tx_pipe, IPROTO_MSG_MAX/2);
+		cpipe_create(&thread->net_pipe);
+		cpipe_set_max_input(&thread->net_pipe, IPROTO_MSG_MAX/2);
+		if (use_readers) {
+			cbus_create(&thread->net_reader_bus);
+			cpipe_create(&thread->reader_pipe);
+			cpipe_set_max_input(&thread->reader_pipe,
+					    IPROTO_MSG_MAX/2);
+			cpipe_create(&thread->net_reader_pipe);
+			cpipe_set_max_input(&thread->net_reader_pipe,
+					    IPROTO_MSG_MAX/2);
+		}
+
+		char name[FIBER_NAME_MAX];
+		if (i == 0)
+			snprintf(name, sizeof(name), "iproto");
+		else
+			snprintf(name, sizeof(name), "iproto%d", i);
+		if (cord_costart(&thread->cord, name, net_cord_f, thread))
+			panic("failed to initialize iproto thread");
+		if (use_readers) {
+			snprintf(name, sizeof(name), "reader%d", i);
+			if (cord_costart(&thread->reader_cord, name,
+					 reader_cord_f, thread))
+				panic("failed to initialize reader thread");
+		}
+
+		cbus_join(&thread->net_tx_bus, &thread->tx_pipe);
+		iproto_thread_count++;
+	}
+}
+
+/**
+ * Invoke @a cb for each counter of @a rmeans, summing up
+ * the counters with the same index.
+ */
+static int
+iproto_rmean_sum(struct rmean **rmeans, int count, rmean_cb cb,
+		 void *cb_ctx)
+{
+	for (size_t name = 0; name < rmeans[0]->stats_n; name++) {
+		int rps = 0;
+		int64_t total = 0;
+		for (int i = 0; i < count; i++) {
+			struct stats *stats = &rmeans[i]->stats[name];
+			rps += rmean_mean(stats->value);
+			total += stats->total;
+		}
+		int res = cb(rmeans[0]->stats[name].name, rps, total, cb_ctx);
+		if (res != 0)
+			return res;
+	}
+	return 0;
+}
+
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx)
+{
+	if (iproto_thread_count == 0)
+		return 0;
+	struct rmean *rmean_net[IPROTO_THREADS_MAX];
+	struct rmean *rmean_bus[IPROTO_THREADS_MAX];
+	for (int i = 0; i < iproto_thread_count; i++) {
+		rmean_net[i] = iproto_threads[i].rmean_net;
+		rmean_bus[i] = iproto_threads[i].net_tx_bus.stats;
+	}
+	int res = iproto_rmean_sum(rmean_net, iproto_thread_count,
+				   cb, cb_ctx);
+	if (res != 0)
+		return res;
+	return iproto_rmean_sum(rmean_bus, iproto_thread_count, cb, cb_ctx);
+}
+
+void
+iproto_stage_latency(int stage, struct histogram *hist)
+{
+	assert(stage >= 0 && stage < IPROTO_STAGE_MAX);
+	histogram_create(hist);
+	for (int i = 0; i < iproto_thread_count; i++)
+		histogram_merge(hist, &iproto_threads[i].stage_hist[stage]);
+}
 
-	cbus_create(&net_tx_bus);
-	rmean_net_tx_bus = net_tx_bus.stats;
-	cpipe_create(&tx_pipe);
-	cpipe_set_max_input(&tx_pipe, IPROTO_MSG_MAX/2);
-	cpipe_create(&net_pipe);
-	cpipe_set_max_input(&net_pipe, IPROTO_MSG_MAX/2);
+void
+iproto_request_latency(uint32_t type, struct histogram *hist)
+{
+	assert(type < IPROTO_TYPE_STAT_MAX);
+	histogram_create(hist);
+	for (int i = 0; i < iproto_thread_count; i++)
+		histogram_merge(hist, &iproto_threads[i].request_hist[type]);
+}
+
+/** Collect memory statistics of connections in a network thread. */
+struct iproto_stat_msg: public cbus_call_msg
+{
+	struct iproto_connection_stat *stat;
+	int count;
+};
 
-	static struct cord net_cord;
-	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
-		panic("failed to initialize iproto thread");
+static void
+iproto_connection_fill_stat(struct iproto_connection *con,
+			    struct iproto_connection_stat *stat)
+{
+	stat->fd = con->input.fd;
+	stat->readahead = con->readahead;
+	stat->input = ibuf_capacity(&con->iobuf[0]->in) +
+		      ibuf_capacity(&con->iobuf[1]->in);
+	/* Owned by tx, may be a bit out of date. */
+	stat->output = obuf_capacity(&con->iobuf[0]->out) +
+		       obuf_capacity(&con->iobuf[1]->out);
+}
 
-	cbus_join(&net_tx_bus, &tx_pipe);
+static int
+net_collect_stat(struct cbus_call_msg *m)
+{
+	struct iproto_stat_msg *msg = (struct iproto_stat_msg *) m;
+	struct iproto_connection *con;
+	int count = 0;
+	rlist_foreach_entry(con, &net_thread->connections, in_thread)
+		count++;
+	rlist_foreach_entry(con, &net_thread->idle_connections, in_thread)
+		count++;
+	if (count == 0)
+		return 0;
+	msg->stat = (struct iproto_connection_stat *)
+		malloc(count * sizeof(*msg->stat));
+	if (msg->stat == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*msg->stat), "malloc",
+			 "struct iproto_connection_stat");
+		return -1;
+	}
+	rlist_foreach_entry(con, &net_thread->connections, in_thread)
+		iproto_connection_fill_stat(con, &msg->stat[msg->count++]);
+	rlist_foreach_entry(con, &net_thread->idle_connections, in_thread)
+		iproto_connection_fill_stat(con, &msg->stat[msg->count++]);
+	return 0;
+}
+
+static int
+iproto_stat_msg_delete(struct cbus_call_msg *m)
+{
+	struct iproto_stat_msg *msg = (struct iproto_stat_msg *) m;
+	free(msg->stat);
+	free(msg);
+	return 0;
+}
+
+int
+iproto_connection_stat_foreach(iproto_connection_stat_cb cb, void *cb_ctx)
+{
+	for (int i = 0; i < iproto_thread_count; i++) {
+		struct iproto_stat_msg *msg = (struct iproto_stat_msg *)
+			malloc(sizeof(*msg));
+		if (msg == NULL) {
+			diag_set(OutOfMemory, sizeof(*msg), "malloc",
+				 "struct iproto_stat_msg");
+			return -1;
+		}
+		msg->stat = NULL;
+		msg->count = 0;
+		if (cbus_call(&iproto_threads[i].net_tx_bus, msg,
+			      net_collect_stat, iproto_stat_msg_delete,
+			      TIMEOUT_INFINITY) != 0) {
+			/* Otherwise it's deleted on return. */
+			if (msg->complete)
+				iproto_stat_msg_delete(msg);
+			return -1;
+		}
+		int res = 0;
+		for (int j = 0; j < msg->count && res == 0; j++)
+			res = cb(&msg->stat[j], cb_ctx);
+		iproto_stat_msg_delete(msg);
+		if (res != 0)
+			return res;
+	}
+	return 0;
 }
 
 /**
@@ -1100,6 +2618,11 @@ struct iproto_set_listen_msg: public cmsg
 	 * The uri to set.
 	 */
 	const char *uri;
+	/**
+	 * Set SO_REUSEPORT on the listening socket, so that
+	 * all network threads can listen on the same port.
+	 */
+	bool reuse_port;
 	/**
 	 * The way to tell the caller about the end of
 	 * bind.
@@ -1113,7 +2636,7 @@ struct iproto_set_listen_msg: public cmsg
 static void
 iproto_on_bind(void *arg)
 {
-	cpipe_push(&tx_pipe, (struct cmsg *) arg);
+	cpipe_push(&net_thread->tx_pipe, (struct cmsg *) arg);
 }
 
 static void
@@ -1121,14 +2644,16 @@ iproto_do_set_listen(struct cmsg *m)
 {
 	struct iproto_set_listen_msg *msg =
 		(struct iproto_set_listen_msg *) m;
+	struct evio_service *binary = &net_thread->binary;
 	try {
-		if (evio_service_is_active(&binary))
-			evio_service_stop(&binary);
+		if (evio_service_is_active(binary))
+			evio_service_stop(binary);
 
 		if (msg->uri != NULL) {
-			binary.on_bind = iproto_on_bind;
-			binary.on_bind_param = &msg->wakeup;
-			evio_service_start(&binary, msg->uri);
+			binary->on_bind = iproto_on_bind;
+			binary->on_bind_param = &msg->wakeup;
+			binary->reuse_port = msg->reuse_port;
+			evio_service_start(binary, msg->uri);
 		} else {
 			iproto_on_bind(&msg->wakeup);
 		}
@@ -1140,16 +2665,34 @@ iproto_do_set_listen(struct cmsg *m)
 
 static void
 iproto_set_listen_msg_init(struct iproto_set_listen_msg *msg,
-			    const char *uri)
+			    const char *uri, bool reuse_port)
 {
 	static cmsg_hop route[] = { { iproto_do_set_listen, NULL }, };
 	cmsg_init(msg, route);
 	msg->uri = uri;
+	msg->reuse_port = reuse_port;
 	diag_create(&msg->diag);
 
 	cmsg_notify_init(&msg->wakeup);
 }
 
+/** Change the listen uri of a network thread. */
+static void
+iproto_thread_set_listen(struct iproto_thread *thread, const char *uri,
+			 bool reuse_port)
+{
+	static struct iproto_set_listen_msg msg;
+	iproto_set_listen_msg_init(&msg, uri, reuse_port);
+
+	cpipe_push(&thread->net_pipe, &msg);
+	/** Wait for the end of bind. */
+	fiber_yield();
+	if (! diag_is_empty(&msg.diag)) {
+		diag_move(&msg.diag, &fiber()->diag);
+		diag_raise();
+	}
+}
+
 void
 iproto_set_listen(const char *uri)
 {
@@ -1161,16 +2704,44 @@ iproto_set_listen(const char *uri)
 	 * To do it, create a message which sets the new
 	 * uri, and another one, which will alert tx
 	 * thread when bind() on the new port is done.
+	 *
+	 * With several network threads, the first thread
+	 * binds to the uri with SO_REUSEPORT, then the others
+	 * bind to the same address, so the kernel spreads
+	 * incoming connections among the threads. A UNIX
+	 * socket can't be shared this way and is only
+	 * listened on by the first thread.
 	 */
-	static struct iproto_set_listen_msg msg;
-	iproto_set_listen_msg_init(&msg, uri);
-
-	cpipe_push(&net_pipe, &msg);
-	/** Wait for the end of bind. */
-	fiber_yield();
-	if (! diag_is_empty(&msg.diag)) {
-		diag_move(&msg.diag, &fiber()->diag);
-		diag_raise();
+	bool reuse_port = false;
+#if defined(SO_REUSEPORT)
+	reuse_port = iproto_thread_count > 1;
+#endif
+	try {
+		iproto_thread_set_listen(&iproto_threads[0], uri, reuse_port);
+	} catch (Exception *) {
+		/* Don't leave the other threads on the old uri. */
+		for (int i = 1; i < iproto_thread_count; i++)
+			iproto_thread_set_listen(&iproto_threads[i], NULL,
+						 false);
+		throw;
+	}
+	struct evio_service *binary = &iproto_threads[0].binary;
+	if (uri == NULL || binary->addr.sa_family == AF_UNIX)
+		reuse_port = false;
+	/*
+	 * Use the address the first thread is bound to rather
+	 * than the uri, in case the port was chosen by the
+	 * system.
+	 */
+	char bound_uri[NI_MAXHOST + NI_MAXSERV + 3];
+	if (reuse_port) {
+		snprintf(bound_uri, sizeof(bound_uri), "%s",
+			 sio_strfaddr(&binary->addr, binary->addr_len));
+	}
+	for (int i = 1; i < iproto_thread_count; i++) {
+		iproto_thread_set_listen(&iproto_threads[i],
+					 reuse_port ? bound_uri : NULL,
+					 reuse_port);
 	}
 }
 
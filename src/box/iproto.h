@@ -30,10 +30,88 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <stddef.h>
+#include "rmean.h"
+
+/** The max number of network threads, see iproto_threads. */
+enum { IPROTO_THREADS_MAX = 32 };
+
+struct histogram;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/** Stages of a request in iproto, see box.stat.latency. */
+enum iproto_stage {
+	/** From the read of the request to the end of its parsing. */
+	IPROTO_STAGE_PARSE,
+	/** Waiting in the queue of tx. */
+	IPROTO_STAGE_TX_QUEUE,
+	/** Execution in tx, WAL write included, and the way back. */
+	IPROTO_STAGE_TX,
+	/** From the reply is ready to the output is written. */
+	IPROTO_STAGE_FLUSH,
+	IPROTO_STAGE_MAX
+};
+
+extern const char *iproto_stage_strs[];
+
+/**
+ * Sum up the latency of the stage @a stage in microseconds
+ * over all network threads into @a hist. The histograms are
+ * read without locks, so the result is approximate.
+ */
+void
+iproto_stage_latency(int stage, struct histogram *hist);
+
+/**
+ * Same as iproto_stage_latency(), but for the whole time of
+ * requests of type @a type < IPROTO_TYPE_STAT_MAX, from the
+ * read of a request to its reply is passed to the socket.
+ */
 void
-iproto_init();
+iproto_request_latency(uint32_t type, struct histogram *hist);
+
+/**
+ * Iterate over network statistics (iproto and cbus),
+ * summed up over all network threads.
+ */
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx);
+
+/** Memory used by a client connection. */
+struct iproto_connection_stat {
+	/** The socket, as of box.session.fd(). */
+	int fd;
+	/** The size of the input buffer to allocate next. */
+	size_t readahead;
+	/** The memory of the input and output buffers. */
+	size_t input;
+	size_t output;
+};
+
+typedef int (*iproto_connection_stat_cb)(
+	const struct iproto_connection_stat *stat, void *cb_ctx);
+
+/**
+ * Invoke @a cb for each open connection of all network threads.
+ * Must be called in a fiber of tx, yields.
+ * @retval 0 success, or the first non-zero value returned by @a cb
+ * @retval -1 error, diag is set
+ */
+int
+iproto_connection_stat_foreach(iproto_connection_stat_cb cb, void *cb_ctx);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+
+void
+iproto_init(int thread_count, bool use_uring, bool use_readers);
 
 void
 iproto_set_listen(const char *uri);
 
+#endif /* defined(__cplusplus) */
+
 #endif
@@ -61,12 +61,12 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 		/* 0x13 */	MP_UINT, /* IPROTO_OFFSET */
 		/* 0x14 */	MP_UINT, /* IPROTO_ITERATOR */
 		/* 0x15 */	MP_UINT, /* IPROTO_INDEX_BASE */
+		/* 0x16 */	MP_UINT, /* IPROTO_CURSOR_ID */
+		/* 0x17 */	MP_UINT, /* IPROTO_CHUNK_SIZE */
+		/* 0x18 */	MP_UINT, /* IPROTO_STALE_OK */
 	/* }}} */
 
 	/* {{{ unused */
-		/* 0x16 */	MP_UINT,
-		/* 0x17 */	MP_UINT,
-		/* 0x18 */	MP_UINT,
 		/* 0x19 */	MP_UINT,
 		/* 0x1a */	MP_UINT,
 		/* 0x1b */	MP_UINT,
@@ -104,7 +104,7 @@ const char *iproto_type_strs[] =
 };
 
 #define bit(c) (1ULL<<IPROTO_##c)
-const uint64_t iproto_body_key_map[IPROTO_UPSERT + 1] = {
+const uint64_t iproto_body_key_map[IPROTO_GET_MANY + 1] = {
 	0,                                                     /* unused */
 	bit(SPACE_ID) | bit(LIMIT) | bit(KEY),                 /* SELECT */
 	bit(SPACE_ID) | bit(TUPLE),                            /* INSERT */
@@ -115,6 +115,11 @@ const uint64_t iproto_body_key_map[IPROTO_UPSERT + 1] = {
 	bit(USER_NAME)| bit(TUPLE),                            /* AUTH */
 	bit(EXPR)     | bit(TUPLE),                            /* EVAL */
 	bit(SPACE_ID) | bit(OPS) | bit(TUPLE),                 /* UPSERT */
+	0, 0, 0, 0, 0, 0,                                      /* unused */
+	bit(SPACE_ID) | bit(LIMIT) | bit(KEY),                 /* OPEN */
+	bit(CURSOR_ID),                                        /* FETCH */
+	bit(CURSOR_ID),                                        /* CLOSE */
+	bit(SPACE_ID) | bit(KEY),                              /* GET_MANY */
 };
 #undef bit
 
@@ -141,9 +146,9 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"offset",           /* 0x13 */
 	"iterator",         /* 0x14 */
 	"index_base",       /* 0x15 */
-	"",                 /* 0x16 */
-	"",                 /* 0x17 */
-	"",                 /* 0x18 */
+	"cursor id",        /* 0x16 */
+	"chunk size",       /* 0x17 */
+	"stale ok",         /* 0x18 */
 	"",                 /* 0x19 */
 	"",                 /* 0x1a */
 	"",                 /* 0x1b */
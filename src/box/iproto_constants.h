@@ -63,6 +63,11 @@ enum iproto_key {
 	IPROTO_OFFSET = 0x13,
 	IPROTO_ITERATOR = 0x14,
 	IPROTO_INDEX_BASE = 0x15,
+	/* Server-side cursors, see IPROTO_OPEN. */
+	IPROTO_CURSOR_ID = 0x16,
+	IPROTO_CHUNK_SIZE = 0x17,
+	/* SELECT may be served from a memtx read view. */
+	IPROTO_STALE_OK = 0x18,
 	/* Leave a gap between integer values and other keys */
 	IPROTO_KEY = 0x20,
 	IPROTO_TUPLE = 0x21,
@@ -87,7 +92,8 @@ enum iproto_key {
 #define IPROTO_BODY_BMAP (bit(SPACE_ID) | bit(INDEX_ID) | bit(LIMIT) |\
 			  bit(OFFSET) | bit(ITERATOR) | bit(INDEX_BASE) |\
 			  bit(KEY) | bit(TUPLE) | bit(FUNCTION_NAME) | \
-			  bit(USER_NAME) | bit(EXPR) | bit(OPS))
+			  bit(USER_NAME) | bit(EXPR) | bit(OPS) |\
+			  bit(CURSOR_ID) | bit(CHUNK_SIZE) | bit(STALE_OK))
 
 static inline bool
 xrow_header_has_key(const char *pos, const char *end)
@@ -130,6 +136,19 @@ enum iproto_type {
 	IPROTO_EVAL = 8,
 	IPROTO_UPSERT = 9,
 	IPROTO_TYPE_STAT_MAX = IPROTO_UPSERT + 1,
+	/*
+	 * Cursor command codes: OPEN takes the body of SELECT
+	 * and opens a server-side cursor on the index iterator,
+	 * FETCH returns the next chunk of rows of the cursor.
+	 */
+	IPROTO_OPEN = 16,
+	IPROTO_FETCH = 17,
+	IPROTO_CLOSE = 18,
+	/*
+	 * Multi-key GET: find a tuple by each key of an array
+	 * of full keys of a unique index.
+	 */
+	IPROTO_GET_MANY = 19,
 	/* admin command codes */
 	IPROTO_PING = 64,
 	IPROTO_JOIN = 65,
@@ -142,7 +161,10 @@ enum iproto_type {
 extern const char *iproto_type_strs[];
 /** Key names. */
 extern const char *iproto_key_strs[];
-/** A map of mandatory members of an iproto DML request. */
+/**
+ * A map of mandatory members of an iproto DML request,
+ * see iproto_type_has_simple_body().
+ */
 extern const uint64_t iproto_body_key_map[];
 
 static inline const char *
@@ -171,6 +193,18 @@ iproto_type_is_request(uint32_t type)
 	return type > IPROTO_OK && type <= IPROTO_UPSERT;
 }
 
+/**
+ * A request with a body which can be decoded with
+ * request_decode(): a DML request or one of the requests
+ * which read data in bulk.
+ */
+static inline bool
+iproto_type_has_simple_body(uint32_t type)
+{
+	return type <= IPROTO_UPSERT ||
+		(type >= IPROTO_OPEN && type <= IPROTO_GET_MANY);
+}
+
 /**
  * The request is "synchronous": no other requests
  * on this connection should be taken before this one
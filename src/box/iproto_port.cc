@@ -145,30 +145,69 @@ iproto_write_error(int fd, const struct error *e)
 
 enum { SVP_SIZE = sizeof(iproto_header_bin) + sizeof(iproto_body_bin) };
 
-int
-iproto_prepare_select(struct obuf *buf, struct obuf_svp *svp)
+/** The body of a reply to IPROTO_OPEN or IPROTO_FETCH. */
+struct PACKED iproto_cursor_body_bin {
+	uint8_t m_body;                    /* MP_MAP */
+	uint8_t k_cursor_id;               /* IPROTO_CURSOR_ID */
+	uint8_t m_cursor_id;               /* MP_UINT32 */
+	uint32_t v_cursor_id;              /* cursor id */
+	uint8_t k_data;                    /* IPROTO_DATA */
+	uint8_t m_data;                    /* MP_ARRAY */
+	uint32_t v_data_len;               /* array size */
+};
+
+static const struct iproto_cursor_body_bin iproto_cursor_body_bin = {
+	0x82, IPROTO_CURSOR_ID, 0xce, 0, IPROTO_DATA, 0xdd, 0
+};
+
+enum {
+	CURSOR_SVP_SIZE = sizeof(iproto_header_bin) +
+			  sizeof(iproto_cursor_body_bin)
+};
+
+static int
+iproto_prepare_reply(struct obuf *buf, struct obuf_svp *svp, size_t size)
 {
 	/**
 	 * Reserve memory before taking a savepoint.
 	 * This ensures that we get a contiguous chunk of memory
 	 * and the savepoint is pointing at the beginning of it.
 	 */
-	void *ptr = obuf_reserve(buf, SVP_SIZE);
+	void *ptr = obuf_reserve(buf, size);
 	if (ptr == NULL) {
-		diag_set(OutOfMemory, SVP_SIZE, "obuf", "reserve");
+		diag_set(OutOfMemory, size, "obuf", "reserve");
 		return -1;
 	}
 	*svp = obuf_create_svp(buf);
-	ptr = obuf_alloc(buf, SVP_SIZE);
+	ptr = obuf_alloc(buf, size);
 	assert(ptr !=  NULL);
 	return 0;
 }
 
+int
+iproto_prepare_select(struct obuf *buf, struct obuf_svp *svp)
+{
+	return iproto_prepare_reply(buf, svp, SVP_SIZE);
+}
+
+int
+iproto_prepare_cursor(struct obuf *buf, struct obuf_svp *svp)
+{
+	return iproto_prepare_reply(buf, svp, CURSOR_SVP_SIZE);
+}
+
 void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t count)
 {
-	uint32_t len = obuf_size(buf) - svp->used - 5;
+	iproto_reply_select_ref(buf, svp, sync, count, 0);
+}
+
+void
+iproto_reply_select_ref(struct obuf *buf, struct obuf_svp *svp,
+			uint64_t sync, uint32_t count, size_t ref_size)
+{
+	uint32_t len = obuf_size(buf) - svp->used - 5 + ref_size;
 
 	struct iproto_header_bin header = iproto_header_bin;
 	header.v_len = mp_bswap_u32(len);
@@ -182,3 +221,23 @@ iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 	memcpy(pos, &header, sizeof(header));
 	memcpy(pos + sizeof(header), &body, sizeof(body));
 }
+
+void
+iproto_reply_cursor(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
+		    uint32_t cursor_id, uint32_t count, size_t ref_size)
+{
+	uint32_t len = obuf_size(buf) - svp->used - 5 + ref_size;
+
+	struct iproto_header_bin header = iproto_header_bin;
+	header.v_len = mp_bswap_u32(len);
+	header.v_sync = mp_bswap_u64(sync);
+	header.v_schema_id = mp_bswap_u32(sc_version);
+
+	struct iproto_cursor_body_bin body = iproto_cursor_body_bin;
+	body.v_cursor_id = mp_bswap_u32(cursor_id);
+	body.v_data_len = mp_bswap_u32(count);
+
+	char *pos = (char *) obuf_svp_to_ptr(buf, svp);
+	memcpy(pos, &header, sizeof(header));
+	memcpy(pos + sizeof(header), &body, sizeof(body));
+}
@@ -30,6 +30,7 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <stddef.h>
 #include <stdint.h>
 
 #if defined(__cplusplus)
@@ -49,6 +50,29 @@ iproto_prepare_select(struct obuf *buf, struct obuf_svp *svp);
 void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t count);
+
+/**
+ * Same as iproto_reply_select(), for a reply which also has
+ * @a ref_size bytes of tuple data written to the client
+ * in place, bypassing @a buf.
+ */
+void
+iproto_reply_select_ref(struct obuf *buf, struct obuf_svp *svp,
+			uint64_t sync, uint32_t count, size_t ref_size);
+
+/** Same as iproto_prepare_select(), for iproto_reply_cursor(). */
+int
+iproto_prepare_cursor(struct obuf *buf, struct obuf_svp *svp);
+
+/**
+ * Write the header of a reply to IPROTO_OPEN or IPROTO_FETCH:
+ * a chunk of @a count rows of cursor @a cursor_id, or of
+ * a closed cursor if @a cursor_id is 0. @a ref_size is the
+ * same as in iproto_reply_select_ref(). Doesn't throw.
+ */
+void
+iproto_reply_cursor(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
+		    uint32_t cursor_id, uint32_t count, size_t ref_size);
 #if defined(__cplusplus)
 } /*  extern "C" */
 
@@ -104,6 +104,8 @@ const struct key_opts key_opts_default = {
 	/* .path                = */ { 0 },
 	/* .compression         = */ { 0 },
 	/* .compression_key     = */ 0,
+	/* .compaction          = */ { 0 },
+	/* .compaction_ratio    = */ 10,
 	/* .node_size           = */ 67108864,
 	/* .page_size           = */ 131072,
 	/* .sync                = */ 2,
@@ -116,6 +118,8 @@ const struct opt_def key_opts_reg[] = {
 	OPT_DEF("path", MP_STR, struct key_opts, path),
 	OPT_DEF("compression", MP_STR, struct key_opts, compression),
 	OPT_DEF("compression_key", MP_UINT, struct key_opts, compression_key),
+	OPT_DEF("compaction", MP_STR, struct key_opts, compaction),
+	OPT_DEF("compaction_ratio", MP_UINT, struct key_opts, compaction_ratio),
 	OPT_DEF("node_size", MP_UINT, struct key_opts, node_size),
 	OPT_DEF("page_size", MP_UINT, struct key_opts, page_size),
 	OPT_DEF("sync", MP_UINT, struct key_opts, sync),
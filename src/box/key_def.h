@@ -180,6 +180,8 @@ struct key_opts {
 	char path[PATH_MAX];
 	char compression[16];
 	uint32_t compression_key;
+	char compaction[16];
+	uint32_t compaction_ratio;
 	uint32_t node_size;
 	uint32_t page_size;
 	uint32_t sync;
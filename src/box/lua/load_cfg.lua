@@ -7,7 +7,10 @@ local private = require('box.internal')
 -- see default_cfg below
 local default_vinyl_cfg = {
     memory_limit      = 1.0, -- 1G
+    page_cache        = 0.25, -- 256M, a part of memory_limit
     threads           = 5,
+    read_threads      = 4,
+    tuple_cache       = 0.125, -- 128M, a part of memory_limit
     compact_wm        = 2,
     run_prio          = 2,
     run_age           = 0,
@@ -22,6 +25,7 @@ local default_cfg = {
     slab_alloc_minimal  = 16,
     slab_alloc_maximal  = 1024 * 1024,
     slab_alloc_factor   = 1.1,
+    memtx_build_threads = 4,
     work_dir            = nil,
     snap_dir            = ".",
     wal_dir             = ".",
@@ -32,10 +36,19 @@ local default_cfg = {
     log_level           = 5,
     io_collect_interval = nil,
     readahead           = 16320,
+    iproto_threads      = 1,
+    iproto_io_uring     = false,
+    read_view_period    = 0,        -- 0 = disabled
     snap_io_rate_limit  = nil, -- no limit
+    snap_threads        = 2,
+    snap_compression    = 'none',
     too_long_threshold  = 0.5,
+    tuple_cord_arenas   = false,
     wal_mode            = "write",
     rows_per_wal        = 500000,
+    wal_group_commit_delay = 0, -- 0 = sync every write
+    wal_group_commit_rows = 1000,
+    wal_stream_dirs     = nil,
     wal_dir_rescan_delay= 2,
     panic_on_snap_error = true,
     panic_on_wal_error  = true,
@@ -55,7 +68,10 @@ local default_cfg = {
 -- see template_cfg below
 local vinyl_template_cfg = {
     memory_limit      = 'number',
+    page_cache        = 'number',
     threads           = 'number',
+    read_threads      = 'number',
+    tuple_cache       = 'number',
     compact_wm        = 'number',
     run_prio          = 'number',
     run_age           = 'number',
@@ -71,6 +87,7 @@ local template_cfg = {
     slab_alloc_minimal  = 'number',
     slab_alloc_maximal  = 'number',
     slab_alloc_factor   = 'number',
+    memtx_build_threads = 'number',
     work_dir            = 'string',
     snap_dir            = 'string',
     wal_dir             = 'string',
@@ -81,10 +98,19 @@ local template_cfg = {
     log_level           = 'number',
     io_collect_interval = 'number',
     readahead           = 'number',
+    iproto_threads      = 'number',
+    iproto_io_uring     = 'boolean',
+    read_view_period    = 'number',
     snap_io_rate_limit  = 'number',
+    snap_threads        = 'number',
+    snap_compression    = 'string',
     too_long_threshold  = 'number',
+    tuple_cord_arenas   = 'boolean',
     wal_mode            = 'string',
     rows_per_wal        = 'number',
+    wal_group_commit_delay = 'number',
+    wal_group_commit_rows = 'number',
+    wal_stream_dirs     = 'string, table',
     wal_dir_rescan_delay= 'number',
     panic_on_snap_error = 'boolean',
     panic_on_wal_error  = 'boolean',
@@ -121,6 +147,8 @@ local dynamic_cfg = {
     readahead               = private.cfg_set_readahead,
     too_long_threshold      = private.cfg_set_too_long_threshold,
     snap_io_rate_limit      = private.cfg_set_snap_io_rate_limit,
+    snap_threads            = private.cfg_set_snap_threads,
+    snap_compression        = private.cfg_set_snap_compression,
     panic_on_wal_error      = function() end,
     read_only               = private.cfg_set_read_only,
     -- snapshot_daemon
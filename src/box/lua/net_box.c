@@ -203,18 +203,11 @@ netbox_encode_eval(lua_State *L)
 	return 0;
 }
 
-static int
-netbox_encode_select(lua_State *L)
+static void
+netbox_encode_select_body(lua_State *L, struct mpstream *stream,
+			  uint32_t map_size)
 {
-	if (lua_gettop(L) < 9)
-		return luaL_error(L, "Usage netbox.encode_select(ibuf, sync, "
-				  "schema_id, space_id, index_id, iterator, "
-				  "offset, limit, key)");
-
-	struct mpstream stream;
-	size_t svp = netbox_prepare_request(L, &stream, IPROTO_SELECT);
-
-	luamp_encode_map(cfg, &stream, 6);
+	luamp_encode_map(cfg, stream, map_size);
 
 	uint32_t space_id = lua_tointeger(L, 4);
 	uint32_t index_id = lua_tointeger(L, 5);
@@ -223,28 +216,141 @@ netbox_encode_select(lua_State *L)
 	uint32_t limit = lua_tointeger(L, 8);
 
 	/* encode space_id */
-	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
-	luamp_encode_uint(cfg, &stream, space_id);
+	luamp_encode_uint(cfg, stream, IPROTO_SPACE_ID);
+	luamp_encode_uint(cfg, stream, space_id);
 
 	/* encode index_id */
-	luamp_encode_uint(cfg, &stream, IPROTO_INDEX_ID);
-	luamp_encode_uint(cfg, &stream, index_id);
+	luamp_encode_uint(cfg, stream, IPROTO_INDEX_ID);
+	luamp_encode_uint(cfg, stream, index_id);
 
 	/* encode iterator */
-	luamp_encode_uint(cfg, &stream, IPROTO_ITERATOR);
-	luamp_encode_uint(cfg, &stream, iterator);
+	luamp_encode_uint(cfg, stream, IPROTO_ITERATOR);
+	luamp_encode_uint(cfg, stream, iterator);
 
 	/* encode offset */
-	luamp_encode_uint(cfg, &stream, IPROTO_OFFSET);
-	luamp_encode_uint(cfg, &stream, offset);
+	luamp_encode_uint(cfg, stream, IPROTO_OFFSET);
+	luamp_encode_uint(cfg, stream, offset);
 
 	/* encode limit */
-	luamp_encode_uint(cfg, &stream, IPROTO_LIMIT);
-	luamp_encode_uint(cfg, &stream, limit);
+	luamp_encode_uint(cfg, stream, IPROTO_LIMIT);
+	luamp_encode_uint(cfg, stream, limit);
 
 	/* encode key */
+	luamp_encode_uint(cfg, stream, IPROTO_KEY);
+	luamp_convert_key(L, cfg, stream, 9);
+}
+
+static int
+netbox_encode_select(lua_State *L)
+{
+	if (lua_gettop(L) < 9)
+		return luaL_error(L, "Usage netbox.encode_select(ibuf, sync, "
+				  "schema_id, space_id, index_id, iterator, "
+				  "offset, limit, key[, stale_ok])");
+
+	bool stale_ok = lua_toboolean(L, 10);
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_SELECT);
+	netbox_encode_select_body(L, &stream, stale_ok ? 7 : 6);
+
+	/* encode stale_ok */
+	if (stale_ok) {
+		luamp_encode_uint(cfg, &stream, IPROTO_STALE_OK);
+		luamp_encode_uint(cfg, &stream, 1);
+	}
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_open(lua_State *L)
+{
+	if (lua_gettop(L) < 10)
+		return luaL_error(L, "Usage netbox.encode_open(ibuf, sync, "
+				  "schema_id, space_id, index_id, iterator, "
+				  "offset, limit, key, chunk_size)");
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_OPEN);
+	netbox_encode_select_body(L, &stream, 7);
+
+	/* encode chunk_size */
+	luamp_encode_uint(cfg, &stream, IPROTO_CHUNK_SIZE);
+	luamp_encode_uint(cfg, &stream, lua_tointeger(L, 10));
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_fetch(lua_State *L)
+{
+	if (lua_gettop(L) < 5)
+		return luaL_error(L, "Usage netbox.encode_fetch(ibuf, sync, "
+				  "schema_id, cursor_id, chunk_size)");
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_FETCH);
+
+	luamp_encode_map(cfg, &stream, 2);
+	luamp_encode_uint(cfg, &stream, IPROTO_CURSOR_ID);
+	luamp_encode_uint(cfg, &stream, lua_tointeger(L, 4));
+	luamp_encode_uint(cfg, &stream, IPROTO_CHUNK_SIZE);
+	luamp_encode_uint(cfg, &stream, lua_tointeger(L, 5));
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_close(lua_State *L)
+{
+	if (lua_gettop(L) < 4)
+		return luaL_error(L, "Usage netbox.encode_close(ibuf, sync, "
+				  "schema_id, cursor_id)");
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_CLOSE);
+
+	luamp_encode_map(cfg, &stream, 1);
+	luamp_encode_uint(cfg, &stream, IPROTO_CURSOR_ID);
+	luamp_encode_uint(cfg, &stream, lua_tointeger(L, 4));
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_get_many(lua_State *L)
+{
+	if (lua_gettop(L) < 6)
+		return luaL_error(L, "Usage netbox.encode_get_many(ibuf, sync, "
+				  "schema_id, space_id, index_id, keys)");
+	luaL_checktype(L, 6, LUA_TTABLE);
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_GET_MANY);
+
+	luamp_encode_map(cfg, &stream, 3);
+
+	/* encode space_id */
+	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
+	luamp_encode_uint(cfg, &stream, lua_tointeger(L, 4));
+
+	/* encode index_id */
+	luamp_encode_uint(cfg, &stream, IPROTO_INDEX_ID);
+	luamp_encode_uint(cfg, &stream, lua_tointeger(L, 5));
+
+	/* encode keys, each like the key of select */
 	luamp_encode_uint(cfg, &stream, IPROTO_KEY);
-	luamp_convert_key(L, cfg, &stream, 9);
+	uint32_t count = lua_objlen(L, 6);
+	luamp_encode_array(cfg, &stream, count);
+	for (uint32_t i = 1; i <= count; i++) {
+		lua_rawgeti(L, 6, i);
+		luamp_convert_key(L, cfg, &stream, lua_gettop(L));
+		lua_pop(L, 1);
+	}
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -406,6 +512,10 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_call",    netbox_encode_call },
 		{ "encode_eval",    netbox_encode_eval },
 		{ "encode_select",  netbox_encode_select },
+		{ "encode_open",    netbox_encode_open },
+		{ "encode_fetch",   netbox_encode_fetch },
+		{ "encode_close",   netbox_encode_close },
+		{ "encode_get_many", netbox_encode_get_many },
 		{ "encode_insert",  netbox_encode_insert },
 		{ "encode_replace", netbox_encode_replace },
 		{ "encode_delete",  netbox_encode_delete },
@@ -22,6 +22,10 @@ local CALL              = 6
 local AUTH              = 7
 local EVAL              = 8
 local UPSERT            = 9
+local OPEN              = 16
+local FETCH             = 17
+local CLOSE             = 18
+local GET_MANY          = 19
 local PING              = 64
 local ERROR_TYPE        = 65536
 
@@ -35,6 +39,8 @@ local LIMIT             = 0x12
 local OFFSET            = 0x13
 local ITERATOR          = 0x14
 local INDEX_BASE        = 0x15
+local CURSOR_ID         = 0x16
+local CHUNK_SIZE        = 0x17
 local KEY               = 0x20
 local TUPLE             = 0x21
 local FUNCTION_NAME     = 0x22
@@ -108,6 +114,45 @@ local function one_tuple(tbl)
     return
 end
 
+local function select_args(spaceno, indexno, key, opts)
+    if opts == nil then
+        opts = {}
+    end
+    if spaceno == nil or type(spaceno) ~= 'number' then
+        box.error(box.error.NO_SUCH_SPACE, '#'..tostring(spaceno))
+    end
+
+    if indexno == nil or type(indexno) ~= 'number' then
+        box.error(box.error.NO_SUCH_INDEX, indexno, '#'..tostring(spaceno))
+    end
+
+    local limit, offset
+    if opts.limit ~= nil then
+        limit = tonumber(opts.limit)
+    else
+        limit = 0xFFFFFFFF
+    end
+    if opts.offset ~= nil then
+        offset = tonumber(opts.offset)
+    else
+        offset = 0
+    end
+    local iterator = require('box.internal').check_iterator_type(opts,
+        key == nil or (type(key) == 'table' and #key == 0))
+    return iterator, offset, limit
+end
+
+-- The max number of open cursors of a connection on the server
+local CURSORS_MAX = 64
+
+-- 0 stands for the server default
+local function cursor_chunk_size(opts)
+    if opts ~= nil and opts.chunk_size ~= nil then
+        return tonumber(opts.chunk_size)
+    end
+    return 0
+end
+
 local requests = {
     [PING]    = internal.encode_ping;
     [AUTH]    = internal.encode_auth;
@@ -119,36 +164,118 @@ local requests = {
     [UPDATE]  = internal.encode_update;
     [UPSERT]  = internal.encode_upsert;
     [SELECT]  = function(wbuf, sync, schema_id, spaceno, indexno, key, opts)
-        if opts == nil then
-            opts = {}
-        end
-        if spaceno == nil or type(spaceno) ~= 'number' then
-            box.error(box.error.NO_SUCH_SPACE, '#'..tostring(spaceno))
+        local iterator, offset, limit = select_args(spaceno, indexno, key,
+                                                    opts)
+        internal.encode_select(wbuf, sync, schema_id, spaceno, indexno,
+            iterator, offset, limit, key, opts ~= nil and opts.stale_ok)
+    end;
+    [OPEN]    = function(wbuf, sync, schema_id, spaceno, indexno, key, opts)
+        local iterator, offset, limit = select_args(spaceno, indexno, key,
+                                                    opts)
+        internal.encode_open(wbuf, sync, schema_id, spaceno, indexno,
+            iterator, offset, limit, key, cursor_chunk_size(opts))
+    end;
+    [FETCH]   = internal.encode_fetch;
+    [CLOSE]   = internal.encode_close;
+    [GET_MANY] = function(wbuf, sync, schema_id, spaceno, indexno, keys)
+        if type(keys) ~= 'table' then
+            error("Usage: space:get_many({key1, key2, ...})")
         end
+        internal.encode_get_many(wbuf, sync, schema_id, spaceno, indexno,
+            keys)
+    end;
+}
 
-        if indexno == nil or type(indexno) ~= 'number' then
-            box.error(box.error.NO_SUCH_INDEX, indexno, '#'..tostring(spaceno))
+--
+-- A server-side cursor, see space:cursor(). The rows are read
+-- in chunks of opts.chunk_size, the next chunk is requested
+-- only when the previous one is consumed.
+--
+-- A cursor dropped before it's exhausted or closed is closed
+-- by the connection, see cursor_gc(). A cursor doesn't survive
+-- a reconnect, see _cursor_request().
+--
+local cursor_methods = {
+    -- Return the next tuple or nil if there are no more rows.
+    next = function(self)
+        if self._pos > #self._chunk then
+            if self.id == 0 then
+                return nil
+            end
+            local res = self._conn:_cursor_request(self._state, FETCH, true,
+                                                   self.id, self._chunk_size)
+            if res == nil then
+                box.error(box.error.ILLEGAL_PARAMS, "no such cursor")
+            end
+            self.id = res.body[CURSOR_ID]
+            if self.id == 0 then
+                self:_closed()
+            end
+            self._chunk = res.body[DATA]
+            self._pos = 1
+            if #self._chunk == 0 then
+                return nil
+            end
         end
+        local tuple = self._chunk[self._pos]
+        self._pos = self._pos + 1
+        return tuple
+    end,
 
-        local limit, offset
-        if opts.limit ~= nil then
-            limit = tonumber(opts.limit)
-        else
-            limit = 0xFFFFFFFF
+    -- for _, tuple in cursor:pairs() do ... end
+    pairs = function(self)
+        local i = 0
+        return function()
+            local tuple = self:next()
+            if tuple ~= nil then
+                i = i + 1
+                return i, tuple
+            end
         end
-        if opts.offset ~= nil then
-            offset = tonumber(opts.offset)
-        else
-            offset = 0
+    end,
+
+    -- Close the cursor before it's exhausted.
+    close = function(self)
+        self._chunk = {}
+        if self.id ~= 0 then
+            local id = self.id
+            self.id = 0
+            self:_closed()
+            self._conn:_cursor_request(self._state, CLOSE, true, id)
         end
-        local iterator = require('box.internal').check_iterator_type(opts,
-            key == nil or (type(key) == 'table' and #key == 0))
+    end,
 
-        internal.encode_select(wbuf, sync, schema_id, spaceno, indexno,
-            iterator, offset, limit, key)
-    end;
+    -- The cursor is closed on the server, nothing to collect.
+    _closed = function(self)
+        local state = self._state
+        if state.id ~= 0 then
+            state.id = 0
+            if state.generation == self._conn._generation then
+                self._conn._cursor_count = self._conn._cursor_count - 1
+            end
+        end
+    end,
 }
 
+--
+-- The finalizer of a cursor. It can't send a request, since
+-- it may not yield, so it only queues the cursor id, and the
+-- connection closes it before the next cursor is opened.
+-- It must not refer to the cursor, or the cursor would never
+-- be collected, so the id is kept in a separate state table.
+--
+local function cursor_gc(conn, state)
+    return function()
+        if state.id ~= 0 and state.generation == conn._generation then
+            table.insert(conn._dropped_cursors,
+                         { id = state.id, generation = state.generation })
+        end
+        state.id = 0
+    end
+end
+
+local cursor_mt = { __index = cursor_methods }
+
 local function check_if_space(space)
     if type(space) == 'table' and space.id ~= nil then
         return
@@ -174,6 +301,16 @@ local function space_metatable(self)
                 return self:_select(space.id, 0, key, opts)
             end,
 
+            cursor = function(space, key, opts)
+                check_if_space(space)
+                return self:_cursor(space.id, 0, key, opts)
+            end,
+
+            get_many = function(space, keys)
+                check_if_space(space)
+                return self:_get_many(space.id, 0, keys)
+            end,
+
             delete = function(space, key)
                 check_if_space(space)
                 return self:_delete(space.id, key, 0)
@@ -220,6 +357,16 @@ local function index_metatable(self)
                 return self:_select(idx.space.id, idx.id, key, opts)
             end,
 
+            cursor = function(idx, key, opts)
+                check_if_index(idx)
+                return self:_cursor(idx.space.id, idx.id, key, opts)
+            end,
+
+            get_many = function(idx, keys)
+                check_if_index(idx)
+                return self:_get_many(idx.space.id, idx.id, keys)
+            end,
+
             get = function(idx, key)
                 check_if_index(idx)
                 local res = self:_select(idx.space.id, idx.id, key,
@@ -357,6 +504,9 @@ local remote_methods = {
         self.ch = { sync = {}, fid = {} }
         self.wait = { state = {} }
         self.timeouts = {}
+        self._generation = 0
+        self._cursor_count = 0
+        self._dropped_cursors = {}
 
         fiber.create(function() self:_connect_worker() end)
         fiber.create(function() self:_read_worker() end)
@@ -650,6 +800,11 @@ local remote_methods = {
 
                 -- on_connect
                 self:_switch_state('handshake')
+                -- the server has closed the cursors of the
+                -- previous session, see _cursor_request()
+                self._generation = self._generation + 1
+                self._cursor_count = 0
+                self._dropped_cursors = {}
                 local greetingbuf = self.s:read(GREETING_SIZE)
                 if greetingbuf == nil then
                     self:_fatal(errno.strerror())
@@ -961,8 +1116,10 @@ local remote_methods = {
         if response.body[DATA] ~= nil and reqtype ~= EVAL then
             if rawget(box, 'tuple') ~= nil then
                 for i, v in pairs(response.body[DATA]) do
-                    response.body[DATA][i] =
-                        box.tuple.new(response.body[DATA][i])
+                    -- get_many() returns null for a missing tuple
+                    if v ~= nil then
+                        response.body[DATA][i] = box.tuple.new(v)
+                    end
                 end
             end
             -- disable YAML flow output (useful for admin console)
@@ -1010,6 +1167,62 @@ local remote_methods = {
         return res.body[DATA]
     end,
 
+    _cursor = function(self, spaceno, indexno, key, opts)
+        if self._cursor_count >= CURSORS_MAX then
+            -- Find the cursors dropped without close().
+            collectgarbage('collect')
+        end
+        self:_close_dropped_cursors()
+        local res = self:_request(OPEN, true, spaceno, indexno, key, opts)
+        local state = {
+            id = res.body[CURSOR_ID],
+            generation = self._generation,
+        }
+        local cursor = setmetatable({
+            id = state.id,
+            _state = state,
+            _conn = self,
+            _chunk = res.body[DATA],
+            _pos = 1,
+            _chunk_size = cursor_chunk_size(opts),
+        }, cursor_mt)
+        if state.id ~= 0 then
+            self._cursor_count = self._cursor_count + 1
+            cursor._gc = ffi.gc(ffi.new('char[1]'), cursor_gc(self, state))
+        end
+        return cursor
+    end,
+
+    -- Close the cursors queued by cursor_gc().
+    _close_dropped_cursors = function(self)
+        local dropped = self._dropped_cursors
+        while #dropped > 0 do
+            local state = table.remove(dropped)
+            self._cursor_count = self._cursor_count - 1
+            self:_cursor_request(state, CLOSE, false, state.id)
+        end
+    end,
+
+    --
+    -- Send a request of a cursor opened in the session
+    -- state.generation, or return nil if the connection has been
+    -- reestablished since then. The server numbers cursors per
+    -- session, so the cursor id would refer to a cursor of the
+    -- new session.
+    --
+    _cursor_request = function(self, state, reqtype, raise, ...)
+        self:_wait_state(self._request_states, self.timeouts[fiber.id()])
+        if state.generation ~= self._generation then
+            return nil
+        end
+        return self:_request(reqtype, raise, ...)
+    end,
+
+    _get_many = function(self, spaceno, indexno, keys)
+        local res = self:_request(GET_MANY, true, spaceno, indexno, keys)
+        return res.body[DATA]
+    end,
+
     _insert = function(self, spaceno, tuple)
         local res = self:_request(INSERT, true, spaceno, tuple)
         return one_tuple(res.body[DATA])
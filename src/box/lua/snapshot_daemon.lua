@@ -76,6 +76,42 @@ do
         end
     end
 
+    -- remove xlogs of wal_dir or a WAL stream dir older than the snapshot
+    local function remove_old_xlogs(wal_dir, snapno)
+        local xlogs = fio.glob(fio.pathjoin(wal_dir, '*.xlog'))
+        if xlogs == nil then
+            log.error("can't read wal_dir %s: %s", wal_dir,
+                      errno.strerror())
+            return false
+        end
+
+        while #xlogs > 0 do
+            if #xlogs < 2 then
+                break
+            end
+
+            if fio.basename(xlogs[1], '.xlog') > snapno then
+                break
+            end
+
+            if fio.basename(xlogs[2], '.xlog') > snapno then
+                break
+            end
+
+
+            local rm = xlogs[1]
+            table.remove(xlogs, 1)
+            log.info("removing old xlog %s", rm)
+
+            if not fio.unlink(rm) then
+                log.error("error while removing %s: %s",
+                          rm, errno.strerror())
+                return false
+            end
+        end
+        return true
+    end
+
     -- check filesystem and current time
     local function process(self)
         local snaps = fio.glob(fio.pathjoin(box.cfg.snap_dir, '*.snap'))
@@ -102,12 +138,6 @@ do
 
         -- reload snap list after snapshot
         snaps = fio.glob(fio.pathjoin(box.cfg.snap_dir, '*.snap'))
-        local xlogs = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
-        if xlogs == nil then
-            log.error("can't read wal_dir %s: %s", box.cfg.wal_dir,
-                      errno.strerror())
-            return
-        end
 
         while #snaps > self.snapshot_count do
             local rm = snaps[1]
@@ -124,27 +154,15 @@ do
 
         local snapno = fio.basename(snaps[1], '.snap')
 
-        while #xlogs > 0 do
-            if #xlogs < 2 then
-                break
-            end
-
-            if fio.basename(xlogs[1], '.xlog') > snapno then
-                break
-            end
-
-            if fio.basename(xlogs[2], '.xlog') > snapno then
-                break
-            end
-
-
-            local rm = xlogs[1]
-            table.remove(xlogs, 1)
-            log.info("removing old xlog %s", rm)
-
-            if not fio.unlink(rm) then
-                log.error("error while removing %s: %s",
-                          rm, errno.strerror())
+        if not remove_old_xlogs(box.cfg.wal_dir, snapno) then
+            return
+        end
+        local stream_dirs = box.cfg.wal_stream_dirs
+        if type(stream_dirs) == 'string' then
+            stream_dirs = { stream_dirs }
+        end
+        for _, dir in ipairs(stream_dirs or {}) do
+            if not remove_old_xlogs(dir, snapno) then
                 return
             end
         end
@@ -33,19 +33,23 @@
 
 #include <string.h>
 #include <rmean.h>
+#include <histogram.h>
 
 #include <lua.h>
 #include <lauxlib.h>
 #include <lualib.h>
 
 #include "lua/utils.h"
+#include "box/iproto.h"
+#include "box/iproto_constants.h"
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
-/** network statistics (iproto & cbus) */
-extern struct rmean *rmean_net;
-extern struct rmean *rmean_net_tx_bus;
 extern struct rmean *rmean_tx_wal_bus;
+extern struct histogram *histogram_wal_batch;
+extern struct histogram *histogram_wal_fsync;
+extern struct histogram *histogram_wal_queue;
+extern struct histogram *histogram_wal_write;
 
 static void
 fill_stat_item(struct lua_State *L, int rps, int64_t total)
@@ -91,6 +95,37 @@ seek_stat_item(const char *name, int rps, int64_t total, void *cb_ctx)
 	return 1;
 }
 
+/**
+ * Push a table with the summary of a histogram:
+ * count, avg, max and a few percentiles.
+ */
+static void
+push_histogram(struct lua_State *L, const struct histogram *hist)
+{
+	static const int percentiles[] = {50, 90, 99};
+
+	lua_newtable(L);
+	lua_pushstring(L, "count");
+	lua_pushnumber(L, hist->count);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "avg");
+	lua_pushnumber(L, hist->count > 0 ?
+		       (double) hist->sum / hist->count : 0);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "max");
+	lua_pushnumber(L, hist->max);
+	lua_settable(L, -3);
+
+	for (unsigned i = 0; i < lengthof(percentiles); i++) {
+		lua_pushfstring(L, "p%d", percentiles[i]);
+		lua_pushnumber(L, histogram_percentile(hist,
+						       percentiles[i]));
+		lua_settable(L, -3);
+	}
+}
+
 static int
 lbox_stat_index(struct lua_State *L)
 {
@@ -114,27 +149,70 @@ static int
 lbox_stat_net_index(struct lua_State *L)
 {
 	luaL_checkstring(L, -1);
-	int res = rmean_foreach(rmean_net, seek_stat_item, L);
-	if (res)
-		return res;
-	return rmean_foreach(rmean_net_tx_bus, seek_stat_item, L);
+	return iproto_rmean_foreach(seek_stat_item, L);
 }
 
 static int
 lbox_stat_net_call(struct lua_State *L)
 {
 	lua_newtable(L);
-	rmean_foreach(rmean_net, set_stat_item, L);
-	rmean_foreach(rmean_net_tx_bus, set_stat_item, L);
+	iproto_rmean_foreach(set_stat_item, L);
+	return 1;
+}
+
+static int
+push_connection_stat(const struct iproto_connection_stat *stat, void *cb_ctx)
+{
+	struct lua_State *L = (struct lua_State *) cb_ctx;
+	lua_newtable(L);
+	lua_pushstring(L, "fd");
+	lua_pushinteger(L, stat->fd);
+	lua_settable(L, -3);
+	lua_pushstring(L, "readahead");
+	lua_pushnumber(L, stat->readahead);
+	lua_settable(L, -3);
+	lua_pushstring(L, "input");
+	lua_pushnumber(L, stat->input);
+	lua_settable(L, -3);
+	lua_pushstring(L, "output");
+	lua_pushnumber(L, stat->output);
+	lua_settable(L, -3);
+	lua_rawseti(L, -2, lua_objlen(L, -2) + 1);
+	return 0;
+}
+
+/** box.stat.net.connections(): buffer memory of each connection. */
+static int
+lbox_stat_net_connections(struct lua_State *L)
+{
+	lua_newtable(L);
+	if (iproto_connection_stat_foreach(push_connection_stat, L) != 0)
+		lbox_error(L);
 	return 1;
 }
 
 static int
 lbox_stat_wal_index(struct lua_State *L)
 {
-	luaL_checkstring(L, -1);
+	const char *name = luaL_checkstring(L, -1);
 	if (rmean_tx_wal_bus == NULL)
 		return 0;
+	if (strcmp(name, "BATCH") == 0) {
+		push_histogram(L, histogram_wal_batch);
+		return 1;
+	}
+	if (strcmp(name, "FSYNC") == 0) {
+		push_histogram(L, histogram_wal_fsync);
+		return 1;
+	}
+	if (strcmp(name, "QUEUE") == 0) {
+		push_histogram(L, histogram_wal_queue);
+		return 1;
+	}
+	if (strcmp(name, "WRITE") == 0) {
+		push_histogram(L, histogram_wal_write);
+		return 1;
+	}
 	return rmean_foreach(rmean_tx_wal_bus, seek_stat_item, L);
 }
 
@@ -142,8 +220,76 @@ static int
 lbox_stat_wal_call(struct lua_State *L)
 {
 	lua_newtable(L);
-	if (rmean_tx_wal_bus)
+	if (rmean_tx_wal_bus) {
 		rmean_foreach(rmean_tx_wal_bus, set_stat_item, L);
+		/* Rows per write (per sync in group commit mode). */
+		lua_pushstring(L, "BATCH");
+		push_histogram(L, histogram_wal_batch);
+		lua_settable(L, -3);
+		/* Sync latency in microseconds, group commit only. */
+		lua_pushstring(L, "FSYNC");
+		push_histogram(L, histogram_wal_fsync);
+		lua_settable(L, -3);
+		/* Wait for the WAL thread and write, in microseconds. */
+		lua_pushstring(L, "QUEUE");
+		push_histogram(L, histogram_wal_queue);
+		lua_settable(L, -3);
+		lua_pushstring(L, "WRITE");
+		push_histogram(L, histogram_wal_write);
+		lua_settable(L, -3);
+	}
+	return 1;
+}
+
+/**
+ * Push the latency histogram of an iproto request stage or
+ * of a request type called @a name, see iproto_stage_latency().
+ * @retval false no such stage or request type
+ */
+static bool
+push_latency(struct lua_State *L, const char *name)
+{
+	struct histogram hist;
+	for (int stage = 0; stage < IPROTO_STAGE_MAX; stage++) {
+		if (strcmp(name, iproto_stage_strs[stage]) == 0) {
+			iproto_stage_latency(stage, &hist);
+			push_histogram(L, &hist);
+			return true;
+		}
+	}
+	for (uint32_t type = IPROTO_SELECT; type < IPROTO_TYPE_STAT_MAX;
+	     type++) {
+		if (strcmp(name, iproto_type_name(type)) == 0) {
+			iproto_request_latency(type, &hist);
+			push_histogram(L, &hist);
+			return true;
+		}
+	}
+	return false;
+}
+
+static int
+lbox_stat_latency_index(struct lua_State *L)
+{
+	const char *name = luaL_checkstring(L, -1);
+	return push_latency(L, name) ? 1 : 0;
+}
+
+static int
+lbox_stat_latency_call(struct lua_State *L)
+{
+	lua_newtable(L);
+	for (int stage = 0; stage < IPROTO_STAGE_MAX; stage++) {
+		lua_pushstring(L, iproto_stage_strs[stage]);
+		push_latency(L, iproto_stage_strs[stage]);
+		lua_settable(L, -3);
+	}
+	for (uint32_t type = IPROTO_SELECT; type < IPROTO_TYPE_STAT_MAX;
+	     type++) {
+		lua_pushstring(L, iproto_type_name(type));
+		push_latency(L, iproto_type_name(type));
+		lua_settable(L, -3);
+	}
 	return 1;
 }
 
@@ -166,6 +312,12 @@ static const struct luaL_reg lbox_stat_wal_meta [] = {
 	{NULL, NULL}
 };
 
+static const struct luaL_reg lbox_stat_latency_meta [] = {
+	{"__index", lbox_stat_latency_index},
+	{"__call",  lbox_stat_latency_call},
+	{NULL, NULL}
+};
+
 
 /** Initialize box.stat package. */
 void
@@ -183,7 +335,12 @@ box_lua_stat_init(struct lua_State *L)
 	lua_pop(L, 1); /* stat module */
 
 
-	luaL_register_module(L, "box.stat.net", statlib);
+	static const struct luaL_reg statnetlib [] = {
+		{"connections", lbox_stat_net_connections},
+		{NULL, NULL}
+	};
+
+	luaL_register_module(L, "box.stat.net", statnetlib);
 
 	lua_newtable(L);
 	luaL_register(L, NULL, lbox_stat_net_meta);
@@ -196,5 +353,12 @@ box_lua_stat_init(struct lua_State *L)
 	luaL_register(L, NULL, lbox_stat_wal_meta);
 	lua_setmetatable(L, -2);
 	lua_pop(L, 1); /* stat wal module */
+
+	luaL_register_module(L, "box.stat.latency", statlib);
+
+	lua_newtable(L);
+	luaL_register(L, NULL, lbox_stat_latency_meta);
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1); /* stat latency module */
 }
 
@@ -572,46 +572,97 @@ memtx_end_build_primary_key(struct space *space, void *param)
 	handler->replace = memtx_replace_primary_key;
 }
 
-/**
- * Secondary indexes are built in bulk after all data is
- * recovered. This function enables secondary keys on a space.
- * Data dictionary spaces are an exception, they are fully
- * built right from the start.
- */
-void
-memtx_build_secondary_keys(struct space *space, void *param)
+/** True if the space is not fully built yet. */
+static inline bool
+memtx_space_is_being_built(struct space *space, MemtxEngine *engine)
 {
 	struct MemtxSpace *handler = (struct MemtxSpace *) space->handler;
-	if (handler->engine != param || space_index(space, 0) == NULL ||
-	    handler->replace == memtx_replace_all_keys)
-		return;
-
-	if (space->index_id_max > 0) {
-		MemtxIndex *pk = (MemtxIndex *) space->index[0];
-		uint32_t n_tuples = pk->size();
+	return handler->engine == engine && space_index(space, 0) != NULL &&
+	       handler->replace != memtx_replace_all_keys;
+}
 
-		if (n_tuples > 0) {
-			say_info("Building secondary indexes in space '%s'...",
-				 space_name(space));
-		}
+/** Secondary keys of all spaces to build at once. */
+struct memtx_build_ctx {
+	MemtxEngine *engine;
+	/** The keys to build, NULL when only counting them. */
+	struct index_build_task *tasks;
+	uint32_t task_count;
+};
 
-		for (uint32_t j = 1; j < space->index_count; j++)
-			index_build((MemtxIndex *) space->index[j], pk);
+static void
+memtx_collect_secondary_keys(struct space *space, void *param)
+{
+	struct memtx_build_ctx *ctx = (struct memtx_build_ctx *) param;
+	if (! memtx_space_is_being_built(space, ctx->engine))
+		return;
 
-		if (n_tuples > 0) {
-			say_info("Space '%s': done", space_name(space));
+	MemtxIndex *pk = (MemtxIndex *) space->index[0];
+	if (ctx->tasks != NULL && space->index_count > 1 && pk->size() > 0) {
+		say_info("Building secondary indexes in space '%s'...",
+			 space_name(space));
+	}
+	for (uint32_t j = 1; j < space->index_count; j++) {
+		if (ctx->tasks != NULL) {
+			struct index_build_task *task =
+				&ctx->tasks[ctx->task_count];
+			task->index = (MemtxIndex *) space->index[j];
+			task->pk = pk;
 		}
+		ctx->task_count++;
 	}
+}
+
+static void
+memtx_enable_secondary_keys(struct space *space, void *param)
+{
+	if (! memtx_space_is_being_built(space, (MemtxEngine *) param))
+		return;
+	struct MemtxSpace *handler = (struct MemtxSpace *) space->handler;
 	handler->replace = memtx_replace_all_keys;
 }
 
+/**
+ * Secondary indexes are built in bulk after all data is
+ * recovered. This function builds the secondary keys of all
+ * spaces, in parallel if possible, and enables them.
+ * Data dictionary spaces are an exception, they are fully
+ * built right from the start.
+ */
+void
+MemtxEngine::buildSecondaryKeys()
+{
+	struct memtx_build_ctx ctx;
+	ctx.engine = this;
+	ctx.tasks = NULL;
+	ctx.task_count = 0;
+	space_foreach(memtx_collect_secondary_keys, &ctx);
+
+	if (ctx.task_count > 0) {
+		ctx.tasks = (struct index_build_task *)
+			region_alloc_xc(&fiber()->gc,
+					ctx.task_count * sizeof(*ctx.tasks));
+		ctx.task_count = 0;
+		space_foreach(memtx_collect_secondary_keys, &ctx);
+
+		ev_tstamp start = ev_time();
+		index_build_parallel(ctx.tasks, ctx.task_count,
+				     m_build_threads);
+		say_info("Secondary indexes built in %.3f sec",
+			 ev_time() - start);
+	}
+	space_foreach(memtx_enable_secondary_keys, this);
+}
+
 MemtxEngine::MemtxEngine(const char *snap_dirname, bool panic_on_snap_error,
-			 bool panic_on_wal_error)
+			 bool panic_on_wal_error, int build_threads)
 	:Engine("memtx"),
 	m_checkpoint(0),
 	m_state(MEMTX_INITIALIZED),
 	m_snap_io_rate_limit(UINT64_MAX),
-	m_panic_on_wal_error(panic_on_wal_error)
+	m_snap_threads(1),
+	m_snap_compression(XLOG_COMPRESSION_NONE),
+	m_panic_on_wal_error(panic_on_wal_error),
+	m_build_threads(build_threads)
 {
 	flags = ENGINE_CAN_BE_TEMPORARY;
 	xdir_create(&m_snap_dir, snap_dirname, SNAP, &SERVER_UUID);
@@ -754,7 +805,7 @@ MemtxEngine::beginFinalRecovery()
 		 * unique keys.
 		 */
 		m_state = MEMTX_OK;
-		space_foreach(memtx_build_secondary_keys, this);
+		buildSecondaryKeys();
 	}
 }
 
@@ -770,7 +821,7 @@ MemtxEngine::endRecovery()
 	if (m_state != MEMTX_OK) {
 		assert(m_state == MEMTX_FINAL_RECOVERY);
 		m_state = MEMTX_OK;
-		space_foreach(memtx_build_secondary_keys, this);
+		buildSecondaryKeys();
 	}
 }
 
@@ -831,6 +882,37 @@ MemtxEngine::needToBuildSecondaryKey(struct space *space)
 	return handler->replace == memtx_replace_all_keys;
 }
 
+void
+MemtxEngine::buildSecondaryKey(struct space *old_space,
+			       struct space *new_space, Index *new_index)
+{
+	if (new_index->key_def->type != TREE) {
+		Engine::buildSecondaryKey(old_space, new_space, new_index);
+		return;
+	}
+	/*
+	 * Sorting all tuples at once in a few threads is much
+	 * faster than inserting them into the tree one by one.
+	 * Duplicates are found by MemtxTree::endBuild().
+	 */
+	MemtxIndex *pk = (MemtxIndex *) index_find(old_space, 0);
+	MemtxIndex *index = (MemtxIndex *) new_index;
+	struct iterator *it = pk->allocIterator();
+	IteratorGuard guard(it);
+	pk->initIterator(it, ITER_ALL, NULL, 0);
+
+	index->beginBuild();
+	index->reserve(pk->size());
+	struct tuple *tuple;
+	struct tuple_format *format = new_space->format;
+	while ((tuple = it->next(it))) {
+		tuple_validate(format, tuple);
+		index->buildNext(tuple);
+	}
+	index->prepareEndBuild(m_build_threads);
+	index->endBuild();
+}
+
 Index *
 MemtxEngine::createIndex(struct key_def *key_def)
 {
@@ -1055,69 +1137,426 @@ MemtxEngine::bootstrap()
 		recoverSnapshotRow(&row);
 }
 
-static void
-checkpoint_write_row(struct xlog *l, struct xrow_header *row,
-		     uint64_t snap_io_rate_limit)
-{
-	static uint64_t bytes;
-	ev_tstamp elapsed;
-	static ev_tstamp last = 0;
-	ev_loop *loop = loop();
+enum {
+	/**
+	 * Snapshot rows are encoded and written in batches
+	 * of about this size.
+	 */
+	CHECKPOINT_BATCH_SIZE = 1024 * 1024,
+	/** The number of batches in flight per snapshot thread. */
+	CHECKPOINT_BATCHES_PER_THREAD = 4,
+};
+
+/** A tuple to write to a snapshot. */
+struct checkpoint_row {
+	uint32_t space_id;
+	struct tuple *tuple;
+};
+
+/**
+ * A batch of snapshot rows. Batches are filled with tuples
+ * by the snapshot thread, encoded by any of the snapshot
+ * threads and written to the file in the order they were
+ * filled, so the file is the same as if it was written
+ * row by row.
+ */
+struct checkpoint_batch {
+	struct checkpoint_row *rows;
+	uint32_t row_count;
+	uint32_t row_capacity;
+	/** Total size of the tuples of the batch. */
+	size_t tuple_size;
+	/** LSN of the first row of the batch. */
+	int64_t lsn;
+	/** Encoded rows. */
+	char *buf;
+	size_t buf_used;
+	size_t buf_capacity;
+	/** The block of compressed rows, empty if not compressed. */
+	char *zbuf;
+	size_t zbuf_used;
+	size_t zbuf_capacity;
+	/** True if the batch has been encoded, successfully or not. */
+	bool is_encoded;
+	/** True if an encoder thread failed to encode the batch. */
+	bool is_failed;
+	/** Link in checkpoint_pipeline::encode_queue. */
+	struct stailq_entry in_encode;
+	/** Link in checkpoint_pipeline::write_queue or free_batches. */
+	struct stailq_entry in_write;
+};
 
-	row->tm = last;
-	row->server_id = 0;
+/**
+ * Encoding of snapshot rows is spread among several threads:
+ * the snapshot thread itself and checkpoint::snap_threads - 1
+ * encoder threads.
+ */
+struct checkpoint_pipeline {
+	struct xlog *snap;
+	uint64_t snap_io_rate_limit;
+	/** The timestamp of all snapshot rows. */
+	double tm;
+	/** Compression of the batches. */
+	enum xlog_compression compression;
+	/** Protects encode_queue, is_stopped and batch states. */
+	pthread_mutex_t mutex;
+	/** Signalled when there is a batch to encode or on stop. */
+	pthread_cond_t encode_cond;
+	/** Signalled when a batch has been encoded. */
+	pthread_cond_t write_cond;
+	/** Filled batches to encode. */
+	struct stailq encode_queue;
+	/** Set when the encoder threads must exit. */
+	bool is_stopped;
 	/**
-	 * Rows in snapshot are numbered from 1 to %rows.
-	 * This makes streaming such rows to a replica or
-	 * to recovery look similar to streaming a normal
-	 * WAL. @sa the place which skips old rows in
-	 * recovery_apply_row().
+	 * Filled batches in the order of their LSNs. Accessed
+	 * by the snapshot thread only, like free_batches.
 	 */
-	row->lsn = ++l->rows;
-	row->sync = 0; /* don't write sync to wal */
-
-	struct iovec iov[XROW_IOVMAX];
-	int iovcnt = xlog_encode_row(row, iov);
-
-	/* TODO: use writev here */
-	for (int i = 0; i < iovcnt; i++) {
-		if (fwrite(iov[i].iov_base, iov[i].iov_len, 1, l->f) != 1) {
-			say_syserror("Can't write row (%zu bytes)",
-				     iov[i].iov_len);
-			tnt_raise(SystemError, "fwrite");
+	struct stailq write_queue;
+	struct stailq free_batches;
+	struct checkpoint_batch *batches;
+	int batch_count;
+	struct cord *encoders;
+	int encoder_count;
+	/** LSN of the next row to add to a batch. */
+	int64_t next_lsn;
+	/** Bytes written since the last rate limit check. */
+	uint64_t bytes;
+	/** The time of the last rate limit check. */
+	ev_tstamp last;
+};
+
+static void
+checkpoint_batch_add(struct checkpoint_batch *batch, uint32_t space_id,
+		     struct tuple *tuple)
+{
+	if (batch->row_count == batch->row_capacity) {
+		uint32_t capacity = batch->row_capacity > 0 ?
+				    batch->row_capacity * 2 : 1024;
+		size_t size = capacity * sizeof(*batch->rows);
+		struct checkpoint_row *rows = (struct checkpoint_row *)
+			realloc(batch->rows, size);
+		if (rows == NULL)
+			tnt_raise(OutOfMemory, size, "realloc", "snapshot rows");
+		batch->rows = rows;
+		batch->row_capacity = capacity;
+	}
+	struct checkpoint_row *row = &batch->rows[batch->row_count++];
+	row->space_id = space_id;
+	row->tuple = tuple;
+	batch->tuple_size += tuple->bsize;
+}
+
+static void
+checkpoint_batch_reserve(struct checkpoint_batch *batch, size_t size)
+{
+	if (batch->buf_used + size <= batch->buf_capacity)
+		return;
+	size_t capacity = MAX(batch->buf_capacity, CHECKPOINT_BATCH_SIZE);
+	while (capacity < batch->buf_used + size)
+		capacity *= 2;
+	char *buf = (char *) realloc(batch->buf, capacity);
+	if (buf == NULL)
+		tnt_raise(OutOfMemory, capacity, "realloc", "snapshot buffer");
+	batch->buf = buf;
+	batch->buf_capacity = capacity;
+}
+
+/**
+ * Compress the encoded rows of a batch into a block, unless
+ * they don't compress well.
+ */
+static void
+checkpoint_batch_compress(struct checkpoint_batch *batch,
+			  enum xlog_compression compression)
+{
+	batch->zbuf_used = 0;
+	if (compression == XLOG_COMPRESSION_NONE || batch->buf_used == 0)
+		return;
+	size_t bound = xlog_block_bound(compression, batch->buf_used);
+	if (bound > batch->zbuf_capacity) {
+		char *zbuf = (char *) realloc(batch->zbuf, bound);
+		if (zbuf == NULL)
+			tnt_raise(OutOfMemory, bound, "realloc", "snapshot block");
+		batch->zbuf = zbuf;
+		batch->zbuf_capacity = bound;
+	}
+	ssize_t len = xlog_encode_block(compression, batch->buf,
+					batch->buf_used, batch->zbuf,
+					batch->zbuf_capacity);
+	if (len < 0)
+		diag_raise();
+	batch->zbuf_used = len;
+}
+
+/**
+ * Encode the rows of a batch into its buffer and compress
+ * them if needed.
+ */
+static void
+checkpoint_batch_encode(struct checkpoint_batch *batch, double tm,
+			enum xlog_compression compression)
+{
+	struct request_replace_body body;
+	body.m_body = 0x82; /* map of two elements. */
+	body.k_space_id = IPROTO_SPACE_ID;
+	body.m_space_id = 0xce; /* uint32 */
+	body.k_tuple = IPROTO_TUPLE;
+
+	batch->buf_used = 0;
+	for (uint32_t i = 0; i < batch->row_count; i++) {
+		struct tuple *tuple = batch->rows[i].tuple;
+		body.v_space_id = mp_bswap_u32(batch->rows[i].space_id);
+
+		struct xrow_header row;
+		memset(&row, 0, sizeof(struct xrow_header));
+		row.type = IPROTO_INSERT;
+		row.tm = tm;
+		row.server_id = 0;
+		/**
+		 * Rows in snapshot are numbered from 1 to %rows.
+		 * This makes streaming such rows to a replica or
+		 * to recovery look similar to streaming a normal
+		 * WAL. @sa the place which skips old rows in
+		 * recovery_apply_row().
+		 */
+		row.lsn = batch->lsn + i;
+		row.sync = 0; /* don't write sync to wal */
+		row.bodycnt = 2;
+		row.body[0].iov_base = &body;
+		row.body[0].iov_len = sizeof(body);
+		row.body[1].iov_base = tuple->data;
+		row.body[1].iov_len = tuple->bsize;
+
+		struct iovec iov[XROW_IOVMAX];
+		int iovcnt = xlog_encode_row(&row, iov);
+		size_t len = 0;
+		for (int j = 0; j < iovcnt; j++)
+			len += iov[j].iov_len;
+		checkpoint_batch_reserve(batch, len);
+		for (int j = 0; j < iovcnt; j++) {
+			memcpy(batch->buf + batch->buf_used, iov[j].iov_base,
+			       iov[j].iov_len);
+			batch->buf_used += iov[j].iov_len;
 		}
-		bytes += iov[i].iov_len;
+		fiber_gc();
 	}
+	checkpoint_batch_compress(batch, compression);
+}
 
-	if (l->rows % 100000 == 0)
-		say_crit("%.1fM rows written", l->rows / 1000000.);
+static void *
+checkpoint_encoder_f(void *arg)
+{
+	struct checkpoint_pipeline *p = (struct checkpoint_pipeline *) arg;
+	tt_pthread_mutex_lock(&p->mutex);
+	while (! p->is_stopped) {
+		if (stailq_empty(&p->encode_queue)) {
+			tt_pthread_cond_wait(&p->encode_cond, &p->mutex);
+			continue;
+		}
+		struct checkpoint_batch *batch =
+			stailq_shift_entry(&p->encode_queue,
+					   struct checkpoint_batch, in_encode);
+		tt_pthread_mutex_unlock(&p->mutex);
+		bool is_failed = false;
+		try {
+			checkpoint_batch_encode(batch, p->tm, p->compression);
+		} catch (Exception *e) {
+			/* cord_join() passes the error to the caller. */
+			is_failed = true;
+		}
+		tt_pthread_mutex_lock(&p->mutex);
+		batch->is_encoded = true;
+		batch->is_failed = is_failed;
+		tt_pthread_cond_signal(&p->write_cond);
+		if (is_failed)
+			break;
+	}
+	tt_pthread_mutex_unlock(&p->mutex);
+	return NULL;
+}
 
-	fiber_gc();
+static void
+checkpoint_pipeline_create(struct checkpoint_pipeline *p, struct xlog *snap,
+			   uint64_t snap_io_rate_limit,
+			   enum xlog_compression compression, int n_threads)
+{
+	memset(p, 0, sizeof(*p));
+	p->snap = snap;
+	p->snap_io_rate_limit = snap_io_rate_limit;
+	p->tm = ev_now(loop());
+	p->compression = compression;
+	tt_pthread_mutex_init(&p->mutex, NULL);
+	tt_pthread_cond_init(&p->encode_cond, NULL);
+	tt_pthread_cond_init(&p->write_cond, NULL);
+	stailq_create(&p->encode_queue);
+	stailq_create(&p->write_queue);
+	stailq_create(&p->free_batches);
+	p->next_lsn = 1;
+
+	p->batch_count = n_threads * CHECKPOINT_BATCHES_PER_THREAD;
+	p->batches = (struct checkpoint_batch *)
+		calloc(p->batch_count, sizeof(*p->batches));
+	if (p->batches == NULL) {
+		tnt_raise(OutOfMemory, p->batch_count * sizeof(*p->batches),
+			  "calloc", "snapshot batches");
+	}
+	for (int i = 0; i < p->batch_count; i++)
+		stailq_add_tail(&p->free_batches, &p->batches[i].in_write);
 
+	if (n_threads <= 1)
+		return;
+	p->encoders = (struct cord *) calloc(n_threads - 1,
+					     sizeof(*p->encoders));
+	if (p->encoders == NULL) {
+		tnt_raise(OutOfMemory, (n_threads - 1) * sizeof(*p->encoders),
+			  "calloc", "snapshot threads");
+	}
+	/* Encode the rows in this thread if no thread starts. */
+	while (p->encoder_count < n_threads - 1 &&
+	       cord_start(&p->encoders[p->encoder_count], "snapshot_encode",
+			  checkpoint_encoder_f, p) == 0)
+		p->encoder_count++;
+}
+
+/**
+ * Stop and join the encoder threads. Keeps the error of the
+ * snapshot thread, if any, or takes the first error of the
+ * encoders.
+ */
+static void
+checkpoint_pipeline_stop(struct checkpoint_pipeline *p)
+{
+	tt_pthread_mutex_lock(&p->mutex);
+	p->is_stopped = true;
+	tt_pthread_cond_broadcast(&p->encode_cond);
+	tt_pthread_mutex_unlock(&p->mutex);
+
+	struct diag diag;
+	diag_create(&diag);
+	diag_move(diag_get(), &diag);
+	for (int i = 0; i < p->encoder_count; i++) {
+		if (cord_join(&p->encoders[i]) != 0)
+			panic_syserror("failed to join a snapshot thread");
+		if (! diag_is_empty(diag_get()) && diag_is_empty(&diag))
+			diag_move(diag_get(), &diag);
+	}
+	p->encoder_count = 0;
+	diag_move(&diag, diag_get());
+	diag_destroy(&diag);
+}
+
+static void
+checkpoint_pipeline_destroy(struct checkpoint_pipeline *p)
+{
+	checkpoint_pipeline_stop(p);
+	free(p->encoders);
+	for (int i = 0; p->batches != NULL && i < p->batch_count; i++) {
+		free(p->batches[i].rows);
+		free(p->batches[i].buf);
+		free(p->batches[i].zbuf);
+	}
+	free(p->batches);
+	tt_pthread_cond_destroy(&p->write_cond);
+	tt_pthread_cond_destroy(&p->encode_cond);
+	tt_pthread_mutex_destroy(&p->mutex);
+}
+
+/** Pass a filled batch to the encoders. */
+static void
+checkpoint_pipeline_submit(struct checkpoint_pipeline *p,
+			   struct checkpoint_batch *batch)
+{
+	stailq_add_tail(&p->write_queue, &batch->in_write);
+	tt_pthread_mutex_lock(&p->mutex);
+	stailq_add_tail(&p->encode_queue, &batch->in_encode);
+	tt_pthread_cond_signal(&p->encode_cond);
+	tt_pthread_mutex_unlock(&p->mutex);
+}
+
+/**
+ * Wait until the batch is encoded, encoding other batches
+ * in this thread meanwhile.
+ */
+static void
+checkpoint_pipeline_wait(struct checkpoint_pipeline *p,
+			 struct checkpoint_batch *batch)
+{
+	tt_pthread_mutex_lock(&p->mutex);
+	while (! batch->is_encoded) {
+		if (stailq_empty(&p->encode_queue)) {
+			tt_pthread_cond_wait(&p->write_cond, &p->mutex);
+			continue;
+		}
+		struct checkpoint_batch *next =
+			stailq_shift_entry(&p->encode_queue,
+					   struct checkpoint_batch, in_encode);
+		tt_pthread_mutex_unlock(&p->mutex);
+		checkpoint_batch_encode(next, p->tm, p->compression);
+		tt_pthread_mutex_lock(&p->mutex);
+		next->is_encoded = true;
+	}
+	tt_pthread_mutex_unlock(&p->mutex);
+	if (batch->is_failed) {
+		checkpoint_pipeline_stop(p);
+		diag_raise();
+	}
+}
+
+/** Write the oldest filled batch to the snapshot file. */
+static void
+checkpoint_pipeline_write(struct checkpoint_pipeline *p)
+{
+	struct checkpoint_batch *batch =
+		stailq_shift_entry(&p->write_queue,
+				   struct checkpoint_batch, in_write);
+	checkpoint_pipeline_wait(p, batch);
+
+	struct xlog *l = p->snap;
+	const char *data = batch->buf;
+	size_t size = batch->buf_used;
+	if (batch->zbuf_used > 0) {
+		data = batch->zbuf;
+		size = batch->zbuf_used;
+	}
+	if (fwrite(data, size, 1, l->f) != 1) {
+		say_syserror("Can't write %" PRIu32 " rows (%zu bytes)",
+			     batch->row_count, size);
+		tnt_raise(SystemError, "fwrite");
+	}
+	p->bytes += size;
+	int64_t rows = l->rows + batch->row_count;
+	if (rows / 100000 != l->rows / 100000)
+		say_crit("%.1fM rows written", rows / 1000000.);
+	l->rows = rows;
+	stailq_add_tail(&p->free_batches, &batch->in_write);
+
+	uint64_t snap_io_rate_limit = p->snap_io_rate_limit;
+	ev_loop *loop = loop();
 	if (snap_io_rate_limit != UINT64_MAX) {
-		if (last == 0) {
+		if (p->last == 0) {
 			/*
 			 * Remember the time of first
 			 * write to disk.
 			 */
 			ev_now_update(loop);
-			last = ev_now(loop);
+			p->last = ev_now(loop);
 		}
 		/**
 		 * If io rate limit is set, flush the
 		 * filesystem cache, otherwise the limit is
 		 * not really enforced.
 		 */
-		if (bytes > snap_io_rate_limit)
+		if (p->bytes > snap_io_rate_limit)
 			fdatasync(fileno(l->f));
 	}
-	while (bytes > snap_io_rate_limit) {
+	while (p->bytes > snap_io_rate_limit) {
 		ev_now_update(loop);
 		/*
 		 * How much time have passed since
 		 * last write?
 		 */
-		elapsed = ev_now(loop) - last;
+		ev_tstamp elapsed = ev_now(loop) - p->last;
 		/*
 		 * If last write was in less than
 		 * a second, sleep until the
@@ -1127,32 +1566,31 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row,
 			usleep(((1 - elapsed) * 1000000));
 
 		ev_now_update(loop);
-		last = ev_now(loop);
-		bytes -= snap_io_rate_limit;
+		p->last = ev_now(loop);
+		p->bytes -= snap_io_rate_limit;
 	}
 }
 
-static void
-checkpoint_write_tuple(struct xlog *l, uint32_t n, struct tuple *tuple,
-		       uint64_t snap_io_rate_limit)
+/**
+ * Get an empty batch, writing out the oldest one if all
+ * batches are in use.
+ */
+static struct checkpoint_batch *
+checkpoint_pipeline_get(struct checkpoint_pipeline *p)
 {
-	struct request_replace_body body;
-	body.m_body = 0x82; /* map of two elements. */
-	body.k_space_id = IPROTO_SPACE_ID;
-	body.m_space_id = 0xce; /* uint32 */
-	body.v_space_id = mp_bswap_u32(n);
-	body.k_tuple = IPROTO_TUPLE;
-
-	struct xrow_header row;
-	memset(&row, 0, sizeof(struct xrow_header));
-	row.type = IPROTO_INSERT;
-
-	row.bodycnt = 2;
-	row.body[0].iov_base = &body;
-	row.body[0].iov_len = sizeof(body);
-	row.body[1].iov_base = tuple->data;
-	row.body[1].iov_len = tuple->bsize;
-	checkpoint_write_row(l, &row, snap_io_rate_limit);
+	if (stailq_empty(&p->free_batches))
+		checkpoint_pipeline_write(p);
+	struct checkpoint_batch *batch =
+		stailq_shift_entry(&p->free_batches,
+				   struct checkpoint_batch, in_write);
+	batch->row_count = 0;
+	batch->tuple_size = 0;
+	batch->lsn = p->next_lsn;
+	batch->buf_used = 0;
+	batch->zbuf_used = 0;
+	batch->is_encoded = false;
+	batch->is_failed = false;
+	return batch;
 }
 
 struct checkpoint_entry {
@@ -1168,6 +1606,9 @@ struct checkpoint {
 	 */
 	struct rlist entries;
 	uint64_t snap_io_rate_limit;
+	/** The number of threads to encode the rows in. */
+	int snap_threads;
+	enum xlog_compression snap_compression;
 	struct cord cord;
 	bool waiting_for_snap_thread;
 	/** The vclock of the snapshot file. */
@@ -1177,12 +1618,15 @@ struct checkpoint {
 
 static void
 checkpoint_init(struct checkpoint *ckpt, const char *snap_dirname,
-		uint64_t snap_io_rate_limit)
+		uint64_t snap_io_rate_limit, int snap_threads,
+		enum xlog_compression snap_compression)
 {
 	ckpt->entries = RLIST_HEAD_INITIALIZER(ckpt->entries);
 	ckpt->waiting_for_snap_thread = false;
 	xdir_create(&ckpt->dir, snap_dirname, SNAP, &SERVER_UUID);
 	ckpt->snap_io_rate_limit = snap_io_rate_limit;
+	ckpt->snap_threads = snap_threads;
+	ckpt->snap_compression = snap_compression;
 	/* May be used in abortCheckpoint() */
 	vclock_create(&ckpt->vclock);
 }
@@ -1235,16 +1679,36 @@ checkpoint_f(va_list ap)
 
 	auto guard = make_scoped_guard([=]{ xlog_close(snap); });
 
-	say_info("saving snapshot `%s'", snap->filename);
+	struct checkpoint_pipeline p;
+	checkpoint_pipeline_create(&p, snap, ckpt->snap_io_rate_limit,
+				   ckpt->snap_compression, ckpt->snap_threads);
+	auto pipeline_guard = make_scoped_guard([&]{
+		checkpoint_pipeline_destroy(&p);
+	});
+
+	say_info("saving snapshot `%s' in %d threads", snap->filename,
+		 p.encoder_count + 1);
+	struct checkpoint_batch *batch = NULL;
 	struct checkpoint_entry *entry;
 	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		uint32_t id = space_id(entry->space);
 		struct tuple *tuple;
 		struct iterator *it = entry->iterator;
 		for (tuple = it->next(it); tuple; tuple = it->next(it)) {
-			checkpoint_write_tuple(snap, space_id(entry->space),
-					       tuple, ckpt->snap_io_rate_limit);
+			if (batch == NULL)
+				batch = checkpoint_pipeline_get(&p);
+			checkpoint_batch_add(batch, id, tuple);
+			p.next_lsn++;
+			if (batch->tuple_size >= CHECKPOINT_BATCH_SIZE) {
+				checkpoint_pipeline_submit(&p, batch);
+				batch = NULL;
+			}
 		}
 	}
+	if (batch != NULL)
+		checkpoint_pipeline_submit(&p, batch);
+	while (! stailq_empty(&p.write_queue))
+		checkpoint_pipeline_write(&p);
 	say_info("done");
 	return 0;
 }
@@ -1256,7 +1720,8 @@ MemtxEngine::beginCheckpoint()
 
 	m_checkpoint = region_alloc_object_xc(&fiber()->gc, struct checkpoint);
 
-	checkpoint_init(m_checkpoint, m_snap_dir.dirname, m_snap_io_rate_limit);
+	checkpoint_init(m_checkpoint, m_snap_dir.dirname, m_snap_io_rate_limit,
+			m_snap_threads, m_snap_compression);
 	space_foreach(checkpoint_add_space, m_checkpoint);
 
 	/* increment snapshot version; set tuple deletion to delayed mode */
@@ -40,12 +40,15 @@ enum memtx_recovery_state {
 	MEMTX_OK,
 };
 
+/** The max number of snapshot threads, see snap_threads. */
+enum { SNAP_THREADS_MAX = 32 };
+
 /** Memtx extents pool, available to statistics. */
 extern struct mempool memtx_index_extent_pool;
 
 struct MemtxEngine: public Engine {
 	MemtxEngine(const char *snap_dirname, bool panic_on_snap_error,
-					      bool panic_on_wal_error);
+		    bool panic_on_wal_error, int build_threads);
 	~MemtxEngine();
 	virtual Handler *open() override;
 	virtual Index *createIndex(struct key_def *key_def) override;
@@ -53,6 +56,9 @@ struct MemtxEngine: public Engine {
 	virtual void dropIndex(Index *index) override;
 	virtual void dropPrimaryKey(struct space *space) override;
 	virtual bool needToBuildSecondaryKey(struct space *space) override;
+	virtual void buildSecondaryKey(struct space *old_space,
+				       struct space *new_space,
+				       Index *new_index) override;
 	virtual void keydefCheck(struct space *space, struct key_def *key_def) override;
 	virtual void begin(struct txn *txn) override;
 	virtual void rollbackStatement(struct txn *,
@@ -77,6 +83,16 @@ struct MemtxEngine: public Engine {
 		if (m_snap_io_rate_limit == 0)
 			m_snap_io_rate_limit = UINT64_MAX;
 	}
+	/* Update snap_threads. */
+	void setSnapThreads(int snap_threads)
+	{
+		m_snap_threads = snap_threads;
+	}
+	/* Update snap_compression. */
+	void setSnapCompression(enum xlog_compression snap_compression)
+	{
+		m_snap_compression = snap_compression;
+	}
 	/**
 	 * Return LSN of the most recent snapshot or -1 if there is
 	 * no snapshot.
@@ -85,6 +101,8 @@ struct MemtxEngine: public Engine {
 private:
 	void
 	recoverSnapshotRow(struct xrow_header *row);
+	void
+	buildSecondaryKeys();
 	/** Non-zero if there is a checkpoint (snapshot) in progress. */
 	struct checkpoint *m_checkpoint;
 	enum memtx_recovery_state m_state;
@@ -92,9 +110,19 @@ private:
 	struct xdir m_snap_dir;
 	/** Limit disk usage of checkpointing (bytes per second). */
 	uint64_t m_snap_io_rate_limit;
+	/** The number of threads to write a snapshot in. */
+	int m_snap_threads;
+	/** Compression of new snapshots. */
+	enum xlog_compression m_snap_compression;
 	struct vclock m_last_checkpoint;
 	bool m_has_checkpoint;
 	bool m_panic_on_wal_error;
+	/**
+	 * The number of threads to build secondary keys
+	 * at the end of recovery or to sort the tuples of
+	 * a new tree index.
+	 */
+	int m_build_threads;
 };
 
 enum {
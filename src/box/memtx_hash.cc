@@ -35,6 +35,7 @@
 #include "space.h"
 #include "schema.h" /* space_cache_find() */
 #include "errinj.h"
+#include "scoped_guard.h"
 
 #include "third_party/PMurHash.h"
 
@@ -211,7 +212,8 @@ hash_iterator_eq(struct iterator *it)
 /* {{{ MemtxHash -- implementation of all hashes. **********************/
 
 MemtxHash::MemtxHash(struct key_def *key_def)
-	: MemtxIndex(key_def)
+	: MemtxIndex(key_def), build_array(NULL), build_hashes(NULL),
+	  build_array_size(0), build_array_alloc_size(0)
 {
 	memtx_index_arena_init();
 	hash_table = (struct light_index_core *) malloc(sizeof(*hash_table));
@@ -228,12 +230,68 @@ MemtxHash::~MemtxHash()
 {
 	light_index_destroy(hash_table);
 	free(hash_table);
+	free(build_array);
+	free(build_hashes);
 }
 
 void
 MemtxHash::reserve(uint32_t size_hint)
 {
-	(void)size_hint;
+	if (size_hint < build_array_alloc_size)
+		return;
+	struct tuple **array = (struct tuple **)
+		realloc(build_array, size_hint * sizeof(struct tuple *));
+	if (array == NULL) {
+		tnt_raise(OutOfMemory, size_hint * sizeof(struct tuple *),
+			  "MemtxHash", "build_array");
+	}
+	build_array = array;
+	build_array_alloc_size = size_hint;
+}
+
+void
+MemtxHash::buildNext(struct tuple *tuple)
+{
+	if (build_array_size == build_array_alloc_size) {
+		reserve(build_array_alloc_size > 0 ?
+			build_array_alloc_size + build_array_alloc_size / 2 :
+			HASH_INDEX_EXTENT_SIZE / sizeof(struct tuple *));
+	}
+	build_array[build_array_size++] = tuple;
+}
+
+void
+MemtxHash::prepareEndBuild(int /* n_threads */)
+{
+	if (build_array_size == 0)
+		return;
+	free(build_hashes);
+	build_hashes = (uint32_t *) malloc(build_array_size * sizeof(uint32_t));
+	if (build_hashes == NULL) {
+		tnt_raise(OutOfMemory, build_array_size * sizeof(uint32_t),
+			  "MemtxHash", "build_hashes");
+	}
+	for (size_t i = 0; i < build_array_size; i++)
+		build_hashes[i] = tuple_hash(build_array[i], key_def);
+}
+
+void
+MemtxHash::endBuild()
+{
+	auto guard = make_scoped_guard([=]{
+		free(build_array);
+		free(build_hashes);
+		build_array = NULL;
+		build_hashes = NULL;
+		build_array_size = 0;
+		build_array_alloc_size = 0;
+	});
+	if (build_hashes == NULL)
+		prepareEndBuild(1);
+	for (size_t i = 0; i < build_array_size; i++) {
+		replaceWithHash(NULL, build_array[i], build_hashes[i],
+				DUP_INSERT);
+	}
 }
 
 size_t
@@ -278,15 +336,22 @@ MemtxHash::findByKey(const char *key, uint32_t part_count) const
 struct tuple *
 MemtxHash::replace(struct tuple *old_tuple, struct tuple *new_tuple,
 		   enum dup_replace_mode mode)
+{
+	uint32_t h = new_tuple ? tuple_hash(new_tuple, key_def) : 0;
+	return replaceWithHash(old_tuple, new_tuple, h, mode);
+}
+
+struct tuple *
+MemtxHash::replaceWithHash(struct tuple *old_tuple, struct tuple *new_tuple,
+			   uint32_t new_hash, enum dup_replace_mode mode)
 {
 	uint32_t errcode;
 
 	if (new_tuple) {
-		uint32_t h = tuple_hash(new_tuple, key_def);
 		struct tuple *dup_tuple = NULL;
-		hash_t pos = light_index_replace(hash_table, h, new_tuple, &dup_tuple);
+		hash_t pos = light_index_replace(hash_table, new_hash, new_tuple, &dup_tuple);
 		if (pos == light_index_end)
-			pos = light_index_insert(hash_table, h, new_tuple);
+			pos = light_index_insert(hash_table, new_hash, new_tuple);
 
 		ERROR_INJECT(ERRINJ_INDEX_ALLOC,
 		{
@@ -303,7 +368,7 @@ MemtxHash::replace(struct tuple *old_tuple, struct tuple *new_tuple,
 		if (errcode) {
 			light_index_delete(hash_table, pos);
 			if (dup_tuple) {
-				uint32_t pos = light_index_insert(hash_table, h, dup_tuple);
+				uint32_t pos = light_index_insert(hash_table, new_hash, dup_tuple);
 				if (pos == light_index_end) {
 					panic("Failed to allocate memory in "
 					      "recover of int hash_table");
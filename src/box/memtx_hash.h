@@ -41,6 +41,9 @@ public:
 	virtual ~MemtxHash() override;
 
 	virtual void reserve(uint32_t size_hint) override;
+	virtual void buildNext(struct tuple *tuple) override;
+	virtual void prepareEndBuild(int n_threads) override;
+	virtual void endBuild() override;
 	virtual size_t size() const override;
 	virtual struct tuple *random(uint32_t rnd) const override;
 	virtual struct tuple *findByKey(const char *key,
@@ -69,7 +72,17 @@ public:
 	virtual size_t bsize() const override;
 
 protected:
+	struct tuple *replaceWithHash(struct tuple *old_tuple,
+				      struct tuple *new_tuple,
+				      uint32_t new_hash,
+				      enum dup_replace_mode mode);
+
 	struct light_index_core *hash_table;
+	/** Tuples added with buildNext(), inserted in endBuild(). */
+	struct tuple **build_array;
+	/** Hashes of build_array tuples, set in prepareEndBuild(). */
+	uint32_t *build_hashes;
+	size_t build_array_size, build_array_alloc_size;
 };
 
 #endif /* TARANTOOL_BOX_MEMTX_HASH_H_INCLUDED */
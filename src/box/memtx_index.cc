@@ -36,6 +36,10 @@
 #include "schema.h"
 #include "user_def.h"
 #include "space.h"
+#include "fiber.h"
+#include "scoped_guard.h"
+
+#include <third_party/pmatomic.h>
 
 void
 MemtxIndex::beginBuild()
@@ -51,6 +55,10 @@ MemtxIndex::buildNext(struct tuple *tuple)
 	replace(NULL, tuple, DUP_INSERT);
 }
 
+void
+MemtxIndex::prepareEndBuild(int /* n_threads */)
+{}
+
 void
 MemtxIndex::endBuild()
 {}
@@ -86,8 +94,13 @@ MemtxIndex::count(enum iterator_type type, const char *key,
 	return count;
 }
 
-void
-index_build(MemtxIndex *index, MemtxIndex *pk)
+/**
+ * Add all tuples of the primary key to the index and do the
+ * preparatory part of endBuild().
+ */
+static void
+index_build_prepare(MemtxIndex *index, MemtxIndex *pk, struct iterator *it,
+		    int n_threads)
 {
 	uint32_t n_tuples = pk->size();
 	uint32_t estimated_tuples = n_tuples * 1.2;
@@ -101,11 +114,162 @@ index_build(MemtxIndex *index, MemtxIndex *pk)
 			 index_name(index));
 	}
 
-	struct iterator *it = pk->position();
 	pk->initIterator(it, ITER_ALL, NULL, 0);
 	struct tuple *tuple;
 	while ((tuple = it->next(it)))
 		index->buildNext(tuple);
 
+	index->prepareEndBuild(n_threads);
+}
+
+void
+index_build(MemtxIndex *index, MemtxIndex *pk, int n_threads)
+{
+	index_build_prepare(index, pk, pk->position(), n_threads);
 	index->endBuild();
 }
+
+/**
+ * True if beginBuild() ... prepareEndBuild() of the index
+ * don't use the index memory allocator and can be run in a
+ * worker thread: TREE and HASH only fill a malloc()ed array
+ * of tuples.
+ */
+static inline bool
+index_build_is_thread_safe(MemtxIndex *index)
+{
+	return index->key_def->type == TREE || index->key_def->type == HASH;
+}
+
+/** The state shared by all threads of a parallel build. */
+struct index_build_pool {
+	struct index_build_task *tasks;
+	uint32_t task_count;
+	/** The next task to take by a worker. */
+	uint32_t next_task;
+	/** The number of threads to sort the tuples of a task in. */
+	int sort_threads;
+};
+
+static void *
+index_build_worker(void *arg)
+{
+	struct index_build_pool *pool = (struct index_build_pool *) arg;
+	try {
+		uint32_t i;
+		while ((i = pm_atomic_fetch_add(&pool->next_task, 1)) <
+		       pool->task_count) {
+			struct index_build_task *task = &pool->tasks[i];
+			if (! index_build_is_thread_safe(task->index))
+				continue;
+			index_build_prepare(task->index, task->pk, task->it,
+					    pool->sort_threads);
+		}
+	} catch (Exception *e) {
+		/* cord_join() passes the error to the caller. */
+	}
+	return NULL;
+}
+
+void
+index_build_parallel(struct index_build_task *tasks, uint32_t task_count,
+		     int n_threads)
+{
+	uint32_t parallel_count = 0;
+	for (uint32_t i = 0; i < task_count; i++) {
+		tasks[i].it = NULL;
+		if (index_build_is_thread_safe(tasks[i].index))
+			parallel_count++;
+	}
+	int sort_threads = parallel_count > 0 ?
+			   MAX(n_threads / (int) parallel_count, 1) : 1;
+	if (n_threads > (int) parallel_count)
+		n_threads = parallel_count;
+	if (n_threads <= 1) {
+		for (uint32_t i = 0; i < task_count; i++) {
+			index_build(tasks[i].index, tasks[i].pk,
+				    sort_threads);
+		}
+		return;
+	}
+
+	auto it_guard = make_scoped_guard([=]{
+		for (uint32_t i = 0; i < task_count; i++) {
+			if (tasks[i].it != NULL)
+				tasks[i].it->free(tasks[i].it);
+		}
+	});
+	/*
+	 * Each thread needs its own iterator over the primary
+	 * key, pk->position() is shared.
+	 */
+	for (uint32_t i = 0; i < task_count; i++) {
+		if (index_build_is_thread_safe(tasks[i].index))
+			tasks[i].it = tasks[i].pk->allocIterator();
+	}
+
+	struct index_build_pool pool;
+	pool.tasks = tasks;
+	pool.task_count = task_count;
+	pool.next_task = 0;
+	pool.sort_threads = sort_threads;
+
+	struct cord *workers = (struct cord *)
+		calloc(n_threads, sizeof(*workers));
+	if (workers == NULL) {
+		tnt_raise(OutOfMemory, n_threads * sizeof(*workers),
+			  "calloc", "index build workers");
+	}
+	auto workers_guard = make_scoped_guard([=]{ free(workers); });
+	int n_workers = 0;
+	while (n_workers < n_threads &&
+	       cord_start(&workers[n_workers], "index_build",
+			  index_build_worker, &pool) == 0)
+		n_workers++;
+
+	say_info("Building %" PRIu32 " indexes in %d threads ...",
+		 task_count, n_workers > 0 ? n_workers : 1);
+
+	struct diag diag;
+	diag_create(&diag);
+	auto diag_guard = make_scoped_guard([&]{ diag_destroy(&diag); });
+	/*
+	 * Indexes which can't be built in a worker are built
+	 * here while the workers are busy.
+	 */
+	try {
+		for (uint32_t i = 0; i < task_count; i++) {
+			struct index_build_task *task = &tasks[i];
+			if (! index_build_is_thread_safe(task->index))
+				index_build(task->index, task->pk, 1);
+		}
+	} catch (Exception *e) {
+		diag_move(diag_get(), &diag);
+	}
+	/* No thread has started, do their work in this one. */
+	if (n_workers == 0) {
+		index_build_worker(&pool);
+		if (! diag_is_empty(diag_get()) && diag_is_empty(&diag))
+			diag_move(diag_get(), &diag);
+	}
+	for (int i = 0; i < n_workers; i++) {
+		/*
+		 * Use a blocking join: other fibers of this
+		 * thread must not run and change the data
+		 * while the workers read it.
+		 */
+		if (cord_join(&workers[i]) != 0)
+			panic_syserror("failed to join an index build thread");
+		if (! diag_is_empty(diag_get()) && diag_is_empty(&diag))
+			diag_move(diag_get(), &diag);
+	}
+	if (! diag_is_empty(&diag)) {
+		diag_move(&diag, diag_get());
+		diag_raise();
+	}
+	/* Populate the indexes with the collected tuples. */
+	for (uint32_t i = 0; i < task_count; i++) {
+		if (index_build_is_thread_safe(tasks[i].index))
+			tasks[i].index->endBuild();
+	}
+}
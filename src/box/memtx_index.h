@@ -66,6 +66,16 @@ public:
 	 */
 	virtual void reserve(uint32_t /* size_hint */);
 	virtual void buildNext(struct tuple *tuple);
+	/**
+	 * The CPU-intensive part of endBuild() which doesn't
+	 * touch the index memory allocator, e.g. sorting of the
+	 * added tuples, and hence can be run in a worker thread.
+	 * Optional: endBuild() does this work itself if it
+	 * hasn't been done yet.
+	 * @param n_threads  the number of threads the index
+	 *                   may use for the work.
+	 */
+	virtual void prepareEndBuild(int n_threads);
 	virtual void endBuild();
 protected:
 	/*
@@ -75,8 +85,40 @@ protected:
 	mutable struct iterator *m_position;
 };
 
-/** Build this index based on the contents of another index. */
+/**
+ * Build this index based on the contents of another index.
+ * @param n_threads  the number of threads to sort the tuples in.
+ */
+void
+index_build(MemtxIndex *index, MemtxIndex *pk, int n_threads);
+
+/** A single index to build with index_build_parallel(). */
+struct index_build_task {
+	/** The index to build. */
+	MemtxIndex *index;
+	/** The index to take the tuples from. */
+	MemtxIndex *pk;
+	/** A private iterator over pk, set by the builder. */
+	struct iterator *it;
+};
+
+/**
+ * Build a few indexes at once, each one based on the contents
+ * of its own primary key.
+ *
+ * Tuples of TREE and HASH indexes are collected and sorted
+ * (hashed) in a pool of up to n_threads worker threads, one
+ * index per thread at a time. The index memory allocator is not
+ * thread-safe, so the indexes are populated and all other index
+ * types are built in the caller thread. If there are fewer such
+ * indexes than threads, the spare threads are used to sort the
+ * tuples of each index.
+ *
+ * Blocks the caller thread until all indexes are built:
+ * the primary keys must not change during the build.
+ */
 void
-index_build(MemtxIndex *index, MemtxIndex *pk);
+index_build_parallel(struct index_build_task *tasks, uint32_t task_count,
+		     int n_threads);
 
 #endif /* TARANTOOL_BOX_MEMTX_INDEX_H_INCLUDED */
@@ -0,0 +1,356 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_read_view.h"
+
+#include <stdlib.h>
+#include <msgpuck.h>
+#include <small/rlist.h>
+
+#include "tt_pthread.h"
+#include "fiber.h"
+#include "scoped_guard.h"
+#include "memtx_tree.h"
+#include "tuple.h"
+#include "space.h"
+#include "schema.h"
+
+enum {
+	/*
+	 * The max number of live views, the current one and a
+	 * retired one. Each view takes a version of the memory
+	 * of every tree, and there are few of them, see
+	 * matras_create_read_view().
+	 */
+	MEMTX_READ_VIEW_MAX = 2,
+};
+
+/** How often memtx_read_view_lock() checks for released views. */
+static const double MEMTX_READ_VIEW_DRAIN_DELAY = 0.001;
+
+/** A view of a memtx TREE index. */
+struct memtx_read_view_index {
+	uint32_t space_id;
+	uint32_t index_id;
+	MemtxTree *index;
+	struct bps_tree_index_view view;
+};
+
+struct memtx_read_view {
+	/** Keeps the tuples of the view from being freed. */
+	struct tuple_read_view tuples;
+	/** sc_version at the moment of the view creation. */
+	uint32_t sc_version;
+	/** The number of users, protected by read_view_mutex. */
+	int refs;
+	/** Link in retired_views. */
+	struct rlist in_retired;
+	/** Views of the indexes, ordered by space id and index id. */
+	struct memtx_read_view_index *indexes;
+	uint32_t index_count;
+};
+
+static double read_view_period;
+static pthread_mutex_t read_view_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** The latest published view, protected by read_view_mutex. */
+static struct memtx_read_view *current_view;
+/**
+ * Views replaced by newer ones. They can't be acquired anymore
+ * and are destroyed as soon as released. Accessed only in tx.
+ */
+static RLIST_HEAD(retired_views);
+/** The number of views, the current one and retired ones. */
+static int view_count;
+/** The number of alters in progress, see memtx_read_view_lock(). */
+static int lock_count;
+
+static void
+memtx_read_view_count_indexes(struct space *space, void *data)
+{
+	if (!space_is_memtx(space))
+		return;
+	uint32_t *count = (uint32_t *) data;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		if (space->index[i]->key_def->type == TREE)
+			(*count)++;
+	}
+}
+
+static void
+memtx_read_view_add_space(struct space *space, void *data)
+{
+	if (!space_is_memtx(space))
+		return;
+	struct memtx_read_view *view = (struct memtx_read_view *) data;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		Index *index = space->index[i];
+		if (index->key_def->type != TREE)
+			continue;
+		struct memtx_read_view_index *entry =
+			&view->indexes[view->index_count++];
+		entry->space_id = space_id(space);
+		entry->index_id = index->key_def->iid;
+		entry->index = (MemtxTree *) index;
+		entry->index->createView(&entry->view);
+	}
+}
+
+static int
+memtx_read_view_index_cmp(const void *a, const void *b)
+{
+	const struct memtx_read_view_index *entry_a =
+		(const struct memtx_read_view_index *) a;
+	const struct memtx_read_view_index *entry_b =
+		(const struct memtx_read_view_index *) b;
+	if (entry_a->space_id != entry_b->space_id)
+		return entry_a->space_id < entry_b->space_id ? -1 : 1;
+	if (entry_a->index_id != entry_b->index_id)
+		return entry_a->index_id < entry_b->index_id ? -1 : 1;
+	return 0;
+}
+
+static void
+memtx_read_view_delete(struct memtx_read_view *view)
+{
+	for (uint32_t i = 0; i < view->index_count; i++) {
+		struct memtx_read_view_index *entry = &view->indexes[i];
+		entry->index->destroyView(&entry->view);
+	}
+	tuple_read_view_close(&view->tuples);
+	free(view->indexes);
+	free(view);
+}
+
+/** Create a view of all memtx TREE indexes. */
+static struct memtx_read_view *
+memtx_read_view_new()
+{
+	uint32_t index_count = 0;
+	space_foreach(memtx_read_view_count_indexes, &index_count);
+
+	struct memtx_read_view *view = (struct memtx_read_view *)
+		calloc(1, sizeof(*view));
+	struct memtx_read_view_index *indexes =
+		(struct memtx_read_view_index *)
+		calloc(MAX(index_count, 1), sizeof(*indexes));
+	if (view == NULL || indexes == NULL) {
+		free(view);
+		free(indexes);
+		tnt_raise(OutOfMemory, index_count * sizeof(*indexes),
+			  "calloc", "memtx read view");
+	}
+	view->indexes = indexes;
+	view->sc_version = sc_version;
+	/* No yields from here on, so the view is consistent. */
+	tuple_read_view_open(&view->tuples);
+	auto view_guard = make_scoped_guard([=]{
+		memtx_read_view_delete(view);
+	});
+	space_foreach(memtx_read_view_add_space, view);
+	assert(view->index_count == index_count);
+	view_guard.is_active = false;
+
+	/* User spaces are visited in no particular order. */
+	qsort(view->indexes, view->index_count, sizeof(*view->indexes),
+	      memtx_read_view_index_cmp);
+	return view;
+}
+
+/** Make @a view the current one and retire the previous one. */
+static void
+memtx_read_view_publish(struct memtx_read_view *view)
+{
+	tt_pthread_mutex_lock(&read_view_mutex);
+	struct memtx_read_view *old = current_view;
+	current_view = view;
+	tt_pthread_mutex_unlock(&read_view_mutex);
+	if (old != NULL)
+		rlist_add_tail_entry(&retired_views, old, in_retired);
+}
+
+/** Destroy the retired views which are released. */
+static void
+memtx_read_view_gc()
+{
+	struct memtx_read_view *view, *tmp;
+	rlist_foreach_entry_safe(view, &retired_views, in_retired, tmp) {
+		tt_pthread_mutex_lock(&read_view_mutex);
+		int refs = view->refs;
+		tt_pthread_mutex_unlock(&read_view_mutex);
+		/* A retired view can't be acquired again. */
+		if (refs > 0)
+			continue;
+		rlist_del_entry(view, in_retired);
+		memtx_read_view_delete(view);
+		view_count--;
+	}
+}
+
+static int
+memtx_read_view_f(va_list /* ap */)
+{
+	while (! fiber_is_cancelled()) {
+		fiber_sleep(read_view_period);
+		memtx_read_view_gc();
+		if (lock_count > 0 || view_count >= MEMTX_READ_VIEW_MAX)
+			continue;
+		struct memtx_read_view *view;
+		try {
+			view = memtx_read_view_new();
+		} catch (Exception *e) {
+			e->log();
+			continue;
+		}
+		view_count++;
+		memtx_read_view_publish(view);
+	}
+	return 0;
+}
+
+void
+memtx_read_view_init(double period)
+{
+	assert(period > 0);
+	read_view_period = period;
+	struct fiber *f = fiber_new_xc("read_view", memtx_read_view_f);
+	fiber_start(f);
+}
+
+struct memtx_read_view *
+memtx_read_view_acquire()
+{
+	tt_pthread_mutex_lock(&read_view_mutex);
+	struct memtx_read_view *view = current_view;
+	if (view != NULL)
+		view->refs++;
+	tt_pthread_mutex_unlock(&read_view_mutex);
+	return view;
+}
+
+void
+memtx_read_view_release(struct memtx_read_view *view)
+{
+	tt_pthread_mutex_lock(&read_view_mutex);
+	assert(view->refs > 0);
+	view->refs--;
+	tt_pthread_mutex_unlock(&read_view_mutex);
+}
+
+uint32_t
+memtx_read_view_schema_version(struct memtx_read_view *view)
+{
+	return view->sc_version;
+}
+
+static struct memtx_read_view_index *
+memtx_read_view_find(struct memtx_read_view *view, uint32_t space_id,
+		     uint32_t index_id)
+{
+	struct memtx_read_view_index key;
+	key.space_id = space_id;
+	key.index_id = index_id;
+	return (struct memtx_read_view_index *)
+		bsearch(&key, view->indexes, view->index_count,
+			sizeof(*view->indexes), memtx_read_view_index_cmp);
+}
+
+bool
+memtx_read_view_select(struct memtx_read_view *view, uint32_t space_id,
+		       uint32_t index_id, uint32_t iterator, uint32_t offset,
+		       uint32_t limit, const char *key,
+		       struct memtx_read_view_result *result)
+{
+	struct memtx_read_view_index *entry =
+		memtx_read_view_find(view, space_id, index_id);
+	if (entry == NULL)
+		return false;
+	MemtxTree *index = entry->index;
+
+	if (iterator >= iterator_type_MAX)
+		tnt_raise(IllegalParams, "Invalid iterator type");
+	enum iterator_type type = (enum iterator_type) iterator;
+
+	uint32_t part_count = key ? mp_decode_array(&key) : 0;
+	key_validate(index->key_def, type, key, part_count);
+
+	struct iterator *it = index->allocIterator();
+	auto it_guard = make_scoped_guard([=]{ it->free(it); });
+	index->initViewIterator(it, &entry->view, type, key, part_count);
+
+	result->data = NULL;
+	result->size = 0;
+	result->count = 0;
+	auto result_guard = make_scoped_guard([=]{ free(result->data); });
+	size_t capacity = 0;
+	struct tuple *tuple;
+	while ((tuple = it->next(it)) != NULL) {
+		if (offset > 0) {
+			offset--;
+			continue;
+		}
+		if (limit == result->count)
+			break;
+		size_t size = result->size + tuple->bsize;
+		if (size > capacity) {
+			capacity = MAX(capacity * 2, size);
+			char *data = (char *) realloc(result->data, capacity);
+			if (data == NULL) {
+				tnt_raise(OutOfMemory, capacity, "realloc",
+					  "memtx read view result");
+			}
+			result->data = data;
+		}
+		memcpy(result->data + result->size, tuple->data, tuple->bsize);
+		result->size = size;
+		result->count++;
+	}
+	result_guard.is_active = false;
+	return true;
+}
+
+void
+memtx_read_view_lock()
+{
+	lock_count++;
+	memtx_read_view_publish(NULL);
+	while (true) {
+		memtx_read_view_gc();
+		if (view_count == 0)
+			break;
+		fiber_sleep(MEMTX_READ_VIEW_DRAIN_DELAY);
+	}
+}
+
+void
+memtx_read_view_unlock()
+{
+	assert(lock_count > 0);
+	lock_count--;
+}
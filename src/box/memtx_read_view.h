@@ -0,0 +1,105 @@
+#ifndef TARANTOOL_BOX_MEMTX_READ_VIEW_H_INCLUDED
+#define TARANTOOL_BOX_MEMTX_READ_VIEW_H_INCLUDED
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Read views of memtx TREE indexes, published by tx every
+ * box.cfg.read_view_period seconds. A view is consistent across
+ * all spaces and lags behind the data by up to the period. Other
+ * threads may execute SELECTs in the latest published view
+ * concurrently with tx, see IPROTO_STALE_OK. Like reads in tx,
+ * a view may include changes which are not written to WAL yet.
+ */
+struct memtx_read_view;
+
+/** The result of a SELECT in a read view. */
+struct memtx_read_view_result {
+	/** MsgPack of the found tuples, allocated with malloc(). */
+	char *data;
+	size_t size;
+	/** The number of the found tuples. */
+	uint32_t count;
+};
+
+/**
+ * Start publishing read views every @a period seconds.
+ * Must be called in tx, after recovery.
+ */
+void
+memtx_read_view_init(double period);
+
+/**
+ * Get the latest published view, NULL if there is none.
+ * The view must be released with memtx_read_view_release().
+ * May be called in any thread.
+ */
+struct memtx_read_view *
+memtx_read_view_acquire();
+
+/** Release a view. May be called in any thread. */
+void
+memtx_read_view_release(struct memtx_read_view *view);
+
+/** The schema version the view was created at. */
+uint32_t
+memtx_read_view_schema_version(struct memtx_read_view *view);
+
+/**
+ * Execute a SELECT in a view. May be called in any thread,
+ * while the view is acquired.
+ * @retval true the result is filled, free result->data
+ * @retval false the index has no read view, e.g. it isn't
+ *         a memtx TREE index
+ * Throws on error.
+ */
+bool
+memtx_read_view_select(struct memtx_read_view *view, uint32_t space_id,
+		       uint32_t index_id, uint32_t iterator, uint32_t offset,
+		       uint32_t limit, const char *key,
+		       struct memtx_read_view_result *result);
+
+/**
+ * Stop publishing and wait until all views are released and
+ * destroyed. Must be called in a fiber of tx before an alter,
+ * which may delete indexes or tuple formats used in the views.
+ * Yields.
+ */
+void
+memtx_read_view_lock();
+
+/** Resume publishing read views. */
+void
+memtx_read_view_unlock();
+
+#endif /* TARANTOOL_BOX_MEMTX_READ_VIEW_H_INCLUDED */
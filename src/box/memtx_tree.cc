@@ -35,7 +35,8 @@
 #include "errinj.h"
 #include "memory.h"
 #include "fiber.h"
-#include <third_party/qsort_arg.h>
+#include "scoped_guard.h"
+#include <salad/psort.h>
 
 /* {{{ Utilities. *************************************************/
 
@@ -185,7 +186,7 @@ tree_iterator_bwd_skip_one_check_next_equality(struct iterator *iterator)
 
 MemtxTree::MemtxTree(struct key_def *key_def_arg)
 	: MemtxIndex(key_def_arg), build_array(0), build_array_size(0),
-	  build_array_alloc_size(0)
+	  build_array_alloc_size(0), build_array_is_sorted(false)
 {
 	memtx_index_arena_init();
 	bps_tree_index_create(&tree, key_def,
@@ -286,6 +287,15 @@ MemtxTree::allocIterator() const
 void
 MemtxTree::initIterator(struct iterator *iterator, enum iterator_type type,
 			const char *key, uint32_t part_count) const
+{
+	initViewIterator(iterator, NULL, type, key, part_count);
+}
+
+void
+MemtxTree::initViewIterator(struct iterator *iterator,
+			    const struct bps_tree_index_view *view,
+			    enum iterator_type type,
+			    const char *key, uint32_t part_count) const
 {
 	assert(part_count == 0 || key != NULL);
 	struct tree_iterator *it = tree_iterator(iterator);
@@ -309,17 +319,26 @@ MemtxTree::initIterator(struct iterator *iterator, enum iterator_type type,
 	if (key == 0) {
 		if (iterator_type_is_reverse(type))
 			it->bps_tree_iter = bps_tree_index_invalid_iterator();
+		else if (view != NULL)
+			it->bps_tree_iter =
+				bps_tree_index_view_itr_first(&tree, view);
 		else
 			it->bps_tree_iter = bps_tree_index_itr_first(&tree);
 	} else {
 		if (type == ITER_ALL || type == ITER_EQ || type == ITER_GE || type == ITER_LT) {
-			it->bps_tree_iter = bps_tree_index_lower_bound(&tree, &it->key_data, &exact);
+			if (view != NULL)
+				it->bps_tree_iter = bps_tree_index_view_lower_bound(&tree, view, &it->key_data, &exact);
+			else
+				it->bps_tree_iter = bps_tree_index_lower_bound(&tree, &it->key_data, &exact);
 			if (type == ITER_EQ && !exact) {
 				it->base.next = tree_iterator_dummie;
 				return;
 			}
 		} else { // ITER_GT, ITER_REQ, ITER_LE
-			it->bps_tree_iter = bps_tree_index_upper_bound(&tree, &it->key_data, &exact);
+			if (view != NULL)
+				it->bps_tree_iter = bps_tree_index_view_upper_bound(&tree, view, &it->key_data, &exact);
+			else
+				it->bps_tree_iter = bps_tree_index_upper_bound(&tree, &it->key_data, &exact);
 			if (type == ITER_REQ && !exact) {
 				it->base.next = tree_iterator_dummie;
 				return;
@@ -327,12 +346,28 @@ MemtxTree::initIterator(struct iterator *iterator, enum iterator_type type,
 		}
 	}
 
+	/*
+	 * Reverse iterators start one step past the first
+	 * element to return. An invalid iterator is stepped back
+	 * to the last element of the tree, but in a read view
+	 * it stays invalid, so start at the last element of the
+	 * view instead.
+	 */
+	bool skip_one = true;
+	if (view != NULL && iterator_type_is_reverse(type) &&
+	    bps_tree_index_itr_is_invalid(&it->bps_tree_iter)) {
+		it->bps_tree_iter = bps_tree_index_view_itr_last(&tree, view);
+		skip_one = false;
+	}
+
 	switch (type) {
 	case ITER_EQ:
 		it->base.next = tree_iterator_fwd_check_next_equality;
 		break;
 	case ITER_REQ:
-		it->base.next = tree_iterator_bwd_skip_one_check_next_equality;
+		it->base.next = skip_one ?
+			tree_iterator_bwd_skip_one_check_next_equality :
+			tree_iterator_bwd_check_equality;
 		break;
 	case ITER_ALL:
 	case ITER_GE:
@@ -342,10 +377,12 @@ MemtxTree::initIterator(struct iterator *iterator, enum iterator_type type,
 		it->base.next = tree_iterator_fwd;
 		break;
 	case ITER_LE:
-		it->base.next = tree_iterator_bwd_skip_one;
+		it->base.next = skip_one ? tree_iterator_bwd_skip_one :
+			tree_iterator_bwd;
 		break;
 	case ITER_LT:
-		it->base.next = tree_iterator_bwd_skip_one;
+		it->base.next = skip_one ? tree_iterator_bwd_skip_one :
+			tree_iterator_bwd;
 		break;
 	default:
 		return Index::initIterator(iterator, type, key, part_count);
@@ -386,18 +423,45 @@ MemtxTree::buildNext(struct tuple *tuple)
 				sizeof(struct tuple *));
 	}
 	build_array[build_array_size++] = tuple;
+	build_array_is_sorted = false;
 }
 
 void
-MemtxTree::endBuild()
+MemtxTree::prepareEndBuild(int n_threads)
 {
-	qsort_arg(build_array, build_array_size, sizeof(struct tuple *), tree_index_qcompare, key_def);
-	bps_tree_index_build(&tree, build_array, build_array_size);
+	psort_arg(build_array, build_array_size, sizeof(struct tuple *),
+		  tree_index_qcompare, key_def, n_threads);
+	build_array_is_sorted = true;
+}
 
-	free(build_array);
-	build_array = 0;
-	build_array_size = 0;
-	build_array_alloc_size = 0;
+void
+MemtxTree::endBuild()
+{
+	auto guard = make_scoped_guard([=]{
+		free(build_array);
+		build_array = 0;
+		build_array_size = 0;
+		build_array_alloc_size = 0;
+		build_array_is_sorted = false;
+	});
+	if (! build_array_is_sorted)
+		prepareEndBuild(1);
+	if (key_def->opts.is_unique) {
+		/* Duplicates are adjacent in the sorted array. */
+		for (size_t i = 1; i < build_array_size; i++) {
+			if (tree_index_compare(build_array[i - 1],
+					       build_array[i], key_def) != 0)
+				continue;
+			struct space *sp = space_cache_find(key_def->space_id);
+			tnt_raise(ClientError, ER_TUPLE_FOUND,
+				  index_name(this), space_name(sp));
+		}
+	}
+	if (bps_tree_index_build(&tree, build_array, build_array_size) != 0) {
+		tnt_raise(OutOfMemory,
+			  build_array_size * sizeof(struct tuple *),
+			  "MemtxTree", "build");
+	}
 }
 
 /**
@@ -424,3 +488,24 @@ MemtxTree::destroyReadViewForIterator(struct iterator *iterator)
 	bps_tree_index_itr_destroy(tree, &it->bps_tree_iter);
 }
 
+
+/**
+ * Create a read view of the whole index. Iterators initialized
+ * with initViewIterator() in the view are not affected by
+ * further index modifications.
+ */
+void
+MemtxTree::createView(struct bps_tree_index_view *view)
+{
+	bps_tree_index_view_create(&tree, view);
+}
+
+/**
+ * Destroy a read view created with createView(). No iterator
+ * may use the view after that.
+ */
+void
+MemtxTree::destroyView(struct bps_tree_index_view *view)
+{
+	bps_tree_index_view_destroy(&tree, view);
+}
@@ -62,6 +62,7 @@ public:
 	virtual void beginBuild() override;
 	virtual void reserve(uint32_t size_hint) override;
 	virtual void buildNext(struct tuple *tuple) override;
+	virtual void prepareEndBuild(int n_threads) override;
 	virtual void endBuild() override;
 	virtual size_t size() const override;
 	virtual struct tuple *random(uint32_t rnd) const override;
@@ -89,10 +90,31 @@ public:
 	 */
 	virtual void destroyReadViewForIterator(struct iterator *iterator) override;
 
+	/**
+	 * Create a read view of the whole index, see
+	 * bps_tree_view_create(). Must be called in tx.
+	 */
+	void createView(struct bps_tree_index_view *view);
+	/** Destroy a read view. Must be called in tx. */
+	void destroyView(struct bps_tree_index_view *view);
+	/**
+	 * Same as initIterator(), but the iterator walks the
+	 * index as it was at the moment of the view creation.
+	 * Such an iterator may be used in any thread while the
+	 * view is alive. With view == NULL, the same as
+	 * initIterator().
+	 */
+	void initViewIterator(struct iterator *iterator,
+			      const struct bps_tree_index_view *view,
+			      enum iterator_type type,
+			      const char *key, uint32_t part_count) const;
+
 // protected:
 	struct bps_tree_index tree;
 	struct tuple **build_array;
 	size_t build_array_size, build_array_alloc_size;
+	/** True if build_array is sorted by prepareEndBuild(). */
+	bool build_array_is_sorted;
 };
 
 #endif /* TARANTOOL_BOX_TREE_INDEX_H_INCLUDED */
@@ -30,8 +30,12 @@
  */
 #include "recovery.h"
 
+#include <sys/stat.h>
+
 #include "scoped_guard.h"
 #include "fiber.h"
+#include "tt_pthread.h"
+#include "salad/stailq.h"
 #include "xlog.h"
 #include "xrow.h"
 #include "xstream.h"
@@ -161,6 +165,21 @@ recovery_new(const char *wal_dirname, bool panic_on_wal_error,
 	return r;
 }
 
+void
+recovery_add_stream_dir(struct recovery *r, const char *dirname)
+{
+	assert(r->stream_dir_count < WAL_STREAMS_MAX - 1);
+	struct xdir *dir = &r->stream_dirs[r->stream_dir_count];
+	xdir_create(dir, dirname, XLOG, &SERVER_UUID);
+	dir->panic_if_error = r->wal_dir.panic_if_error;
+	auto guard = make_scoped_guard([=]{
+		xdir_destroy(dir);
+	});
+	xdir_check_xc(dir);
+	guard.is_active = false;
+	r->stream_dir_count++;
+}
+
 static inline void
 recovery_close_log(struct recovery *r)
 {
@@ -182,6 +201,8 @@ recovery_delete(struct recovery *r)
 	recovery_stop_local(r);
 
 	xdir_destroy(&r->wal_dir);
+	for (int i = 0; i < r->stream_dir_count; i++)
+		xdir_destroy(&r->stream_dirs[i]);
 	if (r->current_wal) {
 		/*
 		 * Possible if shutting down a replication
@@ -200,17 +221,344 @@ recovery_exit(struct recovery *r)
 	recovery_delete(r);
 }
 
+/**
+ * Apply a row read from a WAL unless it has been applied
+ * already.
+ */
+static void
+recovery_apply_row(struct recovery *r, struct xstream *stream,
+		   struct xlog *l, struct xrow_header *row)
+{
+	try {
+		int64_t current_lsn = vclock_get(&r->vclock, row->server_id);
+		if (row->lsn <= current_lsn)
+			return;
+		xstream_write(stream, row);
+	} catch (ClientError *e) {
+		if (l->dir->panic_if_error)
+			throw;
+		say_error("can't apply row: ");
+		e->log();
+	}
+}
+
+enum {
+	/**
+	 * A file with at least this much data left to read is
+	 * read ahead in a separate thread, while the rows are
+	 * applied in the calling thread.
+	 */
+	RECOVERY_READ_AHEAD_MIN = 4 * 1024 * 1024,
+	/** The reader thread passes rows in batches of this size. */
+	RECOVERY_BATCH_SIZE = 1024 * 1024,
+	/** The number of batches in flight. */
+	RECOVERY_BATCH_COUNT = 4,
+};
+
+/** Rows read ahead by the reader thread. */
+struct recovery_batch {
+	struct xrow_header *rows;
+	uint32_t row_count;
+	uint32_t row_capacity;
+	/** Bodies of the rows. */
+	char *buf;
+	size_t buf_used;
+	size_t buf_capacity;
+	/** Link in recovery_reader::read_queue or free_batches. */
+	struct stailq_entry in_queue;
+};
+
+/**
+ * Reads, checks and decodes the rows of a file in a separate
+ * thread, so that the calling thread only has to apply them.
+ */
+struct recovery_reader {
+	struct xlog *log;
+	pthread_mutex_t mutex;
+	/** Signalled when a batch is read or the file is done. */
+	pthread_cond_t read_cond;
+	/** Signalled when a batch is applied or on stop. */
+	pthread_cond_t free_cond;
+	/** Batches of rows read, in the file order. */
+	struct stailq read_queue;
+	/** Batches to fill. */
+	struct stailq free_batches;
+	struct recovery_batch batches[RECOVERY_BATCH_COUNT];
+	/** Set by the reader thread when it is done. */
+	bool is_done;
+	/** Set by the reader thread if the file can't be read. */
+	bool is_failed;
+	/** Set when the reader thread must exit. */
+	bool is_stopped;
+	struct cord cord;
+};
+
+/**
+ * Copy a row to the batch.
+ * @retval false the batch is full
+ */
+static bool
+recovery_batch_add(struct recovery_batch *batch, struct xrow_header *row)
+{
+	size_t size = 0;
+	for (int k = 0; k < row->bodycnt; k++)
+		size += row->body[k].iov_len;
+	if (batch->buf_used + size > batch->buf_capacity) {
+		if (batch->row_count > 0)
+			return false;
+		size_t capacity = MAX((size_t) RECOVERY_BATCH_SIZE, size);
+		char *buf = (char *) realloc(batch->buf, capacity);
+		if (buf == NULL)
+			tnt_raise(OutOfMemory, capacity, "realloc", "WAL rows");
+		batch->buf = buf;
+		batch->buf_capacity = capacity;
+	}
+	if (batch->row_count == batch->row_capacity) {
+		uint32_t capacity = batch->row_capacity > 0 ?
+				    batch->row_capacity * 2 : 1024;
+		size_t rows_size = capacity * sizeof(*batch->rows);
+		struct xrow_header *rows = (struct xrow_header *)
+			realloc(batch->rows, rows_size);
+		if (rows == NULL) {
+			tnt_raise(OutOfMemory, rows_size, "realloc",
+				  "WAL rows");
+		}
+		batch->rows = rows;
+		batch->row_capacity = capacity;
+	}
+	struct xrow_header *copy = &batch->rows[batch->row_count++];
+	*copy = *row;
+	for (int k = 0; k < row->bodycnt; k++) {
+		char *body = batch->buf + batch->buf_used;
+		memcpy(body, row->body[k].iov_base, row->body[k].iov_len);
+		copy->body[k].iov_base = body;
+		batch->buf_used += row->body[k].iov_len;
+	}
+	return true;
+}
+
+/** Take a batch to fill, NULL if the reader is stopped. */
+static struct recovery_batch *
+recovery_reader_get(struct recovery_reader *reader)
+{
+	struct recovery_batch *batch = NULL;
+	tt_pthread_mutex_lock(&reader->mutex);
+	while (! reader->is_stopped && stailq_empty(&reader->free_batches))
+		tt_pthread_cond_wait(&reader->free_cond, &reader->mutex);
+	if (! reader->is_stopped) {
+		batch = stailq_shift_entry(&reader->free_batches,
+					   struct recovery_batch, in_queue);
+	}
+	tt_pthread_mutex_unlock(&reader->mutex);
+	if (batch != NULL) {
+		batch->row_count = 0;
+		batch->buf_used = 0;
+	}
+	return batch;
+}
+
+/** Pass a filled batch to the applying thread. */
+static void
+recovery_reader_push(struct recovery_reader *reader,
+		     struct recovery_batch *batch)
+{
+	tt_pthread_mutex_lock(&reader->mutex);
+	stailq_add_tail(&reader->read_queue, &batch->in_queue);
+	tt_pthread_cond_signal(&reader->read_cond);
+	tt_pthread_mutex_unlock(&reader->mutex);
+}
+
+static void *
+recovery_reader_f(void *arg)
+{
+	struct recovery_reader *reader = (struct recovery_reader *) arg;
+	struct xlog_cursor i;
+	xlog_cursor_open(&i, reader->log);
+	struct recovery_batch *batch = NULL;
+	bool is_failed = false;
+	try {
+		struct xrow_header row;
+		while (xlog_cursor_next_xc(&i, &row) == 0) {
+			if (batch != NULL && ! recovery_batch_add(batch, &row)) {
+				recovery_reader_push(reader, batch);
+				batch = NULL;
+			}
+			if (batch == NULL) {
+				batch = recovery_reader_get(reader);
+				if (batch == NULL)
+					break;
+				recovery_batch_add(batch, &row);
+			}
+		}
+	} catch (Exception *e) {
+		/* cord_join() passes the error to the caller. */
+		is_failed = true;
+	}
+	/* Rows read before an error are applied, like in recover_xlog(). */
+	if (batch != NULL && batch->row_count > 0)
+		recovery_reader_push(reader, batch);
+	xlog_cursor_close(&i);
+
+	tt_pthread_mutex_lock(&reader->mutex);
+	reader->is_done = true;
+	reader->is_failed = is_failed;
+	tt_pthread_cond_signal(&reader->read_cond);
+	tt_pthread_mutex_unlock(&reader->mutex);
+	return NULL;
+}
+
+static void
+recovery_reader_create(struct recovery_reader *reader, struct xlog *l)
+{
+	memset(reader, 0, sizeof(*reader));
+	reader->log = l;
+	tt_pthread_mutex_init(&reader->mutex, NULL);
+	tt_pthread_cond_init(&reader->read_cond, NULL);
+	tt_pthread_cond_init(&reader->free_cond, NULL);
+	stailq_create(&reader->read_queue);
+	stailq_create(&reader->free_batches);
+	for (int i = 0; i < RECOVERY_BATCH_COUNT; i++) {
+		stailq_add_tail(&reader->free_batches,
+				&reader->batches[i].in_queue);
+	}
+}
+
+static void
+recovery_reader_destroy(struct recovery_reader *reader)
+{
+	for (int i = 0; i < RECOVERY_BATCH_COUNT; i++) {
+		free(reader->batches[i].rows);
+		free(reader->batches[i].buf);
+	}
+	tt_pthread_cond_destroy(&reader->free_cond);
+	tt_pthread_cond_destroy(&reader->read_cond);
+	tt_pthread_mutex_destroy(&reader->mutex);
+}
+
+/** Take the next batch of rows, NULL if the file is done. */
+static struct recovery_batch *
+recovery_reader_next(struct recovery_reader *reader)
+{
+	struct recovery_batch *batch = NULL;
+	tt_pthread_mutex_lock(&reader->mutex);
+	while (! reader->is_done && stailq_empty(&reader->read_queue))
+		tt_pthread_cond_wait(&reader->read_cond, &reader->mutex);
+	if (! stailq_empty(&reader->read_queue)) {
+		batch = stailq_shift_entry(&reader->read_queue,
+					   struct recovery_batch, in_queue);
+	}
+	tt_pthread_mutex_unlock(&reader->mutex);
+	return batch;
+}
+
+/** Return an applied batch to the reader thread. */
+static void
+recovery_reader_release(struct recovery_reader *reader,
+			struct recovery_batch *batch)
+{
+	tt_pthread_mutex_lock(&reader->mutex);
+	stailq_add_tail(&reader->free_batches, &batch->in_queue);
+	tt_pthread_cond_signal(&reader->free_cond);
+	tt_pthread_mutex_unlock(&reader->mutex);
+}
+
+/**
+ * Stop and join the reader thread. Keeps the error being
+ * raised by the caller, if any, or takes the error of the
+ * reader.
+ */
+static void
+recovery_reader_stop(struct recovery_reader *reader)
+{
+	tt_pthread_mutex_lock(&reader->mutex);
+	reader->is_stopped = true;
+	tt_pthread_cond_signal(&reader->free_cond);
+	tt_pthread_mutex_unlock(&reader->mutex);
+
+	struct diag diag;
+	diag_create(&diag);
+	diag_move(diag_get(), &diag);
+	if (cord_join(&reader->cord) != 0)
+		panic_syserror("failed to join the WAL reader thread");
+	if (! diag_is_empty(&diag))
+		diag_move(&diag, diag_get());
+	diag_destroy(&diag);
+}
+
+/**
+ * Read the rest of a file in a separate thread and apply
+ * the rows in this one.
+ *
+ * @retval 0 the file is read
+ * @retval -1 the reader thread can't be started
+ */
+static int
+recover_xlog_read_ahead(struct recovery *r, struct xstream *stream,
+			struct xlog *l)
+{
+	struct recovery_reader reader;
+	recovery_reader_create(&reader, l);
+	if (cord_start(&reader.cord, "wal_read", recovery_reader_f,
+		       &reader) != 0) {
+		recovery_reader_destroy(&reader);
+		return -1;
+	}
+	auto guard = make_scoped_guard([&]{
+		recovery_reader_stop(&reader);
+		recovery_reader_destroy(&reader);
+	});
+
+	struct recovery_batch *batch;
+	while ((batch = recovery_reader_next(&reader)) != NULL) {
+		for (uint32_t i = 0; i < batch->row_count; i++)
+			recovery_apply_row(r, stream, l, &batch->rows[i]);
+		recovery_reader_release(&reader, batch);
+	}
+
+	guard.is_active = false;
+	/* Make sure an old error doesn't hide the reader's one. */
+	diag_clear(diag_get());
+	recovery_reader_stop(&reader);
+	bool is_failed = reader.is_failed;
+	recovery_reader_destroy(&reader);
+	if (is_failed)
+		diag_raise();
+	return 0;
+}
+
+/**
+ * Return the size of the part of a file which hasn't been
+ * read yet.
+ */
+static off_t
+xlog_unread_size(struct xlog *l)
+{
+	struct stat st;
+	if (fstat(fileno(l->f), &st) != 0)
+		return 0;
+	return st.st_size - ftello(l->f);
+}
+
 /**
  * Read all rows in a file starting from the last position.
  * Advance the position. If end of file is reached,
  * set l.eof_read.
  * The reading will be stopped on reaching stop_vclock.
  * Use NULL for boundless recover
+ *
+ * Large files are read ahead in a separate thread, unless
+ * there is a stop_vclock, which needs to be checked after
+ * every row.
  */
 static void
 recover_xlog(struct recovery *r, struct xstream *stream, struct xlog *l,
 	     struct vclock *stop_vclock)
 {
+	if (stop_vclock == NULL &&
+	    xlog_unread_size(l) >= RECOVERY_READ_AHEAD_MIN &&
+	    recover_xlog_read_ahead(r, stream, l) == 0)
+		return;
+
 	struct xlog_cursor i;
 
 	xlog_cursor_open(&i, l);
@@ -230,18 +578,7 @@ recover_xlog(struct recovery *r, struct xstream *stream, struct xlog *l,
 		if (stop_vclock != NULL &&
 		    r->vclock.signature >= stop_vclock->signature)
 			return;
-		try {
-			int64_t current_lsn = vclock_get(&r->vclock,
-							 row.server_id);
-			if (row.lsn <= current_lsn)
-				continue;
-			xstream_write(stream, &row);
-		} catch (ClientError *e) {
-			if (l->dir->panic_if_error)
-				throw;
-			say_error("can't apply row: ");
-			e->log();
-		}
+		recovery_apply_row(r, stream, l, &row);
 	}
 }
 
@@ -341,19 +678,212 @@ recover_current_wal:
 	region_free(&fiber()->gc);
 }
 
+/** A WAL stream being recovered, see recover_wal_streams(). */
+struct recovery_stream {
+	struct xdir *dir;
+	/** The vclock of the current file in the directory index. */
+	struct vclock *clock;
+	struct xlog *log;
+	struct xlog_cursor cursor;
+	/** The next row of the stream, if has_row is set. */
+	struct xrow_header row;
+	bool has_row;
+};
+
+static void
+recovery_stream_close_log(struct recovery_stream *s)
+{
+	if (s->log == NULL)
+		return;
+	xlog_cursor_close(&s->cursor);
+	if (s->log->eof_read) {
+		say_info("done `%s'", s->log->filename);
+	} else {
+		say_warn("file `%s` wasn't correctly closed",
+			 s->log->filename);
+	}
+	xlog_close(s->log);
+	s->log = NULL;
+}
+
+/**
+ * Read the next row of a stream, moving on to the next file
+ * of the stream when the current one is over.
+ */
+static void
+recovery_stream_next(struct recovery_stream *s)
+{
+	s->has_row = false;
+	while (s->clock != NULL) {
+		if (s->log == NULL) {
+			s->log = xlog_open_xc(s->dir, vclock_sum(s->clock));
+			say_info("recover from `%s'", s->log->filename);
+			xlog_cursor_open(&s->cursor, s->log);
+		}
+		if (xlog_cursor_next_xc(&s->cursor, &s->row) == 0) {
+			s->has_row = true;
+			return;
+		}
+		recovery_stream_close_log(s);
+		s->clock = vclockset_next(&s->dir->index, s->clock);
+	}
+}
+
+/**
+ * Find the stream to apply the next row from. Rows of this
+ * server are applied in the order of their LSNs, which is
+ * the order they were committed in. Rows of other servers
+ * can only be written before WAL streams were configured,
+ * since streams can't be used with replication, so they
+ * are applied as soon as they are read.
+ */
+static struct recovery_stream *
+recovery_stream_min(struct recovery *r, struct recovery_stream *streams,
+		    int count)
+{
+	struct recovery_stream *min = NULL;
+	for (int i = 0; i < count; i++) {
+		struct recovery_stream *s = &streams[i];
+		if (! s->has_row)
+			continue;
+		if (s->row.server_id != r->server_id)
+			return s;
+		if (min == NULL || s->row.lsn < min->row.lsn)
+			min = s;
+	}
+	return min;
+}
+
+/**
+ * Handle a gap in the LSNs of this server found when merging
+ * WAL streams: throw if panic_on_wal_error is set, otherwise
+ * skip the rest of the rows, so that recovery stops at the
+ * gap.
+ *
+ * The skipped rows stay on disk, so the vclock is moved past
+ * them: new rows must not reuse their LSNs. The next recovery
+ * would find the same gap, so box makes a checkpoint at the
+ * moved vclock when recovery is over, see
+ * recovery::stream_gap.
+ */
+static void
+recovery_stream_gap(struct recovery *r, struct recovery_stream *streams,
+		    int count, int64_t last_lsn, int64_t next_lsn)
+{
+	struct vclock from, to;
+	vclock_copy(&from, &r->vclock);
+	vclock_copy(&to, &r->vclock);
+	vclock_follow(&to, r->server_id, next_lsn);
+	XlogGapError *e = tnt_error(XlogGapError, &from, &to);
+	if (r->wal_dir.panic_if_error)
+		throw e;
+	e->log();
+	int64_t max_lsn = next_lsn;
+	for (int i = 0; i < count; i++) {
+		struct recovery_stream *s = &streams[i];
+		for (; s->has_row; recovery_stream_next(s)) {
+			if (s->row.server_id == r->server_id)
+				max_lsn = MAX(max_lsn, s->row.lsn);
+		}
+	}
+	say_warn("skipping the rows from LSN %lld to %lld after a gap "
+		 "in LSN since %lld", (long long) next_lsn,
+		 (long long) max_lsn, (long long) last_lsn);
+	vclock_follow(&r->vclock, r->server_id, max_lsn);
+	r->stream_gap = true;
+}
+
+/**
+ * Read the WAL streams in wal_dir and the stream directories
+ * at once, merging their rows.
+ *
+ * Unlike in recover_remaining_wals(), gaps between files of
+ * a stream are not checked: a stream has only a part of the
+ * rows, so a file missing in the middle can't be told from
+ * rows written to the other streams. Instead, the LSNs of
+ * this server must follow each other across all streams:
+ * after a crash one stream may lack the tail which was never
+ * synced while the others have later rows on disk, and
+ * applying those would recover a state which never existed.
+ * Such a gap is an error if panic_on_wal_error is set,
+ * otherwise recovery stops at it.
+ *
+ * Failed writes leave gaps too, but with several streams
+ * a failed write panics, so gaps are only checked in the
+ * LSN range written since the stream directories were
+ * configured.
+ */
+static void
+recover_wal_streams(struct recovery *r, struct xstream *stream)
+{
+	struct recovery_stream streams[WAL_STREAMS_MAX];
+	int count = 1 + r->stream_dir_count;
+	memset(streams, 0, sizeof(streams));
+	auto guard = make_scoped_guard([&]{
+		for (int i = 0; i < count; i++)
+			recovery_stream_close_log(&streams[i]);
+	});
+	/* Rows past this LSN of this server were written to streams. */
+	int64_t check_lsn = INT64_MAX;
+	for (int i = 0; i < count; i++) {
+		struct recovery_stream *s = &streams[i];
+		s->dir = i == 0 ? &r->wal_dir : &r->stream_dirs[i - 1];
+		xdir_scan_xc(s->dir);
+		s->clock = vclockset_match(&s->dir->index, &r->vclock);
+		if (i > 0 && s->clock != NULL) {
+			check_lsn = MIN(check_lsn,
+					vclock_get(s->clock, r->server_id));
+		}
+		recovery_stream_next(s);
+	}
+	/* The last LSN of this server read from the streams. */
+	int64_t last_lsn = vclock_get(&r->vclock, r->server_id);
+	struct recovery_stream *s;
+	while ((s = recovery_stream_min(r, streams, count)) != NULL) {
+		if (s->row.server_id == r->server_id) {
+			if (s->row.lsn > MAX(last_lsn, check_lsn) + 1) {
+				recovery_stream_gap(r, streams, count,
+						    last_lsn, s->row.lsn);
+				break;
+			}
+			last_lsn = MAX(last_lsn, s->row.lsn);
+		}
+		recovery_apply_row(r, stream, s->log, &s->row);
+		recovery_stream_next(s);
+	}
+	region_free(&fiber()->gc);
+}
+
+/**
+ * Return true if the last log file of a directory is named
+ * after the current vclock, which happens if it had zero rows.
+ */
+static bool
+recovery_last_log_is_empty(struct recovery *r, struct xdir *dir)
+{
+	struct vclock *last = vclockset_last(&dir->index);
+	return last != NULL && vclock_sum(&r->vclock) == vclock_sum(last);
+}
+
 void
 recovery_finalize(struct recovery *r, struct xstream *stream)
 {
 	recovery_stop_local(r);
 
 	xdir_scan_xc(&r->wal_dir);
-	recover_remaining_wals(r, stream, NULL);
-
-	recovery_close_log(r);
+	if (r->stream_dir_count > 0) {
+		recover_wal_streams(r, stream);
+	} else {
+		recover_remaining_wals(r, stream, NULL);
+		recovery_close_log(r);
+	}
 
-	if (vclockset_last(&r->wal_dir.index) != NULL &&
-	    vclock_sum(&r->vclock) ==
-	    vclock_sum(vclockset_last(&r->wal_dir.index))) {
+	bool last_log_is_empty = recovery_last_log_is_empty(r, &r->wal_dir);
+	for (int i = 0; i < r->stream_dir_count; i++) {
+		last_log_is_empty = last_log_is_empty ||
+			recovery_last_log_is_empty(r, &r->stream_dirs[i]);
+	}
+	if (last_log_is_empty) {
 		/**
 		 * The last log file had zero rows -> bump
 		 * LSN so that we don't stumble over this
@@ -536,6 +1066,12 @@ void
 recovery_follow_local(struct recovery *r, struct xstream *stream,
 		      const char *name, ev_tstamp wal_dir_rescan_delay)
 {
+	/*
+	 * The rows of WAL streams must be merged, which is done
+	 * in recovery_finalize().
+	 */
+	if (r->stream_dir_count > 0)
+		return;
 	/*
 	 * Scan wal_dir and recover all existing at the moment xlogs.
 	 * Blocks until finished.
@@ -35,6 +35,7 @@
 #include "xlog.h"
 #include "vclock.h"
 #include "tt_uuid.h"
+#include "wal.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -58,6 +59,19 @@ struct recovery {
 	 */
 	struct fiber *watcher;
 	uint32_t server_id;
+	/**
+	 * Directories of the WAL streams other than wal_dir,
+	 * see wal_stream_dirs. Their rows are merged with the
+	 * rows of wal_dir in recovery_finalize().
+	 */
+	struct xdir stream_dirs[WAL_STREAMS_MAX - 1];
+	int stream_dir_count;
+	/**
+	 * Set if recovery of the WAL streams stopped at a gap
+	 * in LSN. The vclock is moved past the rows skipped,
+	 * which must be made permanent by a checkpoint.
+	 */
+	bool stream_gap;
 };
 
 struct recovery *
@@ -71,6 +85,13 @@ recovery_delete(struct recovery *r);
 void
 recovery_exit(struct recovery *r);
 
+/**
+ * Add a directory of a WAL stream to recover from.
+ * Local hot standby is not supported with WAL streams.
+ */
+void
+recovery_add_stream_dir(struct recovery *r, const char *dirname);
+
 void
 recovery_follow_local(struct recovery *r, struct xstream *stream,
 		      const char *name, ev_tstamp wal_dir_rescan_delay);
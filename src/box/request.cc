@@ -58,7 +58,7 @@ request_decode(struct request *request, const char *data, uint32_t len)
 {
 	const char *end = data + len;
 	/** Advanced requests don't have a defined key map. */
-	assert(request->type <= IPROTO_UPSERT);
+	assert(iproto_type_has_simple_body(request->type));
 	uint64_t key_map = iproto_body_key_map[request->type];
 
 	if (mp_typeof(*data) != MP_MAP || mp_check_map(data, end) > 0) {
@@ -98,6 +98,15 @@ error:
 		case IPROTO_ITERATOR:
 			request->iterator = mp_decode_uint(&value);
 			break;
+		case IPROTO_CURSOR_ID:
+			request->cursor_id = mp_decode_uint(&value);
+			break;
+		case IPROTO_CHUNK_SIZE:
+			request->chunk_size = mp_decode_uint(&value);
+			break;
+		case IPROTO_STALE_OK:
+			request->stale_ok = mp_decode_uint(&value) != 0;
+			break;
 		case IPROTO_TUPLE:
 			request->tuple = value;
 			request->tuple_end = data;
@@ -74,6 +74,15 @@ struct request
 	const char *ops_end;
 	/** Base field offset for UPDATE/UPSERT, e.g. 0 for C and 1 for Lua. */
 	int index_base;
+	/** Server-side cursor of FETCH/CLOSE, see IPROTO_OPEN. */
+	uint32_t cursor_id;
+	/** The number of rows to return by OPEN/FETCH. */
+	uint32_t chunk_size;
+	/**
+	 * SELECT may be served from a memtx read view, which
+	 * lags behind the current data, see IPROTO_STALE_OK.
+	 */
+	bool stale_ok;
 };
 
 #if defined(__cplusplus)
@@ -35,6 +35,8 @@
 
 #include "trivia/util.h"
 #include "fiber.h"
+#include "tt_pthread.h"
+#include <third_party/pmatomic.h>
 
 uint32_t snapshot_version;
 
@@ -55,6 +57,61 @@ enum {
 
 static struct mempool tuple_iterator_pool;
 
+/**
+ * Tuple memory of a cord, see tuple_init(). With cord arenas off,
+ * tx allocates all tuples from memtx_alloc. With them on, every
+ * other cord allocates tuples from an arena of its own, created
+ * by its first tuple_alloc(), and each tuple keeps the id of its
+ * arena in front of the field map. A tuple may be deleted in any
+ * cord, but only the owner of the arena frees it: other cords
+ * queue it, and the owner collects the queue on its next
+ * tuple_alloc() or in tuple_arena_collect().
+ *
+ * Only tx tuples reference their format and are kept by read
+ * views and snapshots: the tuples of other cords rely on their
+ * space to keep the format alive.
+ */
+struct tuple_arena {
+	uint32_t id;
+	/** memtx_alloc in tx, cord_alloc in other cords. */
+	struct small_alloc *alloc;
+	struct slab_cache slab_cache;
+	struct small_alloc cord_alloc;
+	/** Protects the queue of tuples deleted by other cords. */
+	pthread_mutex_t lock;
+	struct tuple **remote;
+	uint32_t remote_size;
+	uint32_t remote_capacity;
+	/** The queue being collected, swapped with remote. */
+	struct tuple **spare;
+	uint32_t spare_capacity;
+};
+
+/** The max number of cords which allocate tuples. */
+enum { TUPLE_ARENA_MAX = 64 };
+
+static bool tuple_cord_arenas;
+/** The size of the arena id in front of a tuple, if any. */
+static uint32_t tuple_prefix_size;
+static uint32_t tuple_objsize_min;
+static float tuple_alloc_factor;
+static struct tuple_arena tx_tuple_arena;
+static struct tuple_arena *tuple_arenas[TUPLE_ARENA_MAX];
+static uint32_t tuple_arena_count;
+/** The arena of the current cord, -1 until it's created. */
+static __thread int cord_tuple_arena_id = -1;
+
+/** A tuple which free is deferred by a read view. */
+struct tuple_garbage {
+	struct stailq_entry in_garbage;
+	struct tuple *tuple;
+};
+
+static struct mempool tuple_garbage_pool;
+
+/** Open tuple read views, oldest first. */
+static RLIST_HEAD(tuple_read_views);
+
 /**
  * Last tuple returned by public C API
  * \sa tuple_bless()
@@ -155,15 +212,129 @@ tuple_validate(struct tuple_format *format, struct tuple *tuple)
  * to the snapshot file).
  */
 
+static void
+tuple_arena_create(struct tuple_arena *arena, uint32_t id,
+		   struct small_alloc *alloc)
+{
+	arena->id = id;
+	arena->alloc = alloc;
+	tt_pthread_mutex_init(&arena->lock, NULL);
+	arena->remote = NULL;
+	arena->remote_size = 0;
+	arena->remote_capacity = 0;
+	arena->spare = NULL;
+	arena->spare_capacity = 0;
+}
+
+/** Create the tuple arena of the current cord. */
+static struct tuple_arena *
+tuple_arena_new()
+{
+	uint32_t id = pm_atomic_fetch_add(&tuple_arena_count, 1);
+	if (id >= TUPLE_ARENA_MAX) {
+		tnt_raise(ClientError, ER_UNSUPPORTED, "Tuple arena",
+			  "more than 64 cords");
+	}
+	struct tuple_arena *arena = (struct tuple_arena *)
+		malloc(sizeof(*arena));
+	if (arena == NULL) {
+		tnt_raise(OutOfMemory, sizeof(*arena), "malloc",
+			  "struct tuple_arena");
+	}
+	slab_cache_create(&arena->slab_cache, &memtx_arena);
+	small_alloc_create(&arena->cord_alloc, &arena->slab_cache,
+			   tuple_objsize_min, tuple_alloc_factor);
+	tuple_arena_create(arena, id, &arena->cord_alloc);
+	/*
+	 * Other cords look the arena up by the id of a tuple,
+	 * which they get after the tuple is allocated.
+	 */
+	tuple_arenas[id] = arena;
+	cord_tuple_arena_id = id;
+	return arena;
+}
+
+/** Queue a tuple to be freed by the owner of its arena. */
+static void
+tuple_arena_push(struct tuple_arena *arena, struct tuple *tuple)
+{
+	tt_pthread_mutex_lock(&arena->lock);
+	if (arena->remote_size == arena->remote_capacity) {
+		uint32_t capacity = MAX(arena->remote_capacity * 2, 64);
+		struct tuple **remote = (struct tuple **)
+			realloc(arena->remote, capacity * sizeof(*remote));
+		if (remote == NULL)
+			panic("failed to defer tuple free");
+		arena->remote = remote;
+		arena->remote_capacity = capacity;
+	}
+	arena->remote[arena->remote_size] = tuple;
+	pm_atomic_store_explicit(&arena->remote_size, arena->remote_size + 1,
+				 pm_memory_order_relaxed);
+	tt_pthread_mutex_unlock(&arena->lock);
+}
+
+void
+tuple_arena_collect()
+{
+	if (!tuple_cord_arenas || cord_tuple_arena_id < 0)
+		return;
+	struct tuple_arena *arena = tuple_arenas[cord_tuple_arena_id];
+	if (pm_atomic_load_explicit(&arena->remote_size,
+				    pm_memory_order_relaxed) == 0)
+		return;
+	tt_pthread_mutex_lock(&arena->lock);
+	struct tuple **batch = arena->remote;
+	uint32_t count = arena->remote_size;
+	uint32_t capacity = arena->remote_capacity;
+	arena->remote = arena->spare;
+	arena->remote_size = 0;
+	arena->remote_capacity = arena->spare_capacity;
+	arena->spare = batch;
+	arena->spare_capacity = capacity;
+	tt_pthread_mutex_unlock(&arena->lock);
+	/* The owner never queues to itself, see tuple_delete(). */
+	for (uint32_t i = 0; i < count; i++)
+		tuple_delete(batch[i]);
+}
+
+/** The arena of the current cord, with the queue collected. */
+static struct tuple_arena *
+tuple_arena_get()
+{
+	if (cord_tuple_arena_id < 0)
+		return tuple_arena_new();
+	tuple_arena_collect();
+	return tuple_arenas[cord_tuple_arena_id];
+}
+
+static inline struct tuple_arena *
+tuple_arena_of(struct tuple *tuple)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	uint32_t id = *(uint32_t *) ((char *) tuple -
+				     format->field_map_size -
+				     tuple_prefix_size);
+	assert(id < TUPLE_ARENA_MAX && tuple_arenas[id] != NULL);
+	return tuple_arenas[id];
+}
+
 /** Allocate a tuple */
 struct tuple *
 tuple_alloc(struct tuple_format *format, size_t size)
 {
-	size_t total = sizeof(struct tuple) + size + format->field_map_size;
+	size_t total = tuple_prefix_size + sizeof(struct tuple) + size +
+		format->field_map_size;
 	ERROR_INJECT(ERRINJ_TUPLE_ALLOC,
 		     tnt_raise(OutOfMemory, (unsigned) total,
 			       "slab allocator", "tuple"));
-	char *ptr = (char *) smalloc(&memtx_alloc, total);
+	struct tuple_arena *arena = &tx_tuple_arena;
+	struct small_alloc *alloc = &memtx_alloc;
+	if (tuple_cord_arenas) {
+		arena = tuple_arena_get();
+		alloc = arena->alloc;
+	}
+	char *ptr = (char *) smalloc(alloc, total);
 	/**
 	 * Use a nothrow version and throw an exception here,
 	 * to throw an instance of ClientError. Apart from being
@@ -173,7 +344,7 @@ tuple_alloc(struct tuple_format *format, size_t size)
 	 * of disaster recovery.
 	 */
 	if (ptr == NULL) {
-		if (total > memtx_alloc.objsize_max) {
+		if (total > alloc->objsize_max) {
 			tnt_raise(LoggedError, ER_SLAB_ALLOC_MAX,
 				  (unsigned) total);
 		} else {
@@ -181,18 +352,42 @@ tuple_alloc(struct tuple_format *format, size_t size)
 				  "slab allocator", "tuple");
 		}
 	}
+	if (tuple_prefix_size > 0) {
+		*(uint32_t *) ptr = arena->id;
+		ptr += tuple_prefix_size;
+	}
 	struct tuple *tuple = (struct tuple *)(ptr + format->field_map_size);
 
 	tuple->refs = 0;
-	tuple->version = snapshot_version;
 	tuple->bsize = size;
 	tuple->format_id = tuple_format_id(format);
-	tuple_format_ref(format, 1);
+	if (arena == &tx_tuple_arena) {
+		tuple->version = snapshot_version;
+		tuple_format_ref(format, 1);
+	} else {
+		tuple->version = 0;
+	}
 
 	say_debug("tuple_alloc(%zu) = %p", size, tuple);
 	return tuple;
 }
 
+/** Return the tuple memory to the allocator. */
+static void
+tuple_free_memory(struct tuple *tuple)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	size_t total = tuple_prefix_size + sizeof(struct tuple) +
+		tuple->bsize + format->field_map_size;
+	char *ptr = (char *) tuple - format->field_map_size -
+		tuple_prefix_size;
+	tuple_format_ref(format, -1);
+	if (!memtx_alloc.is_delayed_free_mode || tuple->version == snapshot_version)
+		smfree(&memtx_alloc, ptr, total);
+	else
+		smfree_delayed(&memtx_alloc, ptr, total);
+}
+
 /**
  * Free the tuple.
  * @pre tuple->refs  == 0
@@ -202,14 +397,44 @@ tuple_delete(struct tuple *tuple)
 {
 	say_debug("tuple_delete(%p)", tuple);
 	assert(tuple->refs == 0);
-	struct tuple_format *format = tuple_format(tuple);
-	size_t total = sizeof(struct tuple) + tuple->bsize + format->field_map_size;
-	char *ptr = (char *) tuple - format->field_map_size;
-	tuple_format_ref(format, -1);
-	if (!memtx_alloc.is_delayed_free_mode || tuple->version == snapshot_version)
-		smfree(&memtx_alloc, ptr, total);
-	else
-		smfree_delayed(&memtx_alloc, ptr, total);
+	if (tuple_cord_arenas) {
+		struct tuple_arena *arena = tuple_arena_of(tuple);
+		if ((int) arena->id != cord_tuple_arena_id) {
+			tuple_arena_push(arena, tuple);
+			return;
+		}
+		if (arena != &tx_tuple_arena) {
+			struct tuple_format *format = tuple_format(tuple);
+			size_t total = tuple_prefix_size +
+				sizeof(struct tuple) + tuple->bsize +
+				format->field_map_size;
+			smfree(arena->alloc, (char *) tuple -
+			       format->field_map_size - tuple_prefix_size,
+			       total);
+			return;
+		}
+	}
+	if (! rlist_empty(&tuple_read_views)) {
+		/*
+		 * The tuple header can't hold a free list link
+		 * like in smfree_delayed(), since the view users
+		 * still read it.
+		 */
+		struct tuple_read_view *view =
+			rlist_last_entry(&tuple_read_views,
+					 struct tuple_read_view, link);
+		if (tuple->version < view->version) {
+			struct tuple_garbage *garbage = (struct tuple_garbage *)
+				mempool_alloc(&tuple_garbage_pool);
+			if (garbage == NULL)
+				panic("failed to defer tuple free");
+			garbage->tuple = tuple;
+			stailq_add_tail_entry(&view->garbage, garbage,
+					      in_garbage);
+			return;
+		}
+	}
+	tuple_free_memory(tuple);
 }
 
 /**
@@ -658,7 +883,7 @@ tuple_compare_with_key_default(const struct tuple *tuple, const char *key,
 
 void
 tuple_init(float tuple_arena_max_size, uint32_t objsize_min,
-	   uint32_t objsize_max, float alloc_factor)
+	   uint32_t objsize_max, float alloc_factor, bool cord_arenas)
 {
 	tuple_format_init();
 
@@ -694,8 +919,19 @@ tuple_init(float tuple_arena_max_size, uint32_t objsize_min,
 	slab_cache_create(&memtx_slab_cache, &memtx_arena);
 	small_alloc_create(&memtx_alloc, &memtx_slab_cache,
 			   objsize_min, alloc_factor);
+
+	tuple_cord_arenas = cord_arenas;
+	tuple_prefix_size = cord_arenas ? sizeof(uint32_t) : 0;
+	tuple_objsize_min = objsize_min;
+	tuple_alloc_factor = alloc_factor;
+	tuple_arena_create(&tx_tuple_arena, 0, &memtx_alloc);
+	tuple_arenas[0] = &tx_tuple_arena;
+	tuple_arena_count = 1;
+	cord_tuple_arena_id = 0;
 	mempool_create(&tuple_iterator_pool, &cord()->slabc,
 		       sizeof(struct tuple_iterator));
+	mempool_create(&tuple_garbage_pool, &cord()->slabc,
+		       sizeof(struct tuple_garbage));
 
 	box_tuple_last = NULL;
 }
@@ -710,6 +946,9 @@ tuple_free()
 	}
 
 	mempool_destroy(&tuple_iterator_pool);
+	mempool_destroy(&tuple_garbage_pool);
+	free(tx_tuple_arena.remote);
+	free(tx_tuple_arena.spare);
 
 	tuple_format_free();
 }
@@ -727,6 +966,39 @@ tuple_end_snapshot()
 	small_alloc_setopt(&memtx_alloc, SMALL_DELAYED_FREE_MODE, false);
 }
 
+void
+tuple_read_view_open(struct tuple_read_view *view)
+{
+	/* Tuples allocated from now on are not visible in the view. */
+	view->version = ++snapshot_version;
+	stailq_create(&view->garbage);
+	rlist_add_tail_entry(&tuple_read_views, view, link);
+}
+
+void
+tuple_read_view_close(struct tuple_read_view *view)
+{
+	/*
+	 * A tuple is deferred by the newest view at the moment of
+	 * deletion, so it may be visible only in the older ones.
+	 */
+	struct tuple_read_view *prev = NULL;
+	if (view->link.prev != &tuple_read_views)
+		prev = rlist_prev_entry(view, link);
+	rlist_del_entry(view, link);
+	struct tuple_garbage *garbage, *next;
+	stailq_foreach_entry_safe(garbage, next, &view->garbage, in_garbage) {
+		if (prev != NULL && garbage->tuple->version < prev->version) {
+			stailq_add_tail_entry(&prev->garbage, garbage,
+					      in_garbage);
+		} else {
+			tuple_free_memory(garbage->tuple);
+			mempool_free(&tuple_garbage_pool, garbage);
+		}
+	}
+	stailq_create(&view->garbage);
+}
+
 box_tuple_format_t *
 box_tuple_format_default(void)
 {
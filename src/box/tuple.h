@@ -33,6 +33,7 @@
 #include "trivia/util.h"
 
 #include "tuple_format.h"
+#include "salad/stailq.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -738,10 +739,22 @@ tuple_to_obuf(struct tuple *tuple, struct obuf *buf);
 ssize_t
 tuple_to_buf(const struct tuple *tuple, char *buf, size_t size);
 
-/** Initialize tuple library */
+/**
+ * Initialize tuple library. With cord_arenas, each cord
+ * allocates tuples from an arena of its own.
+ */
 void
 tuple_init(float alloc_arena_max_size, uint32_t slab_alloc_minimal,
-	   uint32_t slab_alloc_maximal, float alloc_factor);
+	   uint32_t slab_alloc_maximal, float alloc_factor,
+	   bool cord_arenas);
+
+/**
+ * Free the tuples of the current cord's arena which other cords
+ * have deleted. A cord which allocates tuples calls it from its
+ * loop, so that the tuples don't wait for its next allocation.
+ */
+void
+tuple_arena_collect();
 
 /** Cleanup tuple library */
 void
@@ -753,6 +766,32 @@ tuple_begin_snapshot();
 void
 tuple_end_snapshot();
 
+/**
+ * A read view of memtx tuples. A tuple which exists when a view
+ * is opened is not freed until the view is closed, even if it is
+ * deleted from all spaces meanwhile, so that the view users may
+ * keep reading it, possibly from another thread.
+ */
+struct tuple_read_view {
+	/** Tuples allocated before the view have lesser versions. */
+	uint32_t version;
+	/** Tuples deleted while the view is open. */
+	struct stailq garbage;
+	/** Link in the list of open views, oldest first. */
+	struct rlist link;
+};
+
+/** Open a read view. Must be called in tx. */
+void
+tuple_read_view_open(struct tuple_read_view *view);
+
+/**
+ * Close a read view and free the tuples it has kept, unless
+ * they are visible in an older view. Must be called in tx.
+ */
+void
+tuple_read_view_close(struct tuple_read_view *view);
+
 extern struct tuple *box_tuple_last;
 
 /**
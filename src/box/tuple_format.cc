@@ -30,12 +30,16 @@
  */
 #include "tuple_format.h"
 
-/** Global table of tuple formats */
+/**
+ * Global table of tuple formats. It has room for all format ids
+ * and never moves, so that formats of tuples may be looked up
+ * from other threads, see memtx read views.
+ */
 struct tuple_format **tuple_formats;
 struct tuple_format *tuple_format_default;
 static intptr_t recycled_format_ids = FORMAT_ID_NIL;
 
-static uint32_t formats_size = 0, formats_capacity = 0;
+static uint32_t formats_size = 0;
 
 /** Extract all available type info from keys. */
 static void
@@ -75,24 +79,9 @@ tuple_format_register(struct tuple_format *format)
 		format->id = (uint16_t) recycled_format_ids;
 		recycled_format_ids = (intptr_t) tuple_formats[recycled_format_ids];
 	} else {
-		if (formats_size == formats_capacity) {
-			uint32_t new_capacity = formats_capacity ?
-						formats_capacity * 2 : 16;
-			struct tuple_format **formats;
-			formats = (struct tuple_format **)
-				realloc(tuple_formats, new_capacity *
-						       sizeof(tuple_formats[0]));
-			if (formats == NULL)
-				tnt_raise(OutOfMemory,
-					  sizeof(struct tuple_format),
-					  "malloc", "tuple_formats");
-
-			formats_capacity = new_capacity;
-			tuple_formats = formats;
-		}
 		if (formats_size == FORMAT_ID_MAX + 1) {
 			tnt_raise(LoggedError, ER_TUPLE_FORMAT_LIMIT,
-				  (unsigned) formats_capacity);
+				  (unsigned) formats_size);
 		}
 		format->id = formats_size++;
 	}
@@ -192,6 +181,14 @@ tuple_format_new(struct rlist *key_list)
 void
 tuple_format_init()
 {
+	/*
+	 * The pages of the table are not touched until
+	 * formats are registered there.
+	 */
+	tuple_formats = (struct tuple_format **)
+		malloc((FORMAT_ID_MAX + 1) * sizeof(tuple_formats[0]));
+	if (tuple_formats == NULL)
+		panic("failed to allocate the tuple format table");
 	RLIST_HEAD(empty_list);
 	tuple_format_default = tuple_format_new(&empty_list);
 	/* Make sure this one stays around. */
@@ -70,6 +70,8 @@
 
 #include "trivia/util.h"
 #include "crc32.h"
+#include "third_party/PMurHash.h"
+#include "salad/bloom.h"
 #include "clock.h"
 #include "trivia/config.h"
 #include "tt_pthread.h"
@@ -100,6 +102,9 @@ struct vy_sequence;
 struct vy_conf;
 struct vy_quota;
 struct vy_cachepool;
+struct vy_page_cache;
+struct vy_cache;
+struct vy_read_pool;
 struct tx_manager;
 struct vy_scheduler;
 struct vy_stat;
@@ -113,6 +118,9 @@ struct vy_env {
 	struct vy_conf      *conf;
 	struct vy_quota     *quota;
 	struct vy_cachepool *cachepool;
+	struct vy_page_cache *page_cache;
+	struct vy_cache     *tuple_cache;
+	struct vy_read_pool *read_pool;
 	struct tx_manager   *xm;
 	struct vy_scheduler *scheduler;
 	struct vy_stat      *stat;
@@ -604,14 +612,29 @@ vy_buf_at(struct vy_buf *b, int size, int i) {
 
 enum vy_quotaop {
 	VINYL_QADD,
-	VINYL_QREMOVE
+	VINYL_QREMOVE,
+	/**
+	 * Account memory of the page and tuple caches, see
+	 * vy_quota::cache.
+	 */
+	VINYL_QADD_CACHE,
+	VINYL_QREMOVE_CACHE
 };
 
 struct vy_quota {
 	bool enable;
 	int wait;
+	/** The limit of in-memory indexes, without caches. */
 	int64_t limit;
 	int64_t used;
+	/**
+	 * Memory of the page and tuple caches. It is bounded by
+	 * the cache limits and freed by eviction, not by dumps,
+	 * so it is kept out of used: otherwise full caches would
+	 * throttle writers and move the scheduler to the zones
+	 * of higher memory pressure, which dumps can't relieve.
+	 */
+	int64_t cache;
 	pthread_mutex_t lock;
 	pthread_cond_t cond;
 };
@@ -628,11 +651,12 @@ vy_quota_enable(struct vy_quota*);
 static int
 vy_quota_op(struct vy_quota*, enum vy_quotaop, int64_t);
 
+/** Memory taken by in-memory indexes and caches. */
 static inline uint64_t
 vy_quota_used(struct vy_quota *q)
 {
 	tt_pthread_mutex_lock(&q->lock);
-	uint64_t used = q->used;
+	uint64_t used = q->used + q->cache;
 	tt_pthread_mutex_unlock(&q->lock);
 	return used;
 }
@@ -1128,6 +1152,7 @@ vy_quota_new(int64_t limit)
 	q->wait   = 0;
 	q->limit  = limit;
 	q->used   = 0;
+	q->cache  = 0;
 	tt_pthread_mutex_init(&q->lock, NULL);
 	tt_pthread_cond_init(&q->cond, NULL);
 	return q;
@@ -1176,6 +1201,12 @@ vy_quota_op(struct vy_quota *q, enum vy_quotaop op, int64_t v)
 			tt_pthread_cond_signal(&q->cond);
 		}
 		break;
+	case VINYL_QADD_CACHE:
+		q->cache += v;
+		break;
+	case VINYL_QREMOVE_CACHE:
+		q->cache -= v;
+		break;
 	}
 	tt_pthread_mutex_unlock(&q->lock);
 	return 0;
@@ -1681,6 +1712,10 @@ static inline int
 vy_tuple_compare(const char *tuple_data_a, const char *tuple_data_b,
 		 const struct key_def *key_def);
 
+static inline bool
+vy_tuple_key_hash(const char *tuple_data, const struct key_def *key_def,
+		  uint32_t *hash);
+
 static struct vy_tuple *
 vy_tuple_from_key_data(struct vy_index *index, const char *key,
 			  uint32_t part_count);
@@ -2666,6 +2701,21 @@ struct PACKED vy_page_index_header {
 	char      reserve[31];
 };
 
+/** Flags of vy_page_index_header::extensions. */
+enum {
+	/**
+	 * The page index is followed by a bloom filter of the run
+	 * keys: uint32 crc of the filter and bloom_store() data.
+	 */
+	VY_PAGE_INDEX_BLOOM = 1,
+};
+
+enum {
+	/** Bits of a run bloom filter per key, ~1% false positives. */
+	VY_BLOOM_BITS_PER_KEY = 10,
+	VY_BLOOM_SEED = 13U,
+};
+
 struct PACKED vy_page_info {
 	/* offset of page data in file (0 for first page) */
 	uint64_t offset;
@@ -2691,6 +2741,11 @@ struct PACKED vy_page_info {
 struct vy_page_index {
 	struct vy_page_index_header header;
 	struct vy_buf pages, minmax;
+	/**
+	 * The filter of the run keys, NULL if the run has none,
+	 * see vy_run_may_have().
+	 */
+	struct bloom *bloom;
 };
 
 struct PACKED vy_run {
@@ -2700,6 +2755,8 @@ struct PACKED vy_run {
 	struct vy_run *next;
 	struct sdpage *page_cache;
 	pthread_mutex_t cache_lock;
+	/** The cache the pages are accounted in, set on first load. */
+	struct vy_page_cache *shared_cache;
 };
 
 struct PACKED vy_range {
@@ -2727,6 +2784,21 @@ struct PACKED vy_range {
 
 typedef rb_tree(struct vy_range) vy_range_tree_t;
 
+/**
+ * When to compact a range, see vy_range_need_compact().
+ */
+enum vy_compaction {
+	VY_COMPACTION_TIERED,
+	VY_COMPACTION_LEVELED,
+	VY_COMPACTION_HYBRID,
+	vy_compaction_MAX
+};
+
+static const char *vy_compaction_strs[] = { "tiered", "leveled", "hybrid" };
+
+/** The max number of runs of a range under the leveled policy. */
+enum { VY_LEVELED_RUN_MAX = 8 };
+
 struct vy_index_conf {
 	uint32_t    id;
 	char       *name;
@@ -2736,6 +2808,8 @@ struct vy_index_conf {
 	char       *compression_sz;
 	struct vy_filterif *compression_if;
 	uint32_t    buf_gc_wm;
+	enum vy_compaction compaction;
+	uint32_t    compaction_ratio;
 	struct srversion   version;
 	struct srversion   version_storage;
 };
@@ -2757,6 +2831,9 @@ struct vy_profiler {
 	uint64_t  count_dup;
 	uint64_t  read_disk;
 	uint64_t  read_cache;
+	uint64_t  bloom_skip;
+	char      write_amp_sz[16];
+	char      space_amp_sz[16];
 	int       histogram_run[20];
 	int       histogram_run_20plus;
 	char      histogram_run_sz[256];
@@ -2789,6 +2866,26 @@ struct txv {
 
 typedef rb_tree(struct txv) txvindex_t;
 
+/**
+ * A result of a point lookup, see struct vy_cache.
+ */
+struct vy_cache_entry {
+	/**
+	 * The merged tuple or, if there is no such key, the key
+	 * marked with SVDELETE, see vy_tuple_is_not_found().
+	 */
+	struct vy_tuple *tuple;
+	/** The entry is valid for read views at or after vlsn. */
+	uint64_t vlsn;
+	struct vy_index *index;
+	/** Member of vy_index::cache_tree. */
+	rb_node(struct vy_cache_entry) in_tree;
+	/** Member of vy_cache::lru. */
+	struct rlist in_lru;
+};
+
+typedef rb_tree(struct vy_cache_entry) vy_cache_tree_t;
+
 struct vy_index {
 	struct vy_env *env;
 	struct vy_profiler rtp;
@@ -2807,6 +2904,11 @@ struct vy_index {
 	uint64_t update_time;
 	uint64_t read_disk;
 	uint64_t read_cache;
+	/** Runs skipped by point lookups thanks to bloom filters. */
+	uint64_t bloom_skip;
+	/** Bytes written to disk by dumps and by compactions. */
+	uint64_t dump_size;
+	uint64_t compact_size;
 	uint64_t size;
 	pthread_mutex_t ref_lock;
 	uint32_t refs;
@@ -2819,6 +2921,14 @@ struct vy_index {
 	/** Member of env->db or scheduler->shutdown. */
 	struct rlist link;
 
+	/* {{{ Tuple cache members, protected by vy_cache::lock */
+	vy_cache_tree_t cache_tree;
+	/** Incremented by every commit to the index. */
+	uint64_t cache_version;
+	/** LSN of the last commit to the index. */
+	uint64_t cache_lsn;
+	/* Tuple cache members }}} */
+
 	/* {{{ Scheduler members */
 	struct rlist gc;
 	struct vy_planner p;
@@ -2916,6 +3026,243 @@ txv_abort(struct txv *v)
 	v->tx->is_aborted = true;
 }
 
+/** {{{ Tuple cache */
+
+/**
+ * Results of point lookups by a full key: tuples with all
+ * statements of the key merged and upserts applied, or the fact
+ * that there is no such key. A hit spares a read of the in-memory
+ * indexes and the runs of the range, and in the transaction
+ * thread it spares a trip to a worker thread as well.
+ *
+ * A commit of a key drops its entry, so an entry is always the
+ * latest state of the key. To make sure a lookup didn't race with
+ * a commit, its result is added only if it read the latest
+ * committed state of the index and nothing was committed to the
+ * index while it was running.
+ *
+ * Entries of all indexes share the LRU list and the limit, and
+ * are accounted in the vinyl memory quota.
+ */
+struct vy_cache {
+	pthread_mutex_t lock;
+	/** All entries, the least recently used first. */
+	struct rlist lru;
+	/** Memory taken by the entries. */
+	uint64_t used;
+	uint64_t limit;
+	uint64_t hit;
+	uint64_t miss;
+	struct vy_quota *quota;
+};
+
+static int
+vy_cache_entry_cmp(vy_cache_tree_t *tree, struct vy_cache_entry *a,
+		   struct vy_cache_entry *b)
+{
+	struct key_def *key_def =
+		container_of(tree, struct vy_index, cache_tree)->key_def;
+	return vy_tuple_compare(a->tuple->data, b->tuple->data, key_def);
+}
+
+static int
+vy_cache_entry_key_cmp(vy_cache_tree_t *tree, const char *key,
+		       struct vy_cache_entry *b)
+{
+	struct key_def *key_def =
+		container_of(tree, struct vy_index, cache_tree)->key_def;
+	return vy_tuple_compare(key, b->tuple->data, key_def);
+}
+
+rb_gen_ext_key(, vy_cache_tree_, vy_cache_tree_t, struct vy_cache_entry,
+	       in_tree, vy_cache_entry_cmp, const char *,
+	       vy_cache_entry_key_cmp);
+
+static struct vy_cache *
+vy_cache_new(uint64_t limit, struct vy_quota *quota)
+{
+	struct vy_cache *cache = malloc(sizeof(*cache));
+	if (cache == NULL) {
+		diag_set(OutOfMemory, sizeof(*cache), "tuple cache", "struct");
+		return NULL;
+	}
+	tt_pthread_mutex_init(&cache->lock, NULL);
+	rlist_create(&cache->lru);
+	cache->used = 0;
+	cache->limit = limit;
+	cache->hit = 0;
+	cache->miss = 0;
+	cache->quota = quota;
+	return cache;
+}
+
+static inline size_t
+vy_cache_entry_size(struct vy_cache_entry *entry)
+{
+	return sizeof(*entry) + vy_tuple_size(entry->tuple);
+}
+
+/* forget an entry, the cache lock must be held */
+static void
+vy_cache_entry_delete(struct vy_cache *cache, struct vy_cache_entry *entry)
+{
+	size_t size = vy_cache_entry_size(entry);
+	assert(cache->used >= size);
+	cache->used -= size;
+	vy_quota_op(cache->quota, VINYL_QREMOVE_CACHE, size);
+	vy_cache_tree_remove(&entry->index->cache_tree, entry);
+	rlist_del_entry(entry, in_lru);
+	vy_tuple_unref(entry->tuple);
+	free(entry);
+}
+
+/* evict entries until the cache fits its limit */
+static void
+vy_cache_evict(struct vy_cache *cache)
+{
+	while (cache->used > cache->limit && !rlist_empty(&cache->lru)) {
+		struct vy_cache_entry *entry =
+			rlist_first_entry(&cache->lru, struct vy_cache_entry,
+					  in_lru);
+		vy_cache_entry_delete(cache, entry);
+	}
+}
+
+static void
+vy_cache_delete(struct vy_cache *cache)
+{
+	cache->limit = 0;
+	vy_cache_evict(cache);
+	tt_pthread_mutex_destroy(&cache->lock);
+	free(cache);
+}
+
+/** Drop all entries of an index which is being deleted. */
+static void
+vy_cache_drop_index(struct vy_cache *cache, struct vy_index *index)
+{
+	tt_pthread_mutex_lock(&cache->lock);
+	struct vy_cache_entry *entry;
+	while ((entry = vy_cache_tree_first(&index->cache_tree)) != NULL)
+		vy_cache_entry_delete(cache, entry);
+	tt_pthread_mutex_unlock(&cache->lock);
+}
+
+/**
+ * Look a full key up for the read view vlsn.
+ * @retval true  found, *result is a referenced tuple, marked
+ *               with SVDELETE if there is no such key
+ * @retval false unknown
+ */
+static bool
+vy_cache_get(struct vy_cache *cache, struct vy_index *index,
+	     struct vy_tuple *key, uint64_t vlsn, struct vy_tuple **result)
+{
+	tt_pthread_mutex_lock(&cache->lock);
+	struct vy_cache_entry *entry =
+		vy_cache_tree_search(&index->cache_tree, key->data);
+	if (entry == NULL || vlsn < entry->vlsn) {
+		tt_pthread_mutex_unlock(&cache->lock);
+		return false;
+	}
+	cache->hit++;
+	rlist_move_tail_entry(&cache->lru, entry, in_lru);
+	vy_tuple_ref(entry->tuple);
+	*result = entry->tuple;
+	tt_pthread_mutex_unlock(&cache->lock);
+	return true;
+}
+
+/** Count a lookup the cache couldn't answer. */
+static void
+vy_cache_miss(struct vy_cache *cache)
+{
+	tt_pthread_mutex_lock(&cache->lock);
+	cache->miss++;
+	tt_pthread_mutex_unlock(&cache->lock);
+}
+
+/** The version of the index to pass to vy_cache_add(). */
+static uint64_t
+vy_cache_version(struct vy_cache *cache, struct vy_index *index)
+{
+	tt_pthread_mutex_lock(&cache->lock);
+	uint64_t version = index->cache_version;
+	tt_pthread_mutex_unlock(&cache->lock);
+	return version;
+}
+
+/**
+ * Remember the result of a lookup of a full key, NULL if there
+ * is no such key. The lookup must have read the read view vlsn
+ * and started at the index version.
+ * The cache is only an optimization, so errors are ignored.
+ */
+static void
+vy_cache_add(struct vy_cache *cache, struct vy_index *index,
+	     struct vy_tuple *key, struct vy_tuple *result, uint64_t vlsn,
+	     uint64_t version)
+{
+	if (cache->limit == 0)
+		return;
+	struct vy_tuple *tuple = result;
+	if (tuple == NULL) {
+		tuple = vy_tuple_alloc(key->size);
+		if (tuple == NULL) {
+			diag_clear(diag_get());
+			return;
+		}
+		memcpy(tuple->data, key->data, key->size);
+		tuple->flags = SVDELETE;
+	} else {
+		vy_tuple_ref(tuple);
+	}
+	struct vy_cache_entry *entry = malloc(sizeof(*entry));
+	if (entry == NULL) {
+		vy_tuple_unref(tuple);
+		return;
+	}
+	entry->tuple = tuple;
+	entry->index = index;
+	size_t size = vy_cache_entry_size(entry);
+
+	tt_pthread_mutex_lock(&cache->lock);
+	if (index->cache_version != version || vlsn < index->cache_lsn ||
+	    vy_cache_tree_search(&index->cache_tree, key->data) != NULL) {
+		/* stale, or added by a concurrent lookup */
+		tt_pthread_mutex_unlock(&cache->lock);
+		vy_tuple_unref(tuple);
+		free(entry);
+		return;
+	}
+	/* the key hasn't changed since the last commit */
+	entry->vlsn = index->cache_lsn;
+	vy_cache_tree_insert(&index->cache_tree, entry);
+	rlist_add_tail_entry(&cache->lru, entry, in_lru);
+	cache->used += size;
+	vy_quota_op(cache->quota, VINYL_QADD_CACHE, size);
+	vy_cache_evict(cache);
+	tt_pthread_mutex_unlock(&cache->lock);
+}
+
+/** Drop the entry of a key committed to the index at lsn. */
+static void
+vy_cache_invalidate(struct vy_cache *cache, struct vy_index *index,
+		    struct vy_tuple *tuple, uint64_t lsn)
+{
+	tt_pthread_mutex_lock(&cache->lock);
+	index->cache_version++;
+	if (lsn > index->cache_lsn)
+		index->cache_lsn = lsn;
+	struct vy_cache_entry *entry =
+		vy_cache_tree_search(&index->cache_tree, tuple->data);
+	if (entry != NULL)
+		vy_cache_entry_delete(cache, entry);
+	tt_pthread_mutex_unlock(&cache->lock);
+}
+
+/** }}} Tuple cache */
+
 static int
 txvindex_cmp(txvindex_t *rbtree, struct txv *a, struct txv *b);
 
@@ -3224,6 +3571,10 @@ struct PACKED sdpageheader {
 struct sdpage {
 	struct sdpageheader *h;
 	uint32_t refs;
+	/** The size of the page data, see vy_page_cache. */
+	uint32_t size;
+	/** Link in vy_page_cache::lru while the page is unused. */
+	struct rlist in_lru;
 };
 
 static inline void
@@ -3260,12 +3611,18 @@ vy_page_index_init(struct vy_page_index *i) {
 	vy_buf_init(&i->pages);
 	vy_buf_init(&i->minmax);
 	memset(&i->header, 0, sizeof(i->header));
+	i->bloom = NULL;
 }
 
 static inline void
 vy_page_index_free(struct vy_page_index *i) {
 	vy_buf_free(&i->pages);
 	vy_buf_free(&i->minmax);
+	if (i->bloom != NULL) {
+		bloom_destroy(i->bloom);
+		free(i->bloom);
+		i->bloom = NULL;
+	}
 }
 
 static inline struct vy_page_info *
@@ -3486,6 +3843,33 @@ struct sdread {
 	int reads;
 };
 
+/**
+ * Load the bloom filter stored after the page index. The filter
+ * is only an optimization, so a run is still usable without it
+ * if it is corrupted or there is no memory for it.
+ */
+static void
+vy_page_index_load_bloom(struct vy_page_index *i, const char *ptr)
+{
+	uint32_t size = i->header.extension;
+	if (size < sizeof(uint32_t))
+		return;
+	uint32_t crc;
+	memcpy(&crc, ptr, sizeof(crc));
+	ptr += sizeof(crc);
+	size -= sizeof(crc);
+	if (crc != crc32_calc(0, ptr, size))
+		return;
+	struct bloom *bloom = malloc(sizeof(*bloom));
+	if (bloom == NULL)
+		return;
+	if (bloom_load(bloom, ptr, size) != 0) {
+		free(bloom);
+		return;
+	}
+	i->bloom = bloom;
+}
+
 static int
 vy_page_index_load(struct vy_page_index *i, void *ptr)
 {
@@ -3506,6 +3890,10 @@ vy_page_index_load(struct vy_page_index *i, void *ptr)
 	       minmax_size);
 	vy_buf_advance(&i->minmax, minmax_size);
 	i->header = *h;
+	if (h->extensions & VY_PAGE_INDEX_BLOOM)
+		vy_page_index_load_bloom(i, (char *)ptr +
+					 sizeof(struct vy_page_index_header) +
+					 h->size);
 	return 0;
 }
 
@@ -3656,7 +4044,7 @@ static int sd_recover_complete(struct sdrecover *ri)
 	 * index */
 	char *eof = ri->map.p +
 		    ri->actual->offset + sizeof(struct vy_page_index_header) +
-		    ri->actual->size - ri->actual->extension;
+		    ri->actual->size + ri->actual->extension;
 	uint64_t file_size = eof - ri->map.p;
 	int rc = vy_file_resize(ri->file, file_size);
 	if (unlikely(rc == -1))
@@ -3676,6 +4064,7 @@ vy_run_init(struct vy_run *run)
 	run->link = NULL;
 	run->next = NULL;
 	run->page_cache = NULL;
+	run->shared_cache = NULL;
 	pthread_mutex_init(&run->cache_lock, NULL);
 }
 
@@ -3699,26 +4088,139 @@ vy_run_set(struct vy_run *run, struct vy_page_index *i)
 	run->index = *i;
 }
 
+/**
+ * Check if the run may have statements with the key of the
+ * given hash, see vy_tuple_key_hash().
+ */
+static inline bool
+vy_run_may_have(struct vy_run *run, uint32_t key_hash)
+{
+	return run->index.bloom == NULL ||
+	       bloom_maybe_has(run->index.bloom, key_hash);
+}
+
+/** {{{ Page cache */
+
+/**
+ * Decompressed run pages shared by all vinyl indexes.
+ *
+ * A page is freed when its last user unloads it only if the cache
+ * is over its limit: otherwise it is put to the LRU list and is
+ * found by the next vy_run_load_page() without a disk read. Pages,
+ * both used and cached, are accounted in the vinyl memory quota
+ * apart from in-memory indexes, see vy_quota::cache.
+ * The page state (data, refs and LRU link) of all runs is
+ * protected by the cache lock.
+ */
+struct vy_page_cache {
+	pthread_mutex_t lock;
+	/** Unused pages, the least recently used first. */
+	struct rlist lru;
+	/** Memory taken by all loaded pages. */
+	uint64_t used;
+	/** Unused pages are evicted when used is above the limit. */
+	uint64_t limit;
+	uint64_t hit;
+	uint64_t miss;
+	struct vy_quota *quota;
+};
+
+static struct vy_page_cache *
+vy_page_cache_new(uint64_t limit, struct vy_quota *quota)
+{
+	struct vy_page_cache *cache = malloc(sizeof(*cache));
+	if (cache == NULL) {
+		diag_set(OutOfMemory, sizeof(*cache), "page cache", "struct");
+		return NULL;
+	}
+	tt_pthread_mutex_init(&cache->lock, NULL);
+	rlist_create(&cache->lru);
+	cache->used = 0;
+	cache->limit = limit;
+	cache->hit = 0;
+	cache->miss = 0;
+	cache->quota = quota;
+	return cache;
+}
+
+/* free data of an unused page, the cache lock must be held */
+static void
+vy_page_cache_free_page(struct vy_page_cache *cache, struct sdpage *page)
+{
+	assert(page->refs == 0);
+	assert(cache->used >= page->size);
+	cache->used -= page->size;
+	vy_quota_op(cache->quota, VINYL_QREMOVE_CACHE, page->size);
+	free(page->h);
+	page->h = NULL;
+	page->size = 0;
+}
+
+/* evict unused pages until the cache fits its limit */
+static void
+vy_page_cache_evict(struct vy_page_cache *cache)
+{
+	while (cache->used > cache->limit && !rlist_empty(&cache->lru)) {
+		struct sdpage *page =
+			rlist_first_entry(&cache->lru, struct sdpage, in_lru);
+		rlist_del_entry(page, in_lru);
+		vy_page_cache_free_page(cache, page);
+	}
+}
+
+static void
+vy_page_cache_delete(struct vy_page_cache *cache)
+{
+	cache->limit = 0;
+	vy_page_cache_evict(cache);
+	tt_pthread_mutex_destroy(&cache->lock);
+	free(cache);
+}
+
+/**
+ * Free all pages of the run, which must be unused, and the page
+ * array.
+ */
+static void
+vy_run_free_pages(struct vy_run *run)
+{
+	if (run->page_cache == NULL)
+		return;
+	struct vy_page_cache *cache = run->shared_cache;
+	tt_pthread_mutex_lock(&cache->lock);
+	for (uint32_t pos = 0; pos < run->index.header.count; pos++) {
+		struct sdpage *page = &run->page_cache[pos];
+		if (page->h == NULL)
+			continue;
+		rlist_del_entry(page, in_lru);
+		vy_page_cache_free_page(cache, page);
+	}
+	tt_pthread_mutex_unlock(&cache->lock);
+	free(run->page_cache);
+	run->page_cache = NULL;
+}
+
+/** }}} Page cache */
+
 static inline void
 vy_run_free(struct vy_run *run)
 {
 	vy_page_index_free(&run->index);
-	if (run->page_cache != NULL) {
-		free(run->page_cache);
-		run->page_cache = NULL;
-	}
+	vy_run_free_pages(run);
 	pthread_mutex_destroy(&run->cache_lock);
 	free(run);
 }
 
 /**
  * Load from page with given number
- * If the page is loaded by somebody else, it's returned from cache
+ * If the page is loaded by somebody else or is in the page cache,
+ * it's returned from memory
  * In every case increments page's reference counter
  * After usage user must call vy_run_unload_page
  */
 static struct sdpage *
 vy_run_load_page(struct vy_run *run, uint32_t pos,
+		 struct vy_page_cache *cache,
 		 struct vy_file *file, struct vy_filterif *compression)
 {
 	pthread_mutex_lock(&run->cache_lock);
@@ -3732,13 +4234,22 @@ vy_run_load_page(struct vy_run *run, uint32_t pos,
 				 "load_page", "page cache");
 			return NULL;
 		}
-	}
-	if (run->page_cache[pos].refs) {
-		run->page_cache[pos].refs++;
-		pthread_mutex_unlock(&run->cache_lock);
-		return &run->page_cache[pos];
+		run->shared_cache = cache;
 	}
 	pthread_mutex_unlock(&run->cache_lock);
+	assert(run->shared_cache == cache);
+
+	struct sdpage *page = &run->page_cache[pos];
+	tt_pthread_mutex_lock(&cache->lock);
+	if (page->h != NULL) {
+		if (page->refs++ == 0)
+			rlist_del_entry(page, in_lru);
+		cache->hit++;
+		tt_pthread_mutex_unlock(&cache->lock);
+		return page;
+	}
+	cache->miss++;
+	tt_pthread_mutex_unlock(&cache->lock);
 	struct vy_page_info *page_info = vy_page_index_get_page(&run->index, pos);
 	uint32_t alloc_size = page_info->unpacked_size;
 	if (page_info->size > page_info->unpacked_size)
@@ -3791,14 +4302,35 @@ vy_run_load_page(struct vy_run *run, uint32_t pos,
 		vy_buf_free(&buf);
 	}
 
-	pthread_mutex_lock(&run->cache_lock);
-	run->page_cache[pos].refs++;
-	if (run->page_cache[pos].refs == 1)
-		sd_pageinit(&run->page_cache[pos], data);
-	else
+	tt_pthread_mutex_lock(&cache->lock);
+	if (page->h == NULL) {
+		sd_pageinit(page, data);
+		page->size = alloc_size;
+		cache->used += alloc_size;
+		vy_quota_op(cache->quota, VINYL_QADD_CACHE, alloc_size);
+		vy_page_cache_evict(cache);
+	} else {
+		/* loaded by somebody else meanwhile */
+		if (page->refs++ == 0)
+			rlist_del_entry(page, in_lru);
 		free(data);
-	pthread_mutex_unlock(&run->cache_lock);
-	return &run->page_cache[pos];
+	}
+	tt_pthread_mutex_unlock(&cache->lock);
+	return page;
+}
+
+/**
+ * Increment the reference counter of a page which is already
+ * loaded with vy_run_load_page
+ */
+static void
+vy_run_ref_page(struct vy_run *run, uint32_t pos)
+{
+	struct vy_page_cache *cache = run->shared_cache;
+	tt_pthread_mutex_lock(&cache->lock);
+	assert(run->page_cache[pos].refs > 0);
+	run->page_cache[pos].refs++;
+	tt_pthread_mutex_unlock(&cache->lock);
 }
 
 /**
@@ -3814,21 +4346,24 @@ vy_run_get_page(struct vy_run *run, uint32_t pos)
 }
 
 /**
- * Free page data
- * Actually decrements reference counter and frees data only there are no users
+ * Release page data
+ * Actually decrements reference counter and, when there are no
+ * users left, puts the page to the page cache, which frees the
+ * least recently used pages if it is over the limit
  */
 static void
 vy_run_unload_page(struct vy_run *run, uint32_t pos)
 {
 	assert(run->page_cache != NULL);
-	assert(run->page_cache[pos].refs > 0);
-	pthread_mutex_lock(&run->cache_lock);
-	run->page_cache[pos].refs--;
-	if (run->page_cache[pos].refs == 0) {
-		free(run->page_cache[pos].h);
-		run->page_cache[pos].h = NULL;
+	struct vy_page_cache *cache = run->shared_cache;
+	struct sdpage *page = &run->page_cache[pos];
+	tt_pthread_mutex_lock(&cache->lock);
+	assert(page->refs > 0);
+	if (--page->refs == 0) {
+		rlist_add_tail_entry(&cache->lru, page, in_lru);
+		vy_page_cache_evict(cache);
 	}
-	pthread_mutex_unlock(&run->cache_lock);
+	tt_pthread_mutex_unlock(&cache->lock);
 }
 
 #define SI_NONE       0
@@ -3935,14 +4470,20 @@ vy_range_cmpnode(struct vy_range *n1, struct vy_range *n2, struct key_def *key_d
 				key_def);
 }
 
+static inline uint64_t
+vy_run_size(struct vy_run *run)
+{
+	return vy_page_index_size(&run->index) +
+	       vy_page_index_total(&run->index);
+}
+
 static inline uint64_t
 vy_range_size(struct vy_range *n)
 {
 	uint64_t size = 0;
 	struct vy_run *run = n->run;
 	while (run) {
-		size += vy_page_index_size(&run->index) +
-		        vy_page_index_total(&run->index);
+		size += vy_run_size(run);
 		run = run->next;
 	}
 	return size;
@@ -4334,14 +4875,34 @@ vy_run_dump_tuple(struct svwriteiter *iwrite, struct vy_buf *info_buf,
 	return 0;
 }
 
+/* remember the key hash of the current tuple for the run bloom filter */
+static int
+vy_run_add_key_hash(struct svwriteiter *iwrite,
+		    const struct key_def *key_def,
+		    struct vy_page_index_header *index_header,
+		    struct vy_buf *hash_buf)
+{
+	if (!(index_header->extensions & VY_PAGE_INDEX_BLOOM))
+		return 0;
+	struct sv *value = sv_writeiter_get(iwrite);
+	uint32_t hash;
+	if (!vy_tuple_key_hash(sv_pointer(value), key_def, &hash)) {
+		/* No filter is better than one with false negatives. */
+		index_header->extensions &= ~VY_PAGE_INDEX_BLOOM;
+		return 0;
+	}
+	return vy_buf_add(hash_buf, &hash, sizeof(hash));
+}
+
 /* write tuples from iterator to new page in run,
  * update page and the run statistics */
 static int
 vy_run_write_page(struct vy_file *file, struct svwriteiter *iwrite,
 		  struct vy_filterif *compression,
+		  const struct key_def *key_def,
 		  struct vy_page_index_header *index_header,
 		  struct vy_page_info *page_info,
-		  struct vy_buf *minmax_buf)
+		  struct vy_buf *minmax_buf, struct vy_buf *hash_buf)
 {
 	memset(page_info, 0, sizeof(*page_info));
 
@@ -4359,6 +4920,10 @@ vy_run_write_page(struct vy_file *file, struct svwriteiter *iwrite,
 					   &header);
 		if (rc != 0)
 			goto err;
+		rc = vy_run_add_key_hash(iwrite, key_def, index_header,
+					 hash_buf);
+		if (rc != 0)
+			goto err;
 		sv_writeiter_next(iwrite);
 	}
 	struct vy_buf compressed;
@@ -4455,13 +5020,51 @@ err:
 	return -1;
 }
 
+/*
+ * build the bloom filter of the run from the key hashes and
+ * serialize it to bloom_buf in the page index extension format
+ */
+static int
+vy_run_build_bloom(struct vy_page_index *sdindex, struct vy_buf *hash_buf,
+		   struct vy_buf *bloom_buf)
+{
+	uint32_t count = vy_buf_used(hash_buf) / sizeof(uint32_t);
+	struct bloom *bloom = malloc(sizeof(*bloom));
+	if (bloom == NULL ||
+	    bloom_create(bloom, count, VY_BLOOM_BITS_PER_KEY) != 0) {
+		free(bloom);
+		diag_set(OutOfMemory, sizeof(*bloom) + count, "malloc",
+			 "struct bloom");
+		return -1;
+	}
+	const uint32_t *hashes = (const uint32_t *) hash_buf->s;
+	for (uint32_t i = 0; i < count; i++)
+		bloom_add(bloom, hashes[i]);
+	size_t size = sizeof(uint32_t) + bloom_store_size(bloom);
+	if (vy_buf_ensure(bloom_buf, size)) {
+		bloom_destroy(bloom);
+		free(bloom);
+		return -1;
+	}
+	char *data = bloom_buf->p + sizeof(uint32_t);
+	bloom_store(bloom, data);
+	uint32_t crc = crc32_calc(0, data, size - sizeof(uint32_t));
+	memcpy(bloom_buf->p, &crc, sizeof(crc));
+	vy_buf_advance(bloom_buf, size);
+	sdindex->bloom = bloom;
+	return 0;
+}
+
 /* write tuples for iterator to new run
  * and setup corresponding sdindex structure */
 static int
 vy_run_write(struct vy_file *file, struct svwriteiter *iwrite,
-	     struct vy_filterif *compression, uint64_t limit, struct sdid *id,
-	     struct vy_page_index *sdindex)
+	     struct vy_filterif *compression, const struct key_def *key_def,
+	     uint64_t limit, struct sdid *id, struct vy_page_index *sdindex)
 {
+	struct vy_buf hash_buf, bloom_buf;
+	vy_buf_init(&hash_buf);
+	vy_buf_init(&bloom_buf);
 	uint64_t seal_offset = file->size;
 	struct sdseal seal;
 	sd_sealset_open(&seal);
@@ -4478,6 +5081,7 @@ vy_run_write(struct vy_file *file, struct svwriteiter *iwrite,
 	index_header->lsnmin = UINT64_MAX;
 	index_header->dupmin = UINT64_MAX;
 	index_header->id = *id;
+	index_header->extensions = VY_PAGE_INDEX_BLOOM;
 
 	do {
 		uint64_t page_offset = file->size;
@@ -4486,14 +5090,21 @@ vy_run_write(struct vy_file *file, struct svwriteiter *iwrite,
 			goto err;
 		struct vy_page_info *page = (struct vy_page_info *)sdindex->pages.p;
 		vy_buf_advance(&sdindex->pages, sizeof(struct vy_page_info));
-		if (vy_run_write_page(file, iwrite, compression, index_header,
-				      page, &sdindex->minmax))
+		if (vy_run_write_page(file, iwrite, compression, key_def,
+				      index_header, page, &sdindex->minmax,
+				      &hash_buf))
 			goto err;
 
 		page->offset = page_offset;
 
 	} while (index_header->total < limit && iwrite && sv_writeiter_resume(iwrite));
 
+	if (vy_buf_used(&hash_buf) == 0)
+		index_header->extensions &= ~VY_PAGE_INDEX_BLOOM;
+	if ((index_header->extensions & VY_PAGE_INDEX_BLOOM) &&
+	    vy_run_build_bloom(sdindex, &hash_buf, &bloom_buf) != 0)
+		goto err;
+	index_header->extension = vy_buf_used(&bloom_buf);
 	index_header->size = vy_buf_used(&sdindex->pages) +
 				vy_buf_used(&sdindex->minmax);
 	index_header->offset = file->size;
@@ -4501,12 +5112,14 @@ vy_run_write(struct vy_file *file, struct svwriteiter *iwrite,
 
 	sd_sealset_close(&seal, index_header);
 
-	struct iovec iovv[3];
+	struct iovec iovv[4];
 	struct vy_iov iov;
-	vy_iov_init(&iov, iovv, 3);
+	vy_iov_init(&iov, iovv, 4);
 	vy_iov_add(&iov, index_header, sizeof(struct vy_page_index_header));
 	vy_iov_add(&iov, sdindex->pages.s, vy_buf_used(&sdindex->pages));
 	vy_iov_add(&iov, sdindex->minmax.s, vy_buf_used(&sdindex->minmax));
+	if (vy_buf_used(&bloom_buf) > 0)
+		vy_iov_add(&iov, bloom_buf.s, vy_buf_used(&bloom_buf));
 	if (vy_file_writev(file, &iov) < 0 ||
 		vy_file_pwrite(file, seal_offset, &seal, sizeof(struct sdseal)) < 0) {
 		vy_error("file '%s' write error: %s",
@@ -4517,11 +5130,14 @@ vy_run_write(struct vy_file *file, struct svwriteiter *iwrite,
 	if (vy_file_sync(file) == -1) {
 		vy_error("index file '%s' sync error: %s",
 		               file->path, strerror(errno));
-		return -1;
+		goto err;
 	}
-
+	vy_buf_free(&hash_buf);
+	vy_buf_free(&bloom_buf);
 	return 0;
 err:
+	vy_buf_free(&hash_buf);
+	vy_buf_free(&bloom_buf);
 	return -1;
 }
 
@@ -4558,8 +5174,8 @@ vy_run_create(struct vy_index *index, struct sdc *c,
 	struct vy_page_index sdindex;
 	vy_page_index_init(&sdindex);
 	if ((rc = vy_run_write(&parent->file, &iwrite,
-			        index->conf.compression_if, UINT64_MAX,
-			        &id, &sdindex)))
+			        index->conf.compression_if, index->key_def,
+			        UINT64_MAX, &id, &sdindex)))
 		goto err;
 
 	*result = vy_run_new();
@@ -4622,8 +5238,8 @@ vy_dump(struct vy_index *index, struct sdc *c, struct vy_range *n,
 	assert(n->used >= i->used);
 	n->used -= i->used;
 	vy_quota_op(env->quota, VINYL_QREMOVE, i->used);
-	index->size += vy_page_index_size(&run->index) +
-		       vy_page_index_total(&run->index);
+	index->size += vy_run_size(run);
+	index->dump_size += vy_run_size(run);
 	struct vy_mem swap = *i;
 	swap.tree.arg = &swap;
 	vy_range_unrotate(n);
@@ -4932,7 +5548,8 @@ si_split(struct vy_index *index, struct sdc *c, struct vy_buf *result,
 
 		if ((rc = vy_run_write(&n->file, &iwrite,
 				       index->conf.compression_if,
-				       size_stream, &id, &sdindex)))
+				       index->key_def, size_stream, &id,
+				       &sdindex)))
 			goto error;
 
 		rc = vy_buf_add(result, &n, sizeof(struct vy_range*));
@@ -5018,6 +5635,7 @@ si_merge(struct vy_index *index, struct sdc *c, struct vy_range *range,
 		n->temperature_reads = range->temperature_reads;
 		n->used = j->used;
 		index->size += vy_range_size(n);
+		index->compact_size += vy_range_size(n);
 		vy_range_lock(n);
 		si_replace(index, range, n);
 		vy_planner_update(&index->p, n);
@@ -5035,6 +5653,7 @@ si_merge(struct vy_index *index, struct sdc *c, struct vy_range *range,
 		n->temperature = range->temperature;
 		n->temperature_reads = range->temperature_reads;
 		index->size += vy_range_size(n);
+		index->compact_size += vy_range_size(n);
 		vy_range_lock(n);
 		si_replace(index, range, n);
 		vy_planner_update(&index->p, n);
@@ -5045,6 +5664,7 @@ si_merge(struct vy_index *index, struct sdc *c, struct vy_range *range,
 			n->temperature = range->temperature;
 			n->temperature_reads = range->temperature_reads;
 			index->size += vy_range_size(n);
+			index->compact_size += vy_range_size(n);
 			vy_range_lock(n);
 			si_insert(index, n);
 			vy_planner_update(&index->p, n);
@@ -5270,6 +5890,7 @@ vy_range_free_runs(struct vy_range *n)
 		vy_run_free(p);
 		p = next;
 	}
+	vy_run_free_pages(&n->self);
 	vy_page_index_free(&n->self.index);
 }
 
@@ -5482,6 +6103,48 @@ vy_planner_peek_age(struct vy_index *index, uint32_t ttl, uint32_t ttl_wm,
 	return 0; /* nothing to do */
 }
 
+/**
+ * Check if a range should be compacted under the compaction
+ * policy of the index. Compaction always merges all runs of
+ * a range into one, the policies differ in when it happens:
+ *
+ * - tiered: the range has run_count (compact_wm) runs. A row is
+ *   rewritten once per run_count dumps, but a read may have to
+ *   look at run_count runs and there may be as many versions
+ *   of a row on disk.
+ * - leveled: the newer runs have grown to 1/ratio of the oldest
+ *   one. The space taken by stale versions stays below 1/ratio
+ *   of the data, but the oldest run is rewritten every time.
+ *   Small dumps into a big range would take hundreds of runs
+ *   to get there, and every read of the range merges them all,
+ *   so the range is also compacted at VY_LEVELED_RUN_MAX runs,
+ *   or at run_count if it is bigger.
+ * - hybrid: whichever of the tiered and leveled conditions
+ *   happens first, so that both the number of runs and the
+ *   stale space are bounded.
+ */
+static bool
+vy_range_need_compact(struct vy_index *index, struct vy_range *range,
+		      uint32_t run_count)
+{
+	enum vy_compaction policy = index->conf.compaction;
+	if (range->run_count < 2)
+		return false;
+	if (policy == VY_COMPACTION_LEVELED)
+		run_count = MAX(run_count, VY_LEVELED_RUN_MAX);
+	if (range->run_count >= run_count)
+		return true;
+	if (policy == VY_COMPACTION_TIERED)
+		return false;
+	uint64_t newer_size = 0;
+	struct vy_run *run = range->run;
+	while (run->next != NULL) {
+		newer_size += vy_run_size(run);
+		run = run->next;
+	}
+	return newer_size * index->conf.compaction_ratio >= vy_run_size(run);
+}
+
 static inline int
 vy_planner_peek_compact(struct vy_index *index, uint32_t run_count,
 			struct vy_task *task)
@@ -5494,13 +6157,19 @@ vy_planner_peek_compact(struct vy_index *index, uint32_t run_count,
 		n = container_of(pn, struct vy_range, nodecompact);
 		if (n->flags & SI_LOCK)
 			continue;
-		if (n->run_count >= run_count) {
+		if (vy_range_need_compact(index, n, run_count)) {
 			vy_task_create(task, index, VY_TASK_COMPACT);
 			vy_range_lock(n);
 			task->node = n;
 			return 1; /* new task */
 		}
-		break; /* TODO: why? */
+		/*
+		 * Ranges are ordered by the number of runs, so for
+		 * the tiered policy the rest have too few of them.
+		 * Run sizes have to be checked range by range.
+		 */
+		if (index->conf.compaction == VY_COMPACTION_TIERED)
+			break;
 	}
 	return 0; /* nothing to do */
 }
@@ -5616,6 +6285,7 @@ static int vy_profiler_(struct vy_profiler *p)
 {
 	uint32_t temperature_total = 0;
 	uint64_t memory_used = 0;
+	uint64_t oldest_run_size = 0;
 	struct vy_range *n = vy_range_tree_first(&p->i->tree);
 	while (n) {
 		if (p->temperature_max < n->temperature)
@@ -5644,6 +6314,8 @@ static int vy_profiler_(struct vy_profiler *p)
 			p->total_node_size += indexsize + run->index.header.total;
 			p->total_node_origin_size += indexsize + run->index.header.totalorigin;
 			p->total_page_count += run->index.header.count;
+			if (run->next == NULL)
+				oldest_run_size += indexsize + run->index.header.total;
 			run = run->next;
 		}
 		n = vy_range_tree_next(&p->i->tree, n);
@@ -5657,6 +6329,23 @@ static int vy_profiler_(struct vy_profiler *p)
 	p->memory_used = memory_used;
 	p->read_disk  = p->i->read_disk;
 	p->read_cache = p->i->read_cache;
+	p->bloom_skip = p->i->bloom_skip;
+
+	/*
+	 * Write amplification: all bytes written to disk per byte
+	 * dumped from memory. Space amplification: the size of all
+	 * runs to the size of the oldest run of each range, which
+	 * holds the bulk of the data merged by compaction.
+	 */
+	double write_amp = 1;
+	if (p->i->dump_size > 0)
+		write_amp = (double) (p->i->dump_size + p->i->compact_size) /
+			    p->i->dump_size;
+	double space_amp = 1;
+	if (oldest_run_size > 0)
+		space_amp = (double) p->total_node_size / oldest_run_size;
+	snprintf(p->write_amp_sz, sizeof(p->write_amp_sz), "%.2f", write_amp);
+	snprintf(p->space_amp_sz, sizeof(p->space_amp_sz), "%.2f", space_amp);
 
 	vy_profiler_histogram_run(p);
 	return 0;
@@ -5917,8 +6606,18 @@ next_node:
 	}
 	si_readstat(q, 0, node, 0);
 
+	/* a point lookup may skip runs which don't have the key */
+	uint32_t key_hash;
+	bool use_bloom = q->upsert_eq && q->key != NULL &&
+			 vy_tuple_key_hash(q->key, q->index->key_def,
+					   &key_hash);
 	struct vy_run *run = node->run;
 	while (run) {
+		if (use_bloom && !vy_run_may_have(run, key_hash)) {
+			q->index->bloom_skip++;
+			run = run->next;
+			continue;
+		}
 		struct svmergesrc *s = sv_mergeadd(m, NULL);
 		struct vy_filterif *compression = NULL;
 		if (q->index->conf.compression)
@@ -5986,8 +6685,15 @@ si_readcommited(struct vy_index *index, struct vy_tuple *tuple)
 		return 1;
 
 	/* search runs */
+	uint32_t key_hash;
+	bool use_bloom = vy_tuple_key_hash(tuple->data, index->key_def,
+					   &key_hash);
 	for (struct vy_run *run = range->run; run != NULL; run = run->next)
 	{
+		if (use_bloom && !vy_run_may_have(run, key_hash)) {
+			index->bloom_skip++;
+			continue;
+		}
 		struct vy_run_iterator iterator;
 		struct vy_filterif *compression = NULL;
 		if (index->conf.compression)
@@ -6057,8 +6763,8 @@ si_bootstrap(struct vy_index *index, uint64_t parent)
 	/* create index with one empty page */
 	struct vy_page_index sdindex;
 	vy_page_index_init(&sdindex);
-	vy_run_write(&n->file, NULL, index->conf.compression_if, 0, &id,
-		     &sdindex);
+	vy_run_write(&n->file, NULL, index->conf.compression_if,
+		     index->key_def, 0, &id, &sdindex);
 
 	vy_run_set(&n->self, &sdindex);
 
@@ -6505,6 +7211,7 @@ si_write(logindex_t *logindex, struct txv *v, uint64_t time,
 		quota += vy_tuple_size(tuple);
 		if (rlist_empty(&range->commit))
 			rlist_add(&rangelist, &range->commit);
+		vy_cache_invalidate(env->tuple_cache, index, tuple, lsn);
 	}
 	/* reschedule nodes */
 	struct vy_range *range, *tmp;
@@ -6902,6 +7609,12 @@ struct vy_conf {
 	struct srzonemap zones;
 	/* memory */
 	uint64_t memory_limit;
+	/* the page cache limit, a part of memory_limit */
+	uint64_t page_cache;
+	/* the tuple cache limit, a part of memory_limit */
+	uint64_t tuple_cache;
+	/* the number of threads reading disk for tx fibers */
+	int read_threads;
 };
 
 static struct vy_conf *
@@ -6923,6 +7636,14 @@ vy_conf_new()
 		goto error_2;
 	}
 	conf->memory_limit = cfg_getd("vinyl.memory_limit")*1024*1024*1024;
+	conf->page_cache = cfg_getd("vinyl.page_cache")*1024*1024*1024;
+	conf->tuple_cache = cfg_getd("vinyl.tuple_cache")*1024*1024*1024;
+	/* leave at least a half of the quota for in-memory indexes */
+	if (conf->page_cache > conf->memory_limit / 2)
+		conf->page_cache = conf->memory_limit / 2;
+	if (conf->tuple_cache > conf->memory_limit / 2 - conf->page_cache)
+		conf->tuple_cache = conf->memory_limit / 2 - conf->page_cache;
+	conf->read_threads = cfg_geti("vinyl.read_threads");
 	struct srzone def = {
 		.enable            = 1,
 		.compact_wm        = 2,
@@ -7133,7 +7854,7 @@ static inline int
 vy_info_append_performance(struct vy_info *info, struct vy_info_node *root)
 {
 	struct vy_info_node *node = vy_info_append(root, "performance");
-	if (vy_info_reserve(info, node, 26) != 0)
+	if (vy_info_reserve(info, node, 28) != 0)
 		return 1;
 
 	struct vy_env *env = info->env;
@@ -7159,6 +7880,20 @@ vy_info_append_performance(struct vy_info *info, struct vy_info_node *root)
 	vy_info_append_str(node, "upsert_latency", stat->upsert_latency.sz);
 	vy_info_append_str(node, "get_read_cache", stat->get_read_cache.sz);
 	vy_info_append_str(node, "cursor_latency", stat->cursor_latency.sz);
+	struct vy_page_cache *cache = env->page_cache;
+	tt_pthread_mutex_lock(&cache->lock);
+	vy_info_append_u64(node, "page_cache_hit", cache->hit);
+	vy_info_append_u64(node, "page_cache_miss", cache->miss);
+	vy_info_append_u64(node, "page_cache_used", cache->used);
+	tt_pthread_mutex_unlock(&cache->lock);
+	struct vy_cache *tuple_cache = env->tuple_cache;
+	tt_pthread_mutex_lock(&tuple_cache->lock);
+	vy_info_append_u64(node, "tuple_cache_hit", tuple_cache->hit);
+	vy_info_append_u64(node, "tuple_cache_miss", tuple_cache->miss);
+	vy_info_append_u64(node, "tuple_cache_used", tuple_cache->used);
+	tt_pthread_mutex_unlock(&tuple_cache->lock);
+	vy_info_append_u32(node, "read_inflight", env->read_pool->inflight);
+	vy_info_append_u64(node, "read_wait", env->read_pool->wait_count);
 	return 0;
 }
 
@@ -7194,7 +7929,7 @@ vy_info_append_indices(struct vy_info *info, struct vy_info_node *root)
 		vy_profiler_end(&o->rtp);
 		struct vy_info_node *local_node =
 			vy_info_append(node, o->conf.name);
-		if (vy_info_reserve(info, local_node, 17) != 0)
+		if (vy_info_reserve(info, local_node, 20) != 0)
 			return 1;
 		vy_info_append_u64(local_node, "size", o->rtp.total_node_size);
 		vy_info_append_u64(local_node, "count", o->rtp.count);
@@ -7202,6 +7937,7 @@ vy_info_append_indices(struct vy_info *info, struct vy_info_node *root)
 		vy_info_append_u64(local_node, "read_disk", o->rtp.read_disk);
 		vy_info_append_u32(local_node, "page_count", o->rtp.total_page_count);
 		vy_info_append_u64(local_node, "read_cache", o->rtp.read_cache);
+		vy_info_append_u64(local_node, "bloom_skip", o->rtp.bloom_skip);
 		vy_info_append_u32(local_node, "node_count", o->rtp.total_node_count);
 		vy_info_append_u32(local_node, "run_avg", o->rtp.total_run_avg);
 		vy_info_append_u32(local_node, "run_max", o->rtp.total_run_max);
@@ -7212,6 +7948,10 @@ vy_info_append_indices(struct vy_info *info, struct vy_info_node *root)
 		vy_info_append_u32(local_node, "temperature_max", o->rtp.temperature_max);
 		vy_info_append_str(local_node, "run_histogram", o->rtp.histogram_run_ptr);
 		vy_info_append_u64(local_node, "size_uncompressed", o->rtp.total_node_origin_size);
+		vy_info_append_str(local_node, "compaction",
+				   vy_compaction_strs[o->conf.compaction]);
+		vy_info_append_str(local_node, "write_amplification", o->rtp.write_amp_sz);
+		vy_info_append_str(local_node, "space_amplification", o->rtp.space_amp_sz);
 	}
 	return 0;
 }
@@ -7340,6 +8080,25 @@ vy_index_conf_create(struct vy_index_conf *conf, struct key_def *key_def)
 		}
 	}
 
+	/* compaction */
+	if (key_def->opts.compaction[0] != '\0') {
+		conf->compaction = strindex(vy_compaction_strs,
+					    key_def->opts.compaction,
+					    vy_compaction_MAX);
+		if (conf->compaction == vy_compaction_MAX) {
+			vy_error("unknown compaction policy '%s'",
+				 key_def->opts.compaction);
+			goto error;
+		}
+	} else {
+		conf->compaction = VY_COMPACTION_TIERED;
+	}
+	conf->compaction_ratio = key_def->opts.compaction_ratio;
+	if (conf->compaction_ratio == 0) {
+		vy_error("%s", "compaction_ratio must be greater than 0");
+		goto error;
+	}
+
 	/* path */
 	if (key_def->opts.path[0] == '\0') {
 		char path[1024];
@@ -7453,6 +8212,28 @@ vy_index_read(struct vy_index *index, struct vy_tuple *key,
 		vlsn = vy_sequence(e->scheduler->env->seq, VINYL_LSN);
 	}
 
+	/* a point lookup by a full key may be answered by the cache */
+	struct vy_cache *cache = e->tuple_cache;
+	bool use_cache = order == VINYL_EQ && upsert == NULL &&
+		vy_tuple_key_part(key->data,
+				  index->key_def->part_count - 1) != NULL;
+	uint64_t cache_version = 0;
+	if (use_cache) {
+		struct vy_tuple *cached;
+		if (vy_cache_get(cache, index, key, vlsn, &cached)) {
+			if (vy_tuple_is_not_found(cached) && !cache_only) {
+				vy_tuple_unref(cached);
+				cached = NULL;
+			}
+			/* the caller knows there is no need to read disk */
+			*result = cached;
+			return 0;
+		}
+		if (cache_only)
+			vy_cache_miss(cache);
+		cache_version = vy_cache_version(cache, index);
+	}
+
 	int upsert_eq = 0;
 	if (order == VINYL_EQ) {
 		order = VINYL_GE;
@@ -7485,6 +8266,9 @@ vy_index_read(struct vy_index *index, struct vy_tuple *key,
 	} else if (rc == 0) {
 		/* not found */
 		assert(q.result == NULL);
+		if (use_cache && !cache_only)
+			vy_cache_add(cache, index, key, NULL, vlsn,
+				     cache_version);
 		*result = NULL;
 		return 0;
 	} else if (rc == 2) {
@@ -7505,6 +8289,8 @@ vy_index_read(struct vy_index *index, struct vy_tuple *key,
 	statget.read_latency = clock_monotonic64() - start;
 	vy_stat_get(e->stat, &statget);
 
+	if (use_cache && !cache_only)
+		vy_cache_add(cache, index, key, q.result, vlsn, cache_version);
 	*result = q.result;
 	return 0;
 }
@@ -7587,11 +8373,17 @@ vy_index_new(struct vy_env *e, struct key_def *key_def,
 	index->size = 0;
 	index->read_disk = 0;
 	index->read_cache = 0;
+	index->bloom_skip = 0;
+	index->dump_size = 0;
+	index->compact_size = 0;
 	index->range_count = 0;
 	tt_pthread_mutex_init(&index->ref_lock, NULL);
 	index->refs = 0; /* referenced by scheduler */
 	vy_status_set(&index->status, VINYL_OFFLINE);
 	txvindex_new(&index->txvindex);
+	vy_cache_tree_new(&index->cache_tree);
+	index->cache_version = 0;
+	index->cache_lsn = 0;
 	rlist_add(&e->indexes, &index->link);
 	return index;
 
@@ -7611,6 +8403,7 @@ static inline void
 vy_index_delete(struct vy_index *index)
 {
 	txvindex_iter(&index->txvindex, NULL, txvindex_delete_cb, NULL);
+	vy_cache_drop_index(index->env->tuple_cache, index);
 	rlist_create(&index->gc);
 	vy_range_tree_iter(&index->tree, NULL, vy_range_tree_free_cb, index->env);
 	vy_buf_free(&index->readbuf);
@@ -7898,6 +8691,52 @@ vy_tuple_compare(const char *tuple_data_a, const char *tuple_data_b,
 	return 0;
 }
 
+/**
+ * Calculate the hash of the key of a tuple for a bloom filter.
+ * Fields are hashed by value rather than by their MsgPack, since
+ * the same value may be encoded in a few ways.
+ * @retval false the key is partial, or it has a field of a type
+ *               which is not hashed
+ */
+static inline bool
+vy_tuple_key_hash(const char *tuple_data, const struct key_def *key_def,
+		  uint32_t *hash)
+{
+	uint32_t h = VY_BLOOM_SEED;
+	uint32_t carry = 0;
+	uint32_t total_size = 0;
+	for (uint32_t part_id = 0; part_id < key_def->part_count; part_id++) {
+		const char *field = vy_tuple_key_part(tuple_data, part_id);
+		if (field == NULL)
+			return false;
+		switch (key_def->parts[part_id].type) {
+		case FIELD_TYPE_UNSIGNED:
+		case FIELD_TYPE_INTEGER: {
+			uint64_t value;
+			if (mp_typeof(*field) == MP_UINT)
+				value = mp_decode_uint(&field);
+			else
+				value = (uint64_t) mp_decode_int(&field);
+			PMurHash32_Process(&h, &carry, &value, sizeof(value));
+			total_size += sizeof(value);
+			break;
+		}
+		case FIELD_TYPE_STRING: {
+			uint32_t len;
+			const char *str = mp_decode_str(&field, &len);
+			PMurHash32_Process(&h, &carry, str, len);
+			total_size += len;
+			break;
+		}
+		default:
+			/* NUMBER and SCALAR have many encodings of a value. */
+			return false;
+		}
+	}
+	*hash = PMurHash32_Result(h, carry, total_size);
+	return true;
+}
+
 
 /* }}} Tuple */
 
@@ -8262,62 +9101,246 @@ vy_rollback_to_savepoint(struct vy_tx *tx, void *svp)
 
 /* }}} Public API of transaction control */
 
-/** {{{ vy_read_task - Asynchronous get/cursor I/O using eio pool */
+/** {{{ vy_read_task - Asynchronous get/cursor I/O using vinyl readers */
+
+/**
+ * A pool of threads doing the disk reads of index lookups and
+ * cursors on behalf of tx fibers. Unlike the coio thread pool,
+ * which is shared with getaddrinfo() and file operations, the
+ * pool only serves vinyl reads, so a burst of cache misses is not
+ * stuck behind unrelated work. Tasks are served in FIFO order by
+ * the first idle thread.
+ *
+ * The number of reads in flight is bounded: a fiber which would
+ * exceed the bound waits for a slot, the oldest waiter first.
+ * Waiting in tx keeps the queue short enough for a thread to
+ * pick a task up soon after it's queued.
+ */
+struct vy_read_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	/** Tasks waiting for a thread. */
+	struct rlist queue;
+	/** Tasks done, waiting for tx to wake their fibers up. */
+	struct rlist done;
+	/** Signalled by a thread when it adds a task to done. */
+	struct ev_async async;
+	struct ev_loop *loop;
+	struct cord *threads;
+	int thread_count;
+	bool run;
+	/* The members below are accessed from tx only. */
+	/** The number of tasks queued or being executed. */
+	uint32_t inflight;
+	uint32_t inflight_max;
+	/** The number of reads which had to wait for a slot. */
+	uint64_t wait_count;
+	/** Fibers waiting for a slot, see vy_read_waiter. */
+	struct rlist waiters;
+};
+
+enum {
+	/** The bound of reads in flight per reader thread. */
+	VY_READ_INFLIGHT_PER_THREAD = 32,
+};
+
+struct vy_read_task;
+typedef int (*vy_read_f)(struct vy_read_task *);
 
 /**
  * A context of asynchronous index get or cursor read.
  */
 struct vy_read_task {
-	struct coio_task base;
 	struct vy_index *index;
 	struct vy_cursor *cursor;
 	struct vy_tx *tx;
 	struct vy_tuple *key;
 	struct vy_tuple *result;
 	struct vy_tuple *upsert;
+	/** The function to run in a reader thread. */
+	vy_read_f func;
+	int rc;
+	/** The error of the function, moved to the fiber in tx. */
+	struct diag diag;
+	struct fiber *fiber;
+	bool complete;
+	/** Member of vy_read_pool::queue or vy_read_pool::done. */
+	struct rlist in_pool;
+};
+
+/** A fiber waiting for a slot in vy_read_pool. */
+struct vy_read_waiter {
+	struct fiber *fiber;
+	/** Set when the slot of a finished read is passed over. */
+	bool ready;
+	struct rlist in_waiters;
 };
 
-static ssize_t
-vy_get_cb(struct coio_task *ptr)
+static void *
+vy_read_thread_f(void *arg)
+{
+	struct vy_read_pool *pool = (struct vy_read_pool *) arg;
+	tt_pthread_mutex_lock(&pool->lock);
+	while (pool->run) {
+		if (rlist_empty(&pool->queue)) {
+			tt_pthread_cond_wait(&pool->cond, &pool->lock);
+			continue;
+		}
+		struct vy_read_task *task =
+			rlist_shift_entry(&pool->queue, struct vy_read_task,
+					  in_pool);
+		tt_pthread_mutex_unlock(&pool->lock);
+		task->rc = task->func(task);
+		if (task->rc != 0)
+			diag_move(diag_get(), &task->diag);
+		tt_pthread_mutex_lock(&pool->lock);
+		rlist_add_tail_entry(&pool->done, task, in_pool);
+		ev_async_send(pool->loop, &pool->async);
+	}
+	tt_pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+/** Wake up the fibers of finished tasks, runs in tx. */
+static void
+vy_read_pool_async_cb(ev_loop *loop, struct ev_async *watcher, int events)
+{
+	(void) loop;
+	(void) events;
+	struct vy_read_pool *pool = (struct vy_read_pool *) watcher->data;
+	tt_pthread_mutex_lock(&pool->lock);
+	while (!rlist_empty(&pool->done)) {
+		struct vy_read_task *task =
+			rlist_shift_entry(&pool->done, struct vy_read_task,
+					  in_pool);
+		task->complete = true;
+		fiber_wakeup(task->fiber);
+	}
+	tt_pthread_mutex_unlock(&pool->lock);
+}
+
+static struct vy_read_pool *
+vy_read_pool_new(int thread_count)
+{
+	struct vy_read_pool *pool = calloc(1, sizeof(*pool));
+	if (pool == NULL) {
+		diag_set(OutOfMemory, sizeof(*pool), "read pool", "struct");
+		return NULL;
+	}
+	assert(thread_count > 0);
+	pool->threads = calloc(thread_count, sizeof(struct cord));
+	if (pool->threads == NULL) {
+		diag_set(OutOfMemory, thread_count * sizeof(struct cord),
+			 "read pool", "threads");
+		free(pool);
+		return NULL;
+	}
+	tt_pthread_mutex_init(&pool->lock, NULL);
+	tt_pthread_cond_init(&pool->cond, NULL);
+	rlist_create(&pool->queue);
+	rlist_create(&pool->done);
+	rlist_create(&pool->waiters);
+	pool->loop = loop();
+	ev_async_init(&pool->async, vy_read_pool_async_cb);
+	pool->async.data = pool;
+	ev_async_start(pool->loop, &pool->async);
+	pool->inflight_max = thread_count * VY_READ_INFLIGHT_PER_THREAD;
+	pool->run = true;
+	for (int i = 0; i < thread_count; i++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "vinyl.reader%d", i);
+		if (cord_start(&pool->threads[i], name, vy_read_thread_f,
+			       pool) != 0)
+			panic("failed to start a vinyl reader thread");
+		pool->thread_count++;
+	}
+	return pool;
+}
+
+static void
+vy_read_pool_delete(struct vy_read_pool *pool)
+{
+	assert(pool->inflight == 0);
+	tt_pthread_mutex_lock(&pool->lock);
+	pool->run = false;
+	tt_pthread_cond_broadcast(&pool->cond);
+	tt_pthread_mutex_unlock(&pool->lock);
+	for (int i = 0; i < pool->thread_count; i++)
+		cord_join(&pool->threads[i]);
+	ev_async_stop(pool->loop, &pool->async);
+	tt_pthread_cond_destroy(&pool->cond);
+	tt_pthread_mutex_destroy(&pool->lock);
+	free(pool->threads);
+	free(pool);
+}
+
+/**
+ * Run a task in a reader thread and wait for it to finish.
+ * The wait can't be interrupted: the task refers to the
+ * caller's stack and state.
+ */
+static int
+vy_read_pool_exec(struct vy_read_pool *pool, struct vy_read_task *task)
+{
+	if (pool->inflight >= pool->inflight_max) {
+		pool->wait_count++;
+		struct vy_read_waiter waiter;
+		waiter.fiber = fiber();
+		waiter.ready = false;
+		rlist_add_tail_entry(&pool->waiters, &waiter, in_waiters);
+		while (!waiter.ready)
+			fiber_yield();
+		/* the slot has been passed over, see below */
+	} else {
+		pool->inflight++;
+	}
+	task->fiber = fiber();
+	task->complete = false;
+	diag_create(&task->diag);
+	tt_pthread_mutex_lock(&pool->lock);
+	rlist_add_tail_entry(&pool->queue, task, in_pool);
+	tt_pthread_cond_signal(&pool->cond);
+	tt_pthread_mutex_unlock(&pool->lock);
+	while (!task->complete)
+		fiber_yield();
+	if (!rlist_empty(&pool->waiters)) {
+		struct vy_read_waiter *waiter =
+			rlist_shift_entry(&pool->waiters,
+					  struct vy_read_waiter, in_waiters);
+		waiter->ready = true;
+		fiber_wakeup(waiter->fiber);
+	} else {
+		pool->inflight--;
+	}
+	if (task->rc != 0)
+		diag_move(&task->diag, diag_get());
+	return task->rc;
+}
+
+static int
+vy_get_cb(struct vy_read_task *task)
 {
-	struct vy_read_task *task = (struct vy_read_task *) ptr;
 	return vy_index_read(task->index, task->key, VINYL_EQ,
 			     &task->result, task->upsert, task->tx, false);
 }
 
-static ssize_t
-vy_cursor_next_cb(struct coio_task *ptr)
+static int
+vy_cursor_next_cb(struct vy_read_task *task)
 {
-	struct vy_read_task *task = (struct vy_read_task *) ptr;
 	struct vy_cursor *c = task->cursor;
 	return vy_index_read(c->index, c->key, c->order,
 			     &task->result, task->upsert, &c->tx, false);
 }
 
-static ssize_t
-vy_read_task_free_cb(struct coio_task *ptr)
-{
-	struct vy_read_task *task = (struct vy_read_task *) ptr;
-	struct vy_env *env = task->index->env;
-	assert(env != NULL);
-	if (task->result != NULL)
-		vy_tuple_unref(task->result);
-	if (task->upsert != NULL)
-		vy_tuple_unref(task->upsert);
-	vy_index_unref(task->index);
-	mempool_free(&env->read_task_pool, task);
-	return 0;
-}
-
 /**
- * Create a thread pool task to run a callback,
+ * Create a reader thread task to run a callback,
  * execute the task, and return the result (tuple) back.
  */
 static inline int
 vy_read_task(struct vy_index *index, struct vy_tx *tx,
 	     struct vy_cursor *cursor, struct vy_tuple *key,
 	     struct vy_tuple **result, struct vy_tuple *upsert,
-	     coio_task_cb func)
+	     vy_read_f func)
 {
 	assert(index != NULL);
 	struct vy_env *env = index->env;
@@ -8334,13 +9357,10 @@ vy_read_task(struct vy_index *index, struct vy_tx *tx,
 	task->key = key;
 	task->result = NULL;
 	task->upsert = upsert;
-	if (coio_task(&task->base, func, vy_read_task_free_cb,
-	              TIMEOUT_INFINITY) == -1) {
-		return -1;
-	}
+	task->func = func;
+	int rc = vy_read_pool_exec(env->read_pool, task);
 	vy_index_unref(index);
 	*result = task->result;
-	int rc = task->base.base.result; /* save original error code */
 	mempool_free(&env->read_task_pool, task);
 	assert(rc == 0 || !diag_is_empty(&fiber()->diag));
 	return rc;
@@ -8392,6 +9412,153 @@ vy_get(struct vy_tx *tx, struct vy_index *index, const char *key,
 	return 0;
 }
 
+/** The max number of fibers doing disk lookups of vy_get_many(). */
+enum { VY_GET_MANY_FIBERS = 16 };
+
+/** Disk lookups of vy_get_many(), shared by its fibers. */
+struct vy_get_many_ctx {
+	struct vy_index *index;
+	struct vy_tx *tx;
+	struct vy_tuple **keys;
+	/** Found tuples or UPSERTs found in memory. */
+	struct vy_tuple **results;
+	/** The numbers of the keys to look up on disk. */
+	uint32_t *misses;
+	uint32_t miss_count;
+	/** The next miss to look up. */
+	uint32_t next;
+	bool is_failed;
+	/** The error of a failed lookup. */
+	struct diag diag;
+};
+
+static void
+vy_get_many_lookup(struct vy_get_many_ctx *ctx)
+{
+	while (!ctx->is_failed && ctx->next < ctx->miss_count) {
+		uint32_t i = ctx->misses[ctx->next++];
+		if (vy_read_task(ctx->index, ctx->tx, NULL, ctx->keys[i],
+				 &ctx->results[i], ctx->results[i],
+				 vy_get_cb) != 0) {
+			/* Owned by the task, see vy_get(). */
+			ctx->results[i] = NULL;
+			ctx->is_failed = true;
+			diag_move(diag_get(), &ctx->diag);
+		}
+	}
+}
+
+static int
+vy_get_many_f(va_list ap)
+{
+	struct vy_get_many_ctx *ctx = va_arg(ap, struct vy_get_many_ctx *);
+	vy_get_many_lookup(ctx);
+	return 0;
+}
+
+int
+vy_get_many(struct vy_tx *tx, struct vy_index *index, const char *keys,
+	    uint32_t count, struct tuple **result)
+{
+	size_t size = count * (2 * sizeof(struct vy_tuple *) +
+			       sizeof(uint32_t));
+	char *buf = calloc(1, size > 0 ? size : 1);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "calloc", "vy_get_many");
+		return -1;
+	}
+	struct vy_get_many_ctx ctx;
+	ctx.index = index;
+	ctx.tx = tx;
+	ctx.keys = (struct vy_tuple **) buf;
+	ctx.results = ctx.keys + count;
+	ctx.misses = (uint32_t *) (ctx.results + count);
+	ctx.miss_count = 0;
+	ctx.next = 0;
+	ctx.is_failed = false;
+	diag_create(&ctx.diag);
+
+	int rc = -1;
+	uint32_t i, found = 0;
+	for (i = 0; i < count; i++) {
+		uint32_t part_count = mp_decode_array(&keys);
+		ctx.keys[i] = vy_tuple_from_key_data(index, keys, part_count);
+		if (ctx.keys[i] == NULL)
+			goto out;
+		for (uint32_t j = 0; j < part_count; j++)
+			mp_next(&keys);
+		struct vy_tuple *vyresult = NULL;
+		if (vy_index_read(index, ctx.keys[i], VINYL_EQ, &vyresult,
+				  NULL, tx, true) != 0)
+			goto out;
+		if (vyresult == NULL || (vyresult->flags & SVUPSERT)) {
+			/* cache miss or not found */
+			ctx.results[i] = vyresult;
+			ctx.misses[ctx.miss_count++] = i;
+		} else if (vy_tuple_is_not_found(vyresult)) {
+			/* Deleted in this transaction. */
+			vy_tuple_unref(vyresult);
+		} else {
+			ctx.results[i] = vyresult;
+		}
+	}
+
+	/*
+	 * Instead of waiting for each disk lookup in turn, look
+	 * the misses up in a few fibers at once, so that they
+	 * are run by the thread pool in parallel.
+	 */
+	struct fiber *helpers[VY_GET_MANY_FIBERS - 1];
+	uint32_t helper_count = 0;
+	while (helper_count < VY_GET_MANY_FIBERS - 1 &&
+	       helper_count + 1 < ctx.miss_count) {
+		struct fiber *f = fiber_new("vinyl.get_many", vy_get_many_f);
+		if (f == NULL) {
+			/* Do with the fibers we have. */
+			diag_clear(diag_get());
+			break;
+		}
+		fiber_set_joinable(f, true);
+		fiber_start(f, &ctx);
+		helpers[helper_count++] = f;
+	}
+	vy_get_many_lookup(&ctx);
+	for (uint32_t k = 0; k < helper_count; k++)
+		fiber_join(helpers[k]);
+	if (ctx.is_failed) {
+		diag_move(&ctx.diag, diag_get());
+		goto out;
+	}
+
+	for (found = 0; found < count; found++) {
+		struct vy_tuple *vyresult = ctx.results[found];
+		if (vyresult == NULL) {
+			result[found] = NULL;
+			continue;
+		}
+		result[found] = vinyl_convert_tuple(index, vyresult);
+		if (result[found] == NULL ||
+		    box_tuple_ref(result[found]) != 0)
+			goto out;
+	}
+	rc = 0;
+out:
+	if (rc != 0) {
+		for (uint32_t k = 0; k < found; k++) {
+			if (result[k] != NULL)
+				box_tuple_unref(result[k]);
+		}
+	}
+	for (uint32_t k = 0; k < count; k++) {
+		if (ctx.keys[k] != NULL)
+			vy_tuple_unref(ctx.keys[k]);
+		if (ctx.results[k] != NULL)
+			vy_tuple_unref(ctx.results[k]);
+	}
+	free(buf);
+	return rc;
+}
+
 /**
  * Read the next value from a cursor in a thread pool thread.
  */
@@ -8464,7 +9631,9 @@ vy_env_new(void)
 	e->conf = vy_conf_new();
 	if (e->conf == NULL)
 		goto error_2;
-	e->quota = vy_quota_new(e->conf->memory_limit);
+	/* the caches take their share of memory_limit */
+	e->quota = vy_quota_new(e->conf->memory_limit - e->conf->page_cache -
+				e->conf->tuple_cache);
 	if (e->quota == NULL)
 		goto error_3;
 	e->xm = tx_manager_new(e);
@@ -8473,15 +9642,30 @@ vy_env_new(void)
 	e->stat = vy_stat_new();
 	if (e->stat == NULL)
 		goto error_5;
+	e->page_cache = vy_page_cache_new(e->conf->page_cache, e->quota);
+	if (e->page_cache == NULL)
+		goto error_6;
+	e->tuple_cache = vy_cache_new(e->conf->tuple_cache, e->quota);
+	if (e->tuple_cache == NULL)
+		goto error_7;
 	e->scheduler = vy_scheduler_new(e);
 	if (e->scheduler == NULL)
-		goto error_6;
+		goto error_8;
+	e->read_pool = vy_read_pool_new(e->conf->read_threads);
+	if (e->read_pool == NULL)
+		goto error_9;
 
 	mempool_create(&e->read_task_pool, cord_slab_cache(),
 	               sizeof(struct vy_read_task));
 	mempool_create(&e->cursor_pool, cord_slab_cache(),
 	               sizeof(struct vy_cursor));
 	return e;
+error_9:
+	vy_scheduler_delete(e->scheduler);
+error_8:
+	vy_cache_delete(e->tuple_cache);
+error_7:
+	vy_page_cache_delete(e->page_cache);
 error_6:
 	vy_stat_delete(e->stat);
 error_5:
@@ -8500,11 +9684,14 @@ error_1:
 void
 vy_env_delete(struct vy_env *e)
 {
+	vy_read_pool_delete(e->read_pool);
 	vy_scheduler_delete(e->scheduler);
 	/* TODO: tarantool doesn't delete indexes during shutdown */
 	//assert(rlist_empty(&e->db));
 	tx_manager_delete(e->xm);
 	vy_conf_delete(e->conf);
+	vy_cache_delete(e->tuple_cache);
+	vy_page_cache_delete(e->page_cache);
 	vy_quota_delete(e->quota);
 	vy_stat_delete(e->stat);
 	vy_sequence_delete(e->seq);
@@ -8622,9 +9809,10 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page)
 	if (itr->curr_loaded_page != page) {
 		if (itr->curr_loaded_page != UINT32_MAX)
 			vy_run_unload_page(itr->run, itr->curr_loaded_page);
-		struct sdpage *result = vy_run_load_page(itr->run, page,
-							 itr->file,
-							 itr->compression);
+		struct sdpage *result =
+			vy_run_load_page(itr->run, page,
+					 itr->index->env->page_cache,
+					 itr->file, itr->compression);
 		if (result != NULL)
 			itr->curr_loaded_page = page;
 		else
@@ -8840,8 +10028,7 @@ vy_run_iterator_lock_page(struct vy_run_iterator *itr, uint32_t page_no)
 	if (itr->curr_loaded_page != page_no)
 		return UINT32_MAX;
 	/* just increment reference counter */
-	vy_run_load_page(itr->run, page_no,
-			 itr->file, itr->compression);
+	vy_run_ref_page(itr->run, page_no);
 	return page_no;
 }
 
@@ -8933,18 +10120,11 @@ vy_run_iterator_start(struct vy_run_iterator *itr)
 	assert(!itr->search_started);
 	itr->search_started = true;
 
-	if (itr->run->index.header.count == 1) {
-		/* there can be a stupid bootstrap run in which it's EOF */
-		struct sdpage *page =
-			vy_run_iterator_load_page(itr, 0);
-		if (page == NULL)
-			return -1;
-		if (page->h->count == 0) {
-			vy_run_iterator_close(itr);
-			return 1;
-		}
-	} else if (itr->run->index.header.count == 0) {
-		/* never seen that, but it could be possible in future */
+	if (itr->run->index.header.keys == 0) {
+		/*
+		 * there can be a stupid bootstrap run with one empty
+		 * page, no need to read it to find out it's EOF
+		 */
 		vy_run_iterator_close(itr);
 		return 1;
 	}
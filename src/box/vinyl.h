@@ -129,6 +129,17 @@ int
 vy_get(struct vy_tx *tx, struct vy_index *index,
        const char *key, uint32_t part_count, struct tuple **result);
 
+/**
+ * Same as vy_get() for @a count keys following one another at
+ * @a keys, each a MsgPack array. The keys which are not in
+ * memory are looked up on disk in parallel. result[i] is the
+ * tuple of the i-th key or NULL, the found tuples are
+ * referenced.
+ */
+int
+vy_get_many(struct vy_tx *tx, struct vy_index *index,
+	    const char *keys, uint32_t count, struct tuple **result);
+
 int
 vy_replace(struct vy_tx *tx, struct vy_index *index,
 	   const char *tuple, const char *tuple_end);
@@ -199,6 +199,17 @@ VinylIndex::findByKey(const char *key, uint32_t part_count) const
 	return tuple;
 }
 
+void
+VinylIndex::findByKeys(const char *keys, uint32_t count,
+		       struct tuple **result) const
+{
+	assert(key_def->opts.is_unique);
+	struct vy_tx *transaction = in_txn() ?
+		(struct vy_tx *) in_txn()->engine_tx : NULL;
+	if (vy_get_many(transaction, db, keys, count, result) != 0)
+		diag_raise();
+}
+
 struct tuple *
 VinylIndex::replace(struct tuple*, struct tuple*, enum dup_replace_mode)
 {
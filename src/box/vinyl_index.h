@@ -49,6 +49,10 @@ public:
 	virtual struct tuple*
 	findByKey(const char *key, uint32_t) const override;
 
+	virtual void
+	findByKeys(const char *keys, uint32_t count,
+		   struct tuple **result) const override;
+
 	virtual struct iterator*
 	allocIterator() const override;
 
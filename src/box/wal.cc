@@ -30,18 +30,37 @@
  */
 #include "wal.h"
 
+#include "trivia/config.h"
 #include "vclock.h"
 #include "fiber.h"
 #include "fio.h"
 #include "errinj.h"
+#include "histogram.h"
 
 #include "xlog.h"
 #include "xrow.h"
 #include "cbus.h"
 #include "coeio.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
 
+/** Name of the file created in advance to become the next WAL. */
+static const char wal_spare_name[] = "next.xlog.prealloc";
+
+enum {
+	/**
+	 * Disk space for a WAL is preallocated in steps of at
+	 * most this size as the WAL grows.
+	 */
+	WAL_PREALLOC_STEP = 16 * 1024 * 1024,
+	/** Bounds of space preallocated for a new WAL. */
+	WAL_PREALLOC_MIN = 64 * 1024,
+	WAL_PREALLOC_MAX = 1024 * 1024 * 1024,
+};
+
 /*
  * WAL writer - maintain a Write Ahead Log for every change
  * in the data state.
@@ -64,11 +83,85 @@ struct wal_writer
 	struct stailq rollback;
 	/** A pipe from 'tx' thread to 'wal' */
 	struct cpipe wal_pipe;
+	/** The route of WAL write messages sent to this writer. */
+	struct cmsg_hop write_route[2];
+	/** Messages sent to this writer and not completed yet. */
+	int n_inflight;
 	/* ----------------- wal ------------------- */
 	/** A setting from server configuration - rows_per_wal */
 	int64_t rows_per_wal;
 	/** Another one - wal_mode */
 	enum wal_mode wal_mode;
+	/**
+	 * Group commit settings - wal_group_commit_delay and
+	 * wal_group_commit_rows. With a non-zero delay in fsync
+	 * mode the WAL is not opened with O_SYNC, instead it is
+	 * synced once per group of writes: the first writer of
+	 * a group waits up to the delay for more writes, or until
+	 * the group has enough rows, then syncs all of them.
+	 */
+	double group_commit_delay;
+	int64_t group_commit_rows;
+	/** Rows written but not synced yet. */
+	int64_t group_rows;
+	/** The fiber which will sync the current group, if any. */
+	struct fiber *group_leader;
+	/** Other fibers waiting for the current group sync. */
+	struct rlist group_waiters;
+	/** Incremented on each group sync. */
+	uint64_t group_sync_count;
+	/**
+	 * Rows written per write (per sync in group commit
+	 * mode) and sync latency in microseconds. Updated in
+	 * the WAL thread, shown in box.stat.wal.
+	 */
+	struct histogram batch_hist;
+	struct histogram fsync_hist;
+	/**
+	 * The time a write waits in the queue of the thread and
+	 * the time it takes, in microseconds. In group commit
+	 * mode the wait for the sync is not included.
+	 */
+	struct histogram queue_hist;
+	struct histogram write_hist;
+	/**
+	 * Size of the current WAL and the end of disk space
+	 * preallocated for it. Appending to preallocated space
+	 * doesn't allocate blocks, which would make the writes
+	 * and the following syncs slower.
+	 */
+	off_t wal_size;
+	off_t prealloc_end;
+	/**
+	 * How much space to preallocate for a new WAL, learned
+	 * from the size of the last WAL closed by rows_per_wal.
+	 */
+	off_t prealloc_size;
+	/** Incremented each time the current WAL is closed. */
+	uint64_t wal_id;
+	/**
+	 * An empty file with preallocated space created in
+	 * advance, which becomes the next WAL, so that rotation
+	 * doesn't wait for it to be created.
+	 */
+	char spare_path[PATH_MAX];
+	/** Space allocated for the spare file, -1 if no file. */
+	off_t spare_size;
+	/** Set when a new spare file must be created. */
+	bool spare_is_needed;
+	/**
+	 * The fiber preallocating space and creating the spare
+	 * file in background, in coeio threads.
+	 */
+	struct fiber *prealloc_fiber;
+	/** Set while the fiber waits for a coeio task. */
+	bool prealloc_is_busy;
+	/** Set to stop the fiber. */
+	bool prealloc_is_stopped;
+	/** Cleared if the file system doesn't support it. */
+	bool prealloc_is_supported;
+	/** Set if preallocation failed for the current WAL. */
+	bool prealloc_is_failed;
 	/** wal_dir, from the configuration file. */
 	struct xdir wal_dir;
 	/** 'wal' thread doing the writes. */
@@ -110,6 +203,8 @@ struct wal_writer
 };
 
 struct wal_msg: public cmsg {
+	/** The writer of the stream the message is sent to. */
+	struct wal_writer *writer;
 	/** Input queue, on output contains all committed requests. */
 	struct stailq commit;
 	/**
@@ -117,12 +212,41 @@ struct wal_msg: public cmsg {
 	 * be rolled back.
 	 */
 	struct stailq rollback;
+	/** Link in wal_msg_queue. */
+	struct stailq_entry in_queue;
+	/** Set when the message is back from the WAL thread. */
+	bool is_done;
+	/** The time the message is sent to the WAL thread. */
+	ev_tstamp push_time;
 };
 
-static struct wal_writer wal_writer_singleton;
+/**
+ * Writers of the WAL streams, see wal_stream_dirs. The first
+ * one writes to wal_dir and is the writer handle used by the
+ * rest of the server.
+ */
+static struct wal_writer wal_streams[WAL_STREAMS_MAX];
+static int wal_stream_count;
+
+/**
+ * WAL messages in the order they were sent. With several
+ * streams messages can be written out of order, but their
+ * requests are completed in the order of the queue, so
+ * transactions are committed in the order of their LSNs.
+ */
+static struct stailq wal_msg_queue;
+/**
+ * The vclock of the committed transactions, used to make
+ * their signatures in the tx thread.
+ */
+static struct vclock wal_commit_vclock;
 
 struct wal_writer *wal = NULL;
 struct rmean *rmean_tx_wal_bus;
+struct histogram *histogram_wal_batch;
+struct histogram *histogram_wal_fsync;
+struct histogram *histogram_wal_queue;
+struct histogram *histogram_wal_write;
 
 static void
 wal_write_to_disk(struct cmsg *msg);
@@ -130,23 +254,21 @@ wal_write_to_disk(struct cmsg *msg);
 static void
 tx_schedule_commit(struct cmsg *msg);
 
-static struct cmsg_hop wal_request_route[] = {
-	{wal_write_to_disk, &wal_writer_singleton.tx_pipe},
-	{tx_schedule_commit, NULL},
-};
-
 static void
-wal_msg_create(struct wal_msg *batch)
+wal_msg_create(struct wal_msg *batch, struct wal_writer *writer)
 {
-	cmsg_init(batch, wal_request_route);
+	cmsg_init(batch, writer->write_route);
+	batch->writer = writer;
 	stailq_create(&batch->commit);
 	stailq_create(&batch->rollback);
+	batch->is_done = false;
 }
 
 static struct wal_msg *
-wal_msg(struct cmsg *msg)
+wal_msg(struct wal_writer *writer, struct cmsg *msg)
 {
-	return msg->route == wal_request_route ? (struct wal_msg *) msg : NULL;
+	return msg->route == writer->write_route ?
+	       (struct wal_msg *) msg : NULL;
 }
 
 /**
@@ -168,11 +290,25 @@ tx_schedule_queue(struct stailq *queue)
 		fiber_wakeup(req->fiber);
 }
 
+/** Assign signatures to the committed requests of a batch. */
+static void
+tx_sign_queue(struct stailq *queue)
+{
+	struct wal_request *req;
+	stailq_foreach_entry(req, queue, fifo) {
+		struct xrow_header *last = req->rows[req->n_rows - 1];
+		vclock_follow(&wal_commit_vclock, last->server_id, last->lsn);
+		req->res = vclock_sum(&wal_commit_vclock);
+	}
+}
+
 /**
  * Complete execution of a batch of WAL write requests:
  * schedule all committed requests, and, should there
  * be any requests to be rolled back, append them to
- * the rollback queue.
+ * the rollback queue. The committed requests of a batch
+ * are scheduled only after the requests of all batches
+ * sent before it.
  */
 static void
 tx_schedule_commit(struct cmsg *msg)
@@ -188,7 +324,17 @@ tx_schedule_commit(struct cmsg *msg)
 		/* Closes the input valve. */
 		stailq_concat(&writer->rollback, &batch->rollback);
 	}
-	tx_schedule_queue(&batch->commit);
+	batch->writer->n_inflight--;
+	batch->is_done = true;
+	while (! stailq_empty(&wal_msg_queue)) {
+		batch = stailq_first_entry(&wal_msg_queue, struct wal_msg,
+					   in_queue);
+		if (! batch->is_done)
+			break;
+		stailq_shift(&wal_msg_queue);
+		tx_sign_queue(&batch->commit);
+		tx_schedule_queue(&batch->commit);
+	}
 }
 
 static void
@@ -210,27 +356,55 @@ tx_schedule_rollback(struct cmsg *msg)
 }
 
 /**
- * Initialize WAL writer context. Even though it's a singleton,
- * encapsulate the details just in case we may use
- * more writers in the future.
+ * Initialize the context of a WAL writer, one per WAL stream.
  */
 static void
 wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 		  const char *wal_dirname, const struct tt_uuid *server_uuid,
-		  struct vclock *vclock, int64_t rows_per_wal)
+		  struct vclock *vclock, int64_t rows_per_wal,
+		  double group_commit_delay, int64_t group_commit_rows)
 {
 	writer->wal_mode = wal_mode;
 	writer->rows_per_wal = rows_per_wal;
+	/* Group commit makes sense only if every write is synced. */
+	writer->group_commit_delay = wal_mode == WAL_FSYNC ?
+				     group_commit_delay : 0;
+	writer->group_commit_rows = group_commit_rows;
+	writer->group_rows = 0;
+	writer->group_leader = NULL;
+	rlist_create(&writer->group_waiters);
+	writer->group_sync_count = 0;
+	histogram_create(&writer->batch_hist);
+	histogram_create(&writer->fsync_hist);
+	histogram_create(&writer->queue_hist);
+	histogram_create(&writer->write_hist);
+
+	writer->wal_size = 0;
+	writer->prealloc_end = 0;
+	writer->prealloc_size = WAL_PREALLOC_STEP;
+	writer->wal_id = 0;
+	snprintf(writer->spare_path, sizeof(writer->spare_path), "%s/%s",
+		 wal_dirname, wal_spare_name);
+	writer->spare_size = -1;
+	writer->spare_is_needed = true;
+	writer->prealloc_fiber = NULL;
+	writer->prealloc_is_busy = false;
+	writer->prealloc_is_stopped = false;
+	writer->prealloc_is_supported = true;
+	writer->prealloc_is_failed = false;
 
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, server_uuid);
 	writer->current_wal = NULL;
-	if (wal_mode == WAL_FSYNC)
+	if (wal_mode == WAL_FSYNC && writer->group_commit_delay == 0)
 		(void) strcat(writer->wal_dir.open_wflags, "s");
 	cbus_create(&writer->tx_wal_bus);
 
 	cpipe_create(&writer->tx_pipe);
 	cpipe_create(&writer->wal_pipe);
 	cpipe_set_max_input(&writer->wal_pipe, IOV_MAX);
+	writer->write_route[0] = {wal_write_to_disk, &writer->tx_pipe};
+	writer->write_route[1] = {tx_schedule_commit, NULL};
+	writer->n_inflight = 0;
 
 	writer->batch = fio_batch_new();
 	if (writer->batch == NULL)
@@ -265,83 +439,124 @@ wal_writer_f(va_list ap);
 static int
 wal_opt_rotate(struct wal_writer *writer);
 
+/* Sync and close the current WAL. */
+static void
+wal_close_current(struct wal_writer *writer);
+
 /**
- * Initialize WAL writer, start the thread.
+ * Initialize WAL writers, start the threads.
  *
  * @pre   The server has completed recovery from a snapshot
  *        and/or existing WALs. All WALs opened in read-only
  *        mode are closed.
  *
- * @param state			WAL writer meta-data.
- *
- * @return 0 success, -1 on error. On success, recovery->writer
- *         points to a newly created WAL writer.
+ * @post  wal points to the writer of the first stream.
  */
 void
 wal_writer_start(enum wal_mode wal_mode, const char *wal_dirname,
+		 const char **stream_dirnames, int stream_dir_count,
 		 const struct tt_uuid *server_uuid, struct vclock *vclock,
-		 int64_t rows_per_wal)
+		 int64_t rows_per_wal, double group_commit_delay,
+		 int64_t group_commit_rows)
 {
 	assert(rows_per_wal > 1);
-
-	struct wal_writer *writer = &wal_writer_singleton;
-
-	/* I. Initialize the state. */
-	wal_writer_create(writer, wal_mode, wal_dirname, server_uuid,
-			vclock, rows_per_wal);
-
-	rmean_tx_wal_bus = writer->tx_wal_bus.stats;
-
-	/* II. Start the thread. */
-
-	if (cord_costart(&writer->cord, "wal", wal_writer_f, writer)) {
-		wal_writer_destroy(writer);
-		wal = NULL;
-		panic("failed to start WAL thread");
+	assert(stream_dir_count < WAL_STREAMS_MAX);
+
+	stailq_create(&wal_msg_queue);
+	vclock_copy(&wal_commit_vclock, vclock);
+	wal_stream_count = 1 + stream_dir_count;
+	for (int i = 0; i < wal_stream_count; i++) {
+		struct wal_writer *writer = &wal_streams[i];
+		const char *dirname = i == 0 ? wal_dirname :
+				      stream_dirnames[i - 1];
+
+		/* I. Initialize the state. */
+		wal_writer_create(writer, wal_mode, dirname, server_uuid,
+				  vclock, rows_per_wal, group_commit_delay,
+				  group_commit_rows);
+
+		/* II. Start the thread. */
+		char name[FIBER_NAME_MAX];
+		if (i == 0)
+			snprintf(name, sizeof(name), "wal");
+		else
+			snprintf(name, sizeof(name), "wal%d", i);
+		if (cord_costart(&writer->cord, name, wal_writer_f, writer)) {
+			wal_writer_destroy(writer);
+			wal = NULL;
+			panic("failed to start WAL thread");
+		}
+		cbus_join(&writer->tx_wal_bus, &writer->tx_pipe);
 	}
-	cbus_join(&writer->tx_wal_bus, &writer->tx_pipe);
+	/* Statistics are collected for the first stream only. */
+	struct wal_writer *writer = &wal_streams[0];
+	rmean_tx_wal_bus = writer->tx_wal_bus.stats;
+	histogram_wal_batch = &writer->batch_hist;
+	histogram_wal_fsync = &writer->fsync_hist;
+	histogram_wal_queue = &writer->queue_hist;
+	histogram_wal_write = &writer->write_hist;
 	wal = writer;
 }
 
+struct wal_stop: public cmsg
+{
+	struct wal_writer *writer;
+};
+
 static void
-wal_writer_stop_f(struct cmsg *msg)
+wal_writer_stop_f(struct cmsg *data)
 {
-	(void) msg;
-	fiber_wakeup(wal->main_f);
+	struct wal_stop *msg = (struct wal_stop *) data;
+	fiber_wakeup(msg->writer->main_f);
 }
 
-/** Stop and destroy the writer thread (at shutdown). */
+/** Stop and destroy the writer threads (at shutdown). */
 void
 wal_writer_stop()
 {
-	struct wal_writer *writer = wal;
-
-	/* Stop the worker thread. */
-	struct cmsg wakeup;
-	struct cmsg_hop route[1] = {
-		{wal_writer_stop_f, NULL}
-	};
-	cmsg_init(&wakeup, route);
-
-	cpipe_push(&writer->wal_pipe, &wakeup);
-	ev_invoke(writer->wal_pipe.producer,
-		  &writer->wal_pipe.flush_input, EV_CUSTOM);
+	for (int i = 0; i < wal_stream_count; i++) {
+		struct wal_writer *writer = &wal_streams[i];
+
+		/* Stop the worker thread. */
+		struct wal_stop wakeup;
+		struct cmsg_hop route[1] = {
+			{wal_writer_stop_f, NULL}
+		};
+		cmsg_init(&wakeup, route);
+		wakeup.writer = writer;
+
+		cpipe_push(&writer->wal_pipe, &wakeup);
+		ev_invoke(writer->wal_pipe.producer,
+			  &writer->wal_pipe.flush_input, EV_CUSTOM);
+
+		if (cord_join(&writer->cord)) {
+			/* We can't recover from this in any reasonable way. */
+			panic_syserror("WAL writer: thread join failed");
+		}
 
-	if (cord_join(&writer->cord)) {
-		/* We can't recover from this in any reasonable way. */
-		panic_syserror("WAL writer: thread join failed");
+		wal_writer_destroy(writer);
 	}
 
-	wal_writer_destroy(writer);
-
 	rmean_tx_wal_bus = NULL;
+	histogram_wal_batch = NULL;
+	histogram_wal_fsync = NULL;
+	histogram_wal_queue = NULL;
+	histogram_wal_write = NULL;
+	wal_stream_count = 0;
 	wal = NULL;
 }
 
+static void
+wal_group_sync(struct wal_writer *writer);
+
 struct wal_checkpoint: public cmsg
 {
-	struct vclock *vclock;
+	struct wal_writer *writer;
+	struct cmsg_hop hops[2];
+	struct vclock vclock;
 	struct fiber *fiber;
+	/** The number of streams not checkpointed yet. */
+	int *pending;
 	bool rotate;
 };
 
@@ -349,7 +564,10 @@ void
 wal_checkpoint_f(struct cmsg *data)
 {
 	struct wal_checkpoint *msg = (struct wal_checkpoint *) data;
-	struct wal_writer *writer = wal;
+	struct wal_writer *writer = msg->writer;
+	/* Do not checkpoint rows which are not synced yet. */
+	if (writer->group_leader != NULL)
+		wal_group_sync(writer);
 	/*
 	 * Avoid closing the current WAL if it has no rows (empty).
 	 */
@@ -357,40 +575,252 @@ wal_checkpoint_f(struct cmsg *data)
 	    vclock_sum(&writer->current_wal->vclock) !=
 	    vclock_sum(&writer->vclock)) {
 
-		xlog_close(writer->current_wal);
-		writer->current_wal = NULL;
+		wal_close_current(writer);
 		/*
 		 * Avoid creating an empty xlog if this is the
 		 * last snapshot before shutdown.
 		 */
 	}
-	vclock_copy(msg->vclock, &writer->vclock);
+	vclock_copy(&msg->vclock, &writer->vclock);
 }
 
 void
 wal_checkpoint_done_f(struct cmsg *data)
 {
 	struct wal_checkpoint *msg = (struct wal_checkpoint *) data;
-	fiber_wakeup(msg->fiber);
+	if (--*msg->pending == 0)
+		fiber_wakeup(msg->fiber);
 }
 
+/**
+ * Checkpoint all streams at once and merge their vclocks:
+ * each stream knows only the rows it has written.
+ */
 void
 wal_checkpoint(struct wal_writer *writer, struct vclock *vclock, bool rotate)
 {
-	static struct cmsg_hop wal_checkpoint_route[] = {
-		{wal_checkpoint_f, &wal_writer_singleton.tx_pipe},
-		{wal_checkpoint_done_f, NULL},
-	};
-	vclock_create(vclock);
-	struct wal_checkpoint msg;
-	cmsg_init(&msg, wal_checkpoint_route);
-	msg.vclock = vclock;
-	msg.fiber = fiber();
-	msg.rotate = rotate;
-	cpipe_push(&writer->wal_pipe, &msg);
+	assert(writer == &wal_streams[0]);
+	(void) writer;
+	struct wal_checkpoint msgs[WAL_STREAMS_MAX];
+	int pending = wal_stream_count;
+	for (int i = 0; i < wal_stream_count; i++) {
+		struct wal_checkpoint *msg = &msgs[i];
+		msg->writer = &wal_streams[i];
+		msg->hops[0] = {wal_checkpoint_f, &msg->writer->tx_pipe};
+		msg->hops[1] = {wal_checkpoint_done_f, NULL};
+		cmsg_init(msg, msg->hops);
+		msg->fiber = fiber();
+		msg->pending = &pending;
+		msg->rotate = rotate;
+		cpipe_push(&msg->writer->wal_pipe, msg);
+	}
 	fiber_set_cancellable(false);
-	fiber_yield();
+	while (pending > 0)
+		fiber_yield();
 	fiber_set_cancellable(true);
+
+	vclock_copy(vclock, &msgs[0].vclock);
+	for (int i = 1; i < wal_stream_count; i++) {
+		struct vclock_iterator it;
+		vclock_iterator_init(&it, &msgs[i].vclock);
+		vclock_foreach(&it, server) {
+			if (server.lsn > vclock_get(vclock, server.id))
+				vclock_follow(vclock, server.id, server.lsn);
+		}
+	}
+}
+
+static ssize_t
+wal_prealloc_cb(va_list ap)
+{
+	int fd = va_arg(ap, int);
+	off_t offset = va_arg(ap, off_t);
+	off_t len = va_arg(ap, off_t);
+	return fio_prealloc(fd, offset, len);
+}
+
+/**
+ * Create an empty file with @a size bytes preallocated.
+ * @return the preallocated size, which is 0 if preallocation
+ *         failed, or -1 if the file can't be created.
+ */
+static ssize_t
+wal_spare_create_cb(va_list ap)
+{
+	const char *path = va_arg(ap, const char *);
+	off_t size = va_arg(ap, off_t);
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return -1;
+	if (size > 0 && fio_prealloc(fd, 0, size) != 0)
+		size = 0;
+	/* Make the allocation durable before the file is used. */
+	if (fsync(fd) != 0) {
+		close(fd);
+		unlink(path);
+		return -1;
+	}
+	close(fd);
+	return size;
+}
+
+static inline off_t
+wal_prealloc_step(struct wal_writer *writer)
+{
+	return MIN(writer->prealloc_size, (off_t) WAL_PREALLOC_STEP);
+}
+
+static bool
+wal_prealloc_is_needed(struct wal_writer *writer)
+{
+	return writer->current_wal != NULL &&
+	       writer->prealloc_is_supported &&
+	       ! writer->prealloc_is_failed &&
+	       writer->wal_size + wal_prealloc_step(writer) / 2 >
+	       writer->prealloc_end;
+}
+
+static void
+wal_prealloc_wakeup(struct wal_writer *writer)
+{
+	/* coio_call() must not be woken up spuriously. */
+	if (writer->prealloc_fiber != NULL && ! writer->prealloc_is_busy)
+		fiber_wakeup(writer->prealloc_fiber);
+}
+
+/** Preallocate the next step of space for the current WAL. */
+static void
+wal_prealloc_current(struct wal_writer *writer)
+{
+	struct xlog *l = writer->current_wal;
+	uint64_t wal_id = writer->wal_id;
+	off_t offset = MAX(writer->prealloc_end, writer->wal_size);
+	off_t len = wal_prealloc_step(writer);
+	/*
+	 * The WAL can be closed while the space is allocated,
+	 * so use a copy of its descriptor.
+	 */
+	int fd = dup(fileno(l->f));
+	if (fd < 0) {
+		say_syserror("%s: dup() failed", l->filename);
+		writer->prealloc_is_failed = true;
+		return;
+	}
+	if (coio_call(wal_prealloc_cb, fd, offset, len) != 0) {
+		if (errno == ENOTSUP || errno == EOPNOTSUPP) {
+			say_warn("WAL disk space preallocation "
+				 "is not supported");
+			writer->prealloc_is_supported = false;
+		} else {
+			say_syserror("failed to preallocate WAL disk space");
+			if (writer->wal_id == wal_id)
+				writer->prealloc_is_failed = true;
+		}
+	} else if (writer->wal_id == wal_id) {
+		writer->prealloc_end = offset + len;
+	} else {
+		/* Release the space beyond the end of closed WAL. */
+		struct stat st;
+		if (fstat(fd, &st) == 0)
+			fio_truncate(fd, st.st_size);
+	}
+	close(fd);
+}
+
+static void
+wal_spare_create(struct wal_writer *writer)
+{
+	writer->spare_is_needed = false;
+	off_t size = writer->prealloc_is_supported ?
+		     writer->prealloc_size : 0;
+	ssize_t rc = coio_call(wal_spare_create_cb, writer->spare_path,
+			       size);
+	if (rc < 0) {
+		say_syserror("%s: failed to create", writer->spare_path);
+		return;
+	}
+	writer->spare_size = rc;
+}
+
+/**
+ * The WAL thread fiber which preallocates space for the current
+ * WAL and creates the spare file for the next one.
+ */
+static int
+wal_prealloc_f(va_list ap)
+{
+	struct wal_writer *writer = va_arg(ap, struct wal_writer *);
+	while (! writer->prealloc_is_stopped) {
+		writer->prealloc_is_busy = true;
+		if (wal_prealloc_is_needed(writer)) {
+			wal_prealloc_current(writer);
+		} else if (writer->spare_is_needed &&
+			   writer->spare_size < 0) {
+			wal_spare_create(writer);
+		} else {
+			writer->prealloc_is_busy = false;
+			fiber_yield();
+		}
+	}
+	writer->prealloc_is_busy = false;
+	return 0;
+}
+
+/**
+ * Create a new WAL, from the spare file if it is ready.
+ */
+static struct xlog *
+wal_create(struct wal_writer *writer)
+{
+	struct xlog *l = NULL;
+	off_t prealloc_end = 0;
+	if (writer->spare_size >= 0) {
+		l = xlog_create_from(&writer->wal_dir, &writer->vclock,
+				     writer->spare_path);
+		prealloc_end = writer->spare_size;
+		writer->spare_size = -1;
+	}
+	if (l == NULL) {
+		l = xlog_create(&writer->wal_dir, &writer->vclock);
+		prealloc_end = 0;
+	}
+	writer->spare_is_needed = true;
+	if (l != NULL) {
+		off_t size = fio_lseek(fileno(l->f), 0, SEEK_CUR);
+		writer->wal_size = size > 0 ? size : 0;
+		writer->prealloc_end = prealloc_end;
+	}
+	wal_prealloc_wakeup(writer);
+	return l;
+}
+
+static void
+wal_close_current(struct wal_writer *writer)
+{
+	struct xlog *l = writer->current_wal;
+	assert(l != NULL);
+	if (writer->group_leader != NULL)
+		wal_group_sync(writer);
+	/* Release the preallocated space beyond the end of file. */
+	off_t size = fio_lseek(fileno(l->f), 0, SEEK_CUR);
+	if (size >= 0 && writer->prealloc_end > size)
+		fio_truncate(fileno(l->f), size);
+	if (size >= 0 && l->rows >= writer->rows_per_wal) {
+		writer->prealloc_size = MIN(MAX(size,
+			(off_t) WAL_PREALLOC_MIN), (off_t) WAL_PREALLOC_MAX);
+	}
+	writer->wal_id++;
+	writer->wal_size = 0;
+	writer->prealloc_end = 0;
+	writer->prealloc_is_failed = false;
+	/*
+	 * We can not handle xlog_close()
+	 * failure in any reasonable way.
+	 * A warning is written to the server
+	 * log file.
+	 */
+	xlog_close(l);
+	writer->current_wal = NULL;
 }
 
 /**
@@ -422,17 +852,12 @@ wal_opt_rotate(struct wal_writer *writer)
 		 * one.
 		 */
 		if (wal_to_close) {
-			/*
-			 * We can not handle xlog_close()
-			 * failure in any reasonable way.
-			 * A warning is written to the server
-			 * log file.
-			 */
-			xlog_close(wal_to_close);
+			assert(wal_to_close == writer->current_wal);
+			wal_close_current(writer);
 			wal_to_close = NULL;
 		}
 		/* Open WAL with '.inprogress' suffix. */
-		l = xlog_create(&writer->wal_dir, &writer->vclock);
+		l = wal_create(writer);
 	}
 	assert(wal_to_close == NULL);
 	writer->current_wal = l;
@@ -476,20 +901,29 @@ wal_writer_begin_rollback(struct wal_writer *writer)
 		 * valve is closed by non-empty writer->rollback
 		 * list.
 		 */
-		{ wal_writer_clear_bus, &wal_writer_singleton.wal_pipe },
-		{ wal_writer_clear_bus, &wal_writer_singleton.tx_pipe },
+		{ wal_writer_clear_bus, &wal_streams[0].wal_pipe },
+		{ wal_writer_clear_bus, &wal_streams[0].tx_pipe },
 		/*
 		 * Step 2: writer->rollback queue contains all
 		 * messages which need to be rolled back,
 		 * perform the rollback.
 		 */
-		{ tx_schedule_rollback, &wal_writer_singleton.wal_pipe },
+		{ tx_schedule_rollback, &wal_streams[0].wal_pipe },
 		/*
 		 * Step 3: re-open the WAL for writing.
 		 */
 		{ wal_writer_end_rollback, NULL }
 	};
 
+	/*
+	 * Transactions written to other streams may depend on
+	 * the failed ones, and can't be rolled back once they
+	 * are on disk.
+	 */
+	if (wal_stream_count > 1) {
+		panic("%s: failed to write to a WAL stream",
+		      writer->wal_dir.dirname);
+	}
 	/*
 	 * Make sure the WAL writer rolls back
 	 * all input until rollback mode is off.
@@ -501,22 +935,110 @@ wal_writer_begin_rollback(struct wal_writer *writer)
 static void
 wal_notify_watchers(struct wal_writer *writer);
 
+/**
+ * fdatasync() the current WAL and wake up all fibers of the
+ * current group: the leader first, then the others in the
+ * order they joined the group, so that their messages get
+ * back to tx in the order they were written.
+ */
+static void
+wal_group_sync(struct wal_writer *writer)
+{
+	struct xlog *l = writer->current_wal;
+	assert(l != NULL);
+	ev_tstamp start = ev_time();
+#ifdef HAVE_FDATASYNC
+	int rc = fdatasync(fileno(l->f));
+#else
+	int rc = fsync(fileno(l->f));
+#endif
+	/*
+	 * The written data may be lost after a failed sync, and
+	 * a retry would not tell us, so there is no way to say
+	 * if the transactions are durable.
+	 */
+	if (rc != 0)
+		panic_syserror("%s: fdatasync failed", l->filename);
+	histogram_collect(&writer->fsync_hist, (ev_time() - start) * 1000000);
+	histogram_collect(&writer->batch_hist, writer->group_rows);
+
+	struct fiber *leader = writer->group_leader;
+	writer->group_leader = NULL;
+	writer->group_rows = 0;
+	writer->group_sync_count++;
+	if (leader != NULL && leader != fiber())
+		fiber_wakeup(leader);
+	while (! rlist_empty(&writer->group_waiters)) {
+		/* fiber_wakeup() removes the fiber from the list. */
+		fiber_wakeup(rlist_first_entry(&writer->group_waiters,
+					       struct fiber, state));
+	}
+}
+
+/**
+ * Hold the current WAL message until the rows written by it
+ * are synced, see wal_writer::group_commit_delay.
+ */
+static void
+wal_group_commit(struct wal_writer *writer)
+{
+	if (writer->in_rollback.route != NULL) {
+		/*
+		 * Do not hold messages during a rollback: all
+		 * of them must get to tx before the rollback
+		 * message, see wal_writer_begin_rollback().
+		 * Sync what is written and let the fibers of
+		 * the synced group go back to tx first.
+		 */
+		if (writer->group_rows > 0)
+			wal_group_sync(writer);
+		fiber_reschedule();
+		return;
+	}
+	if (writer->group_leader == NULL) {
+		assert(writer->group_rows > 0);
+		writer->group_leader = fiber();
+		if (writer->group_rows < writer->group_commit_rows)
+			fiber_yield_timeout(writer->group_commit_delay);
+		/* The group could have been synced meanwhile. */
+		if (writer->group_leader == fiber())
+			wal_group_sync(writer);
+		return;
+	}
+	if (writer->group_rows >= writer->group_commit_rows)
+		fiber_wakeup(writer->group_leader);
+	uint64_t sync_count = writer->group_sync_count;
+	do {
+		rlist_add_tail_entry(&writer->group_waiters, fiber(), state);
+		fiber_yield();
+	} while (writer->group_sync_count == sync_count);
+}
+
 static void
 wal_write_to_disk(struct cmsg *msg)
 {
-	struct wal_writer *writer = wal;
 	struct wal_msg *wal_msg = (struct wal_msg *) msg;
+	struct wal_writer *writer = wal_msg->writer;
+	bool group_commit = writer->group_commit_delay > 0;
+	ev_tstamp start = ev_time();
+	histogram_collect(&writer->queue_hist,
+			  (start - wal_msg->push_time) * 1000000);
 
 	if (writer->in_rollback.route != NULL) {
 		/* We're rolling back a failed write. */
 		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+		if (group_commit)
+			wal_group_commit(writer);
 		return;
 	}
 
 	/* Xlog is only rotated between queue processing  */
 	if (wal_opt_rotate(writer) != 0) {
 		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
-		return wal_writer_begin_rollback(writer);
+		wal_writer_begin_rollback(writer);
+		if (group_commit)
+			wal_group_commit(writer);
+		return;
 	}
 
 	/*
@@ -605,6 +1127,7 @@ done:
 	 * Iterate over `input` queue and add all processed requests to
 	 * `commit` queue and all other to `rollback` queue.
 	 */
+	int64_t rows = 0;
 	struct wal_request *reqend = req;
 	for (req = stailq_first_entry(&wal_msg->commit, struct wal_request, fifo);
 	     req != reqend;
@@ -634,6 +1157,9 @@ done:
 			if (ftruncate(fileno(l->f), good_offset) != 0)
 				panic_syserror("failed to rollback xlog");
 			written_bytes = req->start_offset;
+			/* Truncation releases the preallocated space. */
+			writer->prealloc_end = MIN(writer->prealloc_end,
+						   good_offset);
 
 			/* Move tail to `rollback` queue. */
 			stailq_splice(&wal_msg->commit, &req->fifo, &wal_msg->rollback);
@@ -647,12 +1173,22 @@ done:
 			      req->rows[req->n_rows - 1]->lsn);
 		/* Update row counter for wal_opt_rotate() */
 		l->rows += req->n_rows;
-		/* Mark request as successful for tx thread */
-		req->res = vclock_sum(&writer->vclock);
+		rows += req->n_rows;
 	}
 
+	writer->wal_size += written_bytes;
+	if (wal_prealloc_is_needed(writer))
+		wal_prealloc_wakeup(writer);
+
 	fiber_gc();
 	wal_notify_watchers(writer);
+	histogram_collect(&writer->write_hist, (ev_time() - start) * 1000000);
+	if (group_commit) {
+		writer->group_rows += rows;
+		wal_group_commit(writer);
+	} else if (rows > 0) {
+		histogram_collect(&writer->batch_hist, rows);
+	}
 }
 
 /** WAL writer thread main loop.  */
@@ -664,17 +1200,55 @@ wal_writer_f(va_list ap)
 	coeio_enable();
 
 	writer->main_f = fiber();
+
+	struct fiber *prealloc = fiber_new("wal_prealloc", wal_prealloc_f);
+	if (prealloc != NULL) {
+		writer->prealloc_fiber = prealloc;
+		fiber_set_joinable(prealloc, true);
+		fiber_start(prealloc, writer);
+	} else {
+		/* Not critical, WAL files will be just created on demand. */
+		error_log(diag_last_error(diag_get()));
+	}
+
 	cbus_join(&writer->tx_wal_bus, &writer->wal_pipe);
 
 	fiber_yield();
 
-	if (writer->current_wal != NULL) {
-		xlog_close(writer->current_wal);
-		writer->current_wal = NULL;
+	if (writer->prealloc_fiber != NULL) {
+		writer->prealloc_is_stopped = true;
+		wal_prealloc_wakeup(writer);
+		fiber_join(writer->prealloc_fiber);
+		writer->prealloc_fiber = NULL;
 	}
+	if (writer->current_wal != NULL)
+		wal_close_current(writer);
+	if (writer->spare_size >= 0)
+		unlink(writer->spare_path);
 	return 0;
 }
 
+/**
+ * Choose the stream to write a request to: the one which
+ * has a batch not sent yet, so that the request joins it,
+ * or else the one with the fewest batches in progress.
+ */
+static struct wal_writer *
+wal_choose_stream()
+{
+	struct wal_writer *best = &wal_streams[0];
+	for (int i = 0; i < wal_stream_count; i++) {
+		struct wal_writer *writer = &wal_streams[i];
+		if (! stailq_empty(&writer->wal_pipe.input) &&
+		    wal_msg(writer, stailq_first_entry(&writer->wal_pipe.input,
+						       struct cmsg, fifo)))
+			return writer;
+		if (writer->n_inflight < best->n_inflight)
+			best = writer;
+	}
+	return best;
+}
+
 /**
  * WAL writer main entry point: queue a single request
  * to be written to disk and wait until this task is completed.
@@ -698,9 +1272,12 @@ wal_write(struct wal_writer *writer, struct wal_request *req)
 	req->fiber = fiber();
 	req->res = -1;
 
+	if (wal_stream_count > 1)
+		writer = wal_choose_stream();
 	struct wal_msg *batch;
 	if (!stailq_empty(&writer->wal_pipe.input) &&
-	    (batch = wal_msg(stailq_first_entry(&writer->wal_pipe.input,
+	    (batch = wal_msg(writer,
+			     stailq_first_entry(&writer->wal_pipe.input,
 						struct cmsg, fifo)))) {
 
 		stailq_add_tail_entry(&batch->commit, req, fifo);
@@ -708,13 +1285,16 @@ wal_write(struct wal_writer *writer, struct wal_request *req)
 		batch = (struct wal_msg *)
 			region_alloc_xc(&fiber()->gc,
 					sizeof(struct wal_msg));
-		wal_msg_create(batch);
+		wal_msg_create(batch, writer);
+		stailq_add_tail_entry(&wal_msg_queue, batch, in_queue);
+		writer->n_inflight++;
 		/*
 		 * Sic: first add a request, then push the batch,
 		 * since cpipe_push() may pass the batch to WAL
 		 * thread right away.
 		 */
 		stailq_add_tail_entry(&batch->commit, req, fifo);
+		batch->push_time = ev_time();
 		cpipe_push(&writer->wal_pipe, batch);
 	}
 	writer->wal_pipe.n_input += req->n_rows * XROW_IOVMAX;
@@ -781,7 +1361,9 @@ void
 wal_atfork()
 {
 	if (wal) { /* NULL when forking for box.cfg{background = true} */
-		xlog_atfork(&wal->current_wal);
+		for (int i = 0; i < wal_stream_count; i++)
+			xlog_atfork(&wal_streams[i].current_wal);
+		wal_stream_count = 0;
 		wal = NULL;
 	}
 }
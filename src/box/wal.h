@@ -37,14 +37,26 @@
 
 struct fiber;
 struct wal_writer;
+struct histogram;
 
 enum wal_mode { WAL_NONE = 0, WAL_WRITE, WAL_FSYNC, WAL_MODE_MAX };
 
+/** The max number of WAL streams, see wal_stream_dirs. */
+enum { WAL_STREAMS_MAX = 8 };
+
 /** String constants for the supported modes. */
 extern const char *wal_mode_STRS[];
 
 extern struct wal_writer *wal;
 extern struct rmean *rmean_tx_wal_bus;
+/**
+ * Rows per WAL write, WAL sync latency, the time a write waits
+ * for the WAL thread and the time it takes, see box.stat.wal.
+ */
+extern struct histogram *histogram_wal_batch;
+extern struct histogram *histogram_wal_fsync;
+extern struct histogram *histogram_wal_queue;
+extern struct histogram *histogram_wal_write;
 
 #if defined(__cplusplus)
 
@@ -68,10 +80,24 @@ int64_t
 wal_write(struct wal_writer *writer, struct wal_request *req);
 
 
+/**
+ * Start the WAL threads. With @a group_commit_delay > 0 in
+ * fsync mode the WAL is synced once per group of writes:
+ * a write waits up to @a group_commit_delay seconds for
+ * other writes, or until the group has @a group_commit_rows
+ * rows, before the group is synced and committed.
+ *
+ * With @a stream_dir_count > 0 the WAL is split into streams,
+ * one in @a wal_dirname and one in each of @a stream_dirnames,
+ * written by separate threads. Each write goes to one stream,
+ * but transactions are committed in the order of their LSNs.
+ */
 void
 wal_writer_start(enum wal_mode wal_mode, const char *wal_dirname,
+		 const char **stream_dirnames, int stream_dir_count,
 		 const struct tt_uuid *server_uuid, struct vclock *vclock,
-		 int64_t rows_per_wal);
+		 int64_t rows_per_wal, double group_commit_delay,
+		 int64_t group_commit_rows);
 
 void
 wal_writer_stop();
@@ -45,6 +45,9 @@
 #include "xrow.h"
 #include "iproto_constants.h"
 
+#include <lz4.h>
+#include <zstd.h>
+
 /*
  * marker is MsgPack fixext2
  * +--------+--------+--------+--------+
@@ -55,6 +58,10 @@ typedef uint32_t log_magic_t;
 
 static const log_magic_t row_marker = mp_bswap_u32(0xd5ba0bab); /* host byte order */
 static const log_magic_t eof_marker = mp_bswap_u32(0xd510aded); /* host byte order */
+static const log_magic_t block_marker = mp_bswap_u32(0xd5b10c0b); /* host byte order */
+
+const char *xlog_compression_STRS[] = { "none", "lz4", "zstd", NULL };
+
 static const char inprogress_suffix[] = ".inprogress";
 static const char v12[] = "0.12\n";
 
@@ -385,90 +392,378 @@ format_filename(struct xdir *dir, int64_t signature,
 
 /* {{{ struct xlog_cursor */
 
+enum {
+	/**
+	 * The cursor reads the file in chunks of this size and
+	 * decodes rows right in the read buffer.
+	 */
+	XLOG_CURSOR_READ_SIZE = 1024 * 1024,
+};
+
+/** File offset of the next byte to parse. */
+static inline off_t
+xlog_cursor_pos(struct xlog_cursor *i)
+{
+	return i->rbuf_offset + i->rbuf_pos;
+}
+
 /**
- * @retval -1 error
+ * Set the position of the next byte to parse, keeping
+ * the data read ahead if the position is within it.
+ */
+static void
+xlog_cursor_seek(struct xlog_cursor *i, off_t offset)
+{
+	if (offset >= i->rbuf_offset &&
+	    offset <= i->rbuf_offset + (off_t) i->rbuf_size) {
+		i->rbuf_pos = offset - i->rbuf_offset;
+	} else {
+		i->rbuf_offset = offset;
+		i->rbuf_size = 0;
+		i->rbuf_pos = 0;
+	}
+}
+
+/**
+ * Make sure there are at least @a size bytes to parse in the
+ * read buffer, reading the file ahead if necessary. May move
+ * the data in the buffer, so rows decoded earlier are
+ * invalidated.
+ *
  * @retval 0 success
- * @retval 1 EOF
+ * @retval 1 EOF: the file ends before @a size bytes
  */
 static int
-row_reader(FILE *f, struct xrow_header *row)
+xlog_cursor_fill(struct xlog_cursor *i, size_t size)
 {
-	const char *data;
+	size_t unread = i->rbuf_size - i->rbuf_pos;
+	if (unread >= size)
+		return 0;
+	if (i->rbuf_pos > 0) {
+		memmove(i->rbuf, i->rbuf + i->rbuf_pos, unread);
+		i->rbuf_offset += i->rbuf_pos;
+		i->rbuf_size = unread;
+		i->rbuf_pos = 0;
+	}
+	size_t capacity = MAX((size_t) XLOG_CURSOR_READ_SIZE, size);
+	if (i->rbuf_capacity < capacity) {
+		char *rbuf = (char *) realloc(i->rbuf, capacity);
+		if (rbuf == NULL) {
+			tnt_raise(OutOfMemory, capacity, "realloc",
+				  "xlog read buffer");
+		}
+		i->rbuf = rbuf;
+		i->rbuf_capacity = capacity;
+	}
 
-	/* Read fixed header */
-	char fixheader[XLOG_FIXHEADER_SIZE - sizeof(log_magic_t)];
-	if (fread(fixheader, sizeof(fixheader), 1, f) != 1) {
-		if (feof(f))
-			return 1;
-error:
-		char buf[PATH_MAX];
-		snprintf(buf, sizeof(buf), "%s: failed to read or parse row "
-			 "header at offset %" PRIu64, fio_filename(fileno(f)),
-			 (uint64_t) ftello(f));
-		tnt_error(ClientError, ER_INVALID_MSGPACK, buf);
-		return -1;
+	FILE *f = i->log->f;
+	char *buf = i->rbuf + i->rbuf_size;
+	size_t count = i->rbuf_capacity - i->rbuf_size;
+	off_t offset = i->rbuf_offset + i->rbuf_size;
+	ssize_t n;
+	if (fileno(f) >= 0) {
+		n = fio_pread(fileno(f), buf, count, offset);
+	} else {
+		/* A memory stream, e.g. the bootstrap snapshot. */
+		n = -1;
+		if (fseeko(f, offset, SEEK_SET) == 0) {
+			n = fread(buf, 1, count, f);
+			if (n == 0 && ferror(f))
+				n = -1;
+		}
 	}
+	if (n < 0)
+		tnt_raise(SystemError, "%s: failed to read", i->log->filename);
+	i->rbuf_size += n;
+	return i->rbuf_size - i->rbuf_pos < size;
+}
 
-	/* Decode len, previous crc32 and row crc32 */
-	data = fixheader;
-	if (mp_check(&data, data + sizeof(fixheader)) != 0)
-		goto error;
+/**
+ * Set diag to an error about a corrupt record at the cursor
+ * position.
+ */
+static void
+xlog_cursor_error(struct xlog_cursor *i, const char *what)
+{
+	char buf[PATH_MAX];
+	snprintf(buf, sizeof(buf), "%s: %s at offset %" PRIu64,
+		 i->log->filename, what, (uint64_t) xlog_cursor_pos(i));
+	tnt_error(ClientError, ER_INVALID_MSGPACK, buf);
+}
+
+/**
+ * Decode length and checksum of a row from the fixed header
+ * following row_marker.
+ * @retval 0 success
+ * @retval -1 the header is malformed
+ */
+static int
+row_fixheader_decode(const char *fixheader, uint32_t *len, uint32_t *crc32c)
+{
+	const char *data = fixheader;
+	const char *end = fixheader + XLOG_FIXHEADER_SIZE - sizeof(log_magic_t);
+	if (mp_check(&data, end) != 0)
+		return -1;
 	data = fixheader;
 
 	/* Read length */
 	if (mp_typeof(*data) != MP_UINT)
-		goto error;
-	uint32_t len = mp_decode_uint(&data);
-	if (len > IPROTO_BODY_LEN_MAX) {
-		char buf[PATH_MAX];
-		snprintf(buf, sizeof(buf),
-			 "%s: row is too big at offset %" PRIu64,
-			 fio_filename(fileno(f)), (uint64_t) ftello(f));
-		tnt_error(ClientError, ER_INVALID_MSGPACK, buf);
 		return -1;
-	}
+	*len = mp_decode_uint(&data);
 
 	/* Read previous crc32 */
 	if (mp_typeof(*data) != MP_UINT)
-		goto error;
+		return -1;
+	uint32_t crc32p = mp_decode_uint(&data);
+	(void) crc32p;
 
 	/* Read current crc32 */
-	uint32_t crc32p = mp_decode_uint(&data);
 	if (mp_typeof(*data) != MP_UINT)
-		goto error;
-	uint32_t crc32c = mp_decode_uint(&data);
-	assert(data <= fixheader + sizeof(fixheader));
-	(void) crc32p;
+		return -1;
+	*crc32c = mp_decode_uint(&data);
+	assert(data <= end);
+	return 0;
+}
 
-	/* Allocate memory for body */
-	char *bodybuf = (char *) region_alloc(&fiber()->gc, len);
-	if (bodybuf == NULL) {
-		tnt_error(OutOfMemory, len, "region", "new slab");
+/**
+ * Decode the row at the cursor position, which starts with
+ * row_marker. The row is decoded in place: it refers to
+ * the read buffer of the cursor.
+ *
+ * @retval -1 error
+ * @retval 0 success
+ * @retval 1 EOF
+ */
+static int
+row_reader(struct xlog_cursor *i, struct xrow_header *row)
+{
+	/* Read fixed header */
+	if (xlog_cursor_fill(i, XLOG_FIXHEADER_SIZE) != 0)
+		return 1;
+
+	/* Decode len, previous crc32 and row crc32 */
+	uint32_t len, crc32c;
+	const char *fixheader = i->rbuf + i->rbuf_pos + sizeof(log_magic_t);
+	if (row_fixheader_decode(fixheader, &len, &crc32c) != 0) {
+		xlog_cursor_error(i, "failed to read or parse row header");
+		return -1;
+	}
+	if (len > IPROTO_BODY_LEN_MAX) {
+		xlog_cursor_error(i, "row is too big");
 		return -1;
 	}
 
 	/* Read header and body */
-	if (fread(bodybuf, len, 1, f) != 1)
+	if (xlog_cursor_fill(i, XLOG_FIXHEADER_SIZE + len) != 0)
 		return 1;
+	const char *data = i->rbuf + i->rbuf_pos + XLOG_FIXHEADER_SIZE;
+	const char *end = data + len;
 
 	/* Validate checksum */
-	if (crc32_calc(0, bodybuf, len) != crc32c) {
+	if (crc32_calc(0, data, len) != crc32c) {
 		char buf[PATH_MAX];
+		snprintf(buf, sizeof(buf), "row checksum mismatch "
+			 "(expected %u)", (unsigned) crc32c);
+		xlog_cursor_error(i, buf);
+		return -1;
+	}
+
+	i->rbuf_pos = end - i->rbuf;
+	xrow_header_decode(row, &data, end);
+	return 0;
+}
+
+/**
+ * Decompress the block of rows at the cursor position, which
+ * starts with block_marker, so that xlog_cursor_next() can
+ * take rows from it.
+ *
+ * @retval -1 error
+ * @retval 0 success
+ * @retval 1 EOF
+ */
+static int
+block_reader(struct xlog_cursor *i)
+{
+	/* Read fixed header */
+	if (xlog_cursor_fill(i, XLOG_BLOCK_HEADER_SIZE) != 0)
+		return 1;
 
-		snprintf(buf, sizeof(buf), "%s: row checksum mismatch (expected %u)"
-			 " at offset %" PRIu64,
-			 fio_filename(fileno(f)), (unsigned) crc32c,
-			 (uint64_t) ftello(f));
-		tnt_error(ClientError, ER_INVALID_MSGPACK, buf);
+	/*
+	 * Decode compressed len, raw len, compression method
+	 * and crc32 of compressed data.
+	 */
+	uint64_t fields[4];
+	const char *data = i->rbuf + i->rbuf_pos + sizeof(log_magic_t);
+	const char *end = i->rbuf + i->rbuf_pos + XLOG_BLOCK_HEADER_SIZE;
+	for (unsigned k = 0; k < lengthof(fields); k++) {
+		const char *field = data;
+		if (mp_check(&data, end) != 0 ||
+		    mp_typeof(*field) != MP_UINT) {
+			xlog_cursor_error(i, "failed to read or parse "
+					  "block header");
+			return -1;
+		}
+		fields[k] = mp_decode_uint(&field);
+	}
+	uint64_t len = fields[0];
+	uint64_t size = fields[1];
+	uint64_t compression = fields[2];
+	uint32_t crc32c = fields[3];
+	if (len > IPROTO_BODY_LEN_MAX || size > IPROTO_BODY_LEN_MAX) {
+		xlog_cursor_error(i, "block is too big");
 		return -1;
 	}
 
-	data = bodybuf;
-	xrow_header_decode(row, &data, bodybuf + len);
+	/* Read compressed data */
+	if (xlog_cursor_fill(i, XLOG_BLOCK_HEADER_SIZE + len) != 0)
+		return 1;
+	const char *zdata = i->rbuf + i->rbuf_pos + XLOG_BLOCK_HEADER_SIZE;
 
+	/* Validate checksum */
+	if (crc32_calc(0, zdata, len) != crc32c) {
+		char buf[PATH_MAX];
+		snprintf(buf, sizeof(buf), "block checksum mismatch "
+			 "(expected %u)", (unsigned) crc32c);
+		xlog_cursor_error(i, buf);
+		return -1;
+	}
+
+	if (i->block_capacity < size) {
+		char *block = (char *) realloc(i->block, size);
+		if (block == NULL) {
+			tnt_error(OutOfMemory, size, "realloc", "xlog block");
+			return -1;
+		}
+		i->block = block;
+		i->block_capacity = size;
+	}
+	bool is_ok;
+	switch (compression) {
+	case XLOG_COMPRESSION_LZ4:
+		is_ok = LZ4_decompress_safe(zdata, i->block, len,
+					    size) == (int) size;
+		break;
+	case XLOG_COMPRESSION_ZSTD: {
+		size_t rc = ZSTD_decompress(i->block, size, zdata, len);
+		is_ok = !ZSTD_isError(rc) && rc == size;
+		break;
+	}
+	default:
+		is_ok = false;
+		break;
+	}
+	if (!is_ok) {
+		char buf[PATH_MAX];
+		snprintf(buf, sizeof(buf), "failed to decompress block "
+			 "(compression %u)", (unsigned) compression);
+		xlog_cursor_error(i, buf);
+		return -1;
+	}
+	i->rbuf_pos = zdata + len - i->rbuf;
+	i->block_size = size;
+	i->block_pos = 0;
 	return 0;
 }
 
+/**
+ * Decode the next row of the current block in place: the row
+ * refers to the block memory, which stays valid until the
+ * next block is read.
+ */
+static void
+block_row_reader(struct xlog_cursor *i, struct xrow_header *row)
+{
+	const char *data = i->block + i->block_pos;
+	const char *end = i->block + i->block_size;
+	log_magic_t magic;
+	uint32_t len, crc32c;
+
+	if (end - data < XLOG_FIXHEADER_SIZE)
+		goto error;
+	memcpy(&magic, data, sizeof(magic));
+	if (magic != row_marker ||
+	    row_fixheader_decode(data + sizeof(magic), &len, &crc32c) != 0)
+		goto error;
+	data += XLOG_FIXHEADER_SIZE;
+	if (len > (size_t) (end - data) || crc32_calc(0, data, len) != crc32c)
+		goto error;
+	end = data + len;
+	i->block_pos = end - i->block;
+	xrow_header_decode(row, &data, end);
+	return;
+error:
+	char buf[PATH_MAX];
+	snprintf(buf, sizeof(buf), "%s: corrupt row at position %zu "
+		 "of the block ending at offset %" PRIu64,
+		 i->log->filename, i->block_pos, (uint64_t) i->good_offset);
+	tnt_raise(ClientError, ER_INVALID_MSGPACK, buf);
+}
+
+size_t
+xlog_block_bound(enum xlog_compression compression, size_t size)
+{
+	switch (compression) {
+	case XLOG_COMPRESSION_LZ4:
+		return XLOG_BLOCK_HEADER_SIZE + LZ4_compressBound(size);
+	case XLOG_COMPRESSION_ZSTD:
+		return XLOG_BLOCK_HEADER_SIZE + ZSTD_compressBound(size);
+	default:
+		return XLOG_BLOCK_HEADER_SIZE + size;
+	}
+}
+
+ssize_t
+xlog_encode_block(enum xlog_compression compression, const char *rows,
+		  size_t size, char *buf, size_t capacity)
+{
+	assert(capacity >= xlog_block_bound(compression, size));
+	assert(size <= IPROTO_BODY_LEN_MAX);
+	char *zdata = buf + XLOG_BLOCK_HEADER_SIZE;
+	size_t zcapacity = capacity - XLOG_BLOCK_HEADER_SIZE;
+	size_t len = 0;
+	switch (compression) {
+	case XLOG_COMPRESSION_LZ4: {
+		int rc = LZ4_compress_default(rows, zdata, size, zcapacity);
+		if (rc > 0)
+			len = rc;
+		break;
+	}
+	case XLOG_COMPRESSION_ZSTD: {
+		/* Fast compression level, same as in vinyl. */
+		size_t rc = ZSTD_compress(zdata, zcapacity, rows, size, 3);
+		if (!ZSTD_isError(rc))
+			len = rc;
+		break;
+	}
+	default:
+		return 0;
+	}
+	if (len == 0) {
+		tnt_error(XlogError, "failed to compress a block of %zu "
+			  "bytes with %s", size,
+			  xlog_compression_STRS[compression]);
+		return -1;
+	}
+	/* Write incompressible data as is. */
+	if (len + XLOG_BLOCK_HEADER_SIZE >= size)
+		return 0;
+
+	char *data = buf;
+	*(log_magic_t *) data = block_marker;
+	data += sizeof(block_marker);
+	data = mp_encode_uint(data, len);
+	data = mp_encode_uint(data, size);
+	data = mp_encode_uint(data, compression);
+	data = mp_encode_uint(data, crc32_calc(0, zdata, len));
+	/* Encode padding */
+	ssize_t padding = XLOG_BLOCK_HEADER_SIZE - (data - buf);
+	if (padding > 0)
+		data = mp_encode_strl(data, padding - 1) + padding - 1;
+	assert(data == buf + XLOG_BLOCK_HEADER_SIZE);
+	return XLOG_BLOCK_HEADER_SIZE + len;
+}
+
 int
 xlog_encode_row(const struct xrow_header *row, struct iovec *iov)
 {
@@ -508,6 +803,21 @@ xlog_cursor_open(struct xlog_cursor *i, struct xlog *l)
 	i->row_count = 0;
 	i->good_offset = ftello(l->f);
 	i->eof_read  = false;
+	i->rbuf = NULL;
+	i->rbuf_capacity = 0;
+	i->rbuf_offset = i->good_offset;
+	i->rbuf_size = 0;
+	i->rbuf_pos = 0;
+	i->block = NULL;
+	i->block_size = 0;
+	i->block_pos = 0;
+	i->block_capacity = 0;
+#if defined(HAVE_POSIX_FADVISE)
+	/* The file is read from the cursor position to the end. */
+	if (fileno(l->f) >= 0)
+		posix_fadvise(fileno(l->f), i->good_offset, 0,
+			      POSIX_FADV_SEQUENTIAL);
+#endif
 }
 
 void
@@ -524,53 +834,61 @@ xlog_cursor_close(struct xlog_cursor *i)
 	 */
 	fseeko(l->f, i->good_offset, SEEK_SET);
 	region_free(&fiber()->gc);
+	free(i->rbuf);
+	free(i->block);
 }
 
 /**
- * Read logfile contents using designated format, panic if
- * the log is corrupted/unreadable.
- *
- * @param i	iterator object, encapsulating log specifics.
+ * Take the next row from the current block.
+ * @retval 0 success
+ * @retval -1 the row is corrupt, the rest of the block
+ *            is skipped
+ */
+static int
+xlog_cursor_next_block_row(struct xlog_cursor *i, struct xrow_header *row)
+{
+	try {
+		block_row_reader(i, row);
+	} catch (ClientError *e) {
+		if (i->log->dir->panic_if_error)
+			throw;
+		e->log();
+		i->block_pos = i->block_size;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Read the next record of the file: a row or a block of
+ * compressed rows.
  *
- * @retval 0    OK
+ * @retval 0    a row is read
  * @retval 1    EOF
+ * @retval 2    a block is read, its rows are in the cursor
  */
-int
-xlog_cursor_next(struct xlog_cursor *i, struct xrow_header *row)
+static int
+xlog_cursor_next_record(struct xlog_cursor *i, struct xrow_header *row)
 {
 	struct xlog *l = i->log;
 	log_magic_t magic;
 	off_t marker_offset = 0;
 
-	assert(i->eof_read == false);
-
-	say_debug("xlog_cursor_next: marker:0x%016X/%zu",
-		  row_marker, sizeof(row_marker));
-
-	/*
-	 * Don't let gc pool grow too much. Yet to
-	 * it before reading the next row, to make
-	 * sure it's not freed along here.
-	 */
-	region_free_after(&fiber()->gc, 128 * 1024);
-
 restart:
 	if (marker_offset > 0)
-		fseeko(l->f, marker_offset + 1, SEEK_SET);
-
-	if (fread(&magic, sizeof(magic), 1, l->f) != 1)
-		goto eof;
+		xlog_cursor_seek(i, marker_offset + 1);
 
-	while (magic != row_marker) {
-		int c = fgetc(l->f);
-		if (c == EOF) {
+	for (;;) {
+		if (xlog_cursor_fill(i, sizeof(magic)) != 0) {
 			say_debug("eof while looking for magic");
 			goto eof;
 		}
-		magic = magic >> 8 |
-			((log_magic_t) c & 0xff) << (sizeof(magic)*8 - 8);
+		memcpy(&magic, i->rbuf + i->rbuf_pos, sizeof(magic));
+		if (magic == row_marker || magic == block_marker)
+			break;
+		i->rbuf_pos++;
 	}
-	marker_offset = ftello(l->f) - sizeof(row_marker);
+	marker_offset = xlog_cursor_pos(i);
 	if (i->good_offset != marker_offset)
 		say_warn("skipped %jd bytes after 0x%08jx offset",
 			(intmax_t)(marker_offset - i->good_offset),
@@ -578,8 +896,12 @@ restart:
 	say_debug("magic found at 0x%08jx", (uintmax_t)marker_offset);
 
 	try {
-		if (row_reader(l->f, row) != 0)
+		if (magic == block_marker) {
+			if (block_reader(i) != 0)
+				goto eof;
+		} else if (row_reader(i, row) != 0) {
 			goto eof;
+		}
 	} catch (ClientError *e) {
 		if (l->dir->panic_if_error)
 			throw;
@@ -594,33 +916,26 @@ restart:
 		goto restart;
 	}
 
-	i->good_offset = ftello(l->f);
-	i->row_count++;
-
-	if (i->row_count % 100000 == 0)
-		say_info("%.1fM rows processed", i->row_count / 1000000.);
-
-	return 0;
+	i->good_offset = xlog_cursor_pos(i);
+	return magic == block_marker ? 2 : 0;
 eof:
 	/*
-	 * According to POSIX, if a partial element is read, value
-	 * of the file position indicator for the stream is
-	 * unspecified.
-	 *
-	 * Thus don't trust the current file position, seek to the
-	 * last good position first.
+	 * A partial record may have been read, go back to
+	 * the last good position first.
 	 *
 	 * The only case of a fully read file is when eof_marker
 	 * is present and it is the last record in the file. If
 	 * eof_marker is missing, the caller must make the
 	 * decision whether to switch to the next file or not.
 	 */
-	fseeko(l->f, i->good_offset, SEEK_SET);
-	if (fread(&magic, sizeof(magic), 1, l->f) == 1) {
+	xlog_cursor_seek(i, i->good_offset);
+	if (xlog_cursor_fill(i, sizeof(magic)) == 0) {
+		memcpy(&magic, i->rbuf + i->rbuf_pos, sizeof(magic));
 		if (magic == eof_marker) {
-			i->good_offset = ftello(l->f);
+			i->rbuf_pos += sizeof(magic);
+			i->good_offset = xlog_cursor_pos(i);
 			i->eof_read = true;
-		} else if (magic == row_marker) {
+		} else if (magic == row_marker || magic == block_marker) {
 			/*
 			 * Row marker at the end of a file: a sign
 			 * of a corrupt log file in case of
@@ -638,6 +953,53 @@ eof:
 	return 1;
 }
 
+/**
+ * Read logfile contents using designated format, panic if
+ * the log is corrupted/unreadable. Rows of compressed blocks
+ * are returned one by one, as if they were written as is.
+ *
+ * @param i	iterator object, encapsulating log specifics.
+ *
+ * @retval 0    OK
+ * @retval 1    EOF
+ */
+int
+xlog_cursor_next(struct xlog_cursor *i, struct xrow_header *row)
+{
+	assert(i->eof_read == false);
+
+	say_debug("xlog_cursor_next: marker:0x%016X/%zu",
+		  row_marker, sizeof(row_marker));
+
+	/*
+	 * Don't let gc pool grow too much. Yet to
+	 * it before reading the next row, to make
+	 * sure it's not freed along here.
+	 */
+	region_free_after(&fiber()->gc, 128 * 1024);
+
+	for (;;) {
+		if (i->block_pos < i->block_size) {
+			if (xlog_cursor_next_block_row(i, row) == 0)
+				break;
+			continue;
+		}
+		int rc = xlog_cursor_next_record(i, row);
+		if (rc == 0)
+			break;
+		if (rc == 1)
+			return 1;
+		/* A block is read, take rows from it. */
+	}
+
+	i->row_count++;
+
+	if (i->row_count % 100000 == 0)
+		say_info("%.1fM rows processed", i->row_count / 1000000.);
+
+	return 0;
+}
+
 /* }}} */
 
 /* {{{ struct xlog */
@@ -905,12 +1267,14 @@ xlog_rename(struct xlog *l)
  * In case of error, writes a message to the server log
  * and sets errno.
  */
-struct xlog *
-xlog_create(struct xdir *dir, const struct vclock *vclock)
+static struct xlog *
+xlog_create_impl(struct xdir *dir, const struct vclock *vclock,
+		 const char *spare_path)
 {
 	char *filename;
 	FILE *f = NULL;
 	struct xlog *l = NULL;
+	bool is_created = false;
 
 	int64_t signature = vclock_sum(vclock);
 	assert(signature >= 0);
@@ -937,9 +1301,27 @@ xlog_create(struct xdir *dir, const struct vclock *vclock)
 	 * replication.
 	 */
 	filename = format_filename(dir, signature, INPROGRESS);
-	f = fiob_open(filename, dir->open_wflags);
+	if (spare_path != NULL) {
+		/*
+		 * Take over the spare file: it is empty, but may
+		 * have disk space allocated for it, which the
+		 * truncating open below would release.
+		 */
+		if (access(filename, F_OK) == 0) {
+			errno = EEXIST;
+			goto error;
+		}
+		if (rename(spare_path, filename) != 0)
+			goto error;
+		is_created = true;
+		f = fiob_open(filename, strchr(dir->open_wflags, 's') ?
+			      "r+s" : "r+");
+	} else {
+		f = fiob_open(filename, dir->open_wflags);
+	}
 	if (!f)
 		goto error;
+	is_created = true;
 	say_info("creating `%s'", filename);
 	l = (struct xlog *) calloc(1, sizeof(*l));
 	if (l == NULL)
@@ -962,14 +1344,27 @@ xlog_create(struct xdir *dir, const struct vclock *vclock)
 error:
 	int save_errno = errno;
 	say_syserror("%s: failed to open", filename);
-	if (f != NULL) {
+	if (f != NULL)
 		fclose(f);
+	if (is_created)
 		unlink(filename); /* try to remove incomplete file */
-	}
 	free(l);
 	errno = save_errno;
 	return NULL;
 }
 
+struct xlog *
+xlog_create(struct xdir *dir, const struct vclock *vclock)
+{
+	return xlog_create_impl(dir, vclock, NULL);
+}
+
+struct xlog *
+xlog_create_from(struct xdir *dir, const struct vclock *vclock,
+		 const char *spare_path)
+{
+	return xlog_create_impl(dir, vclock, spare_path);
+}
+
 /* }}} */
 
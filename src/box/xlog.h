@@ -240,6 +240,15 @@ xlog_open_stream(struct xdir *dir, int64_t signature,
 struct xlog *
 xlog_create(struct xdir *dir, const struct vclock *vclock);
 
+/**
+ * Same as xlog_create(), but instead of creating a new file
+ * rename an empty file created in advance, e.g. with disk
+ * space preallocated for it, and use it.
+ */
+struct xlog *
+xlog_create_from(struct xdir *dir, const struct vclock *vclock,
+		 const char *spare_path);
+
 /**
  * Sync a log file. The exact action is defined
  * by xdir flags.
@@ -274,6 +283,27 @@ struct xlog_cursor
 	int row_count;
 	off_t good_offset;
 	bool eof_read;
+	/**
+	 * The file contents read ahead. Rows are decoded right
+	 * in this buffer.
+	 */
+	char *rbuf;
+	/** Allocated size of the read buffer. */
+	size_t rbuf_capacity;
+	/** File offset of the beginning of the read buffer. */
+	off_t rbuf_offset;
+	/** Size of the data in the read buffer. */
+	size_t rbuf_size;
+	/** Position of the next byte to parse in the read buffer. */
+	size_t rbuf_pos;
+	/** Decompressed rows of the last read block. */
+	char *block;
+	/** Size of the decompressed rows. */
+	size_t block_size;
+	/** Position of the next row to read from the block. */
+	size_t block_pos;
+	/** Allocated size of the block buffer. */
+	size_t block_capacity;
 };
 
 void
@@ -282,6 +312,13 @@ xlog_cursor_open(struct xlog_cursor *i, struct xlog *l);
 void
 xlog_cursor_close(struct xlog_cursor *i);
 
+/**
+ * Read the next row. The row refers to the memory of the
+ * cursor and is valid until the next call.
+ *
+ * @retval 0 success
+ * @retval 1 EOF
+ */
 int
 xlog_cursor_next(struct xlog_cursor *i, struct xrow_header *packet);
 
@@ -302,6 +339,49 @@ format_filename(struct xdir *dir, int64_t signature, enum log_suffix suffix);
 int
 xlog_encode_row(const struct xrow_header *packet, struct iovec *iov);
 
+/**
+ * Compression of log rows. Compressed rows are written in
+ * blocks: a fixed header followed by a number of ordinary
+ * rows, compressed as a whole. xlog_cursor_next() reads files
+ * with both plain rows and blocks.
+ */
+enum xlog_compression {
+	XLOG_COMPRESSION_NONE = 0,
+	XLOG_COMPRESSION_LZ4,
+	XLOG_COMPRESSION_ZSTD,
+	XLOG_COMPRESSION_MAX
+};
+
+/** String constants for the supported compression methods. */
+extern const char *xlog_compression_STRS[];
+
+enum {
+	/**
+	 * marker + compressed len + rows len + compression +
+	 * crc32 of compressed data + (padding)
+	 */
+	XLOG_BLOCK_HEADER_SIZE = 24
+};
+
+/**
+ * The max size of a block with @a size bytes of rows.
+ */
+size_t
+xlog_block_bound(enum xlog_compression compression, size_t size);
+
+/**
+ * Compress @a size bytes of encoded rows into a block.
+ * @a capacity of @a buf must be at least xlog_block_bound().
+ *
+ * @retval >0 size of the block in @a buf
+ * @retval 0 compression doesn't pay off, the rows should
+ *           be written as is
+ * @retval -1 error, diag is set
+ */
+ssize_t
+xlog_encode_block(enum xlog_compression compression, const char *rows,
+		  size_t size, char *buf, size_t capacity);
+
 /** }}} */
 
 #if defined(__cplusplus)
@@ -198,17 +198,14 @@ cpipe_flush_cb(ev_loop *loop, struct ev_async *watcher, int events)
 	if (pipe->n_input == 0)
 		return;
 
-	/* Trigger task processing when the queue becomes non-empty. */
-	bool pipe_was_empty;
-
-	tt_pthread_mutex_lock(&pool->mutex);
-	pipe_was_empty = stailq_empty(&pool->pipe);
-	/** Flush input */
-	stailq_concat(&pool->pipe, &pipe->input);
-	tt_pthread_mutex_unlock(&pool->mutex);
-
+	/*
+	 * Flush input. The consumer is woken up only if it hasn't
+	 * been already: while it is busy, more and more messages
+	 * pile up in the pipe and are fetched in one go.
+	 */
+	bool wakeup = fiber_pool_push(pool, &pipe->input);
 	pipe->n_input = 0;
-	if (pipe_was_empty) {
+	if (wakeup) {
 		/* Count statistics */
 		rmean_collect(pipe->bus->stats, CBUS_STAT_EVENTS, 1);
 
@@ -109,7 +109,7 @@ struct cpipe {
 	/**
 	 * When pushing messages, keep the staged input size under
 	 * this limit (speeds up message delivery and reduces
-	 * latency, while still keeping the bus mutex cold enough).
+	 * latency, while still keeping the consumer wakeups rare).
 	 */
 	int max_input;
 	/**
@@ -141,7 +141,7 @@ cpipe_create(struct cpipe *pipe);
  * Otherwise, the messages flushed once per event loop iteration.
  *
  * @todo: collect bus stats per second and adjust max_input once
- * a second to keep the mutex cold regardless of the message load,
+ * a second to keep the wakeups rare regardless of the message load,
  * while still keeping the latency low if there are few
  * long-to-process messages.
  */
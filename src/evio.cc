@@ -238,6 +238,13 @@ evio_service_bind_addr(struct evio_service *service)
 	auto fd_guard = make_scoped_guard([=]{ close(fd); });
 
 	evio_setsockopt_server(fd, service->addr.sa_family, SOCK_STREAM);
+#if defined(SO_REUSEPORT)
+	if (service->reuse_port && service->addr.sa_family != AF_UNIX) {
+		int on = 1;
+		sio_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT,
+			       &on, sizeof(on));
+	}
+#endif
 
 	if (sio_bind(fd, &service->addr, service->addr_len)) {
 		assert(errno == EADDRINUSE);
@@ -251,6 +258,13 @@ evio_service_bind_addr(struct evio_service *service)
 		return -1;
 	}
 
+	if (service->addr.sa_family != AF_UNIX) {
+		/* Get the port chosen by the system, if any. */
+		socklen_t addr_len = sizeof(service->addrstorage);
+		if (getsockname(fd, &service->addr, &addr_len) == 0)
+			service->addr_len = addr_len;
+	}
+
 	say_info("%s: bound to %s", evio_service_name(service),
 		 sio_strfaddr(&service->addr, service->addr_len));
 
@@ -82,6 +82,13 @@ struct evio_service
 	 */
 	void (*on_bind)(void *);
 	void *on_bind_param;
+	/**
+	 * Set SO_REUSEPORT on the listening socket, so that
+	 * several services can listen on the same port and
+	 * the kernel balances connections among them.
+	 * Ignored for UNIX sockets and where unsupported.
+	 */
+	bool reuse_port;
 	/**
 	 * A callback invoked on every accepted client socket.
 	 * It's OK to throw an exception in the callback:
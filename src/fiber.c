@@ -635,14 +635,96 @@ fiber_destroy_all(struct cord *cord)
 
 /* {{{ fiber_pool */
 
-static void
-fiber_pool_fetch_output(struct fiber_pool *pool)
+enum {
+	/**
+	 * How many times the consumer re-reads the pipe when
+	 * it finds a producer in the middle of linking its
+	 * batch, before giving up and waiting for a wakeup.
+	 */
+	FIBER_POOL_FETCH_SPIN = 64,
+};
+
+static inline void
+fiber_pool_pipe_link(struct fiber_pool *pool, struct stailq_entry *first,
+		     struct stailq_entry *last)
 {
-	tt_pthread_mutex_lock(&pool->mutex);
-	stailq_concat(&pool->output, &pool->pipe);
-	tt_pthread_mutex_unlock(&pool->mutex);
+	pm_atomic_store_explicit(&last->next, NULL, pm_memory_order_relaxed);
+	struct stailq_entry *prev =
+		pm_atomic_exchange(&pool->pipe_tail, last);
+	/*
+	 * Until this store the batch is invisible to the
+	 * consumer, which stops at prev.
+	 */
+	pm_atomic_store(&prev->next, first);
 }
 
+bool
+fiber_pool_push(struct fiber_pool *pool, struct stailq *input)
+{
+	if (stailq_empty(input))
+		return false;
+	fiber_pool_pipe_link(pool, stailq_first(input), stailq_last(input));
+	stailq_create(input);
+	return pm_atomic_exchange(&pool->wakeup_pending, 1) == 0;
+}
+
+/**
+ * Wait a bit for a producer which has swapped the pipe tail
+ * but not yet linked its batch to the entry.
+ */
+static inline struct stailq_entry *
+fiber_pool_pipe_next(struct stailq_entry *entry)
+{
+	struct stailq_entry *next;
+	int spin = FIBER_POOL_FETCH_SPIN;
+	while ((next = pm_atomic_load(&entry->next)) == NULL && --spin > 0)
+		__asm__ __volatile__("" ::: "memory");
+	return next;
+}
+
+bool
+fiber_pool_fetch_output(struct fiber_pool *pool)
+{
+	struct stailq_entry *stub = &pool->pipe_stub;
+	struct stailq_entry *head = pool->pipe_head;
+	struct stailq_entry *next = pm_atomic_load(&head->next);
+	bool fetched = false;
+	if (head == stub) {
+		if (next == NULL)
+			return false;
+		head = next;
+		next = pm_atomic_load(&head->next);
+	}
+	for (;;) {
+		while (next != NULL) {
+			if (head != stub) {
+				stailq_add_tail(&pool->output, head);
+				fetched = true;
+			}
+			head = next;
+			next = pm_atomic_load(&head->next);
+		}
+		if (head == stub)
+			break;
+		/*
+		 * The head may be the last entry in the pipe, but it
+		 * can't be moved to the output while producers may
+		 * still link to it: put the stub behind it first.
+		 */
+		if (head == pm_atomic_load(&pool->pipe_tail))
+			fiber_pool_pipe_link(pool, stub, stub);
+		next = fiber_pool_pipe_next(head);
+		if (next == NULL) {
+			/*
+			 * A producer is still linking its batch,
+			 * it will wake the consumer up once it's done.
+			 */
+			break;
+		}
+	}
+	pool->pipe_head = head;
+	return fetched;
+}
 
 static void
 fiber_pool_idle_cb(ev_loop *loop, struct ev_timer *watcher, int events)
@@ -669,6 +751,12 @@ fiber_pool_cb(ev_loop *loop, struct ev_async *watcher, int events)
 	(void) loop;
 	(void) events;
 	struct fiber_pool *pool = (struct fiber_pool *) watcher->data;
+	/*
+	 * Clear the flag before looking at the pipe: producers
+	 * which see it set are guaranteed their messages are
+	 * fetched below.
+	 */
+	pm_atomic_exchange(&pool->wakeup_pending, 0);
 	fiber_pool_fetch_output(pool);
 
 	struct stailq *output = &pool->output;
@@ -703,7 +791,7 @@ fiber_pool_destroy(struct fiber_pool *pool)
 	 * and fibers are freed at once when thread runtime
 	 * pool is destroyed.
          */
-	(void) tt_pthread_mutex_destroy(&pool->mutex);
+	(void) pool;
 }
 
 void
@@ -721,12 +809,13 @@ fiber_pool_create(struct fiber_pool *pool, int max_pool_size,
 	pool->size = 0;
 	pool->max_size = max_pool_size;
 	stailq_create(&pool->output);
-	stailq_create(&pool->pipe);
+	pool->pipe_stub.next = NULL;
+	pool->pipe_head = &pool->pipe_stub;
+	pool->pipe_tail = &pool->pipe_stub;
+	pool->wakeup_pending = 0;
 	ev_async_init(&pool->fetch_output, fiber_pool_cb);
 	pool->fetch_output.data = pool;
 	ev_async_start(pool->consumer, &pool->fetch_output);
-
-	(void) tt_pthread_mutex_init(&pool->mutex, NULL);
 }
 
 /* }}} */
@@ -305,6 +305,16 @@ struct fiber_pool {
 		/** Staged messages (for fibers to work on) */
 		struct stailq output;
 		struct ev_timer idle_timer;
+		/**
+		 * The head of the pipe, only the consumer
+		 * reads the pipe.
+		 */
+		struct stailq_entry *pipe_head;
+		/**
+		 * A dummy pipe entry, so that the pipe is never
+		 * empty and producers never touch pipe_head.
+		 */
+		struct stailq_entry pipe_stub;
 	} __attribute__((aligned(CACHELINE_SIZE)));
 	struct {
 
@@ -315,10 +325,23 @@ struct fiber_pool {
 		 * the pipe becomes non-empty.
 		 */
 		struct ev_async fetch_output;
-		/** The lock around the pipe. */
-		pthread_mutex_t mutex;
-		/** The pipe with incoming messages. */
-		struct stailq pipe;
+		/**
+		 * The tail of the pipe with incoming messages.
+		 * The pipe is a lock-free multi-producer single
+		 * consumer queue: a producer swaps the tail with
+		 * the last message of its batch, then links the
+		 * batch to the previous tail.
+		 */
+		struct stailq_entry *pipe_tail;
+		/**
+		 * Set by the producer which wakes the consumer up,
+		 * cleared by the consumer right before it fetches
+		 * the pipe. While it is set, the consumer is bound
+		 * to look at the pipe again, so other producers
+		 * don't send wakeups: the busier the consumer is,
+		 * the bigger batches it fetches per wakeup.
+		 */
+		int wakeup_pending;
 	} __attribute__((aligned(CACHELINE_SIZE)));
 	fiber_func f;
 };
@@ -332,6 +355,23 @@ void
 fiber_pool_create(struct fiber_pool *pool, int max_pool_size,
 		  float idle_timeout, fiber_func f);
 
+/**
+ * Append a batch of messages to the pool pipe and wake the
+ * consumer up unless a wakeup is already pending. Can be
+ * called from any thread, never blocks. Returns true if
+ * the consumer was woken up.
+ */
+bool
+fiber_pool_push(struct fiber_pool *pool, struct stailq *input);
+
+/**
+ * Move all messages which have been pushed to the pool pipe
+ * so far to the pool output. Must be called by the consumer.
+ * Returns true if anything was fetched.
+ */
+bool
+fiber_pool_fetch_output(struct fiber_pool *pool);
+
 struct cord_on_exit;
 
 /**
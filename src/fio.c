@@ -32,6 +32,7 @@
 
 #include <sys/types.h>
 
+#include <fcntl.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
@@ -90,6 +91,30 @@ fio_read(int fd, void *buf, size_t count)
 	return count - to_read;
 }
 
+ssize_t
+fio_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	ssize_t to_read = (size_t) count;
+	while (to_read > 0) {
+		ssize_t nrd = pread(fd, buf, to_read, offset);
+		if (nrd < 0) {
+			if (errno == EINTR) {
+				errno = 0;
+				continue;
+			}
+			say_syserror("pread, [%s]", fio_filename(fd));
+			return -1;
+		}
+		if (nrd == 0)
+			break;
+
+		buf += nrd;
+		offset += nrd;
+		to_read -= nrd;
+	}
+	return count - to_read;
+}
+
 ssize_t
 fio_write(int fd, const void *buf, size_t count)
 {
@@ -161,6 +186,20 @@ fio_truncate(int fd, off_t offset)
 	return rc;
 }
 
+int
+fio_prealloc(int fd, off_t offset, off_t len)
+{
+#if defined(HAVE_FALLOCATE) && defined(FALLOC_FL_KEEP_SIZE)
+	return fallocate(fd, FALLOC_FL_KEEP_SIZE, offset, len);
+#else
+	(void) fd;
+	(void) offset;
+	(void) len;
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
+
 
 struct fio_batch *
 fio_batch_new(void)
@@ -80,6 +80,22 @@ struct iovec;
 ssize_t
 fio_read(int fd, void *buf, size_t count);
 
+/**
+ * Read up to count bytes at the given offset, re-trying for
+ * partial reads, like fio_read(). Doesn't change the file
+ * offset.
+ *
+ * @param fd		file descriptor.
+ * @param buf		pointer to the buffer.
+ * @param count		how many bytes to read.
+ * @param offset	file offset to read at.
+ *
+ * @return the total number of bytes read, which is less than
+ *         count only if EOF is reached, or -1 if error.
+ */
+ssize_t
+fio_pread(int fd, void *buf, size_t count, off_t offset);
+
 /**
  * Write the given buffer, re-trying for partial writes
  * (when interrupted by a signal, for instance). In case
@@ -150,6 +166,18 @@ fio_lseek(int fd, off_t offset, int whence);
 int
 fio_truncate(int fd, off_t offset);
 
+/**
+ * Allocate disk space for @a len bytes of the file starting at
+ * @a offset, without changing the file size, so that writes
+ * to this range don't need to allocate blocks.
+ *
+ * @return 0 on success, -1 on error. errno is ENOTSUP
+ *         (or EOPNOTSUPP) if not supported by the system or
+ *         the file system.
+ */
+int
+fio_prealloc(int fd, off_t offset, off_t len);
+
 /**
  * A helper wrapper around writev() to do batched
  * writes.
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "histogram.h"
+
+#include <string.h>
+
+void
+histogram_create(struct histogram *hist)
+{
+	memset(hist, 0, sizeof(*hist));
+}
+
+static inline int
+histogram_bucket(int64_t value)
+{
+	if (value <= 0)
+		return 0;
+	int bucket = 64 - __builtin_clzll((uint64_t) value);
+	return bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1;
+}
+
+void
+histogram_collect(struct histogram *hist, int64_t value)
+{
+	if (value < 0)
+		value = 0;
+	hist->buckets[histogram_bucket(value)]++;
+	hist->count++;
+	hist->sum += value;
+	if (value > hist->max)
+		hist->max = value;
+}
+
+void
+histogram_merge(struct histogram *dst, const struct histogram *src)
+{
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+		dst->buckets[i] += src->buckets[i];
+	dst->count += src->count;
+	dst->sum += src->sum;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}
+
+int64_t
+histogram_bucket_max(int bucket)
+{
+	if (bucket >= HISTOGRAM_BUCKETS - 1)
+		return INT64_MAX;
+	return ((int64_t) 1 << bucket) - 1;
+}
+
+int64_t
+histogram_percentile(const struct histogram *hist, int pct)
+{
+	int64_t count = hist->count;
+	if (count == 0)
+		return 0;
+	/* The rank of the value, rounded up. */
+	int64_t rank = (count * pct + 99) / 100;
+	int64_t seen = 0;
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		seen += hist->buckets[i];
+		if (seen >= rank) {
+			int64_t bound = histogram_bucket_max(i);
+			return bound < hist->max ? bound : hist->max;
+		}
+	}
+	return hist->max;
+}
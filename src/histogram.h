@@ -0,0 +1,86 @@
+#ifndef TARANTOOL_HISTOGRAM_H_INCLUDED
+#define TARANTOOL_HISTOGRAM_H_INCLUDED
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+enum { HISTOGRAM_BUCKETS = 48 };
+
+/**
+ * A histogram of non-negative integer values with
+ * power-of-two buckets: bucket 0 counts zeros, bucket i > 0
+ * counts values in range [2^(i-1), 2^i - 1], the last bucket
+ * also counts everything above it. Updated by one thread,
+ * may be read (approximately) by another one.
+ */
+struct histogram {
+	/** Number of collected values. */
+	int64_t count;
+	/** Sum of collected values. */
+	int64_t sum;
+	/** The max collected value. */
+	int64_t max;
+	int64_t buckets[HISTOGRAM_BUCKETS];
+};
+
+void
+histogram_create(struct histogram *hist);
+
+void
+histogram_collect(struct histogram *hist, int64_t value);
+
+/**
+ * Add the values collected by @a src to @a dst, e.g. to sum
+ * up histograms updated by different threads.
+ */
+void
+histogram_merge(struct histogram *dst, const struct histogram *src);
+
+/** The max value counted by the given bucket. */
+int64_t
+histogram_bucket_max(int bucket);
+
+/**
+ * Return the upper bound of values not greater than which
+ * are @a pct percents of the collected values.
+ */
+int64_t
+histogram_percentile(const struct histogram *hist, int pct);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_HISTOGRAM_H_INCLUDED */
@@ -59,6 +59,32 @@ static unsigned iobuf_max_size()
 	return 18 * iobuf_readahead;
 }
 
+/**
+ * A client connection starts with a small input buffer, so that
+ * idle connections don't pin much memory. The size fits
+ * a minimal slab, like the default readahead does.
+ */
+enum { IOBUF_READAHEAD_MIN = 4032 };
+
+/**
+ * The input buffer of a connection grows up to this many times
+ * the readahead. Stay below iobuf_max_size(), so that a grown
+ * buffer isn't shrunk on every reset.
+ */
+enum { IOBUF_READAHEAD_GROW_MAX = 16 };
+
+size_t
+iobuf_readahead_min()
+{
+	return MIN((unsigned) IOBUF_READAHEAD_MIN, iobuf_readahead);
+}
+
+size_t
+iobuf_readahead_max()
+{
+	return IOBUF_READAHEAD_GROW_MAX * iobuf_readahead;
+}
+
 /** Create an instance of input/output buffer or take one from cache. */
 struct iobuf *
 iobuf_new()
@@ -74,6 +100,8 @@ iobuf_new_mt(struct slab_cache *slabc_out)
 	/* Note: do not allocate memory upfront. */
 	ibuf_create(&iobuf->in, &cord()->slabc, iobuf_readahead);
 	obuf_create(&iobuf->out, slabc_out, iobuf_readahead);
+	stailq_create(&iobuf->refs);
+	iobuf->ref_written = 0;
 	return iobuf;
 }
 
@@ -93,6 +121,7 @@ iobuf_delete_mt(struct iobuf *iobuf)
 	ibuf_destroy(&iobuf->in);
 	/* Destroyed by the caller. */
 	assert(iobuf->out.pos == 0 && iobuf->out.iov[0].iov_base == NULL);
+	assert(stailq_empty(&iobuf->refs));
 	mempool_free(&iobuf_pool, iobuf);
 }
 
@@ -128,23 +157,46 @@ iobuf_reset_mt(struct iobuf *iobuf)
 	 * move the pos to the start of the input buffer.
 	 */
 	if (ibuf_used(&iobuf->in) == 0) {
-		if (ibuf_capacity(&iobuf->in) < iobuf_max_size()) {
+		size_t capacity = ibuf_capacity(&iobuf->in);
+		/*
+		 * Drop the buffer if it's smaller than the
+		 * readahead, see iobuf_set_readahead_mt(), or
+		 * too big.
+		 */
+		if (capacity >= iobuf->in.start_capacity &&
+		    capacity < iobuf_max_size()) {
 			ibuf_reset(&iobuf->in);
 		} else {
-			struct slab_cache *slabc = iobuf->in.slabc;
-			ibuf_destroy(&iobuf->in);
-			ibuf_create(&iobuf->in, slabc, iobuf_readahead);
+			/* Keeps the start capacity. */
+			ibuf_reinit(&iobuf->in);
 		}
 	}
 	/*
 	 * We can't re-create the output buffer in iproto thread,
-	 * since obuf->slabc is from tx thread.
-	 * FIXME: send a message to tx thread to garbage-collect
-	 * the buffer when it's too big.
+	 * since obuf->slabc is from tx thread. It's released by
+	 * tx when the connection is idle, see iobuf_release_out().
 	 */
 	obuf_reset(&iobuf->out);
 }
 
+void
+iobuf_release_in(struct iobuf *iobuf)
+{
+	assert(ibuf_used(&iobuf->in) == 0);
+	ibuf_reinit(&iobuf->in);
+}
+
+void
+iobuf_release_out(struct iobuf *iobuf)
+{
+	assert(obuf_used(&iobuf->out) == 0);
+	assert(stailq_empty(&iobuf->refs));
+	struct slab_cache *slabc = iobuf->out.slabc;
+	size_t start_capacity = iobuf->out.start_capacity;
+	obuf_destroy(&iobuf->out);
+	obuf_create(&iobuf->out, slabc, start_capacity);
+}
+
 void
 iobuf_init()
 {
@@ -34,6 +34,20 @@
 #include <stdbool.h>
 #include "small/ibuf.h"
 #include "small/obuf.h"
+#include "salad/stailq.h"
+
+/**
+ * A piece of data written to the client in place rather than
+ * copied to the output buffer. It goes after the output buffer
+ * data preceding @a svp.
+ */
+struct iobuf_ref
+{
+	struct stailq_entry in_iobuf;
+	struct obuf_svp svp;
+	const char *data;
+	size_t size;
+};
 
 struct iobuf
 {
@@ -41,6 +55,14 @@ struct iobuf
 	struct ibuf in;
 	/** Output buffer. */
 	struct obuf out;
+	/**
+	 * Data written in between the output buffer data,
+	 * ordered by position. Owned by the cord which writes
+	 * the output.
+	 */
+	struct stailq refs;
+	/** How much of the first ref is already written. */
+	size_t ref_written;
 };
 
 /**
@@ -103,4 +125,41 @@ iobuf_init();
 void
 iobuf_set_readahead(int readahead);
 
+/**
+ * The input buffer size a client connection starts with,
+ * see iobuf_set_readahead_mt().
+ */
+size_t
+iobuf_readahead_min();
+
+/** The max input buffer size a client connection grows to. */
+size_t
+iobuf_readahead_max();
+
+/**
+ * Set the size of the input buffer to allocate next time it
+ * is needed. A smaller buffer in use is dropped the next time
+ * it is reset.
+ */
+static inline void
+iobuf_set_readahead_mt(struct iobuf *iobuf, size_t readahead)
+{
+	iobuf->in.start_capacity = readahead;
+}
+
+/**
+ * Give the memory of an idle input buffer back to the slab
+ * cache, see iobuf_release_out().
+ */
+void
+iobuf_release_in(struct iobuf *iobuf);
+
+/**
+ * Give the memory of an idle output buffer back to the slab
+ * cache. Must be called in the cord the output memory comes
+ * from.
+ */
+void
+iobuf_release_out(struct iobuf *iobuf);
+
 #endif /* TARANTOOL_IOBUF_H_INCLUDED */
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "bloom.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** The header of a stored filter, followed by the table. */
+struct bloom_store_header {
+	uint32_t bit_count;
+	uint32_t hash_count;
+};
+
+int
+bloom_create(struct bloom *bloom, uint32_t count, uint32_t bits_per_value)
+{
+	uint64_t bit_count = (uint64_t) count * bits_per_value;
+	if (bit_count < 64)
+		bit_count = 64;
+	bit_count = (bit_count + 63) / 64 * 64;
+	if (bit_count > UINT32_MAX - 63)
+		bit_count = (uint64_t) UINT32_MAX / 64 * 64;
+	/* ln(2) * bits per value minimizes false positives. */
+	uint32_t hash_count = (bits_per_value * 69 + 50) / 100;
+	if (hash_count < 1)
+		hash_count = 1;
+	if (hash_count > 30)
+		hash_count = 30;
+	bloom->table = (uint64_t *) calloc(bit_count / 64, sizeof(uint64_t));
+	if (bloom->table == NULL)
+		return -1;
+	bloom->bit_count = bit_count;
+	bloom->hash_count = hash_count;
+	return 0;
+}
+
+void
+bloom_destroy(struct bloom *bloom)
+{
+	free(bloom->table);
+	bloom->table = NULL;
+}
+
+size_t
+bloom_store_size(const struct bloom *bloom)
+{
+	return sizeof(struct bloom_store_header) + bloom->bit_count / 8;
+}
+
+char *
+bloom_store(const struct bloom *bloom, char *buf)
+{
+	struct bloom_store_header header;
+	header.bit_count = bloom->bit_count;
+	header.hash_count = bloom->hash_count;
+	memcpy(buf, &header, sizeof(header));
+	buf += sizeof(header);
+	memcpy(buf, bloom->table, bloom->bit_count / 8);
+	return buf + bloom->bit_count / 8;
+}
+
+int
+bloom_load(struct bloom *bloom, const char *buf, size_t size)
+{
+	struct bloom_store_header header;
+	if (size < sizeof(header))
+		return -1;
+	memcpy(&header, buf, sizeof(header));
+	if (header.bit_count == 0 || header.bit_count % 64 != 0 ||
+	    header.hash_count == 0 ||
+	    size != sizeof(header) + header.bit_count / 8)
+		return -1;
+	bloom->table = (uint64_t *) malloc(header.bit_count / 8);
+	if (bloom->table == NULL)
+		return -1;
+	memcpy(bloom->table, buf + sizeof(header), header.bit_count / 8);
+	bloom->bit_count = header.bit_count;
+	bloom->hash_count = header.hash_count;
+	return 0;
+}
@@ -0,0 +1,133 @@
+#ifndef TARANTOOL_LIB_SALAD_BLOOM_H_INCLUDED
+#define TARANTOOL_LIB_SALAD_BLOOM_H_INCLUDED
+
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * A bloom filter: a set of 32-bit hashes of values, which may
+ * answer "maybe" for a value which is not in the set, but never
+ * answers "no" for a value which is. With 10 bits per value
+ * the false positive rate is about 1%.
+ *
+ * A value sets hash_count bits, which are derived from a single
+ * hash by double hashing, so the hash must be good in all of
+ * its bits.
+ */
+struct bloom {
+	/** The number of bits in the table, a multiple of 64. */
+	uint32_t bit_count;
+	/** The number of bits set by a value. */
+	uint32_t hash_count;
+	uint64_t *table;
+};
+
+/**
+ * Create an empty filter for @a count values with
+ * @a bits_per_value bits of the table per value.
+ * @retval  0 success
+ * @retval -1 out of memory
+ */
+int
+bloom_create(struct bloom *bloom, uint32_t count, uint32_t bits_per_value);
+
+void
+bloom_destroy(struct bloom *bloom);
+
+/** The step of double hashing, see bloom_add(). */
+static inline uint32_t
+bloom_delta(uint32_t hash)
+{
+	return (hash >> 17) | (hash << 15);
+}
+
+static inline void
+bloom_add(struct bloom *bloom, uint32_t hash)
+{
+	uint32_t delta = bloom_delta(hash);
+	for (uint32_t i = 0; i < bloom->hash_count; i++) {
+		uint32_t bit = hash % bloom->bit_count;
+		bloom->table[bit / 64] |= (uint64_t) 1 << (bit % 64);
+		hash += delta;
+	}
+}
+
+/**
+ * Check if a value with the given hash may be in the set.
+ * false means it is definitely not.
+ */
+static inline bool
+bloom_maybe_has(const struct bloom *bloom, uint32_t hash)
+{
+	uint32_t delta = bloom_delta(hash);
+	for (uint32_t i = 0; i < bloom->hash_count; i++) {
+		uint32_t bit = hash % bloom->bit_count;
+		uint64_t mask = (uint64_t) 1 << (bit % 64);
+		if ((bloom->table[bit / 64] & mask) == 0)
+			return false;
+		hash += delta;
+	}
+	return true;
+}
+
+/** The size of the filter written by bloom_store(). */
+size_t
+bloom_store_size(const struct bloom *bloom);
+
+/**
+ * Write the filter to @a buf, which must have at least
+ * bloom_store_size() bytes.
+ * @return the end of the written data
+ */
+char *
+bloom_store(const struct bloom *bloom, char *buf);
+
+/**
+ * Create a filter from the data written by bloom_store().
+ * @retval  0 success
+ * @retval -1 out of memory, or the data is malformed
+ */
+int
+bloom_load(struct bloom *bloom, const char *buf, size_t size);
+
+#if defined(__cplusplus)
+} /* extern C */
+#endif
+
+#endif /* TARANTOOL_LIB_SALAD_BLOOM_H_INCLUDED */
@@ -157,6 +157,13 @@
  * bool bps_tree_itr_prev(tree, itr);
  * void bps_tree_itr_freeze(tree, itr);
  * void bps_tree_itr_destroy(tree, itr);
+ * // read views:
+ * void bps_tree_view_create(tree, view);
+ * void bps_tree_view_destroy(tree, view);
+ * struct bps_tree_iterator bps_tree_view_itr_first(tree, view);
+ * struct bps_tree_iterator bps_tree_view_itr_last(tree, view);
+ * struct bps_tree_iterator bps_tree_view_lower_bound(tree, view, key, exact);
+ * struct bps_tree_iterator bps_tree_view_upper_bound(tree, view, key, exact);
  */
 /* }}} */
 
@@ -357,6 +364,13 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_itr_prev _bps_tree(itr_prev)
 #define bps_tree_itr_freeze _bps_tree(itr_freeze)
 #define bps_tree_itr_destroy _bps_tree(itr_destroy)
+#define bps_tree_view _bps_tree(view)
+#define bps_tree_view_create _bps_tree(view_create)
+#define bps_tree_view_destroy _bps_tree(view_destroy)
+#define bps_tree_view_itr_first _bps_tree(view_itr_first)
+#define bps_tree_view_itr_last _bps_tree(view_itr_last)
+#define bps_tree_view_lower_bound _bps_tree(view_lower_bound)
+#define bps_tree_view_upper_bound _bps_tree(view_upper_bound)
 #define bps_tree_debug_check _bps_tree(debug_check)
 #define bps_tree_print _bps_tree(print)
 #define bps_tree_debug_check_internal_functions \
@@ -529,6 +543,26 @@ struct bps_tree_iterator {
 	struct matras_view view;
 };
 
+/**
+ * Tree read view. Keeps the tree as it was at the moment of the
+ * view creation, all following tree modifications are not visible
+ * in the view. Lookups in the view may be done in another thread
+ * concurrently with the tree modifications, but the view must be
+ * created and destroyed in the thread that modifies the tree.
+ */
+struct bps_tree_view {
+	/* Root, first and last block IDs and the depth of the tree */
+	bps_tree_block_id_t root_id, first_id, last_id;
+	bps_tree_block_id_t depth;
+	/* Version of matras memory, registered in the matras */
+	struct matras_view view;
+	/*
+	 * A copy of the version for iterators, which is never
+	 * changed after creation, unlike the registered one.
+	 */
+	struct matras_view itr_view;
+};
+
 /**
  * Pointer to function that allocates extent of size BPS_TREE_EXTENT_SIZE
  * BPS-tree properly handles with NULL result but could leak memory
@@ -761,6 +795,60 @@ bps_tree_itr_freeze(struct bps_tree *tree, struct bps_tree_iterator *itr);
 void
 bps_tree_itr_destroy(struct bps_tree *tree, struct bps_tree_iterator *itr);
 
+/**
+ * @brief Create a read view of the tree. The view should be destroyed
+ * with a bps_tree_view_destroy call after usage.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view to fill
+ */
+void
+bps_tree_view_create(struct bps_tree *tree, struct bps_tree_view *view);
+
+/**
+ * @brief Destroy a read view. Iterators created in the view must not
+ * be used after that.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ */
+void
+bps_tree_view_destroy(struct bps_tree *tree, struct bps_tree_view *view);
+
+/**
+ * @brief Get an iterator to the first element of the tree in a view.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ * @return - First iterator. Could be invalid if the tree was empty.
+ */
+struct bps_tree_iterator
+bps_tree_view_itr_first(const struct bps_tree *tree,
+			const struct bps_tree_view *view);
+
+/**
+ * @brief Get an iterator to the last element of the tree in a view.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ * @return - Last iterator. Could be invalid if the tree was empty.
+ */
+struct bps_tree_iterator
+bps_tree_view_itr_last(const struct bps_tree *tree,
+		       const struct bps_tree_view *view);
+
+/**
+ * @brief Same as bps_tree_lower_bound, but in a read view.
+ */
+struct bps_tree_iterator
+bps_tree_view_lower_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key, bool *exact);
+
+/**
+ * @brief Same as bps_tree_upper_bound, but in a read view.
+ */
+struct bps_tree_iterator
+bps_tree_view_upper_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key, bool *exact);
+
 /**
  * @brief Debug self-checking. Returns bitmask of found errors (0
  * on success).
@@ -1738,6 +1826,169 @@ bps_tree_itr_destroy(struct bps_tree *tree, struct bps_tree_iterator *itr)
 	matras_destroy_read_view(&tree->matras, &itr->view);
 }
 
+/**
+ * @brief Create a read view of the tree. The view should be destroyed
+ * with a bps_tree_view_destroy call after usage.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view to fill
+ */
+inline void
+bps_tree_view_create(struct bps_tree *tree, struct bps_tree_view *view)
+{
+	view->root_id = tree->root_id;
+	view->first_id = tree->first_id;
+	view->last_id = tree->last_id;
+	view->depth = tree->depth;
+	matras_create_read_view(&tree->matras, &view->view);
+	view->itr_view = view->view;
+}
+
+/**
+ * @brief Destroy a read view. Iterators created in the view must not
+ * be used after that.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ */
+inline void
+bps_tree_view_destroy(struct bps_tree *tree, struct bps_tree_view *view)
+{
+	matras_destroy_read_view(&tree->matras, &view->view);
+}
+
+/**
+ * @brief Get an iterator to the first element of the tree in a view.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ * @return - First iterator. Could be invalid if the tree was empty.
+ */
+inline struct bps_tree_iterator
+bps_tree_view_itr_first(const struct bps_tree *tree,
+			const struct bps_tree_view *view)
+{
+	(void) tree;
+	struct bps_tree_iterator itr;
+	itr.block_id = view->first_id;
+	itr.pos = 0;
+	itr.view = view->itr_view;
+	return itr;
+}
+
+/**
+ * @brief Get an iterator to the last element of the tree in a view.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ * @return - Last iterator. Could be invalid if the tree was empty.
+ */
+inline struct bps_tree_iterator
+bps_tree_view_itr_last(const struct bps_tree *tree,
+		       const struct bps_tree_view *view)
+{
+	(void) tree;
+	struct bps_tree_iterator itr;
+	itr.block_id = view->last_id;
+	itr.pos = (bps_tree_pos_t)(-1);
+	itr.view = view->itr_view;
+	return itr;
+}
+
+/**
+ * @brief Same as bps_tree_lower_bound, but in a read view.
+ */
+inline struct bps_tree_iterator
+bps_tree_view_lower_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key, bool *exact)
+{
+	struct bps_tree_iterator res;
+	res.view = view->itr_view;
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	if (view->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	bps_tree_block_id_t block_id = view->root_id;
+	struct bps_block *block =
+		bps_tree_restore_block_ver(tree, block_id, &res.view);
+	for (bps_tree_block_id_t i = 0; i < view->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_ins_point_key(tree, inner->elems,
+						  inner->header.size - 1,
+						  key, exact);
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block_ver(tree, block_id, &res.view);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_ins_point_key(tree, leaf->elems, leaf->header.size,
+					  key, exact);
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
+/**
+ * @brief Same as bps_tree_upper_bound, but in a read view.
+ */
+inline struct bps_tree_iterator
+bps_tree_view_upper_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key, bool *exact)
+{
+	struct bps_tree_iterator res;
+	res.view = view->itr_view;
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	bool exact_test;
+	if (view->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	bps_tree_block_id_t block_id = view->root_id;
+	struct bps_block *block =
+		bps_tree_restore_block_ver(tree, block_id, &res.view);
+	for (bps_tree_block_id_t i = 0; i < view->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_after_ins_point_key(tree, inner->elems,
+							inner->header.size - 1,
+							key, &exact_test);
+		if (exact_test)
+			*exact = true;
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block_ver(tree, block_id, &res.view);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_after_ins_point_key(tree, leaf->elems,
+						leaf->header.size,
+						key, &exact_test);
+	if (exact_test)
+		*exact = true;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
 /**
  * @brief Find the first element that is equal to the key (comparator returns 0)
  * @param tree - pointer to a tree
@@ -5612,6 +5863,13 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_itr_prev
 #undef bps_tree_itr_freeze
 #undef bps_tree_itr_destroy
+#undef bps_tree_view
+#undef bps_tree_view_create
+#undef bps_tree_view_destroy
+#undef bps_tree_view_itr_first
+#undef bps_tree_view_itr_last
+#undef bps_tree_view_lower_bound
+#undef bps_tree_view_upper_bound
 #undef bps_tree_debug_check
 #undef bps_tree_print
 #undef bps_tree_debug_check_internal_functions
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "psort.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <third_party/qsort_arg.h>
+
+enum {
+	/**
+	 * The least number of elements per thread for which
+	 * the parallel sort makes sense.
+	 */
+	PSORT_MIN_ELEMENTS_PER_THREAD = 8192,
+	/** Sample elements per bucket to pick splitters from. */
+	PSORT_OVERSAMPLING = 64,
+};
+
+/** The state of a parallel sort shared by all threads. */
+struct psort {
+	char *data;
+	size_t n;
+	size_t es;
+	int (*cmp)(const void *a, const void *b, void *arg);
+	void *arg;
+	/** The number of threads, which is also the number of buckets. */
+	int n_threads;
+	/**
+	 * A sorted sample of the array, every PSORT_OVERSAMPLING-th
+	 * element of it separates two adjacent buckets.
+	 */
+	char *sample;
+	/** The bucket of every element of the array. */
+	uint8_t *bucket_of;
+	/** Elements grouped by bucket. */
+	char *buf;
+	/** Offsets of the buckets in buf, n_threads + 1 entries. */
+	size_t *bucket_start;
+	/**
+	 * A n_threads x n_threads matrix: the number of elements
+	 * of a thread's chunk in a bucket, which is turned into
+	 * the offset in buf the thread writes the bucket to.
+	 */
+	size_t *pos;
+	struct psort_thread *threads;
+};
+
+/** A thread running one phase of the sort. */
+struct psort_thread {
+	struct psort *sort;
+	/** The chunk of the array and the bucket of the thread. */
+	int id;
+	void (*phase)(struct psort *sort, int id);
+	pthread_t thread;
+	bool is_started;
+};
+
+static inline char *
+psort_splitter(struct psort *sort, int i)
+{
+	return sort->sample + (size_t) (i + 1) * PSORT_OVERSAMPLING * sort->es;
+}
+
+static inline size_t
+psort_chunk_begin(struct psort *sort, int id)
+{
+	return sort->n / sort->n_threads * id;
+}
+
+static inline size_t
+psort_chunk_end(struct psort *sort, int id)
+{
+	return id == sort->n_threads - 1 ? sort->n :
+	       psort_chunk_begin(sort, id + 1);
+}
+
+/** Pick the splitters from a random sample of the array. */
+static void
+psort_sample(struct psort *sort)
+{
+	size_t sample_size = (size_t) sort->n_threads * PSORT_OVERSAMPLING;
+	/* A xorshift generator, the sort needn't be secure. */
+	uint64_t state = sort->n ^ 0x9e3779b97f4a7c15ULL;
+	for (size_t i = 0; i < sample_size; i++) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		memcpy(sort->sample + i * sort->es,
+		       sort->data + (state % sort->n) * sort->es, sort->es);
+	}
+	qsort_arg(sort->sample, sample_size, sort->es, sort->cmp, sort->arg);
+}
+
+/** Find the bucket of each element of the chunk. */
+static void
+psort_classify(struct psort *sort, int id)
+{
+	size_t *count = sort->pos + (size_t) id * sort->n_threads;
+	memset(count, 0, sort->n_threads * sizeof(*count));
+	size_t end = psort_chunk_end(sort, id);
+	for (size_t i = psort_chunk_begin(sort, id); i < end; i++) {
+		const char *elem = sort->data + i * sort->es;
+		/* The number of splitters <= elem. */
+		int lo = 0, hi = sort->n_threads - 1;
+		while (lo < hi) {
+			int mid = (lo + hi) / 2;
+			if (sort->cmp(elem, psort_splitter(sort, mid),
+				      sort->arg) < 0)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		sort->bucket_of[i] = lo;
+		count[lo]++;
+	}
+}
+
+/** Copy the elements of the chunk to their buckets. */
+static void
+psort_scatter(struct psort *sort, int id)
+{
+	size_t *pos = sort->pos + (size_t) id * sort->n_threads;
+	size_t es = sort->es;
+	size_t end = psort_chunk_end(sort, id);
+	for (size_t i = psort_chunk_begin(sort, id); i < end; i++) {
+		size_t offset = pos[sort->bucket_of[i]]++;
+		memcpy(sort->buf + offset * es, sort->data + i * es, es);
+	}
+}
+
+/** Sort the bucket and put it back to the array. */
+static void
+psort_sort_bucket(struct psort *sort, int id)
+{
+	size_t begin = sort->bucket_start[id];
+	size_t count = sort->bucket_start[id + 1] - begin;
+	char *bucket = sort->buf + begin * sort->es;
+	qsort_arg(bucket, count, sort->es, sort->cmp, sort->arg);
+	memcpy(sort->data + begin * sort->es, bucket, count * sort->es);
+}
+
+static void *
+psort_thread_f(void *arg)
+{
+	struct psort_thread *thread = (struct psort_thread *) arg;
+	thread->phase(thread->sort, thread->id);
+	return NULL;
+}
+
+/**
+ * Run a phase of the sort for every chunk or bucket in
+ * parallel and wait for it to end. The calling thread does
+ * the work of the threads which failed to start.
+ */
+static void
+psort_run(struct psort *sort, void (*phase)(struct psort *sort, int id))
+{
+	for (int i = 1; i < sort->n_threads; i++) {
+		struct psort_thread *thread = &sort->threads[i];
+		thread->sort = sort;
+		thread->id = i;
+		thread->phase = phase;
+		thread->is_started = pthread_create(&thread->thread, NULL,
+						    psort_thread_f,
+						    thread) == 0;
+	}
+	phase(sort, 0);
+	for (int i = 1; i < sort->n_threads; i++) {
+		struct psort_thread *thread = &sort->threads[i];
+		if (thread->is_started)
+			pthread_join(thread->thread, NULL);
+		else
+			phase(sort, i);
+	}
+}
+
+/** Distribute the elements among the buckets and sort them. */
+static void
+psort_do(struct psort *sort)
+{
+	psort_sample(sort);
+	psort_run(sort, psort_classify);
+	/* Turn the counters into the offsets in the buffer. */
+	size_t offset = 0;
+	int n_threads = sort->n_threads;
+	for (int b = 0; b < n_threads; b++) {
+		sort->bucket_start[b] = offset;
+		for (int t = 0; t < n_threads; t++) {
+			size_t *pos = &sort->pos[(size_t) t * n_threads + b];
+			size_t count = *pos;
+			*pos = offset;
+			offset += count;
+		}
+	}
+	assert(offset == sort->n);
+	sort->bucket_start[n_threads] = sort->n;
+	psort_run(sort, psort_scatter);
+	psort_run(sort, psort_sort_bucket);
+}
+
+void
+psort_arg(void *a, size_t n, size_t es,
+	  int (*cmp)(const void *a, const void *b, void *arg), void *arg,
+	  int n_threads)
+{
+	if (n_threads > PSORT_THREADS_MAX)
+		n_threads = PSORT_THREADS_MAX;
+	if ((size_t) n_threads > n / PSORT_MIN_ELEMENTS_PER_THREAD)
+		n_threads = n / PSORT_MIN_ELEMENTS_PER_THREAD;
+	if (n_threads <= 1) {
+		qsort_arg(a, n, es, cmp, arg);
+		return;
+	}
+	/* Like qsort_arg(), don't touch presorted arrays. */
+	char *end = (char *) a + n * es;
+	char *p = (char *) a + es;
+	while (p < end && cmp(p - es, p, arg) <= 0)
+		p += es;
+	if (p == end)
+		return;
+
+	struct psort sort;
+	sort.data = (char *) a;
+	sort.n = n;
+	sort.es = es;
+	sort.cmp = cmp;
+	sort.arg = arg;
+	sort.n_threads = n_threads;
+	sort.sample = (char *) malloc((size_t) n_threads *
+				      PSORT_OVERSAMPLING * es);
+	sort.bucket_of = (uint8_t *) malloc(n);
+	sort.buf = (char *) malloc(n * es);
+	sort.bucket_start = (size_t *) malloc((n_threads + 1) *
+					      sizeof(size_t));
+	sort.pos = (size_t *) malloc((size_t) n_threads * n_threads *
+				     sizeof(size_t));
+	sort.threads = (struct psort_thread *) malloc(n_threads *
+					sizeof(struct psort_thread));
+	if (sort.sample == NULL || sort.bucket_of == NULL ||
+	    sort.buf == NULL || sort.bucket_start == NULL ||
+	    sort.pos == NULL || sort.threads == NULL) {
+		qsort_arg(a, n, es, cmp, arg);
+	} else {
+		psort_do(&sort);
+	}
+
+	free(sort.sample);
+	free(sort.bucket_of);
+	free(sort.buf);
+	free(sort.bucket_start);
+	free(sort.pos);
+	free(sort.threads);
+}
@@ -0,0 +1,68 @@
+#ifndef TARANTOOL_LIB_SALAD_PSORT_H_INCLUDED
+#define TARANTOOL_LIB_SALAD_PSORT_H_INCLUDED
+
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+enum {
+	/** The max number of threads psort_arg() can use. */
+	PSORT_THREADS_MAX = 256,
+};
+
+/**
+ * Sort an array of @a n elements of size @a es in @a n_threads
+ * threads, the calling thread included. The interface is the
+ * same as of qsort_arg() which is used when the array is too
+ * small to be worth splitting, @a n_threads is 1 or there is
+ * not enough memory for the sort buffers.
+ *
+ * The sort is a sample sort: elements are distributed among
+ * @a n_threads buckets separated by splitters taken from
+ * a random sample of the array, then every bucket is sorted
+ * in its own thread. It needs n * (es + 1) bytes of extra
+ * memory. The comparator must be thread-safe.
+ */
+void
+psort_arg(void *a, size_t n, size_t es,
+	  int (*cmp)(const void *a, const void *b, void *arg), void *arg,
+	  int n_threads);
+
+#if defined(__cplusplus)
+} /* extern C */
+#endif
+
+#endif /* TARANTOOL_LIB_SALAD_PSORT_H_INCLUDED */
@@ -107,6 +107,9 @@ sio_option_name(int option)
 	CASE_OPTION(SO_LINGER);
 	CASE_OPTION(SO_ERROR);
 	CASE_OPTION(SO_REUSEADDR);
+#ifdef SO_REUSEPORT
+	CASE_OPTION(SO_REUSEPORT);
+#endif
 	CASE_OPTION(TCP_NODELAY);
 #ifdef __linux__
 	CASE_OPTION(TCP_KEEPCNT);
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "uring.h"
+#include "trivia/config.h"
+#include "trivia/util.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#if defined(HAVE_LINUX_IO_URING)
+
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#if !defined(__NR_io_uring_setup)
+#define __NR_io_uring_setup 425
+#endif
+#if !defined(__NR_io_uring_enter)
+#define __NR_io_uring_enter 426
+#endif
+
+static inline void
+uring_unmap(struct uring *ring)
+{
+	if (ring->sq_ring != MAP_FAILED)
+		munmap(ring->sq_ring, ring->sq_ring_size);
+	if (ring->cq_ring != MAP_FAILED)
+		munmap(ring->cq_ring, ring->cq_ring_size);
+	if (ring->sqes != MAP_FAILED)
+		munmap(ring->sqes, ring->sqes_size);
+}
+
+static inline void *
+uring_mmap(int fd, size_t size, off_t offset)
+{
+	return mmap(NULL, size, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_POPULATE, fd, offset);
+}
+
+int
+uring_create(struct uring *ring, unsigned entries)
+{
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (ring->fd < 0)
+		return -1;
+	/*
+	 * Non-blocking sendmsg() works as expected since
+	 * the kernels which never drop completions.
+	 */
+	if (!(p.features & IORING_FEAT_NODROP)) {
+		close(ring->fd);
+		errno = ENOSYS;
+		return -1;
+	}
+	ring->entries = p.sq_entries;
+	ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_ring_size = p.cq_off.cqes +
+		p.cq_entries * sizeof(struct io_uring_cqe);
+	ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sq_ring = uring_mmap(ring->fd, ring->sq_ring_size,
+				   IORING_OFF_SQ_RING);
+	ring->cq_ring = uring_mmap(ring->fd, ring->cq_ring_size,
+				   IORING_OFF_CQ_RING);
+	ring->sqes = uring_mmap(ring->fd, ring->sqes_size, IORING_OFF_SQES);
+	if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED ||
+	    ring->sqes == MAP_FAILED) {
+		int save_errno = errno;
+		uring_unmap(ring);
+		close(ring->fd);
+		errno = save_errno;
+		return -1;
+	}
+	char *sq = (char *) ring->sq_ring;
+	ring->sq_head = (unsigned *) (sq + p.sq_off.head);
+	ring->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+	ring->sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+	ring->sq_array = (unsigned *) (sq + p.sq_off.array);
+	char *cq = (char *) ring->cq_ring;
+	ring->cq_head = (unsigned *) (cq + p.cq_off.head);
+	ring->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+	ring->cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+	ring->cqes = cq + p.cq_off.cqes;
+	return 0;
+}
+
+void
+uring_destroy(struct uring *ring)
+{
+	uring_unmap(ring);
+	close(ring->fd);
+}
+
+/** Collect the results of completed writes. */
+static int
+uring_reap(struct uring *ring, struct uring_write *writes)
+{
+	struct io_uring_cqe *cqes = (struct io_uring_cqe *) ring->cqes;
+	unsigned mask = *ring->cq_mask;
+	unsigned head = *ring->cq_head;
+	unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+	int count = 0;
+	for (; head != tail; head++, count++) {
+		struct io_uring_cqe *cqe = &cqes[head & mask];
+		writes[cqe->user_data].res = cqe->res;
+	}
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+	return count;
+}
+
+int
+uring_writev_batch(struct uring *ring, struct uring_write *writes,
+		   int count)
+{
+	assert(count > 0 && (unsigned) count <= ring->entries);
+	struct io_uring_sqe *sqes = (struct io_uring_sqe *) ring->sqes;
+	unsigned mask = *ring->sq_mask;
+	unsigned tail = *ring->sq_tail;
+	for (int i = 0; i < count; i++) {
+		struct uring_write *w = &writes[i];
+		w->res = -EAGAIN;
+		memset(&w->msg, 0, sizeof(w->msg));
+		w->msg.msg_iov = (struct iovec *) w->iov;
+		w->msg.msg_iovlen = w->iovcnt;
+
+		unsigned idx = (tail + i) & mask;
+		struct io_uring_sqe *sqe = &sqes[idx];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = IORING_OP_SENDMSG;
+		sqe->fd = w->fd;
+		sqe->addr = (uintptr_t) &w->msg;
+		sqe->len = 1;
+		sqe->msg_flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+		sqe->user_data = i;
+		ring->sq_array[idx] = idx;
+	}
+	__atomic_store_n(ring->sq_tail, tail + count, __ATOMIC_RELEASE);
+
+	/*
+	 * The writes are non-blocking, so waiting for all of
+	 * them to complete doesn't block the caller.
+	 */
+	unsigned to_submit = count;
+	int completed = 0;
+	while (completed < count) {
+		int rc = syscall(__NR_io_uring_enter, ring->fd, to_submit,
+				 count - completed, IORING_ENTER_GETEVENTS,
+				 NULL, 0);
+		if (rc >= 0) {
+			to_submit -= rc;
+		} else if (errno != EINTR) {
+			int save_errno = errno;
+			uring_reap(ring, writes);
+			errno = save_errno;
+			return -1;
+		}
+		completed += uring_reap(ring, writes);
+	}
+	return 0;
+}
+
+#else /* !defined(HAVE_LINUX_IO_URING) */
+
+int
+uring_create(struct uring *ring, unsigned entries)
+{
+	(void) ring;
+	(void) entries;
+	errno = ENOSYS;
+	return -1;
+}
+
+void
+uring_destroy(struct uring *ring)
+{
+	(void) ring;
+	unreachable();
+}
+
+int
+uring_writev_batch(struct uring *ring, struct uring_write *writes,
+		   int count)
+{
+	(void) ring;
+	(void) writes;
+	(void) count;
+	unreachable();
+	return -1;
+}
+
+#endif /* defined(HAVE_LINUX_IO_URING) */
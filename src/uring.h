@@ -0,0 +1,122 @@
+#ifndef TARANTOOL_URING_H_INCLUDED
+#define TARANTOOL_URING_H_INCLUDED
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/**
+ * A minimal io_uring wrapper to batch socket writes: all writes
+ * of an event loop iteration are submitted in one system call
+ * instead of one writev() per socket. Available on Linux with
+ * a kernel which supports io_uring, uring_create() fails with
+ * ENOSYS otherwise and the caller is expected to fall back to
+ * writev().
+ */
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct uring {
+	/** The ring file descriptor. */
+	int fd;
+	/** The number of submission queue entries. */
+	unsigned entries;
+	/* Submission queue. */
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	void *sqes;
+	/* Completion queue. */
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	void *cqes;
+	/* Mapped memory of the rings. */
+	void *sq_ring;
+	size_t sq_ring_size;
+	void *cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+};
+
+/** A single write of a batch, see uring_writev_batch(). */
+struct uring_write {
+	/** The socket to write to. */
+	int fd;
+	const struct iovec *iov;
+	int iovcnt;
+	/**
+	 * The result of the write: the number of bytes written
+	 * or -errno, as of writev().
+	 */
+	ssize_t res;
+	/** Used internally. */
+	struct msghdr msg;
+};
+
+/**
+ * Set up a ring which can take up to @a entries writes
+ * in a batch.
+ *
+ * @retval  0 success
+ * @retval -1 error, errno is set, ENOSYS if io_uring is
+ *            not supported
+ */
+int
+uring_create(struct uring *ring, unsigned entries);
+
+void
+uring_destroy(struct uring *ring);
+
+/**
+ * Write @a count iovec arrays to their sockets in a single
+ * system call. Every write is non-blocking, i.e. its result
+ * is -EAGAIN if the socket buffer is full, and never raises
+ * SIGPIPE. @a count must not exceed the ring size.
+ *
+ * @retval  0 success, the results are in writes[i].res
+ * @retval -1 the ring failed, errno is set. The writes which
+ *            were not done have -EAGAIN result. The ring must
+ *            be destroyed.
+ */
+int
+uring_writev_batch(struct uring *ring, struct uring_write *writes,
+		   int count);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_URING_H_INCLUDED */
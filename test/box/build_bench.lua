@@ -0,0 +1,27 @@
+#!/usr/bin/env tarantool
+os = require('os')
+
+-- The number of threads to build secondary keys in
+-- at the end of recovery, see set_build_threads().
+local build_threads = 1
+local f = io.open('build_threads.txt')
+if f ~= nil then
+    build_threads = tonumber(f:read('*l'))
+    f:close()
+end
+
+box.cfg{
+    listen              = os.getenv("LISTEN"),
+    slab_alloc_arena    = 2,
+    pid_file            = "tarantool.pid",
+    memtx_build_threads = build_threads,
+}
+
+-- Used on the next restart of the server.
+function set_build_threads(n)
+    local f = io.open('build_threads.txt', 'w')
+    f:write(tostring(n))
+    f:close()
+end
+
+require('console').listen(os.getenv('ADMIN'))
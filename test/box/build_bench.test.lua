@@ -0,0 +1,83 @@
+env = require('test_run')
+test_run = env.new()
+fiber = require('fiber')
+
+--
+-- Server startup time with secondary keys built in 1, 2, 4
+-- and 8 threads. The timings are written to build_bench.res.
+--
+test_run:cmd("create server build_bench with script='box/build_bench.lua'")
+test_run:cmd("start server build_bench")
+test_run:cmd("switch build_bench")
+n_spaces = 4
+n_tuples = 1000000
+test_run:cmd("setopt delimiter ';'")
+for i = 1, n_spaces do
+    local s = box.schema.space.create('test' .. i)
+    s:create_index('pk')
+    s:create_index('tree_uint', {parts = {2, 'unsigned'}, unique = false})
+    s:create_index('tree_str', {parts = {3, 'string'}, unique = false})
+    s:create_index('hash', {type = 'hash', parts = {4, 'unsigned'}})
+    box.begin()
+    for j = 1, n_tuples do
+        s:insert{j, math.random(n_tuples), tostring(math.random(n_tuples)), j}
+        if j % 1000 == 0 then
+            box.commit()
+            box.begin()
+        end
+    end
+    box.commit()
+end;
+test_run:cmd("setopt delimiter ''");
+box.snapshot()
+test_run:cmd("switch default")
+
+file = io.open("build_bench.res", "w")
+test_run:cmd("setopt delimiter ';'")
+function restart(threads)
+    test_run:cmd("stop server build_bench")
+    local start = fiber.time()
+    test_run:cmd("start server build_bench")
+    file:write(string.format("Startup time with %d build threads: %.3f sec\n",
+                             threads, fiber.time() - start))
+end;
+test_run:cmd("setopt delimiter ''");
+
+test_run:cmd("switch build_bench")
+set_build_threads(1)
+test_run:cmd("switch default")
+restart(1)
+
+test_run:cmd("switch build_bench")
+box.cfg.memtx_build_threads
+box.space.test1.index.hash:count()
+box.space.test4.index.tree_str:count()
+set_build_threads(2)
+test_run:cmd("switch default")
+restart(2)
+
+test_run:cmd("switch build_bench")
+box.cfg.memtx_build_threads
+box.space.test1.index.hash:count()
+box.space.test4.index.tree_str:count()
+set_build_threads(4)
+test_run:cmd("switch default")
+restart(4)
+
+test_run:cmd("switch build_bench")
+box.cfg.memtx_build_threads
+box.space.test1.index.hash:count()
+box.space.test4.index.tree_str:count()
+set_build_threads(8)
+test_run:cmd("switch default")
+restart(8)
+
+test_run:cmd("switch build_bench")
+box.cfg.memtx_build_threads
+box.space.test1.index.hash:count()
+box.space.test4.index.tree_str:count()
+test_run:cmd("switch default")
+
+file:close()
+test_run:cmd("stop server build_bench")
+test_run:cmd("cleanup server build_bench")
@@ -0,0 +1,9 @@
+#!/usr/bin/env tarantool
+
+box.cfg {
+    listen              = os.getenv("LISTEN"),
+    slab_alloc_arena    = 0.1,
+    memtx_build_threads = 4,
+}
+
+require('console').listen(os.getenv('ADMIN'))
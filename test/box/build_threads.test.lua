@@ -0,0 +1,47 @@
+--
+-- Check that secondary keys built in several threads at the
+-- end of recovery are complete and ordered.
+--
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server build_threads with script='box/build_threads.lua'")
+test_run:cmd("start server build_threads")
+test_run:cmd("switch build_threads")
+box.cfg.memtx_build_threads
+space = box.schema.space.create('test')
+_ = space:create_index('pk')
+_ = space:create_index('tree', {parts = {2, 'unsigned'}})
+_ = space:create_index('tree_multi', {parts = {3, 'string'}, unique = false})
+_ = space:create_index('hash', {type = 'hash', parts = {4, 'unsigned'}})
+function fill(from, to) box.begin() for i = from, to do space:insert{i, 100000 - i, tostring(i % 100), i * 2} end box.commit() end
+fill(1, 10000)
+box.snapshot()
+-- Rows recovered from the WAL.
+fill(10001, 10100)
+test_run:cmd("restart server build_threads")
+space = box.space.test
+function check_order(index, field) local prev = nil for _, t in index:pairs() do if prev ~= nil and t[field] < prev then return false end prev = t[field] end return true end
+space.index.pk:count()
+space.index.tree:count()
+space.index.tree_multi:count()
+space.index.hash:count()
+check_order(space.index.tree, 2)
+check_order(space.index.tree_multi, 3)
+space.index.tree:get{100000 - 10}
+space.index.tree:select({}, {limit = 3})
+space.index.tree_multi:select({'7'}, {limit = 3})
+space.index.tree_multi:count({'7'})
+space.index.hash:get{20}
+space.index.hash:get{20200}
+-- Unique keys are enforced.
+space:insert{20000, 100000 - 5, 'x', 1}
+space:insert{20000, 1, 'x', 10}
+-- A unique key can't be built on duplicates at runtime either.
+space:create_index('dup', {parts = {3, 'string'}})
+_ = space:create_index('tree_new', {parts = {4, 'unsigned'}})
+space.index.tree_new:count()
+check_order(space.index.tree_new, 4)
+space:drop()
+test_run:cmd("switch default")
+test_run:cmd("stop server build_threads")
+test_run:cmd("cleanup server build_threads")
@@ -0,0 +1,43 @@
+--
+-- Pipelined DML requests of a connection are executed in
+-- batches sharing one transaction. Check that every request
+-- still gets its own reply.
+--
+test_run = require('test_run').new()
+net = require('net.box')
+fiber = require('fiber')
+errinj = box.error.injection
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+space = box.schema.space.create('test')
+_ = space:create_index('pk')
+space:insert{5}
+c = net.connect(box.cfg.listen)
+test_run:cmd("setopt delimiter ';'")
+function insert_batch(count)
+    local ch = fiber.channel(count)
+    for i = 1, count do
+        fiber.create(function()
+            local ok, res = pcall(c.space.test.insert, c.space.test, {i})
+            ch:put({i, ok and res or tostring(res)})
+        end)
+    end
+    local result = {}
+    for i = 1, count do
+        local r = ch:get()
+        result[r[1]] = r[2]
+    end
+    return result
+end;
+test_run:cmd("setopt delimiter ''");
+-- A failed statement doesn't affect the other requests.
+insert_batch(10)
+space:select{}
+for i = 1, 10 do if i ~= 5 then space:delete{i} end end
+-- A failed commit fails every request of the transaction.
+errinj.set("ERRINJ_WAL_IO", true)
+insert_batch(10)
+errinj.set("ERRINJ_WAL_IO", false)
+space:select{}
+c:close()
+space:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
@@ -0,0 +1,10 @@
+#!/usr/bin/env tarantool
+
+box.cfg {
+    listen              = os.getenv("LISTEN"),
+    slab_alloc_arena    = 0.1,
+    iproto_threads      = 2,
+    iproto_io_uring     = true,
+}
+
+require('console').listen(os.getenv('ADMIN'))
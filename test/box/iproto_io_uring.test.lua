@@ -0,0 +1,29 @@
+--
+-- Check that replies are written with io_uring, or with writev()
+-- if the kernel doesn't support it.
+--
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server iproto_io_uring with script='box/iproto_io_uring.lua'")
+test_run:cmd("start server iproto_io_uring")
+test_run:cmd("switch iproto_io_uring")
+box.cfg.iproto_io_uring
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+space = box.schema.space.create('test')
+index = space:create_index('primary')
+net_box = require('net.box')
+conns = {}
+for i = 1, 16 do conns[i] = net_box.new(box.cfg.listen) end
+for i = 1, 16 do conns[i].space.test:insert{i, string.rep('x', i * 10000)} end
+space:count()
+-- Big replies take more than one write.
+ok = true
+for i = 1, 16 do local r = conns[i].space.test:select{} ok = ok and #r == 16 and r[i][2] == string.rep('x', i * 10000) end
+ok
+for i = 1, 16 do conns[i]:close() end
+box.stat.net().SENT.total > 0
+-- The option can't be changed on the fly.
+box.cfg{iproto_io_uring = false}
+test_run:cmd("switch default")
+test_run:cmd("stop server iproto_io_uring")
+test_run:cmd("cleanup server iproto_io_uring")
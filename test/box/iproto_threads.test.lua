@@ -0,0 +1,36 @@
+--
+-- Check that requests are served by several network threads.
+--
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server iproto_threads with script='box/iproto_threads.lua'")
+test_run:cmd("start server iproto_threads")
+test_run:cmd("switch iproto_threads")
+box.cfg.iproto_threads
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+space = box.schema.space.create('test')
+index = space:create_index('primary')
+-- Listen on a TCP port, shared by all threads.
+socket = require('socket')
+server = socket.tcp_server('127.0.0.1', 0, function() end)
+port = server:name().port
+server:close()
+box.cfg{listen = '127.0.0.1:' .. port}
+net_box = require('net.box')
+conns = {}
+for i = 1, 16 do conns[i] = net_box.new('127.0.0.1:' .. port) end
+for i = 1, 16 do conns[i].space.test:insert{i} end
+space:count()
+ok = true
+for i = 1, 16 do ok = ok and conns[i]:ping() end
+ok
+for i = 1, 16 do conns[i]:close() end
+-- Statistics are summed up over all threads.
+box.stat.net().RECEIVED.total > 0
+box.stat.net().SENT.total > 0
+box.stat.net.EVENTS ~= nil
+-- The number of threads can't be changed on the fly.
+box.cfg{iproto_threads = 2}
+test_run:cmd("switch default")
+test_run:cmd("stop server iproto_threads")
+test_run:cmd("cleanup server iproto_threads")
@@ -389,6 +389,11 @@ for i = 0,10000 do box.space.test:insert{i, data1k} end
 net = require('net.box')
 c = net:new(box.cfg.listen)
 r = c.space.test:select(nil, {limit=5000})
+-- big tuples are sent right from the tuple data
+#r
+ok = true
+for i, t in ipairs(r) do ok = ok and t[1] == i - 1 and t[2] == data1k end
+ok
 box.space.test:drop()
 
 -- gh-970 gh-971 UPSERT over network
@@ -405,5 +410,57 @@ c.space.test:upsert({2, 4, 'nothing'}, {{'+', 3, 100500}}) -- wrong operation
 c.space.test:select{}
 box.space.test:drop()
 
+-- server-side cursors
+_ = box.schema.space.create('test')
+_ = box.space.test:create_index('primary', {type = 'TREE', parts = {1,'unsigned'}})
+for i = 1, 10 do box.space.test:insert{i} end
+c = net:new(box.cfg.listen)
+cur = c.space.test:cursor({}, {chunk_size = 3})
+cur.id > 0
+#cur._chunk
+t = {} for _, tuple in cur:pairs() do table.insert(t, tuple[1]) end
+t
+cur.id
+cur = c.space.test.index.primary:cursor({3}, {iterator = 'GE', offset = 2, limit = 4, chunk_size = 2})
+t = {} for _, tuple in cur:pairs() do table.insert(t, tuple[1]) end
+t
+cur = c.space.test:cursor({}, {limit = 3})
+cur.id
+#cur._chunk
+cur = c.space.test:cursor({}, {chunk_size = 2})
+cur:next()
+id = cur.id
+cur:close()
+cur:next()
+cur.id = id
+cur:next()
+-- cursors dropped without close() don't leak
+for i = 1, 100 do c.space.test:cursor({}, {chunk_size = 1}) end
+cur = c.space.test:cursor({}, {chunk_size = 1})
+cur:next()
+cur:close()
+for i = 1, 100 do for _, tuple in c.space.test:cursor({}, {chunk_size = 1}):pairs() do break end end
+c.space.test:cursor({}, {chunk_size = 1}):next()
+c:close()
+-- cursors of a previous session don't reach the server
+c = net:new(box.cfg.listen, {reconnect_after = .1})
+old = c.space.test:cursor({}, {chunk_size = 1})
+old:next()
+dropped = c.space.test:cursor({}, {chunk_size = 1})
+c:_fatal('Test error')
+c:_wait_state({active = true, activew = true}, 2)
+new = c.space.test:cursor({}, {chunk_size = 1})
+new.id == old.id
+old:next()
+old:close()
+dropped = nil
+collectgarbage('collect')
+#c._dropped_cursors
+c._cursor_count
+new:next()
+new:next()
+new:close()
+c:close()
+box.space.test:drop()
 box.schema.user.revoke('guest', 'read,write,execute', 'universe')
 test_run:cmd("clear filter")
@@ -0,0 +1,10 @@
+#!/usr/bin/env tarantool
+
+box.cfg {
+    listen              = os.getenv("LISTEN"),
+    slab_alloc_arena    = 0.1,
+    iproto_threads      = 2,
+    read_view_period    = 0.2,
+}
+
+require('console').listen(os.getenv('ADMIN'))
@@ -0,0 +1,53 @@
+--
+-- Check that SELECTs with stale_ok are served from memtx read views.
+--
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server read_view with script='box/read_view.lua'")
+test_run:cmd("start server read_view")
+test_run:cmd("switch read_view")
+box.cfg.read_view_period
+fiber = require('fiber')
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+space = box.schema.space.create('test')
+pk = space:create_index('primary')
+sk = space:create_index('secondary', {unique = false, parts = {2, 'unsigned'}})
+hash = space:create_index('hash', {type = 'hash', parts = {1, 'unsigned'}})
+for i = 1, 10 do space:insert{i, i % 3} end
+net_box = require('net.box')
+c = net_box.new(box.cfg.listen)
+-- Wait for a view with the data.
+fiber.sleep(0.5)
+c.space.test:select({}, {stale_ok = true})
+c.space.test:select({5}, {stale_ok = true})
+c.space.test:select({5}, {stale_ok = true, iterator = 'LE', limit = 3})
+c.space.test:select({}, {stale_ok = true, iterator = 'LT', limit = 2})
+c.space.test:select({11}, {stale_ok = true, iterator = 'LE', limit = 2})
+c.space.test:select({}, {stale_ok = true, offset = 8})
+c.space.test.index.secondary:select({1}, {stale_ok = true})
+c.space.test.index.secondary:select({1}, {stale_ok = true, iterator = 'REQ'})
+-- Not a TREE index: served in tx.
+c.space.test.index.hash:select({3}, {stale_ok = true})
+-- Errors are reported by tx.
+c.space.test:select({'a'}, {stale_ok = true})
+-- Changes show up with the next view.
+function wait_view(count) while #c.space.test:select({}, {stale_ok = true}) ~= count do fiber.sleep(0.001) end end
+for i = 1, 10 do space:delete{i} end
+wait_view(0)
+c.space.test:select({}, {stale_ok = true})
+-- Until then the view returns the old rows.
+space:insert{1, 1}
+c.space.test:select({}, {stale_ok = true})
+c.space.test:select({})
+wait_view(1)
+c.space.test:select({}, {stale_ok = true})
+-- Alter waits for the views to be released.
+sk:drop()
+space:drop()
+box.space.test == nil
+c:close()
+-- The period can't be changed on the fly.
+box.cfg{read_view_period = 1}
+test_run:cmd("switch default")
+test_run:cmd("stop server read_view")
+test_run:cmd("cleanup server read_view")
@@ -21,6 +21,30 @@ box.stat.net.RECEIVED.total > 0
 box.stat.net.EVENTS.total > 0
 -- box.stat.net.LOCKS.total > 0
 
+-- Buffer memory of each connection
+conns = box.stat.net.connections()
+#conns
+conns[1].fd > 0
+conns[1].readahead <= box.cfg.readahead
+conns[1].input > 0
+-- Buffers of idle connections are released.
+fiber = require('fiber')
+for i = 1, 50 do if box.stat.net.connections()[1].input == 0 then break end fiber.sleep(0.1) end
+box.stat.net.connections()[1].input
+
+-- Latency of requests by stage and by request type
+cn.space.tweedledum:insert{1}
+box.stat.latency.INSERT.count
+box.stat.latency.SELECT.count > 0
+lat = box.stat.latency()
+lat.PARSE.count == lat.TX_QUEUE.count
+lat.TX.count == lat.TX_QUEUE.count
+lat.FLUSH.count > 0
+lat.INSERT.max >= lat.INSERT.p50
+box.stat.latency.UNKNOWN
+box.stat.wal.QUEUE.count > 0
+box.stat.wal.WRITE.count > 0
+
 space:drop()
 cn:close()
 box.schema.user.revoke('guest','read,write,execute','universe')
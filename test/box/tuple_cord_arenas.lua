@@ -0,0 +1,9 @@
+#!/usr/bin/env tarantool
+
+box.cfg {
+    listen              = os.getenv("LISTEN"),
+    slab_alloc_arena    = 0.1,
+    tuple_cord_arenas   = true,
+}
+
+require('console').listen(os.getenv('ADMIN'))
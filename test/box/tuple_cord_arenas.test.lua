@@ -0,0 +1,35 @@
+--
+-- Check that tuples keep working with the arena id in front of
+-- them: the tx arena goes through DML, snapshot and recovery.
+--
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server tuple_cord_arenas with script='box/tuple_cord_arenas.lua'")
+test_run:cmd("start server tuple_cord_arenas")
+test_run:cmd("switch tuple_cord_arenas")
+box.cfg.tuple_cord_arenas
+space = box.schema.space.create('test')
+index = space:create_index('primary')
+s2 = space:create_index('secondary', {parts = {2, 'str'}, unique = false})
+for i = 1, 1000 do space:insert{i, string.rep('x', i % 100)} end
+for i = 1, 1000, 2 do space:delete{i} end
+for i = 2, 1000, 4 do space:replace{i, string.rep('y', i % 300)} end
+space:count()
+box.snapshot()
+for i = 1001, 1100 do space:insert{i, 'z'} end
+space:count()
+-- The option can't be changed on the fly.
+box.cfg{tuple_cord_arenas = false}
+test_run:cmd("switch default")
+test_run:cmd("stop server tuple_cord_arenas")
+test_run:cmd("start server tuple_cord_arenas")
+test_run:cmd("switch tuple_cord_arenas")
+space = box.space.test
+space:count()
+space.index.secondary:count('z')
+space:get{2}[2] == string.rep('y', 2)
+space:get{4}[2] == string.rep('x', 4)
+space:drop()
+test_run:cmd("switch default")
+test_run:cmd("stop server tuple_cord_arenas")
+test_run:cmd("cleanup server tuple_cord_arenas")
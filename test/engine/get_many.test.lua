@@ -0,0 +1,31 @@
+test_run = require('test_run')
+inspector = test_run.new()
+engine = inspector:get_cfg('engine')
+net = require('net.box')
+
+space = box.schema.space.create('test', { engine = engine })
+index = space:create_index('primary', { type = 'tree', parts = {1, 'unsigned'} })
+for key = 1, 100 do space:replace({key, tostring(key)}) end
+box.snapshot()
+-- some keys are in memory, some are not
+space:replace({101, '101'})
+space:delete({50})
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+c = net.connect(box.cfg.listen)
+c.space.test:get_many({{1}, {50}, 100, {101}, {102}})
+c.space.test.index.primary:get_many({7, 7})
+c.space.test:get_many({})
+t = {}
+for key = 1, 100 do table.insert(t, key) end
+r = c.space.test:get_many(t)
+#r
+r[49], r[50], r[51]
+-- errors
+c.space.test:get_many({{}})
+c.space.test:get_many({{1, 2}})
+c.space.test:get_many({'1'})
+c:close()
+
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+space:drop()
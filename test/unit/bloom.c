@@ -0,0 +1,89 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "unit.h"
+#include "salad/bloom.h"
+
+enum { COUNT = 100000 };
+
+/** A well mixed hash of a number, see bloom.h. */
+static uint32_t
+hash(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x85ebca6b;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35;
+	x ^= x >> 16;
+	return x;
+}
+
+static void
+test_false_positives(void)
+{
+	header();
+	struct bloom bloom;
+	fail_unless(bloom_create(&bloom, COUNT, 10) == 0);
+	for (uint32_t i = 0; i < COUNT; i++)
+		bloom_add(&bloom, hash(i));
+	for (uint32_t i = 0; i < COUNT; i++)
+		fail_unless(bloom_maybe_has(&bloom, hash(i)));
+	uint32_t false_positives = 0;
+	for (uint32_t i = COUNT; i < 2 * COUNT; i++)
+		false_positives += bloom_maybe_has(&bloom, hash(i));
+	/* The expected rate is about 1%. */
+	printf("false positive rate is less than 2%%: %d\n",
+	       false_positives < COUNT / 50);
+	bloom_destroy(&bloom);
+	footer();
+}
+
+static void
+test_store_load(void)
+{
+	header();
+	struct bloom bloom, loaded;
+	fail_unless(bloom_create(&bloom, COUNT, 10) == 0);
+	for (uint32_t i = 0; i < COUNT; i += 2)
+		bloom_add(&bloom, hash(i));
+	size_t size = bloom_store_size(&bloom);
+	char *buf = malloc(size);
+	fail_unless(buf != NULL);
+	fail_unless(bloom_store(&bloom, buf) == buf + size);
+	fail_unless(bloom_load(&loaded, buf, size - 1) == -1);
+	fail_unless(bloom_load(&loaded, buf, size) == 0);
+	fail_unless(loaded.bit_count == bloom.bit_count);
+	fail_unless(loaded.hash_count == bloom.hash_count);
+	for (uint32_t i = 0; i < COUNT; i++) {
+		fail_unless(bloom_maybe_has(&loaded, hash(i)) ==
+			    bloom_maybe_has(&bloom, hash(i)));
+	}
+	free(buf);
+	bloom_destroy(&loaded);
+	bloom_destroy(&bloom);
+	footer();
+}
+
+static void
+test_empty(void)
+{
+	header();
+	struct bloom bloom;
+	fail_unless(bloom_create(&bloom, 0, 10) == 0);
+	fail_unless(bloom.bit_count == 64);
+	fail_unless(! bloom_maybe_has(&bloom, hash(1)));
+	bloom_add(&bloom, hash(1));
+	fail_unless(bloom_maybe_has(&bloom, hash(1)));
+	bloom_destroy(&bloom);
+	footer();
+}
+
+int
+main(void)
+{
+	test_false_positives();
+	test_store_load();
+	test_empty();
+	return 0;
+}
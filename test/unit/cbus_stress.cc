@@ -0,0 +1,146 @@
+#include "memory.h"
+#include "fiber.h"
+#include "cbus.h"
+#include "say.h"
+#include "unit.h"
+
+#include <stdio.h>
+
+/*
+ * Several producer cords send messages to the main cord over
+ * their own buses, so that all of them push to the same fiber
+ * pool pipe. Each message makes a round trip and is sent
+ * again until the producer runs out of iterations. Prints the
+ * throughput and the average round trip latency to stderr.
+ */
+
+enum {
+	PRODUCERS = 4,
+	/** Messages in flight per producer. */
+	WINDOW = 64,
+	ITERATIONS = 200000,
+};
+
+struct producer;
+
+struct bench_msg {
+	struct cmsg base;
+	struct producer *producer;
+	/** The time the current round trip has started at. */
+	ev_tstamp sent_at;
+};
+
+struct producer {
+	struct cord cord;
+	struct cbus bus;
+	/** Consumed by the main cord. */
+	struct cpipe main_pipe;
+	/** Consumed by the producer cord. */
+	struct cpipe producer_pipe;
+	/** The producer side of main_pipe, set in cbus_join(). */
+	struct cpipe *out;
+	struct cmsg_hop route[2];
+	struct bench_msg msgs[WINDOW];
+	struct fiber *fiber;
+	int sent;
+	int received;
+	double latency;
+};
+
+static struct producer producers[PRODUCERS];
+static int main_received;
+
+static void
+main_receive(struct cmsg *m)
+{
+	(void) m;
+	main_received++;
+}
+
+static void
+producer_send(struct producer *p, struct bench_msg *msg)
+{
+	cmsg_init(&msg->base, p->route);
+	msg->sent_at = ev_time();
+	p->sent++;
+	cpipe_push(p->out, &msg->base);
+}
+
+static void
+producer_receive(struct cmsg *m)
+{
+	struct bench_msg *msg = (struct bench_msg *) m;
+	struct producer *p = msg->producer;
+	p->latency += ev_time() - msg->sent_at;
+	p->received++;
+	if (p->sent < ITERATIONS)
+		producer_send(p, msg);
+	else if (p->received == ITERATIONS)
+		fiber_wakeup(p->fiber);
+}
+
+static int
+producer_f(va_list ap)
+{
+	struct producer *p = va_arg(ap, struct producer *);
+	p->out = cbus_join(&p->bus, &p->producer_pipe);
+	p->fiber = fiber();
+	p->route[0].f = main_receive;
+	p->route[0].pipe = &p->producer_pipe;
+	p->route[1].f = producer_receive;
+	p->route[1].pipe = NULL;
+	for (int i = 0; i < WINDOW; i++) {
+		p->msgs[i].producer = p;
+		producer_send(p, &p->msgs[i]);
+	}
+	while (p->received < ITERATIONS)
+		fiber_yield();
+	return 0;
+}
+
+static int
+main_f(va_list ap)
+{
+	(void) ap;
+	header();
+	ev_tstamp start = ev_time();
+	for (int i = 0; i < PRODUCERS; i++) {
+		struct producer *p = &producers[i];
+		cbus_create(&p->bus);
+		cpipe_create(&p->main_pipe);
+		cpipe_create(&p->producer_pipe);
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "producer%d", i);
+		if (cord_costart(&p->cord, name, producer_f, p) != 0)
+			panic("failed to start a producer cord");
+		cbus_join(&p->bus, &p->main_pipe);
+	}
+	double latency = 0;
+	for (int i = 0; i < PRODUCERS; i++) {
+		struct producer *p = &producers[i];
+		cord_cojoin(&p->cord);
+		latency += p->latency;
+	}
+	ev_tstamp elapsed = ev_time() - start;
+	fail_unless(main_received == PRODUCERS * ITERATIONS);
+	fprintf(stderr, "%d messages in %.3f s, %.0f msg/s, "
+		"avg round trip %.2f us\n", main_received, elapsed,
+		main_received / elapsed, latency / main_received * 1e6);
+	for (int i = 0; i < PRODUCERS; i++)
+		cbus_destroy(&producers[i].bus);
+	ev_break(loop(), EVBREAK_ALL);
+	footer();
+	return 0;
+}
+
+int main()
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	struct fiber *main = fiber_new_xc("main", main_f);
+	fiber_wakeup(main);
+	ev_run(loop(), 0);
+	fiber_free();
+	memory_free();
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "unit.h"
+#include "histogram.h"
+
+static void
+test_buckets(void)
+{
+	header();
+	struct histogram hist;
+	histogram_create(&hist);
+	int64_t values[] = {0, 1, 2, 3, 4, 7, 8, 1000, 1024, INT64_MAX};
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+		histogram_collect(&hist, values[i]);
+	fail_unless(hist.count == 10);
+	fail_unless(hist.max == INT64_MAX);
+	fail_unless(hist.buckets[0] == 1);
+	fail_unless(hist.buckets[1] == 1);
+	fail_unless(hist.buckets[2] == 2);
+	fail_unless(hist.buckets[3] == 2);
+	fail_unless(hist.buckets[4] == 1);
+	fail_unless(hist.buckets[10] == 1);
+	fail_unless(hist.buckets[11] == 1);
+	fail_unless(hist.buckets[HISTOGRAM_BUCKETS - 1] == 1);
+	fail_unless(histogram_bucket_max(0) == 0);
+	fail_unless(histogram_bucket_max(1) == 1);
+	fail_unless(histogram_bucket_max(10) == 1023);
+	fail_unless(histogram_bucket_max(HISTOGRAM_BUCKETS - 1) == INT64_MAX);
+	footer();
+}
+
+static void
+test_percentile(void)
+{
+	header();
+	struct histogram hist;
+	histogram_create(&hist);
+	fail_unless(histogram_percentile(&hist, 99) == 0);
+	for (int64_t i = 1; i <= 1000; i++)
+		histogram_collect(&hist, i);
+	fail_unless(hist.sum == 500500);
+	printf("p50 %lld\n", (long long) histogram_percentile(&hist, 50));
+	printf("p90 %lld\n", (long long) histogram_percentile(&hist, 90));
+	printf("p99 %lld\n", (long long) histogram_percentile(&hist, 99));
+	printf("p100 %lld\n", (long long) histogram_percentile(&hist, 100));
+	footer();
+}
+
+static void
+test_merge(void)
+{
+	header();
+	struct histogram a, b;
+	histogram_create(&a);
+	histogram_create(&b);
+	for (int64_t i = 1; i <= 500; i++)
+		histogram_collect(&a, i);
+	for (int64_t i = 501; i <= 1000; i++)
+		histogram_collect(&b, i);
+	histogram_merge(&a, &b);
+	fail_unless(a.count == 1000);
+	fail_unless(a.sum == 500500);
+	fail_unless(a.max == 1000);
+	printf("p50 %lld\n", (long long) histogram_percentile(&a, 50));
+	printf("p99 %lld\n", (long long) histogram_percentile(&a, 99));
+	footer();
+}
+
+int
+main(void)
+{
+	test_buckets();
+	test_percentile();
+	test_merge();
+	return 0;
+}
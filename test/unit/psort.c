@@ -0,0 +1,198 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "unit.h"
+#include "trivia/config.h"
+#include "salad/psort.h"
+#include "third_party/qsort_arg.h"
+
+/*
+ * Without arguments the test checks the sorts on arrays of
+ * the default size. With an element count in argv[1] it
+ * also prints the time each sort takes, for benchmarking:
+ *
+ *     ./psort.test 10000000
+ */
+enum { DEFAULT_COUNT = 1000 * 1000 };
+
+static size_t count = DEFAULT_COUNT;
+static bool is_bench = false;
+
+struct sorter {
+	const char *name;
+	void (*sort)(void *a, size_t n, size_t es,
+		     int (*cmp)(const void *, const void *, void *),
+		     void *arg);
+};
+
+static void
+psort_2(void *a, size_t n, size_t es,
+	int (*cmp)(const void *, const void *, void *), void *arg)
+{
+	psort_arg(a, n, es, cmp, arg, 2);
+}
+
+static void
+psort_4(void *a, size_t n, size_t es,
+	int (*cmp)(const void *, const void *, void *), void *arg)
+{
+	psort_arg(a, n, es, cmp, arg, 4);
+}
+
+static void
+psort_8(void *a, size_t n, size_t es,
+	int (*cmp)(const void *, const void *, void *), void *arg)
+{
+	psort_arg(a, n, es, cmp, arg, 8);
+}
+
+static void
+psort_300(void *a, size_t n, size_t es,
+	  int (*cmp)(const void *, const void *, void *), void *arg)
+{
+	psort_arg(a, n, es, cmp, arg, 300);
+}
+
+static struct sorter sorters[] = {
+	{"qsort_arg", qsort_arg},
+#if defined(HAVE_OPENMP)
+	{"qsort_arg_mt", qsort_arg_mt},
+#endif
+	{"psort_arg(2)", psort_2},
+	{"psort_arg(4)", psort_4},
+	{"psort_arg(8)", psort_8},
+	{"psort_arg(300)", psort_300},
+};
+
+enum fill_mode {
+	FILL_RANDOM,
+	FILL_SORTED,
+	FILL_REVERSED,
+	FILL_FEW_UNIQUE,
+	FILL_EQUAL,
+	fill_mode_MAX
+};
+
+static const char *fill_mode_strs[] = {
+	"random", "sorted", "reversed", "few unique", "equal"
+};
+
+static void
+fill(uint64_t *values, size_t n, enum fill_mode mode)
+{
+	for (size_t i = 0; i < n; i++) {
+		switch (mode) {
+		case FILL_RANDOM:
+			values[i] = ((uint64_t) rand() << 32) ^ rand();
+			break;
+		case FILL_SORTED:
+			values[i] = i;
+			break;
+		case FILL_REVERSED:
+			values[i] = n - i;
+			break;
+		case FILL_FEW_UNIQUE:
+			values[i] = rand() % 10;
+			break;
+		default:
+			values[i] = 42;
+			break;
+		}
+	}
+}
+
+/**
+ * Memtx sorts arrays of pointers to tuples, so sort pointers
+ * to values rather than values themselves.
+ */
+static int
+ptr_cmp(const void *a, const void *b, void *arg)
+{
+	(void) arg;
+	uint64_t va = **(const uint64_t **) a;
+	uint64_t vb = **(const uint64_t **) b;
+	return va < vb ? -1 : va > vb;
+}
+
+/** Check that the array is sorted and is a permutation. */
+static void
+check(uint64_t **ptrs, size_t n, uint64_t *values)
+{
+	uint64_t sum = 0, expected_sum = 0;
+	for (size_t i = 0; i < n; i++) {
+		fail_if(i > 0 && *ptrs[i - 1] > *ptrs[i]);
+		fail_unless(ptrs[i] >= values && ptrs[i] < values + n);
+		sum += ptrs[i] - values;
+		expected_sum += i;
+	}
+	fail_unless(sum == expected_sum);
+}
+
+static void
+sort_check(enum fill_mode mode)
+{
+	printf("\t%s\n", fill_mode_strs[mode]);
+	uint64_t *values = (uint64_t *) malloc(count * sizeof(*values));
+	uint64_t **ptrs = (uint64_t **) malloc(count * sizeof(*ptrs));
+	fail_if(values == NULL || ptrs == NULL);
+	srand(count);
+	fill(values, count, mode);
+	for (size_t s = 0; s < sizeof(sorters) / sizeof(sorters[0]); s++) {
+		for (size_t i = 0; i < count; i++)
+			ptrs[i] = &values[i];
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		sorters[s].sort(ptrs, count, sizeof(*ptrs), ptr_cmp, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		check(ptrs, count, values);
+		if (is_bench) {
+			printf("\t\t%-16s %.3f sec\n", sorters[s].name,
+			       end.tv_sec - start.tv_sec +
+			       (end.tv_nsec - start.tv_nsec) / 1e9);
+		}
+	}
+	free(ptrs);
+	free(values);
+}
+
+static void
+small_check()
+{
+	header();
+	/* Too small arrays are sorted by qsort_arg(). */
+	uint64_t values[100];
+	uint64_t *ptrs[100];
+	for (size_t n = 0; n <= 100; n++) {
+		fill(values, n, FILL_RANDOM);
+		for (size_t i = 0; i < n; i++)
+			ptrs[i] = &values[i];
+		psort_arg(ptrs, n, sizeof(*ptrs), ptr_cmp, NULL, 8);
+		check(ptrs, n, values);
+	}
+	footer();
+}
+
+static void
+large_check()
+{
+	header();
+	for (int mode = 0; mode < fill_mode_MAX; mode++)
+		sort_check(mode);
+	footer();
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (argc > 1) {
+		count = strtoull(argv[1], NULL, 10);
+		is_bench = true;
+	}
+	small_check();
+	large_check();
+	return 0;
+}
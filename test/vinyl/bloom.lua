@@ -0,0 +1,18 @@
+#!/usr/bin/env tarantool
+
+require('suite')
+
+-- The runs must survive restarts, see bloom.test.lua.
+vinyl_mkdir()
+
+box.cfg {
+    listen            = os.getenv("LISTEN"),
+    slab_alloc_arena  = 0.1,
+    vinyl_dir         = "./vinyl/vinyl_test",
+    vinyl = {
+        threads = 3;
+        memory_limit = 0.05;
+    }
+}
+
+require('console').listen(os.getenv('ADMIN'))
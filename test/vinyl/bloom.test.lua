@@ -0,0 +1,30 @@
+--
+-- Check that point lookups of absent keys skip runs by their
+-- bloom filters, and that the filters are loaded with runs.
+--
+test_run = require('test_run').new()
+test_run:cmd("create server bloom with script='vinyl/bloom.lua'")
+test_run:cmd("start server bloom")
+test_run:cmd("switch bloom")
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 100 do s:replace{i * 2} end
+box.snapshot()
+function bloom_skip() return box.info.vinyl().db[box.space.test.id .. '/0'].bloom_skip end
+bloom_skip()
+for i = 1, 100 do s:get{i * 2 + 1} end
+bloom_skip() > 0
+s:get{10}
+s:get{11}
+test_run:cmd("restart server bloom")
+s = box.space.test
+function bloom_skip() return box.info.vinyl().db[box.space.test.id .. '/0'].bloom_skip end
+bloom_skip()
+for i = 1, 100 do s:get{i * 2 + 1} end
+bloom_skip() > 0
+s:get{10}
+s:count()
+s:drop()
+test_run:cmd("switch default")
+test_run:cmd("stop server bloom")
+test_run:cmd("cleanup server bloom")
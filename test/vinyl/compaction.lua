@@ -0,0 +1,18 @@
+#!/usr/bin/env tarantool
+
+require('suite')
+
+vinyl_rmdir()
+vinyl_mkdir()
+
+box.cfg {
+    listen            = os.getenv("LISTEN"),
+    slab_alloc_arena  = 0.1,
+    vinyl_dir         = "./vinyl/vinyl_test",
+    vinyl = {
+        threads = 3;
+        compact_wm = 4;
+    }
+}
+
+require('console').listen(os.getenv('ADMIN'))
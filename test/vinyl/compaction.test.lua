@@ -0,0 +1,61 @@
+--
+-- Check when each compaction policy merges the runs of a range.
+--
+test_run = require('test_run').new()
+test_run:cmd("create server compaction with script='vinyl/compaction.lua'")
+test_run:cmd("start server compaction")
+test_run:cmd("switch compaction")
+fiber = require('fiber')
+tiered = box.schema.space.create('tiered', {engine = 'vinyl'})
+_ = tiered:create_index('pk', {compaction = 'tiered'})
+leveled = box.schema.space.create('leveled', {engine = 'vinyl'})
+_ = leveled:create_index('pk', {compaction = 'leveled'})
+hybrid = box.schema.space.create('hybrid', {engine = 'vinyl'})
+_ = hybrid:create_index('pk', {compaction = 'hybrid'})
+function run_count(s) return box.info.vinyl().db[s.id .. '/0'].run_count end
+function run_counts() return {run_count(tiered), run_count(leveled), run_count(hybrid)} end
+function wait_run_count(s, count) while run_count(s) ~= count do fiber.sleep(0.01) end end
+function dump(first, last) for _, s in ipairs({tiered, leveled, hybrid}) do for i = first, last do s:replace{i, string.rep('x', 100)} end end box.snapshot() end
+dump(1, 1000)
+run_counts()
+-- A dump of more than 1/compaction_ratio of the data makes
+-- leveled and hybrid compact, tiered waits for compact_wm runs.
+dump(1, 200)
+wait_run_count(leveled, 1)
+wait_run_count(hybrid, 1)
+run_counts()
+-- Small dumps: tiered and hybrid compact when the range has
+-- compact_wm runs, leveled only at 8 runs.
+dump(1001, 1001)
+run_counts()
+dump(1002, 1002)
+wait_run_count(tiered, 1)
+run_counts()
+dump(1003, 1003)
+wait_run_count(hybrid, 1)
+run_counts()
+dump(1004, 1004)
+run_counts()
+dump(1005, 1005)
+wait_run_count(tiered, 1)
+run_counts()
+dump(1006, 1006)
+wait_run_count(hybrid, 1)
+run_counts()
+dump(1007, 1007)
+wait_run_count(leveled, 1)
+run_counts()
+tiered:count()
+leveled:count()
+hybrid:count()
+tiered:drop()
+leveled:drop()
+hybrid:drop()
+-- Bad options are rejected.
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {compaction = 'foo'})
+s:create_index('pk', {compaction_ratio = 0})
+s:drop()
+test_run:cmd("switch default")
+test_run:cmd("stop server compaction")
+test_run:cmd("cleanup server compaction")
@@ -0,0 +1,19 @@
+--
+-- Check that pages of dumped runs are read from the page cache.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 1000 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+function page_cache_hit() return box.info.vinyl().performance.page_cache_hit end
+#s:select{}
+hit = page_cache_hit()
+#s:select{}
+page_cache_hit() > hit
+s:get{500}
+-- Cached pages are accounted in the memory used by vinyl, but
+-- don't count as the memory of in-memory indexes, which only
+-- a dump can free and which the scheduler zone depends on.
+box.info.vinyl().memory.used > 0
+box.info.vinyl().scheduler.zone
+s:drop()
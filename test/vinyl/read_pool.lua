@@ -0,0 +1,18 @@
+#!/usr/bin/env tarantool
+
+require('suite')
+
+-- The runs must survive restarts, see read_pool.test.lua.
+vinyl_mkdir()
+
+box.cfg {
+    listen            = os.getenv("LISTEN"),
+    slab_alloc_arena  = 0.1,
+    vinyl_dir         = "./vinyl/vinyl_test",
+    vinyl = {
+        threads = 3;
+        read_threads = 1;
+    }
+}
+
+require('console').listen(os.getenv('ADMIN'))
@@ -0,0 +1,30 @@
+--
+-- Check that disk reads which don't fit into the reader thread
+-- slots wait for a slot and still get their results.
+--
+test_run = require('test_run').new()
+test_run:cmd("create server read_pool with script='vinyl/read_pool.lua'")
+test_run:cmd("start server read_pool")
+test_run:cmd("switch read_pool")
+fiber = require('fiber')
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 1000 do s:replace{i, i * 2} end
+box.snapshot()
+-- empty the caches, so that every get goes to a reader thread
+test_run:cmd("restart server read_pool")
+fiber = require('fiber')
+s = box.space.test
+function read_wait() return box.info.vinyl().performance.read_wait end
+read_wait()
+ch = fiber.channel(100)
+for i = 1, 100 do fiber.create(function() ch:put({i, s:get{i * 10}}) end) end
+ok = true
+for i = 1, 100 do local r = ch:get() ok = ok and r[2] ~= nil and r[2][1] == r[1] * 10 and r[2][2] == r[1] * 20 end
+ok
+read_wait() > 0
+box.info.vinyl().performance.read_inflight
+s:drop()
+test_run:cmd("switch default")
+test_run:cmd("stop server read_pool")
+test_run:cmd("cleanup server read_pool")
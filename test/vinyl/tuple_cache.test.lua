@@ -0,0 +1,85 @@
+--
+-- Check that the tuple cache of point lookups never returns
+-- a stale result.
+--
+net = require('net.box')
+yaml = require('yaml')
+test_run = require('test_run').new()
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+s:replace{1}
+s:replace{4}
+box.snapshot()
+
+test_run:cmd("setopt delimiter ';'")
+hit, miss = 0, 0;
+function cache_stat()
+    local p = box.info.vinyl().performance
+    local r = {p.tuple_cache_hit - hit, p.tuple_cache_miss - miss}
+    hit, miss = p.tuple_cache_hit, p.tuple_cache_miss
+    return r
+end;
+test_run:cmd("setopt delimiter ''");
+_ = cache_stat()
+
+-- The first lookup of an absent key caches it.
+s:get{2}
+cache_stat()
+s:get{2}
+cache_stat()
+s:insert{2}
+s:get{2}
+_ = cache_stat()
+s:get{3}
+s:get{3}
+cache_stat()
+s:upsert({3, 'x'}, {{'=', 2, 'y'}})
+s:get{3}
+
+-- The first lookup of a key on disk caches the tuple.
+_ = cache_stat()
+s:get{1}
+cache_stat()
+s:get{1}
+cache_stat()
+s:update({1}, {{'=', 2, 'b'}})
+s:get{1}
+_ = cache_stat()
+s:get{4}
+s:get{4}
+cache_stat()
+s:delete{4}
+s:get{4}
+
+-- A transaction doesn't read the entries cached after its
+-- read view was created.
+c1 = net.new(os.getenv('ADMIN'))
+test_run:cmd("setopt delimiter ';'")
+getmetatable(c1).__call = function(c, command)
+    local f = yaml.decode(c:console(command))
+    if type(f) == 'table' then
+        setmetatable(f, {__serialize='array'})
+    end
+    return f
+end;
+test_run:cmd("setopt delimiter ''");
+s:get{5}
+c1("box.begin()")
+c1("box.space.test:get{5}")
+s:insert{5}
+box.snapshot()
+s:get{5}
+_ = cache_stat()
+s:get{5}
+cache_stat()
+c1("box.space.test:get{5}")
+cache_stat()
+c1("box.commit()")
+c1("box.space.test:get{5}")
+cache_stat()
+
+c1:close()
+s:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
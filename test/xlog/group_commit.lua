@@ -0,0 +1,12 @@
+#!/usr/bin/env tarantool
+
+box.cfg {
+    listen              = os.getenv("LISTEN"),
+    slab_alloc_arena    = 0.1,
+    wal_mode            = 'fsync',
+    rows_per_wal        = 50,
+    wal_group_commit_delay = 0.01,
+    wal_group_commit_rows = 20,
+}
+
+require('console').listen(os.getenv('ADMIN'))
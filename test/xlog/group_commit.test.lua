@@ -0,0 +1,33 @@
+--
+-- Check that WAL writes are grouped under a single sync
+-- with wal_group_commit_delay in fsync mode.
+--
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server group_commit with script='xlog/group_commit.lua'")
+test_run:cmd("start server group_commit")
+test_run:cmd("switch group_commit")
+fiber = require('fiber')
+space = box.schema.space.create('test')
+index = space:create_index('primary')
+ch = fiber.channel(200)
+-- Concurrent writes from many fibers span several groups and WALs.
+for i = 1, 200 do fiber.create(function() space:insert{i} ch:put(true) end) end
+for i = 1, 200 do ch:get() end
+space:count()
+stat = box.stat.wal()
+stat.FSYNC.count > 0
+stat.FSYNC.count == stat.BATCH.count
+-- Less syncs than writes.
+stat.BATCH.avg > 1
+-- A single write waits for the delay and gets synced alone.
+count = stat.BATCH.count
+space:insert{201}
+box.stat.wal.BATCH.count == count + 1
+test_run:cmd("restart server group_commit")
+space = box.space.test
+space:count()
+space:get{201}
+test_run:cmd('switch default')
+test_run:cmd("stop server group_commit")
+test_run:cmd("cleanup server group_commit")
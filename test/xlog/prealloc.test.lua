@@ -0,0 +1,24 @@
+env = require('test_run')
+test_run = env.new()
+fio = require('fio')
+fiber = require('fiber')
+--
+-- The next WAL is created in advance, with disk space
+-- preallocated, which doesn't show in the file size.
+--
+spare = fio.pathjoin(box.cfg.wal_dir, 'next.xlog.prealloc')
+while fio.stat(spare) == nil do fiber.sleep(0.01) end
+fio.stat(spare).size
+space = box.schema.space.create('test')
+_ = space:create_index('pk')
+-- Rotate the WAL a few times, taking the spare file each time.
+for i = 1, 50 do space:insert{i} end
+while fio.stat(spare) == nil do fiber.sleep(0.01) end
+files = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
+table.sort(files)
+fio.stat(files[#files]).size < 4096
+test_run:cmd("restart server default")
+space = box.space.test
+space:count()
+space:get{50}
+space:drop()
@@ -0,0 +1,21 @@
+env = require('test_run')
+test_run = env.new()
+--
+-- Large WAL files are read ahead in a separate thread on
+-- recovery, small ones are read row by row.
+--
+space = box.schema.space.create('test')
+_ = space:create_index('pk')
+box.begin() for i = 1, 10000 do space:insert{i, string.rep('x', 500)} end box.commit()
+for i = 10001, 10020 do space:insert{i, ''} end
+box.begin() for i = 10021, 20000 do space:insert{i, string.rep('y', 500)} end box.commit()
+test_run:cmd("restart server default")
+space = box.space.test
+space:count()
+sum = 0
+for _, t in space:pairs() do sum = sum + t[1] end
+sum
+space:get{10000}[2]:len()
+space:get{10020}[2] == ''
+space:get{20000}[2]:len()
+space:drop()
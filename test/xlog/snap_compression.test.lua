@@ -0,0 +1,64 @@
+env = require('test_run')
+test_run = env.new()
+fio = require('fio')
+box.cfg.snap_compression
+box.cfg{snap_compression = 'gzip'}
+box.cfg.snap_compression
+box.cfg{snap_compression = 'lz4'}
+box.cfg.snap_compression
+--
+-- Compressed snapshots are smaller and recovery reads them
+-- as if they were written row by row.
+--
+space = box.schema.space.create('test')
+_ = space:create_index('pk')
+_ = space:create_index('sk', {parts = {2, 'str'}})
+test_run:cmd("setopt delimiter ';'")
+function fill(from, to)
+    box.begin()
+    for id = from, to do
+        space:insert{id, string.format('%08d', 20000 - id), string.rep('x', 500)}
+    end
+    box.commit()
+end;
+function last_snap_size()
+    local snaps = fio.glob(fio.pathjoin(box.cfg.snap_dir, '*.snap'))
+    table.sort(snaps)
+    return fio.stat(snaps[#snaps]).size
+end;
+test_run:cmd("setopt delimiter ''");
+fill(1, 10000)
+box.snapshot()
+last_snap_size() < 10000 * 500 / 2
+-- recover from the snapshot only
+for _, f in pairs(fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))) do fio.unlink(f) end
+test_run:cmd("restart server default")
+fio = require('fio')
+space = box.space.test
+space:count()
+space.index.sk:count()
+space:get{1}[2]
+space:get{10000}[2]
+box.cfg{snap_compression = 'zstd'}
+box.begin() for id = 10001, 20000 do space:insert{id, string.format('%08d', 20000 - id), string.rep('x', 500)} end box.commit()
+box.snapshot()
+for _, f in pairs(fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))) do fio.unlink(f) end
+test_run:cmd("restart server default")
+fio = require('fio')
+space = box.space.test
+space:count()
+space.index.sk:min()[1]
+space.index.sk:max()[1]
+sum = 0
+for _, t in space:pairs() do sum = sum + t[1] end
+sum
+-- a snapshot without compression is read as before
+box.cfg.snap_compression
+_ = space:delete{1}
+box.snapshot()
+for _, f in pairs(fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))) do fio.unlink(f) end
+test_run:cmd("restart server default")
+space = box.space.test
+space:count()
+space:get{1}
+space:drop()
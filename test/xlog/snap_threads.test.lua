@@ -0,0 +1,44 @@
+env = require('test_run')
+test_run = env.new()
+fio = require('fio')
+box.cfg.snap_threads
+box.cfg{snap_threads = 0}
+box.cfg.snap_threads
+box.cfg{snap_threads = 1000}
+box.cfg.snap_threads
+box.cfg{snap_threads = 4}
+box.cfg.snap_threads
+--
+-- A snapshot written in several threads must contain
+-- all rows in the primary key order.
+--
+space = box.schema.space.create('test')
+_ = space:create_index('pk')
+_ = space:create_index('sk', {parts = {2, 'str'}})
+test_run:cmd("setopt delimiter ';'")
+for i = 1, 20 do
+    box.begin()
+    for j = 1, 1000 do
+        local id = (i - 1) * 1000 + j
+        space:insert{id, string.format('%08d', 20000 - id), string.rep('x', 500)}
+    end
+    box.commit()
+end;
+test_run:cmd("setopt delimiter ''");
+space:count()
+box.snapshot()
+-- recover from the snapshot only
+glob = fio.pathjoin(box.cfg.wal_dir, '*.xlog')
+for _, file in pairs(fio.glob(glob)) do fio.unlink(file) end
+test_run:cmd("restart server default")
+space = box.space.test
+space:count()
+space.index.sk:count()
+space:get{1}[2]
+space:get{20000}[2]
+space.index.sk:min()[1]
+space.index.sk:max()[1]
+sum = 0
+for _, t in space:pairs() do sum = sum + t[1] end
+sum
+space:drop()
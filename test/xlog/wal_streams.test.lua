@@ -0,0 +1,38 @@
+--
+-- Check that the WAL can be split into streams written
+-- to several directories, and is merged back on recovery.
+--
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server wal_streams with script='xlog/wal_streams.lua'")
+test_run:cmd("start server wal_streams")
+test_run:cmd("switch wal_streams")
+fio = require('fio')
+fiber = require('fiber')
+space = box.schema.space.create('test')
+index = space:create_index('primary')
+ch = fiber.channel(1000)
+-- Enough concurrent writes to fill a batch for every stream.
+for i = 1, 1000 do fiber.create(function() space:insert{i} ch:put(true) end) end
+for i = 1, 1000 do ch:get() end
+space:count()
+#fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog')) > 0
+#fio.glob('wal_stream1/*.xlog') > 0
+#fio.glob('wal_stream2/*.xlog') > 0
+-- Changes of the same row written to different streams.
+for i = 1, 1000 do fiber.create(function() space:replace{1, i} ch:put(true) end) end
+for i = 1, 1000 do ch:get() end
+space:get{1}
+-- Replication reads wal_dir only.
+box.cfg{replication_source = 'localhost:3301'}
+box.cfg.replication_source
+test_run:cmd("restart server wal_streams")
+space = box.space.test
+space:count()
+-- The changes are applied in the order they were committed.
+space:get{1}
+space:get{1000}
+space:insert{1001}
+test_run:cmd('switch default')
+test_run:cmd("stop server wal_streams")
+test_run:cmd("cleanup server wal_streams")
@@ -0,0 +1,19 @@
+#!/usr/bin/env tarantool
+
+local fio = require('fio')
+local stream_dirs = { 'wal_stream1', 'wal_stream2' }
+for _, dir in ipairs(stream_dirs) do
+    if fio.stat(dir) == nil then
+        fio.mkdir(dir)
+    end
+end
+
+box.cfg {
+    listen              = os.getenv("LISTEN"),
+    slab_alloc_arena    = 0.1,
+    rows_per_wal        = 50,
+    wal_stream_dirs     = stream_dirs,
+    panic_on_wal_error  = false,
+}
+
+require('console').listen(os.getenv('ADMIN'))
@@ -9,6 +9,12 @@ extern "C" {
 
 void qsort_arg(void *a, size_t n, size_t es, int (*cmp)(const void *a, const void *b, void *arg), void *arg);
 
+/**
+ * OpenMP version of qsort_arg(), available if the server is
+ * built with HAVE_OPENMP.
+ */
+void qsort_arg_mt(void *a, size_t n, size_t es, int (*cmp)(const void *a, const void *b, void *arg), void *arg);
+
 #if defined(__cplusplus)
 }
 #endif /* defined(__cplusplus) */